@@ -27,10 +27,10 @@ Accumulator::Accumulator(const QDSPStream & stream, const size_t & recordLength,
 };
 
 void Accumulator::reset() {
-    data_.assign(recordLength_*numSegments_, 0);
+    std::fill(data_.begin(), data_.end(), 0);
     idx_ = data_.begin();
     std::fill(data2_.begin(), data2_.end(), 0);
-    idx2_ = data_.begin();
+    idx2_ = data2_.begin();
     wfmCt_ = 0;
     recordsTaken = 0;
 }
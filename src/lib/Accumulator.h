@@ -11,13 +11,14 @@
 #define ACCUMULATOR_H_
 
 #include "QDSPStream.h"
+#include "MemoryPolicy.h"
 
 #include <algorithm> //std::transform
 #include <vector>
 using std::vector;
 using std::max;
 
-#include <plog/Log.h>
+#include "logging.h"
 
 #include <BufferDatagrams_Mb.h>
 
@@ -28,8 +29,10 @@ public:
 	/* Helper class to accumulate/average data */
 	Accumulator();
 	Accumulator(const QDSPStream &, const size_t &, const size_t &, const size_t &);
-	template <class T>
-	void accumulate(const Innovative::AccessDatagram<T> &);
+	// accepts any record buffer with size(), begin() and operator[], e.g. a
+	// Malibu datagram or a RecordView into the received VITA packets
+	template <class B>
+	void accumulate(const B &);
 
 	void reset();
 	void snapshot(double *);
@@ -46,20 +49,22 @@ private:
 	size_t recordLength_;
 	unsigned fixed_to_float_;
 
-	vector<int64_t> data_;
-	vector<int64_t>::iterator idx_;
+	// large enough (segments x record length) to warrant huge pages
+	typedef vector<int64_t, HugePageAllocator<int64_t>> SumBuffer;
+	SumBuffer data_;
+	SumBuffer::iterator idx_;
 	// second data object to store the square of the data
-	vector<int64_t> data2_;
-	vector<int64_t>::iterator idx2_;
+	SumBuffer data2_;
+	SumBuffer::iterator idx2_;
 };
 
-template <class T>
-void Accumulator::accumulate(const Innovative::AccessDatagram<T> & buffer) {
+template <class B>
+void Accumulator::accumulate(const B & buffer) {
     //TODO: worry about performance, cache-friendly etc.
-    LOG(plog::debug) << "Accumulating data...";
-    LOG(plog::debug) << "recordLength_ = " << recordLength_ << "; idx_ = " << std::distance(data_.begin(), idx_) << "; recordsTaken = " << recordsTaken;
-    LOG(plog::debug) << "New buffer size is " << buffer.size();
-    LOG(plog::debug) << "Accumulator buffer size is " << data_.size();
+    X6_LOG(plog::debug) << "Accumulating data...";
+    X6_LOG(plog::debug) << "recordLength_ = " << recordLength_ << "; idx_ = " << std::distance(data_.begin(), idx_) << "; recordsTaken = " << recordsTaken;
+    X6_LOG(plog::debug) << "New buffer size is " << buffer.size();
+    X6_LOG(plog::debug) << "Accumulator buffer size is " << data_.size();
 
     // The assumption is that this will be called with a full record size
     // Accumulate the buffer into data_
@@ -72,16 +77,14 @@ void Accumulator::accumulate(const Innovative::AccessDatagram<T> & buffer) {
         });
     } else {
         // data is complex: real/imaginary are interleaved every other point
-        // form a complex vector from the input buffer
-        vector<std::complex<int64_t>> cvec(recordLength_/2);
-        for (size_t i = 0; i < recordLength_/2; i++) {
-            cvec[i] = std::complex<int64_t>(buffer[2*i], buffer[2*i+1]);
-        }
         // calculate 3-component correlations into a triple of successive points
-        for (size_t i = 0; i < cvec.size(); i++) {
-            idx2_[3*i] += cvec[i].real() * cvec[i].real();
-            idx2_[3*i+1] += cvec[i].imag() * cvec[i].imag();
-            idx2_[3*i+2] += cvec[i].real() * cvec[i].imag();
+        // straight from the buffer rather than through a temporary per record
+        for (size_t i = 0; i < recordLength_/2; i++) {
+            int64_t re = buffer[2*i];
+            int64_t im = buffer[2*i+1];
+            idx2_[3*i] += re * re;
+            idx2_[3*i+1] += im * im;
+            idx2_[3*i+2] += re * im;
         }
     }
     recordsTaken++;
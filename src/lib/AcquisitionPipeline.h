@@ -0,0 +1,342 @@
+// AcquisitionPipeline.h
+//
+// Staged data path from DMA receive to accumulation. The receive stage only
+// takes ownership of buffers and queues them; a parse thread demultiplexes
+// them into batches of records and a process thread hands those to the
+// record handler. Batches can then be handed to a consumer, either on the
+// process thread or on a consume thread of its own.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef ACQUISITIONPIPELINE_H_
+#define ACQUISITIONPIPELINE_H_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+using std::vector;
+
+#include "BufferPool.h"
+#include "PipelineStage.h"
+#include "VitaDemux.h"
+#include "X6_enums.h"
+#include "X6_errno.h"
+
+template <class Buffer>
+class AcquisitionPipeline {
+public:
+	typedef std::shared_ptr<Buffer> BufferPtr;
+	typedef VitaDemux::RecordHandler RecordHandler;
+	// called on the process thread after each batch of records
+	typedef std::function<void()> BatchHandler;
+	// called on each worker thread as it starts, e.g. to set its affinity
+	typedef std::function<void(X6_PIPELINE_STAGE)> ThreadInit;
+
+	explicit AcquisitionPipeline(VitaDemux &);
+	~AcquisitionPipeline();
+
+	void set_depth(size_t);
+	void set_record_handler(RecordHandler);
+	void set_batch_handler(BatchHandler);
+	void set_thread_init(ThreadInit);
+	void set_consumer(RecordHandler, BatchHandler, bool);
+
+	void start();
+	void request_stop();
+	void stop();
+	BufferPtr acquire_buffer();
+	bool receive(BufferPtr, const uint32_t *, size_t);
+
+	bool is_worker_thread() const;
+	PipelineStats get_stats(X6_PIPELINE_STAGE) const;
+	BufferPoolStats get_buffer_pool_stats();
+
+private:
+	AcquisitionPipeline(const AcquisitionPipeline&) = delete;
+	AcquisitionPipeline& operator=(const AcquisitionPipeline&) = delete;
+
+	struct ReceivedBuffer {
+		BufferPtr buffer;
+		const uint32_t * words = nullptr;
+		size_t numWords = 0;
+	};
+
+	struct Record {
+		unsigned slot;
+		// points into the source buffer, or nullptr when copied to storage
+		const uint32_t * data;
+		size_t offset;
+		size_t numWords;
+		VitaHeader header;
+	};
+
+	struct RecordBatch {
+		void clear() {
+			buffer.reset();
+			records.clear();
+			storage.clear();
+		}
+
+		// keeps the received buffer alive until its records are processed
+		BufferPtr buffer;
+		vector<Record> records;
+		// records the demux assembled from several packets or buffers
+		vector<uint32_t> storage;
+	};
+
+	typedef std::shared_ptr<RecordBatch> BatchPtr;
+
+	void parse(ReceivedBuffer &);
+	void add_record(unsigned, const uint32_t *, size_t, const VitaHeader &);
+	void process(BatchPtr &);
+	void consume(BatchPtr &);
+
+	VitaDemux & demux_;
+	RecordHandler recordHandler_;
+	BatchHandler batchHandler_;
+
+	// receive buffers and record batches are recycled rather than allocated;
+	// declared ahead of the stages so they outlive anything still queued
+	BufferPool<Buffer> bufferPool_;
+	BufferPool<RecordBatch> batchPool_;
+
+	PipelineStage<ReceivedBuffer> parseStage_;
+	PipelineStage<BatchPtr> processStage_;
+	PipelineStage<BatchPtr> consumeStage_;
+	std::atomic<uint64_t> received_;
+
+	RecordHandler consumeRecordHandler_;
+	BatchHandler consumeBatchHandler_;
+	bool consumeThread_ = false;
+
+	// filled on the parse thread only
+	BatchPtr batch_;
+	const uint32_t * bufferBegin_ = nullptr;
+	const uint32_t * bufferEnd_ = nullptr;
+};
+
+template <class Buffer>
+AcquisitionPipeline<Buffer>::AcquisitionPipeline(VitaDemux & demux) :
+	demux_(demux), received_{0} {
+	// consumers see every record the process stage handled, even after stop
+	consumeStage_.set_drain_on_stop(true);
+}
+
+template <class Buffer>
+AcquisitionPipeline<Buffer>::~AcquisitionPipeline() {
+	stop();
+}
+
+template <class Buffer>
+void AcquisitionPipeline<Buffer>::set_depth(size_t depth) {
+	// number of buffers (and batches) each stage can have waiting
+	parseStage_.set_capacity(depth);
+	processStage_.set_capacity(depth);
+	consumeStage_.set_capacity(depth);
+}
+
+template <class Buffer>
+void AcquisitionPipeline<Buffer>::set_record_handler(RecordHandler handler) {
+	recordHandler_ = handler;
+}
+
+template <class Buffer>
+void AcquisitionPipeline<Buffer>::set_batch_handler(BatchHandler handler) {
+	batchHandler_ = handler;
+}
+
+template <class Buffer>
+void AcquisitionPipeline<Buffer>::set_thread_init(ThreadInit init) {
+	if (init) {
+		parseStage_.set_thread_init([init]() { init(PIPELINE_PARSE); });
+		processStage_.set_thread_init([init]() { init(PIPELINE_PROCESS); });
+		consumeStage_.set_thread_init([init]() { init(PIPELINE_CONSUME); });
+	} else {
+		parseStage_.set_thread_init(nullptr);
+		processStage_.set_thread_init(nullptr);
+		consumeStage_.set_thread_init(nullptr);
+	}
+}
+
+template <class Buffer>
+void AcquisitionPipeline<Buffer>::set_consumer(RecordHandler recordHandler, BatchHandler batchHandler, bool ownThread) {
+	/*
+	 * Only while stopped. The record handler is called for every record of a
+	 * batch and the batch handler after the last one, while the batch still
+	 * holds its receive buffer. With ownThread the calls come from the consume
+	 * thread, otherwise from the process thread after the record handler.
+	 */
+	consumeRecordHandler_ = recordHandler;
+	consumeBatchHandler_ = batchHandler;
+	consumeThread_ = ownThread && recordHandler;
+}
+
+template <class Buffer>
+void AcquisitionPipeline<Buffer>::start() {
+	received_ = 0;
+	batch_.reset();
+	// every stage can hold a full queue plus the item it is working on
+	size_t depth = parseStage_.get_stats().capacity;
+	size_t batchStages = consumeThread_ ? 2 : 1;
+	bufferPool_.reset_stats();
+	bufferPool_.reserve((batchStages + 1)*(depth + 1) + 1);
+	batchPool_.reset_stats();
+	batchPool_.reserve(batchStages*(depth + 1) + 1);
+	demux_.reset();
+	demux_.set_record_handler([this](unsigned slot, const uint32_t * data, size_t numWords, const VitaHeader & vh) {
+		add_record(slot, data, numWords, vh);
+	});
+	if (consumeThread_) {
+		consumeStage_.start([this](BatchPtr & batch) { consume(batch); });
+	}
+	processStage_.start([this](BatchPtr & batch) { process(batch); });
+	parseStage_.start([this](ReceivedBuffer & buffer) { parse(buffer); });
+}
+
+template <class Buffer>
+void AcquisitionPipeline<Buffer>::request_stop() {
+	// flags every stage without joining, so a receive or parse thread blocked
+	// on a full queue returns; safe from any thread
+	parseStage_.request_stop();
+	processStage_.request_stop();
+	consumeStage_.request_stop();
+}
+
+template <class Buffer>
+void AcquisitionPipeline<Buffer>::stop() {
+	// all stages are flagged before joining so a parse thread blocked on a
+	// full process queue can exit
+	request_stop();
+	parseStage_.stop();
+	processStage_.stop();
+	// finishes the batches already queued for it first
+	consumeStage_.stop();
+}
+
+template <class Buffer>
+typename AcquisitionPipeline<Buffer>::BufferPtr AcquisitionPipeline<Buffer>::acquire_buffer() {
+	// a receive buffer no stage still holds
+	return bufferPool_.acquire();
+}
+
+template <class Buffer>
+bool AcquisitionPipeline<Buffer>::receive(BufferPtr buffer, const uint32_t * words, size_t numWords) {
+	/*
+	 * Receive stage: runs on the driver's event thread and does nothing but
+	 * queue the buffer, blocking only if the parse stage has fallen a full
+	 * queue behind. Returns false once the pipeline has been stopped.
+	 */
+	ReceivedBuffer item;
+	item.buffer = buffer;
+	item.words = words;
+	item.numWords = numWords;
+	received_++;
+	return parseStage_.push(std::move(item));
+}
+
+template <class Buffer>
+bool AcquisitionPipeline<Buffer>::is_worker_thread() const {
+	return parseStage_.is_worker_thread() || processStage_.is_worker_thread() ||
+		consumeStage_.is_worker_thread();
+}
+
+template <class Buffer>
+PipelineStats AcquisitionPipeline<Buffer>::get_stats(X6_PIPELINE_STAGE stage) const {
+	switch (stage) {
+		case PIPELINE_RECEIVE: {
+			// the receive stage has no queue of its own; report what it handed on
+			PipelineStats stats = parseStage_.get_stats();
+			stats.processed = received_;
+			return stats;
+		}
+		case PIPELINE_PARSE:
+			return parseStage_.get_stats();
+		case PIPELINE_PROCESS:
+			return processStage_.get_stats();
+		case PIPELINE_CONSUME:
+			return consumeStage_.get_stats();
+		default:
+			throw X6_INVALID_ARGUMENT;
+	}
+}
+
+template <class Buffer>
+BufferPoolStats AcquisitionPipeline<Buffer>::get_buffer_pool_stats() {
+	return bufferPool_.get_stats();
+}
+
+template <class Buffer>
+void AcquisitionPipeline<Buffer>::parse(ReceivedBuffer & item) {
+	batch_ = batchPool_.acquire();
+	batch_->clear();
+	batch_->buffer = item.buffer;
+	bufferBegin_ = item.words;
+	bufferEnd_ = item.words + item.numWords;
+	demux_.parse(item.words, item.numWords);
+	// push only moves the batch out if the process stage accepted it
+	if (batch_->records.empty() || !processStage_.push(std::move(batch_))) {
+		batch_->clear();
+	}
+	batch_.reset();
+}
+
+template <class Buffer>
+void AcquisitionPipeline<Buffer>::add_record(unsigned slot, const uint32_t * data, size_t numWords, const VitaHeader & vh) {
+	Record record;
+	record.slot = slot;
+	record.numWords = numWords;
+	record.header = vh;
+	if (data >= bufferBegin_ && data + numWords <= bufferEnd_) {
+		record.data = data;
+		record.offset = 0;
+	} else {
+		// the demux reuses its staging memory, so keep a copy with the batch
+		record.data = nullptr;
+		record.offset = batch_->storage.size();
+		batch_->storage.insert(batch_->storage.end(), data, data + numWords);
+	}
+	batch_->records.push_back(record);
+}
+
+template <class Buffer>
+void AcquisitionPipeline<Buffer>::process(BatchPtr & batch) {
+	for (auto & record : batch->records) {
+		const uint32_t * data = record.data ? record.data : batch->storage.data() + record.offset;
+		if (recordHandler_) {
+			recordHandler_(record.slot, data, record.numWords, record.header);
+		}
+	}
+	if (consumeThread_) {
+		// the consume thread releases the buffer once the consumer is done
+		BatchPtr queued = batch;
+		if (!consumeStage_.push(std::move(queued))) {
+			batch->buffer.reset();
+		}
+	} else {
+		if (consumeRecordHandler_) {
+			consume(batch);
+		}
+		// hand the receive buffer back to its pool before the batch goes back to its own
+		batch->buffer.reset();
+	}
+	if (batchHandler_) {
+		batchHandler_();
+	}
+}
+
+template <class Buffer>
+void AcquisitionPipeline<Buffer>::consume(BatchPtr & batch) {
+	for (auto & record : batch->records) {
+		const uint32_t * data = record.data ? record.data : batch->storage.data() + record.offset;
+		consumeRecordHandler_(record.slot, data, record.numWords, record.header);
+	}
+	if (consumeBatchHandler_) {
+		consumeBatchHandler_();
+	}
+	batch->buffer.reset();
+}
+
+#endif // ACQUISITIONPIPELINE_H_
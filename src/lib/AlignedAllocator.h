@@ -0,0 +1,81 @@
+// AlignedAllocator.h
+//
+// Standard library allocator returning memory aligned to a fixed boundary,
+// e.g. so per-stream state handled by different threads lands on separate
+// cache lines.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef ALIGNEDALLOCATOR_H_
+#define ALIGNEDALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+const size_t CACHE_LINE_SIZE = 64;
+
+template <class T, size_t Alignment = CACHE_LINE_SIZE>
+class AlignedAllocator {
+public:
+	typedef T value_type;
+	typedef T * pointer;
+	typedef const T * const_pointer;
+	typedef T & reference;
+	typedef const T & const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	template <class U>
+	struct rebind {
+		typedef AlignedAllocator<U, Alignment> other;
+	};
+
+	AlignedAllocator() {}
+	template <class U>
+	AlignedAllocator(const AlignedAllocator<U, Alignment> &) {}
+
+	T * allocate(size_t n) {
+		if (n == 0) {
+			return nullptr;
+		}
+		void * ptr = nullptr;
+	#ifdef _WIN32
+		ptr = _aligned_malloc(n * sizeof(T), Alignment);
+	#else
+		if (posix_memalign(&ptr, Alignment, n * sizeof(T)) != 0) {
+			ptr = nullptr;
+		}
+	#endif
+		if (!ptr) {
+			throw std::bad_alloc();
+		}
+		return static_cast<T *>(ptr);
+	}
+
+	void deallocate(T * ptr, size_t) {
+	#ifdef _WIN32
+		_aligned_free(ptr);
+	#else
+		free(ptr);
+	#endif
+	}
+};
+
+template <class T, class U, size_t Alignment>
+bool operator==(const AlignedAllocator<T, Alignment> &, const AlignedAllocator<U, Alignment> &) {
+	return true;
+}
+
+template <class T, class U, size_t Alignment>
+bool operator!=(const AlignedAllocator<T, Alignment> &, const AlignedAllocator<U, Alignment> &) {
+	return false;
+}
+
+#endif // ALIGNEDALLOCATOR_H_
@@ -0,0 +1,192 @@
+// AsyncFileAppender.h
+//
+// plog appender that formats records on the logging thread, queues the text
+// in a bounded lock-free ring and writes it to a set of rolling files from a
+// background thread, so logging from the acquisition threads never waits on
+// disk or on a lock. Lines that do not fit in the ring are dropped and
+// counted rather than blocking the caller.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef ASYNCFILEAPPENDER_H_
+#define ASYNCFILEAPPENDER_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include <plog/Log.h>
+
+#include "MPMCQueue.h"
+
+template <class Formatter>
+class AsyncFileAppender : public plog::IAppender {
+public:
+	typedef plog::util::nstring Line;
+
+	AsyncFileAppender(const char * fileName, size_t maxFileSize = 0, int maxFiles = 0, size_t capacity = 8192);
+	virtual ~AsyncFileAppender();
+
+	virtual void write(const plog::Record & record);
+
+	void flush();
+	uint64_t get_dropped() const { return dropped_; }
+	uint64_t get_written() const { return written_; }
+
+private:
+	AsyncFileAppender(const AsyncFileAppender&) = delete;
+	AsyncFileAppender& operator=(const AsyncFileAppender&) = delete;
+
+	void run();
+	void write_line(const Line &);
+	void open_file();
+	void roll_files();
+	std::string file_name(int) const;
+
+	MPMCQueue<Line> ring_;
+	std::atomic<bool> running_;
+	std::atomic<uint64_t> queued_;
+	std::atomic<uint64_t> written_;
+	std::atomic<uint64_t> dropped_;
+	uint64_t droppedReported_ = 0;
+
+	std::string fileBase_;
+	std::string fileExt_;
+	size_t maxFileSize_;
+	int maxFiles_;
+	std::basic_ofstream<Line::value_type> file_;
+	size_t fileSize_ = 0;
+
+	std::thread writer_;
+};
+
+template <class Formatter>
+AsyncFileAppender<Formatter>::AsyncFileAppender(const char * fileName, size_t maxFileSize, int maxFiles, size_t capacity) :
+	ring_(capacity), running_{true}, queued_{0}, written_{0}, dropped_{0},
+	maxFileSize_(maxFileSize), maxFiles_(maxFiles) {
+	// split "libx6.log" so rolled files are named "libx6.1.log", "libx6.2.log", ...
+	std::string name(fileName);
+	size_t dot = name.find_last_of('.');
+	size_t slash = name.find_last_of("/\\");
+	if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+		fileBase_ = name.substr(0, dot);
+		fileExt_ = name.substr(dot);
+	} else {
+		fileBase_ = name;
+	}
+	writer_ = std::thread(&AsyncFileAppender::run, this);
+}
+
+template <class Formatter>
+AsyncFileAppender<Formatter>::~AsyncFileAppender() {
+	running_ = false;
+	if (writer_.joinable()) {
+		writer_.join();
+	}
+}
+
+template <class Formatter>
+void AsyncFileAppender<Formatter>::write(const plog::Record & record) {
+	// format here so the timestamp and thread ID are those of the caller
+	Line line = Formatter::format(record);
+	if (ring_.push(std::move(line))) {
+		queued_++;
+	} else {
+		dropped_++;
+	}
+}
+
+template <class Formatter>
+void AsyncFileAppender<Formatter>::flush() {
+	// wait for the writer to catch up with everything queued so far
+	uint64_t target = queued_;
+	while (running_ && written_ < target) {
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+}
+
+template <class Formatter>
+void AsyncFileAppender<Formatter>::run() {
+	Line line;
+	for (;;) {
+		bool wasRunning = running_;
+		bool wroteAny = false;
+		while (ring_.pop(line)) {
+			write_line(line);
+			written_++;
+			wroteAny = true;
+		}
+		uint64_t dropped = dropped_;
+		if (dropped != droppedReported_) {
+			std::string note = "AsyncFileAppender: dropped " + std::to_string(dropped - droppedReported_) +
+				" log lines; the log ring was full\n";
+			write_line(Line(note.begin(), note.end()));
+			droppedReported_ = dropped;
+			wroteAny = true;
+		}
+		if (wroteAny) {
+			file_.flush();
+		}
+		if (!wasRunning) {
+			// the ring was drained after the stop request was seen
+			break;
+		}
+		if (!wroteAny) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+}
+
+template <class Formatter>
+void AsyncFileAppender<Formatter>::write_line(const Line & line) {
+	size_t lineBytes = line.size() * sizeof(typename Line::value_type);
+	if (file_.is_open() && maxFileSize_ > 0 && fileSize_ + lineBytes > maxFileSize_) {
+		file_.close();
+		roll_files();
+	}
+	if (!file_.is_open()) {
+		open_file();
+	}
+	file_ << line;
+	fileSize_ += lineBytes;
+}
+
+template <class Formatter>
+void AsyncFileAppender<Formatter>::open_file() {
+	file_.open(file_name(0), std::ios::out | std::ios::app);
+	file_.seekp(0, std::ios::end);
+	std::streamoff pos = file_.tellp();
+	fileSize_ = pos > 0 ? static_cast<size_t>(pos) : 0;
+	if (fileSize_ == 0) {
+		Line header = Formatter::header();
+		file_ << header;
+		fileSize_ += header.size() * sizeof(typename Line::value_type);
+	}
+}
+
+template <class Formatter>
+void AsyncFileAppender<Formatter>::roll_files() {
+	if (maxFiles_ <= 1) {
+		std::remove(file_name(0).c_str());
+		return;
+	}
+	std::remove(file_name(maxFiles_ - 1).c_str());
+	for (int ct = maxFiles_ - 2; ct >= 0; ct--) {
+		std::rename(file_name(ct).c_str(), file_name(ct + 1).c_str());
+	}
+}
+
+template <class Formatter>
+std::string AsyncFileAppender<Formatter>::file_name(int index) const {
+	if (index == 0) {
+		return fileBase_ + fileExt_;
+	}
+	return fileBase_ + "." + std::to_string(index) + fileExt_;
+}
+
+#endif // ASYNCFILEAPPENDER_H_
@@ -0,0 +1,67 @@
+// BankQueue.cpp
+//
+// Bookkeeping for double-buffered acquisitions, where the stream state comes
+// in two banks that successive acquisitions fill in turn.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#include "BankQueue.h"
+
+#include "X6_errno.h"
+#include "logging.h"
+
+BankQueue::BankQueue() :
+    numStreams_{0}, filled_{{0, 0}}, completed_{0}, closed_{true}, released_{0} {}
+
+void BankQueue::reset(size_t numStreams) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    numStreams_ = numStreams;
+    filled_ = {{0, 0}};
+    completed_ = 0;
+    closed_ = false;
+    released_ = 0;
+}
+
+void BankQueue::stream_filled(size_t n) {
+    size_t & filled = filled_[n % 2];
+    if (++filled < numStreams_) {
+        return;
+    }
+    // the acquisition after next in this bank cannot start before this one
+    // is released, so the count is free to reuse
+    filled = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        completed_++;
+    }
+    cv_.notify_all();
+}
+
+size_t BankQueue::num_ready() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return completed_ - released_;
+}
+
+bool BankQueue::wait_until(const std::chrono::system_clock::time_point & end) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_until(lock, end, [this]{ return closed_ || completed_ > released_; });
+}
+
+void BankQueue::release() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (completed_ == released_) {
+        LOG(plog::error) << "No filled bank to release";
+        throw X6_MODE_ERROR;
+    }
+    released_.fetch_add(1, std::memory_order_release);
+}
+
+void BankQueue::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+    }
+    cv_.notify_all();
+}
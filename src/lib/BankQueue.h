@@ -0,0 +1,63 @@
+// BankQueue.h
+//
+// Bookkeeping for double-buffered acquisitions, where the stream state comes
+// in two banks that successive acquisitions fill in turn. Streams move on to
+// the other bank as they fill their part of one; a bank is handed to the
+// client once every stream has filled it and may be filled again once the
+// client releases it.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef BANKQUEUE_H_
+#define BANKQUEUE_H_
+
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <cstddef>
+
+class BankQueue {
+public:
+	BankQueue();
+
+	void reset(size_t);
+
+	// data handling thread: a stream has filled its part of acquisition n,
+	// which occupies bank n % 2
+	void stream_filled(size_t);
+	// whether acquisition n may start, i.e. the client released the one
+	// before it in the same bank
+	bool may_start(size_t n) const { return n < released_.load(std::memory_order_acquire) + 2; }
+
+	// filled acquisitions the client has not released yet
+	size_t num_ready();
+	// bank of the oldest unreleased acquisition
+	unsigned front_bank() const { return released_.load(std::memory_order_relaxed) % 2; }
+	// blocks until an acquisition is ready or the queue is closed
+	bool wait_until(const std::chrono::system_clock::time_point &);
+	// the client is done with the front acquisition, whose bank must have
+	// been cleared already
+	void release();
+	void close();
+
+private:
+	BankQueue(const BankQueue&) = delete;
+	BankQueue& operator=(const BankQueue&) = delete;
+
+	size_t numStreams_;
+	// streams done with the acquisition in each bank; only touched by the
+	// data handling thread
+	std::array<size_t, 2> filled_;
+
+	std::mutex mutex_;
+	std::condition_variable cv_;
+	size_t completed_;
+	bool closed_;
+	std::atomic<size_t> released_;
+};
+
+#endif // BANKQUEUE_H_
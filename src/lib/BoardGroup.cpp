@@ -0,0 +1,174 @@
+// BoardGroup.cpp
+//
+// Acquires with several X6 boards as one: arms them all in parallel, waits on
+// all of them with one call and transfers their data concurrently into a
+// single buffer, with one worker thread per board.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#include "BoardGroup.h"
+
+#include <algorithm>
+
+#include "logging.h"
+
+BoardGroup::BoardGroup(const vector<int> & deviceIDs, const vector<X6_1000 *> & boards) :
+    deviceIDs_(deviceIDs), boards_(boards), workers_(boards.size()) {
+    if (boards_.empty() || boards_.size() != deviceIDs_.size()) {
+        LOG(plog::error) << "A board group needs at least one board";
+        throw X6_INVALID_ARGUMENT;
+    }
+}
+
+BoardGroup::~BoardGroup() {
+    for (auto & corr : correlators_) {
+        for (auto board : boards_) {
+            try {
+                board->detach_cross_correlator(corr.get());
+            }
+            catch (X6_STATUS) {
+                // the board is still running; stop it rather than leave it
+                // feeding a correlator that is about to go away
+                board->stop();
+                board->detach_cross_correlator(corr.get());
+            }
+        }
+    }
+}
+
+bool BoardGroup::contains(int deviceID) const {
+    return std::find(deviceIDs_.begin(), deviceIDs_.end(), deviceID) != deviceIDs_.end();
+}
+
+void BoardGroup::check(const vector<X6_STATUS> & statuses, const char * what) {
+    for (size_t ct = 0; ct < statuses.size(); ct++) {
+        if (statuses[ct] != X6_OK) {
+            LOG(plog::error) << what << " failed on board " << deviceIDs_[ct] << " with status " << statuses[ct];
+            throw statuses[ct];
+        }
+    }
+}
+
+void BoardGroup::acquire() {
+    for (size_t ct = 0; ct < correlators_.size(); ct++) {
+        X6_1000 * board = boards_[correlatorBoards_[ct]];
+        correlators_[ct]->reset(board->get_num_segments(), board->get_num_waveforms(), board->get_num_records());
+    }
+    vector<X6_STATUS> statuses = workers_.run([this](size_t board) {
+        boards_[board]->acquire();
+    });
+    bool failed = std::any_of(statuses.begin(), statuses.end(), [](X6_STATUS s) { return s != X6_OK; });
+    if (failed) {
+        // leave no board of the group running on its own
+        workers_.run([this, &statuses](size_t board) {
+            if (statuses[board] == X6_OK) {
+                boards_[board]->stop();
+            }
+        });
+    }
+    check(statuses, "Group acquire");
+}
+
+void BoardGroup::wait_for_acquisition(unsigned timeOut) {
+    // the boards share the one timeout since they all wait at once
+    check(workers_.run([this, timeOut](size_t board) {
+        boards_[board]->wait_for_acquisition(timeOut);
+    }), "Group wait for acquisition");
+}
+
+void BoardGroup::stop() {
+    check(workers_.run([this](size_t board) {
+        boards_[board]->stop();
+    }), "Group stop");
+}
+
+vector<size_t> BoardGroup::get_buffer_sizes(vector<QDSPStream> & streams) {
+    vector<size_t> sizes(boards_.size());
+    for (size_t board = 0; board < boards_.size(); board++) {
+        sizes[board] = boards_[board]->get_buffer_size(streams);
+    }
+    return sizes;
+}
+
+void BoardGroup::transfer_stream(vector<QDSPStream> & streams, double * buffer, const vector<size_t> & sizes) {
+    if (sizes.size() != boards_.size()) {
+        LOG(plog::error) << "Group transfer needs one buffer size per board.";
+        throw X6_INVALID_ARGUMENT;
+    }
+    vector<size_t> offsets(boards_.size(), 0);
+    for (size_t board = 1; board < boards_.size(); board++) {
+        offsets[board] = offsets[board - 1] + sizes[board - 1];
+    }
+    check(workers_.run([&](size_t board) {
+        double * slice = buffer + offsets[board];
+        if (streams.size() == 1) {
+            boards_[board]->transfer_stream(streams[0], slice, sizes[board]);
+        } else {
+            boards_[board]->transfer_correlation(streams, slice, sizes[board]);
+        }
+    }), "Group transfer");
+}
+
+unsigned BoardGroup::add_correlator(const vector<int> & deviceIDs, const vector<QDSPStream> & streams,
+                                    X6_SHOT_ALIGNMENT alignment, uint64_t tolerance) {
+    if (deviceIDs.size() != streams.size()) {
+        LOG(plog::error) << "Cross-board correlator needs one device per stream";
+        throw X6_INVALID_ARGUMENT;
+    }
+    vector<size_t> inputBoards;
+    for (int id : deviceIDs) {
+        auto it = std::find(deviceIDs_.begin(), deviceIDs_.end(), id);
+        if (it == deviceIDs_.end()) {
+            LOG(plog::error) << "Board " << id << " is not in the group";
+            throw X6_INVALID_ARGUMENT;
+        }
+        inputBoards.push_back(it - deviceIDs_.begin());
+    }
+    std::unique_ptr<CrossBoardCorrelator> corr(new CrossBoardCorrelator(streams, alignment, tolerance));
+    try {
+        for (size_t input = 0; input < streams.size(); input++) {
+            boards_[inputBoards[input]]->attach_cross_correlator(streams[input], corr.get(), input);
+        }
+    }
+    catch (X6_STATUS) {
+        for (auto board : boards_) {
+            board->detach_cross_correlator(corr.get());
+        }
+        throw;
+    }
+    correlators_.push_back(std::move(corr));
+    correlatorBoards_.push_back(inputBoards[0]);
+    return correlators_.size() - 1;
+}
+
+CrossBoardCorrelator & BoardGroup::get_correlator(unsigned idx) {
+    if (idx >= correlators_.size()) {
+        LOG(plog::error) << "Board group has no correlator " << idx;
+        throw X6_INVALID_CHANNEL;
+    }
+    return *correlators_[idx];
+}
+
+size_t BoardGroup::get_correlator_size(unsigned idx) {
+    return get_correlator(idx).get_buffer_size();
+}
+
+void BoardGroup::transfer_correlation(unsigned idx, double * buffer, size_t length) {
+    CrossBoardCorrelator & corr = get_correlator(idx);
+    if (length < corr.get_buffer_size()) {
+        LOG(plog::error) << "Not enough memory allocated in buffer to transfer correlator.";
+        throw X6_INVALID_ARGUMENT;
+    }
+    corr.snapshot(buffer);
+}
+
+void BoardGroup::transfer_correlation_variance(unsigned idx, double * buffer, size_t length) {
+    CrossBoardCorrelator & corr = get_correlator(idx);
+    if (length < corr.get_variance_buffer_size()) {
+        LOG(plog::error) << "Not enough memory allocated in buffer to transfer correlator variance.";
+        throw X6_INVALID_ARGUMENT;
+    }
+    corr.snapshot_variance(buffer);
+}
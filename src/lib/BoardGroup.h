@@ -0,0 +1,61 @@
+// BoardGroup.h
+//
+// Acquires with several X6 boards as one: arms them all in parallel, waits on
+// all of them with one call and transfers their data concurrently into a
+// single buffer, with one worker thread per board.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef BOARDGROUP_H_
+#define BOARDGROUP_H_
+
+#include <memory>
+#include <vector>
+using std::vector;
+#include <cstddef>
+#include <cstdint>
+
+#include "X6_1000.h"
+#include "BoardWorkers.h"
+#include "CrossBoardCorrelator.h"
+
+class BoardGroup {
+public:
+	BoardGroup(const vector<int> &, const vector<X6_1000 *> &);
+	~BoardGroup();
+
+	const vector<int> & get_device_ids() const { return deviceIDs_; }
+	bool contains(int) const;
+
+	void acquire();
+	void wait_for_acquisition(unsigned);
+	void stop();
+
+	// buffer size of each board, in group order
+	vector<size_t> get_buffer_sizes(vector<QDSPStream> &);
+	// data of every board one after the other, each taking the given size
+	void transfer_stream(vector<QDSPStream> &, double *, const vector<size_t> &);
+
+	// correlators of result streams on different boards of the group, given
+	// as one device ID per stream; returns the correlator index
+	unsigned add_correlator(const vector<int> &, const vector<QDSPStream> &, X6_SHOT_ALIGNMENT, uint64_t);
+	size_t get_correlator_size(unsigned);
+	void transfer_correlation(unsigned, double *, size_t);
+	void transfer_correlation_variance(unsigned, double *, size_t);
+
+private:
+	// throws the status of the first board that failed
+	void check(const vector<X6_STATUS> &, const char *);
+	CrossBoardCorrelator & get_correlator(unsigned);
+
+	vector<int> deviceIDs_;
+	vector<X6_1000 *> boards_;
+	BoardWorkers workers_;
+	vector<std::unique_ptr<CrossBoardCorrelator>> correlators_;
+	// board of the first input of each correlator, whose settings it takes
+	vector<size_t> correlatorBoards_;
+};
+
+#endif // BOARDGROUP_H_
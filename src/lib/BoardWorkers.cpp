@@ -0,0 +1,73 @@
+// BoardWorkers.cpp
+//
+// One long-lived worker thread per board of a board group. A job runs on
+// every worker at once and returns when all of them are done, with the
+// status each board's part ended in.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#include "BoardWorkers.h"
+
+BoardWorkers::BoardWorkers(size_t numBoards) {
+    statuses_.assign(numBoards, X6_OK);
+    for (size_t board = 0; board < numBoards; board++) {
+        threads_.emplace_back(&BoardWorkers::work, this, board);
+    }
+}
+
+BoardWorkers::~BoardWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        quit_ = true;
+    }
+    start_.notify_all();
+    for (auto & thread : threads_) {
+        thread.join();
+    }
+}
+
+vector<X6_STATUS> BoardWorkers::run(const std::function<void(size_t)> & job) {
+    std::lock_guard<std::mutex> runLock(runMutex_);
+    std::unique_lock<std::mutex> lock(mutex_);
+    job_ = &job;
+    remaining_ = threads_.size();
+    statuses_.assign(threads_.size(), X6_OK);
+    generation_++;
+    start_.notify_all();
+    done_.wait(lock, [this]() { return remaining_ == 0; });
+    job_ = nullptr;
+    return statuses_;
+}
+
+void BoardWorkers::work(size_t board) {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        start_.wait(lock, [&]() { return quit_ || generation_ != seen; });
+        if (quit_) {
+            return;
+        }
+        seen = generation_;
+        const std::function<void(size_t)> & job = *job_;
+        lock.unlock();
+
+        X6_STATUS status = X6_OK;
+        try {
+            job(board);
+        }
+        catch (X6_STATUS err) {
+            status = err;
+        }
+        catch (...) {
+            status = X6_UNKNOWN_ERROR;
+        }
+
+        lock.lock();
+        statuses_[board] = status;
+        if (--remaining_ == 0) {
+            done_.notify_all();
+        }
+    }
+}
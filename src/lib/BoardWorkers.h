@@ -0,0 +1,56 @@
+// BoardWorkers.h
+//
+// One long-lived worker thread per board of a board group. A job runs on
+// every worker at once and returns when all of them are done, with the
+// status each board's part ended in.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef BOARDWORKERS_H_
+#define BOARDWORKERS_H_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+using std::vector;
+#include <cstddef>
+#include <cstdint>
+
+#include "X6_errno.h"
+
+class BoardWorkers {
+public:
+	BoardWorkers(size_t);
+	~BoardWorkers();
+
+	BoardWorkers(const BoardWorkers &) = delete;
+	BoardWorkers & operator=(const BoardWorkers &) = delete;
+
+	size_t size() const { return threads_.size(); }
+
+	// calls job(board) for every board on its own worker and waits for all
+	// of them; a thrown X6_STATUS becomes that board's status
+	vector<X6_STATUS> run(const std::function<void(size_t)> &);
+
+private:
+	void work(size_t);
+
+	vector<std::thread> threads_;
+	// serializes run() callers
+	std::mutex runMutex_;
+
+	std::mutex mutex_;
+	std::condition_variable start_;
+	std::condition_variable done_;
+	const std::function<void(size_t)> * job_ = nullptr;
+	uint64_t generation_ = 0;
+	size_t remaining_ = 0;
+	vector<X6_STATUS> statuses_;
+	bool quit_ = false;
+};
+
+#endif // BOARDWORKERS_H_
@@ -0,0 +1,207 @@
+// BufferPool.h
+//
+// Fixed set of reusable buffers handed out as reference-counted pointers. A
+// buffer goes back into circulation once every holder has released it, so
+// steady-state acquisition runs without allocating.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef BUFFERPOOL_H_
+#define BUFFERPOOL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include <cstddef>
+
+#include "MPMCQueue.h"
+#include "X6_enums.h"
+
+template <class T>
+class BufferPool {
+public:
+	typedef std::shared_ptr<T> Ptr;
+	typedef std::function<T *()> Factory;
+
+	static const size_t DEFAULT_MAX_BUFFERS = 1024;
+
+	BufferPool();
+	explicit BufferPool(Factory, size_t maxBuffers = DEFAULT_MAX_BUFFERS);
+
+	void reserve(size_t);
+	Ptr acquire();
+	void reset_stats();
+	BufferPoolStats get_stats();
+
+private:
+	BufferPool(const BufferPool&) = delete;
+	BufferPool& operator=(const BufferPool&) = delete;
+
+	// room for the control block of a shared_ptr with an empty deleter and a
+	// one pointer allocator
+	static const size_t CONTROL_BLOCK_SIZE = 64;
+
+	struct Slot {
+		std::unique_ptr<T> buffer;
+		BufferPool * pool;
+		typename std::aligned_storage<CONTROL_BLOCK_SIZE, alignof(std::max_align_t)>::type controlBlock;
+	};
+
+	// the buffer itself belongs to its slot
+	struct NoDelete {
+		void operator()(T *) const {}
+	};
+
+	// Places the control block of a handed out pointer in its slot, so
+	// acquire() does not allocate. The control block is deallocated after
+	// the last reference to it is gone, which is when the slot can go back on
+	// the free list.
+	template <class U>
+	struct SlotAllocator {
+		typedef U value_type;
+		template <class V>
+		struct rebind {
+			typedef SlotAllocator<V> other;
+		};
+
+		explicit SlotAllocator(Slot * slot) : slot(slot) {}
+		template <class V>
+		SlotAllocator(const SlotAllocator<V> & other) : slot(other.slot) {}
+
+		U * allocate(size_t n) {
+			static_assert(sizeof(U) <= CONTROL_BLOCK_SIZE, "shared_ptr control block does not fit its slot");
+			static_assert(alignof(U) <= alignof(std::max_align_t), "shared_ptr control block is over-aligned");
+			if (n != 1) {
+				throw std::bad_alloc();
+			}
+			return reinterpret_cast<U *>(&slot->controlBlock);
+		}
+		void deallocate(U *, size_t) {
+			slot->pool->release(slot);
+		}
+		template <class V>
+		bool operator==(const SlotAllocator<V> & other) const { return slot == other.slot; }
+		template <class V>
+		bool operator!=(const SlotAllocator<V> & other) const { return slot != other.slot; }
+
+		Slot * slot;
+	};
+
+	Slot * add_slot();
+	Slot * grow();
+	void release(Slot *);
+
+	Factory factory_;
+	const size_t maxBuffers_;
+	// guards growing the pool only; acquire() and release() are lock-free
+	std::mutex mutex_;
+	std::vector<std::unique_ptr<Slot>> slots_;
+	// buffers no one holds, returned by whichever thread drops the last reference
+	MPMCQueue<Slot *> free_;
+	std::atomic<uint64_t> capacity_;
+	std::atomic<uint64_t> inUse_;
+	std::atomic<uint64_t> highWater_;
+	std::atomic<uint64_t> allocations_;
+	std::atomic<uint64_t> acquisitions_;
+};
+
+template <class T>
+const size_t BufferPool<T>::DEFAULT_MAX_BUFFERS;
+
+template <class T>
+BufferPool<T>::BufferPool() : BufferPool([]() { return new T(); }) {}
+
+template <class T>
+BufferPool<T>::BufferPool(Factory factory, size_t maxBuffers) :
+	factory_{factory}, maxBuffers_{maxBuffers}, free_(maxBuffers), capacity_{0}, inUse_{0},
+	highWater_{0}, allocations_{0}, acquisitions_{0} {}
+
+template <class T>
+void BufferPool<T>::reserve(size_t count) {
+	// allocate up front, e.g. at acquire(), so the data path never has to
+	std::lock_guard<std::mutex> lock(mutex_);
+	while (slots_.size() < std::min(count, maxBuffers_)) {
+		Slot * slot = add_slot();
+		free_.push(std::move(slot));
+	}
+}
+
+template <class T>
+typename BufferPool<T>::Ptr BufferPool<T>::acquire() {
+	/*
+	 * Returns a buffer no one else holds. Contents are whatever the previous
+	 * user left so callers can keep capacity and clear what they need. Grows
+	 * the pool rather than waiting if every buffer is in use; past the
+	 * maximum size the extra buffer is allocated on its own and freed when
+	 * released.
+	 */
+	acquisitions_.fetch_add(1, std::memory_order_relaxed);
+	Slot * slot = nullptr;
+	// popping pairs with the push of the last holder before reusing its contents
+	if (!free_.pop(slot)) {
+		slot = grow();
+		if (!slot) {
+			allocations_++;
+			return Ptr(factory_());
+		}
+	}
+	uint64_t inUse = inUse_.fetch_add(1, std::memory_order_relaxed) + 1;
+	uint64_t highWater = highWater_.load(std::memory_order_relaxed);
+	while (inUse > highWater && !highWater_.compare_exchange_weak(highWater, inUse)) {}
+	return Ptr(slot->buffer.get(), NoDelete(), SlotAllocator<T>(slot));
+}
+
+template <class T>
+typename BufferPool<T>::Slot * BufferPool<T>::grow() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (slots_.size() >= maxBuffers_) {
+		return nullptr;
+	}
+	return add_slot();
+}
+
+template <class T>
+typename BufferPool<T>::Slot * BufferPool<T>::add_slot() {
+	// with mutex_ held
+	slots_.emplace_back(new Slot());
+	Slot * slot = slots_.back().get();
+	slot->buffer.reset(factory_());
+	slot->pool = this;
+	allocations_++;
+	capacity_ = slots_.size();
+	return slot;
+}
+
+template <class T>
+void BufferPool<T>::release(Slot * slot) {
+	// the free list holds up to maxBuffers_ slots, so this never fails
+	inUse_.fetch_sub(1, std::memory_order_relaxed);
+	free_.push(std::move(slot));
+}
+
+template <class T>
+void BufferPool<T>::reset_stats() {
+	highWater_ = inUse_.load();
+	acquisitions_ = 0;
+	allocations_ = 0;
+}
+
+template <class T>
+BufferPoolStats BufferPool<T>::get_stats() {
+	BufferPoolStats stats;
+	stats.capacity = capacity_;
+	stats.inUse = inUse_;
+	stats.highWater = highWater_;
+	stats.allocations = allocations_;
+	stats.acquisitions = acquisitions_;
+	return stats;
+}
+
+#endif // BUFFERPOOL_H_
@@ -31,6 +31,11 @@ Correlator::Correlator(const vector<QDSPStream> & streams, const size_t & numSeg
     }
 };
 
+int Correlator::get_buffer_index(const uint16_t & sid) const {
+    auto it = bufferSID_.find(sid);
+    return (it == bufferSID_.end()) ? -1 : it->second;
+}
+
 void Correlator::reset() {
     for (size_t i = 0; i < buffers_.size(); i++)
         buffers_[i].clear();
@@ -44,7 +49,7 @@ void Correlator::reset() {
 
 void Correlator::correlate() {
     vector<size_t> bufsizes(buffers_.size());
-    std::transform(buffers_.begin(), buffers_.end(), bufsizes.begin(), [](vector<int> b) {
+    std::transform(buffers_.begin(), buffers_.end(), bufsizes.begin(), [](const vector<int> & b) {
         return b.size();
     });
     size_t minsize = *std::min_element(bufsizes.begin(), bufsizes.end());
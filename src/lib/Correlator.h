@@ -24,8 +24,12 @@ class Correlator {
 public:
 	Correlator();
 	Correlator(const vector<QDSPStream> &, const size_t &, const size_t &);
-	template <class T>
-	void accumulate(const int &, const Innovative::AccessDatagram<T> &);
+	template <class B>
+	void accumulate(const int &, const B &);
+	// look up a stream's input index once, then accumulate by index
+	int get_buffer_index(const uint16_t &) const;
+	template <class B>
+	void accumulate_buffer(const int &, const B &);
 	void correlate();
 
 	void reset();
@@ -57,11 +61,15 @@ private:
 
 vector<vector<int>> combinations(int, int);
 
-template <class T>
-void Correlator::accumulate(const int & sid, const Innovative::AccessDatagram<T> & buffer) {
+template <class B>
+void Correlator::accumulate(const int & sid, const B & buffer) {
+    accumulate_buffer(bufferSID_[sid], buffer);
+}
+
+template <class B>
+void Correlator::accumulate_buffer(const int & index, const B & buffer) {
     // copy the data
-    for (size_t i = 0; i < buffer.size(); i++)
-        buffers_[bufferSID_[sid]].push_back(buffer[i]);
+    buffers_[index].insert(buffers_[index].end(), buffer.begin(), buffer.end());
     correlate();
 }
 
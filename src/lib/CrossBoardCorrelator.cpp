@@ -0,0 +1,174 @@
+// CrossBoardCorrelator.cpp
+//
+// Correlator for result streams read out on different boards. Records arrive
+// from each board's process thread, are aligned into shots by record index or
+// VITA timestamp, and the product of each shot is accumulated per segment
+// together with its second moments.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#include "CrossBoardCorrelator.h"
+
+#include <algorithm>
+
+#include "X6_errno.h"
+#include "logging.h"
+
+namespace {
+
+// VITA fractional timestamps count 5 ns ticks
+const uint64_t TICKS_PER_SECOND = 200000000;
+
+} // namespace
+
+CrossBoardCorrelator::CrossBoardCorrelator(const vector<QDSPStream> & inputs, X6_SHOT_ALIGNMENT alignment,
+                                           uint64_t tolerance) :
+    inputs_(inputs), alignment_{alignment}, tolerance_{tolerance} {
+    if (inputs_.size() < 2) {
+        LOG(plog::error) << "A cross-board correlator needs at least two inputs";
+        throw X6_INVALID_ARGUMENT;
+    }
+    for (auto & input : inputs_) {
+        if (input.type != RESULT || input.is_kernel_bank()) {
+            LOG(plog::error) << "Cross-board correlator inputs must be result streams";
+            throw X6_INVALID_CHANNEL;
+        }
+        inputScales_.push_back(1.0 / input.fixed_to_float());
+    }
+    if (alignment_ != ALIGN_RECORD_INDEX && alignment_ != ALIGN_TIMESTAMP) {
+        LOG(plog::error) << "Unknown shot alignment " << alignment_;
+        throw X6_INVALID_ARGUMENT;
+    }
+    pending_.resize(inputs_.size());
+    reset(1, 1, 0);
+}
+
+void CrossBoardCorrelator::reset(size_t numSegments, size_t numWaveforms, size_t maxRecords) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    numSegments_ = std::max<size_t>(numSegments, 1);
+    numWaveforms_ = std::max<size_t>(numWaveforms, 1);
+    maxRecords_ = maxRecords;
+    for (auto & shots : pending_) {
+        shots.clear();
+    }
+    lastKey_.assign(inputs_.size(), 0);
+    sameKeyCount_.assign(inputs_.size(), 0);
+    data_.assign(2 * numSegments_, 0);
+    data2_.assign(3 * numSegments_, 0);
+    recordsTaken_ = 0;
+    unmatched_ = 0;
+}
+
+void CrossBoardCorrelator::push(const int & index, const complex<double> & value, uint64_t recordIndex,
+                                const VitaHeader & vh) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (recordsTaken_ >= maxRecords_) {
+        return;
+    }
+    Shot shot;
+    shot.value = value;
+    if (alignment_ == ALIGN_RECORD_INDEX) {
+        shot.key = recordIndex;
+        shot.sub = 0;
+    } else {
+        // a packet carries several result records under one timestamp, so
+        // they are told apart by their order within it
+        shot.key = vh.timestampSeconds * TICKS_PER_SECOND + vh.timestampFractional;
+        if (sameKeyCount_[index] > 0 && shot.key == lastKey_[index]) {
+            shot.sub = sameKeyCount_[index]++;
+        } else {
+            lastKey_[index] = shot.key;
+            sameKeyCount_[index] = 1;
+            shot.sub = 0;
+        }
+    }
+    pending_[index].push_back(shot);
+    correlate();
+}
+
+bool CrossBoardCorrelator::before(const Shot & a, const Shot & b) const {
+    if (alignment_ == ALIGN_TIMESTAMP) {
+        uint64_t diff = (a.key > b.key) ? a.key - b.key : b.key - a.key;
+        if (diff <= tolerance_) {
+            return a.sub < b.sub;
+        }
+    }
+    return a.key < b.key;
+}
+
+void CrossBoardCorrelator::correlate() {
+    auto ready = [this]() {
+        return std::none_of(pending_.begin(), pending_.end(), [](const std::deque<Shot> & q) { return q.empty(); });
+    };
+    while (recordsTaken_ < maxRecords_ && ready()) {
+        // shots behind the latest front have no partner on that input
+        const Shot * latest = &pending_[0].front();
+        for (auto & shots : pending_) {
+            if (before(*latest, shots.front())) {
+                latest = &shots.front();
+            }
+        }
+        Shot target = *latest;
+        bool dropped = false;
+        for (auto & shots : pending_) {
+            while (!shots.empty() && before(shots.front(), target)) {
+                shots.pop_front();
+                unmatched_++;
+                dropped = true;
+            }
+        }
+        if (dropped) {
+            continue;
+        }
+
+        complex<double> product = 1;
+        for (auto & shots : pending_) {
+            product *= shots.front().value;
+            shots.pop_front();
+        }
+        size_t segment = (recordsTaken_ / numWaveforms_) % numSegments_;
+        data_[2*segment] += product.real();
+        data_[2*segment + 1] += product.imag();
+        data2_[3*segment] += product.real() * product.real();
+        data2_[3*segment + 1] += product.imag() * product.imag();
+        data2_[3*segment + 2] += product.real() * product.imag();
+        recordsTaken_++;
+    }
+}
+
+size_t CrossBoardCorrelator::get_records_taken() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return recordsTaken_;
+}
+
+size_t CrossBoardCorrelator::get_unmatched() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return unmatched_;
+}
+
+void CrossBoardCorrelator::snapshot(double * buf) {
+    /* Copies the mean product of each segment into a *preallocated* buffer */
+    std::lock_guard<std::mutex> lock(mutex_);
+    double N = std::max<size_t>(recordsTaken_ / numSegments_, 1);
+    for (size_t ct = 0; ct < data_.size(); ct++) {
+        buf[ct] = data_[ct] / N;
+    }
+}
+
+void CrossBoardCorrelator::snapshot_variance(double * buf) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    double N = static_cast<double>(recordsTaken_ / numSegments_);
+    for (size_t seg = 0; seg < numSegments_; seg++) {
+        if (N < 2) {
+            std::fill(buf + 3*seg, buf + 3*seg + 3, 0.0);
+            continue;
+        }
+        double re = data_[2*seg];
+        double im = data_[2*seg + 1];
+        buf[3*seg] = (data2_[3*seg] - re*re/N) / (N-1);
+        buf[3*seg + 1] = (data2_[3*seg + 1] - im*im/N) / (N-1);
+        buf[3*seg + 2] = (data2_[3*seg + 2] - re*im/N) / (N-1);
+    }
+}
@@ -0,0 +1,90 @@
+// CrossBoardCorrelator.h
+//
+// Correlator for result streams read out on different boards. Records arrive
+// from each board's process thread, are aligned into shots by record index or
+// VITA timestamp, and the product of each shot is accumulated per segment
+// together with its second moments.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef CROSSBOARDCORRELATOR_H_
+#define CROSSBOARDCORRELATOR_H_
+
+#include <complex>
+using std::complex;
+#include <deque>
+#include <mutex>
+#include <vector>
+using std::vector;
+#include <cstddef>
+#include <cstdint>
+
+#include "QDSPStream.h"
+#include "VitaHeader.h"
+#include "X6_enums.h"
+
+class CrossBoardCorrelator {
+public:
+	// inputs are result streams, one per board; the tolerance is in VITA
+	// fractional timestamp ticks and only applies to timestamp alignment
+	CrossBoardCorrelator(const vector<QDSPStream> &, X6_SHOT_ALIGNMENT, uint64_t);
+
+	size_t get_num_inputs() const { return inputs_.size(); }
+	const QDSPStream & get_input(size_t idx) const { return inputs_[idx]; }
+
+	void reset(size_t, size_t, size_t);
+	// may be called concurrently from the process threads of different boards
+	template <class B>
+	void add_record(const int &, const B &, uint64_t, const VitaHeader &);
+
+	size_t get_buffer_size() const { return 2 * numSegments_; }
+	size_t get_variance_buffer_size() const { return 3 * numSegments_; }
+	void snapshot(double *);
+	void snapshot_variance(double *);
+
+	size_t get_records_taken();
+	// records dropped because another input never delivered their shot
+	size_t get_unmatched();
+
+private:
+	struct Shot {
+		uint64_t key;    // record index or timestamp
+		uint64_t sub;    // position among records sharing a timestamp
+		complex<double> value;
+	};
+
+	void push(const int &, const complex<double> &, uint64_t, const VitaHeader &);
+	bool before(const Shot &, const Shot &) const;
+	void correlate();
+
+	vector<QDSPStream> inputs_;
+	vector<double> inputScales_;
+	X6_SHOT_ALIGNMENT alignment_;
+	uint64_t tolerance_;
+
+	std::mutex mutex_;
+	vector<std::deque<Shot>> pending_;
+	// last timestamp seen on each input and how many records carried it
+	vector<uint64_t> lastKey_;
+	vector<uint64_t> sameKeyCount_;
+
+	size_t numSegments_ = 1;
+	size_t numWaveforms_ = 1;
+	size_t maxRecords_ = 0;
+	size_t recordsTaken_ = 0;
+	size_t unmatched_ = 0;
+	// sum of the shot products, interleaved real/imaginary per segment
+	vector<double> data_;
+	// sums of re*re, im*im and re*im of the products per segment
+	vector<double> data2_;
+};
+
+template <class B>
+void CrossBoardCorrelator::add_record(const int & index, const B & buffer, uint64_t recordIndex, const VitaHeader & vh) {
+	double scale = inputScales_[index];
+	push(index, complex<double>(buffer[0] * scale, buffer[1] * scale), recordIndex, vh);
+}
+
+#endif // CROSSBOARDCORRELATOR_H_
@@ -0,0 +1,166 @@
+// DSPShadow.cpp
+//
+// In-memory copy of the geometry and configuration registers of one DSP
+// module.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#include "DSPShadow.h"
+
+#include "constants.h"
+#include "logging.h"
+#include "helpers.h"
+#include "X6_errno.h"
+
+// the stream enable register has a bit per stream, which bounds the geometry
+static const uint32_t MAX_DSP_STREAMS = 32;
+
+DSPLayout::DSPLayout(uint32_t numRawKi, uint32_t numDemod) :
+    numRawKi(numRawKi), numDemod(numDemod),
+    demodKernelLength(WB_QDSP_DEMOD_KERNEL_LENGTH(numRawKi,numDemod)),
+    rawKernelAddrData(WB_QDSP_RAW_KERNEL_ADDR_DATA(numRawKi,numDemod)),
+    demodKernelAddrData(WB_QDSP_DEMOD_KERNEL_ADDR_DATA(numRawKi,numDemod)),
+    threshold(WB_QDSP_THRESHOLD(numRawKi,numDemod)),
+    phaseInc(WB_QDSP_PHASE_INC(numRawKi,numDemod)),
+    thresholdInvert(WB_QDSP_THRESHOLD_INVERT(numRawKi,numDemod)),
+    thresholdInputSel(WB_QDSP_THRESHOLD_INPUT_SEL(numRawKi,numDemod)),
+    rawKernelBias(WB_QDSP_RAW_KERNEL_BIAS(numRawKi,numDemod)),
+    demodKernelBias(WB_QDSP_DEMOD_KERNEL_BIAS(numRawKi,numDemod)),
+    correlatorSizeReg(WB_QDSP_CORRELATOR_SIZE(numRawKi,numDemod)),
+    correlatorMAddr(WB_QDSP_CORRELATOR_M_ADDR(numRawKi,numDemod)),
+    correlatorMData(WB_QDSP_CORRELATOR_M_DATA(numRawKi,numDemod)),
+    correlatorSel(WB_QDSP_CORRELATOR_SEL(numRawKi,numDemod)) {}
+
+void DSPShadow::load(uint32_t base, const Executor & execute) {
+    clear();
+
+    // the geometry places everything else
+    uint32_t numRawKi = 0, numDemod = 0;
+    RegisterBatch geometry;
+    geometry.read(base, WB_QDSP_NUM_RAW_KI, &numRawKi);
+    geometry.read(base, WB_QDSP_NUM_DEMOD, &numDemod);
+    execute(geometry);
+    if (numRawKi > MAX_DSP_STREAMS || numDemod > MAX_DSP_STREAMS) {
+        LOG(plog::error) << "DSP at " << hexn<4> << base << std::dec << " reports " << numRawKi
+                         << " raw streams and " << numDemod << " demod streams";
+        throw X6_MODULE_ERROR;
+    }
+    DSPLayout layout(numRawKi, numDemod);
+
+    uint32_t correlatorSize = 0;
+    RegisterBatch correlator;
+    correlator.read(base, layout.correlatorSizeReg, &correlatorSize);
+    execute(correlator);
+    if (correlatorSize > MAX_DSP_STREAMS) {
+        LOG(plog::error) << "DSP at " << hexn<4> << base << std::dec << " reports a correlator of size " << correlatorSize;
+        throw X6_MODULE_ERROR;
+    }
+    layout.correlatorSize = correlatorSize;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    base_ = base;
+    layout_ = layout;
+    values_.assign(layout.correlatorSel + correlatorSize, 0);
+    kinds_.assign(values_.size(), NOT_SHADOWED);
+
+    shadow(WB_QDSP_MODULE_FIRMWARE_VERSION, 1, CONSTANT);
+    shadow(WB_QDSP_MODULE_FIRMWARE_GIT_SHA1, 1, CONSTANT);
+    shadow(WB_QDSP_MODULE_FIRMWARE_BUILD_TIMESTAMP, 1, CONSTANT);
+    shadow(WB_QDSP_NUM_RAW_KI, 1, CONSTANT);
+    shadow(WB_QDSP_NUM_DEMOD, 1, CONSTANT);
+    shadow(layout.correlatorSizeReg, 1, CONSTANT);
+
+    shadow(WB_QDSP_RECORD_LENGTH, 1, CONFIGURATION);
+    shadow(WB_QDSP_STREAM_ENABLE, 1, CONFIGURATION);
+    shadow(WB_QDSP_STATE_VLD_MASK, 1, CONFIGURATION);
+    shadow(WB_QDSP_RAW_KERNEL_LENGTH, numRawKi, CONFIGURATION);
+    shadow(layout.demodKernelLength, numDemod, CONFIGURATION);
+    shadow(layout.threshold, numRawKi, CONFIGURATION);
+    shadow(layout.phaseInc, numRawKi + numDemod, CONFIGURATION);
+    shadow(layout.thresholdInvert, 1, CONFIGURATION);
+    shadow(layout.thresholdInputSel, 1, CONFIGURATION);
+    shadow(layout.rawKernelBias, 2*numRawKi, CONFIGURATION);
+    shadow(layout.demodKernelBias, 2*numDemod, CONFIGURATION);
+    shadow(layout.correlatorSel, correlatorSize, CONFIGURATION);
+
+    RegisterBatch registers;
+    for (uint32_t offset = 0; offset < values_.size(); offset++) {
+        if (kinds_[offset] != NOT_SHADOWED) {
+            registers.read(base, offset, &values_[offset]);
+        }
+    }
+    execute(registers);
+    loaded_ = true;
+
+    LOG(plog::info) << "DSP at " << hexn<4> << base << std::dec << " has " << numRawKi << " raw streams, "
+                    << numDemod << " demod streams and a correlator of size " << correlatorSize;
+}
+
+void DSPShadow::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    loaded_ = false;
+    layout_ = DSPLayout();
+    values_.clear();
+    kinds_.clear();
+}
+
+bool DSPShadow::read(uint32_t offset, uint32_t & value) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (offset >= kinds_.size() || kinds_[offset] == NOT_SHADOWED) {
+        return false;
+    }
+    value = values_[offset];
+    return true;
+}
+
+void DSPShadow::write(uint32_t offset, uint32_t value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (offset < kinds_.size() && kinds_[offset] == CONFIGURATION) {
+        values_[offset] = value;
+    }
+}
+
+void DSPShadow::write(const RegisterBatch & batch) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto & access : batch.accesses()) {
+        if (!access.result && access.base == base_ && access.offset < kinds_.size() &&
+            kinds_[access.offset] == CONFIGURATION) {
+            values_[access.offset] = access.value;
+        }
+    }
+}
+
+vector<DSPShadow::Mismatch> DSPShadow::verify(const Executor & execute) const {
+    vector<uint32_t> offsets, shadowed, card;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (uint32_t offset = 0; offset < kinds_.size(); offset++) {
+            if (kinds_[offset] != NOT_SHADOWED) {
+                offsets.push_back(offset);
+                shadowed.push_back(values_[offset]);
+            }
+        }
+    }
+    card.resize(offsets.size());
+    RegisterBatch registers;
+    for (size_t ct = 0; ct < offsets.size(); ct++) {
+        registers.read(base_, offsets[ct], &card[ct]);
+    }
+    execute(registers);
+
+    vector<Mismatch> mismatches;
+    for (size_t ct = 0; ct < offsets.size(); ct++) {
+        if (card[ct] != shadowed[ct]) {
+            mismatches.push_back({offsets[ct], shadowed[ct], card[ct]});
+        }
+    }
+    return mismatches;
+}
+
+void DSPShadow::shadow(uint32_t offset, uint32_t count, Kind kind) {
+    for (uint32_t ct = 0; ct < count; ct++) {
+        kinds_[offset + ct] = kind;
+    }
+}
@@ -0,0 +1,94 @@
+// DSPShadow.h
+//
+// In-memory copy of the registers of one DSP module that only the driver
+// changes: the firmware geometry, which fixes where most other registers sit,
+// and the writable configuration registers. It is filled from the card in a
+// few batches when the card is opened. Afterwards writes keep it current and
+// reads of shadowed registers are served from it without going to the bus.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef DSPSHADOW_H_
+#define DSPSHADOW_H_
+
+#include <functional>
+#include <mutex>
+#include <vector>
+using std::vector;
+#include <cstdint>
+
+#include "RegisterBus.h"
+
+// register offsets of a DSP module, derived from its geometry with the
+// WB_QDSP_* macros
+struct DSPLayout {
+	uint32_t numRawKi = 0;
+	uint32_t numDemod = 0;
+	uint32_t correlatorSize = 0;
+
+	uint32_t demodKernelLength = 0;
+	uint32_t rawKernelAddrData = 0;
+	uint32_t demodKernelAddrData = 0;
+	uint32_t threshold = 0;
+	uint32_t phaseInc = 0;
+	uint32_t thresholdInvert = 0;
+	uint32_t thresholdInputSel = 0;
+	uint32_t rawKernelBias = 0;
+	uint32_t demodKernelBias = 0;
+	uint32_t correlatorSizeReg = 0;
+	uint32_t correlatorMAddr = 0;
+	uint32_t correlatorMData = 0;
+	uint32_t correlatorSel = 0;
+
+	DSPLayout() {}
+	DSPLayout(uint32_t, uint32_t);
+};
+
+class DSPShadow {
+public:
+	// runs a batch of register accesses on the card
+	typedef std::function<void(const RegisterBatch &)> Executor;
+
+	struct Mismatch {
+		uint32_t offset;
+		uint32_t shadow;
+		uint32_t card;
+	};
+
+	DSPShadow() {}
+
+	// reads the geometry of the module at base address, then every register
+	// it shadows; throws X6_MODULE_ERROR for an implausible geometry
+	void load(uint32_t, const Executor &);
+	void clear();
+	bool is_loaded() const { return loaded_; }
+	const DSPLayout & get_layout() const { return layout_; }
+
+	// the value of a shadowed register; false for registers not shadowed
+	bool read(uint32_t, uint32_t &) const;
+	// keep up with writes to the module; writes to the geometry and firmware
+	// identification registers are ignored as the firmware ignores them
+	void write(uint32_t, uint32_t);
+	void write(const RegisterBatch &);
+	// reads every shadowed register from the card and lists those that differ
+	vector<Mismatch> verify(const Executor &) const;
+
+private:
+	DSPShadow(const DSPShadow &) = delete;
+	DSPShadow & operator=(const DSPShadow &) = delete;
+
+	enum Kind : uint8_t { NOT_SHADOWED = 0, CONFIGURATION, CONSTANT };
+	void shadow(uint32_t, uint32_t, Kind);
+
+	mutable std::mutex mutex_;
+	bool loaded_ = false;
+	uint32_t base_ = 0;
+	DSPLayout layout_;
+	// indexed by register offset
+	vector<uint32_t> values_;
+	vector<Kind> kinds_;
+};
+
+#endif // DSPSHADOW_H_
@@ -0,0 +1,115 @@
+// DataNotifier.cpp
+//
+// Signal clients when new records have arrived or an acquisition finished
+// through a pollable file descriptor, a callback and a condition variable.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#include "DataNotifier.h"
+#include "X6_errno.h"
+
+#include <algorithm> // std::max
+
+#include <plog/Log.h>
+
+#ifdef __linux__
+	#include <sys/eventfd.h>
+	#include <unistd.h>
+	#include <cstring>
+	#include <cerrno>
+#endif
+
+DataNotifier::DataNotifier() :
+    done_{true}, fd_{-1}, threshold_{1}, pending_{0}, deviceID_{-1}, callback_{nullptr}, userData_{nullptr} {};
+
+DataNotifier::~DataNotifier() {
+#ifdef __linux__
+    if (fd_ != -1) close(fd_);
+#endif
+}
+
+int DataNotifier::get_fd() {
+    /* Lazily creates a non-blocking eventfd. The counter is incremented on every
+     * notification; clients poll for readability and read 8 bytes to clear it.
+     */
+#ifdef __linux__
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ == -1) {
+        fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (fd_ == -1) {
+            LOG(plog::error) << "Failed to create eventfd: " << std::strerror(errno);
+            throw X6_UNKNOWN_ERROR;
+        }
+    }
+    return fd_;
+#else
+    LOG(plog::error) << "Data notification file descriptors are only available on Linux.";
+    throw X6_NOT_SUPPORTED;
+#endif
+}
+
+void DataNotifier::set_threshold(size_t threshold) {
+    threshold_ = std::max<size_t>(threshold, 1);
+}
+
+void DataNotifier::set_callback(int deviceID, X6_DATA_CALLBACK callback, void * userData) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    deviceID_ = deviceID;
+    callback_ = callback;
+    userData_ = userData;
+}
+
+void DataNotifier::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_ = false;
+    pending_ = 0;
+}
+
+void DataNotifier::records_available(size_t numRecords) {
+    // Called from the data handling thread for every record so only take the
+    // lock once the threshold is crossed.
+    size_t pending = pending_ += numRecords;
+    if (pending >= threshold_) {
+        signal(pending_.exchange(0), false);
+    }
+}
+
+void DataNotifier::finish() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (done_) return;
+        done_ = true;
+    }
+    cv_.notify_all();
+    signal(pending_.exchange(0), true);
+}
+
+bool DataNotifier::wait_until(const std::chrono::system_clock::time_point & end) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_until(lock, end, [this]{ return done_; });
+}
+
+void DataNotifier::signal(size_t numRecords, bool done) {
+    X6_DATA_CALLBACK callback;
+    void * userData;
+    int deviceID;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+#ifdef __linux__
+        if (fd_ != -1) {
+            uint64_t one = 1;
+            if (write(fd_, &one, sizeof(one)) != sizeof(one)) {
+                LOG(plog::warning) << "Failed to signal data eventfd.";
+            }
+        }
+#endif
+        callback = callback_;
+        userData = userData_;
+        deviceID = deviceID_;
+    }
+    if (callback) {
+        callback(deviceID, static_cast<unsigned>(numRecords), done, userData);
+    }
+}
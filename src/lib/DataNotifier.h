@@ -0,0 +1,55 @@
+// DataNotifier.h
+//
+// Signal clients when new records have arrived or an acquisition finished
+// through a pollable file descriptor, a callback and a condition variable.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef DATANOTIFIER_H_
+#define DATANOTIFIER_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <cstddef>
+
+#include "X6_enums.h"
+
+class DataNotifier {
+public:
+	DataNotifier();
+	~DataNotifier();
+
+	int get_fd();
+	void set_threshold(size_t);
+	void set_callback(int, X6_DATA_CALLBACK, void *);
+
+	void start();
+	void records_available(size_t);
+	void finish();
+	bool wait_until(const std::chrono::system_clock::time_point &);
+
+private:
+	DataNotifier(const DataNotifier&) = delete;
+	DataNotifier& operator=(const DataNotifier&) = delete;
+
+	void signal(size_t, bool);
+
+	std::mutex mutex_;
+	std::condition_variable cv_;
+	bool done_;
+
+	int fd_;
+	std::atomic<size_t> threshold_;
+	std::atomic<size_t> pending_;
+
+	// callback is swapped under mutex_ and invoked with a copy
+	int deviceID_;
+	X6_DATA_CALLBACK callback_;
+	void * userData_;
+};
+
+#endif // DATANOTIFIER_H_
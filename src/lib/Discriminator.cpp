@@ -0,0 +1,272 @@
+// Discriminator.cpp
+//
+// Host state discriminator: classifies the I/Q points of one or more result
+// streams into one of several states with a nearest-centroid, linear or
+// Gaussian classifier, and counts the states of each segment.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#include "Discriminator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "X6_errno.h"
+#include "logging.h"
+
+Discriminator::Discriminator() :
+    recordsTaken{0}, kind_{DISCRIMINATOR_NEAREST_CENTROID}, numClasses_{0}, dimension_{0},
+    numSegments_{1}, numWaveforms_{1}, maxRecords_{0} {};
+
+Discriminator::Discriminator(const vector<QDSPStream> & inputs, X6_DISCRIMINATOR_KIND kind,
+                             unsigned numClasses, const vector<double> & params) :
+    recordsTaken{0}, kind_{kind}, numClasses_{numClasses}, dimension_{2*inputs.size()}, inputs_(inputs),
+    numSegments_{1}, numWaveforms_{1}, maxRecords_{0} {
+
+    if (inputs_.empty() || numClasses_ < 2) {
+        LOG(plog::error) << "A discriminator needs at least one input stream and two states";
+        throw X6_INVALID_ARGUMENT;
+    }
+    if (params.size() != num_parameters(kind_, numClasses_, inputs_.size())) {
+        LOG(plog::error) << "Discriminator expected " << num_parameters(kind_, numClasses_, inputs_.size())
+                         << " parameters but was given " << params.size();
+        throw X6_INVALID_ARGUMENT;
+    }
+
+    buffers_.resize(inputs_.size());
+    features_.resize(dimension_);
+    for (size_t i = 0; i < inputs_.size(); i++) {
+        bufferSID_[inputs_[i].streamID] = i;
+        inputScales_.push_back(1.0 / inputs_[i].fixed_to_float());
+    }
+
+    offset_.assign(numClasses_, 0);
+    linear_.assign(numClasses_ * dimension_, 0);
+    switch (kind_) {
+        case DISCRIMINATOR_NEAREST_CENTROID:
+            set_nearest_centroid(params);
+            break;
+        case DISCRIMINATOR_LINEAR:
+            set_linear(params);
+            break;
+        case DISCRIMINATOR_GAUSSIAN:
+            set_gaussian(params);
+            break;
+        default:
+            LOG(plog::error) << "Unknown discriminator kind " << kind_;
+            throw X6_INVALID_ARGUMENT;
+    }
+}
+
+size_t Discriminator::num_parameters(X6_DISCRIMINATOR_KIND kind, unsigned numClasses, size_t numInputs) {
+    /*
+     * Parameters per class for D = 2*numInputs features:
+     *   nearest centroid: the centroid (D)
+     *   linear: weights (D) then bias (1)
+     *   Gaussian: mean (D), row-major covariance (D*D) then prior (1)
+     */
+    size_t D = 2 * numInputs;
+    switch (kind) {
+        case DISCRIMINATOR_NEAREST_CENTROID:
+            return numClasses * D;
+        case DISCRIMINATOR_LINEAR:
+            return numClasses * (D + 1);
+        case DISCRIMINATOR_GAUSSIAN:
+            return numClasses * (D + D*D + 1);
+        default:
+            return 0;
+    }
+}
+
+void Discriminator::set_nearest_centroid(const vector<double> & params) {
+    // -|x - mu|^2 without the -|x|^2 every class shares
+    size_t D = dimension_;
+    for (unsigned k = 0; k < numClasses_; k++) {
+        const double * mu = &params[k * D];
+        for (size_t d = 0; d < D; d++) {
+            linear_[k*D + d] = 2 * mu[d];
+            offset_[k] -= mu[d] * mu[d];
+        }
+    }
+}
+
+void Discriminator::set_linear(const vector<double> & params) {
+    size_t D = dimension_;
+    for (unsigned k = 0; k < numClasses_; k++) {
+        const double * w = &params[k * (D + 1)];
+        std::copy(w, w + D, linear_.begin() + k*D);
+        offset_[k] = w[D];
+    }
+}
+
+void Discriminator::set_gaussian(const vector<double> & params) {
+    /*
+     * log-likelihood plus log-prior of each class, up to a shared constant:
+     * -(x-mu)' S^-1 (x-mu) / 2 - log|S| / 2 + log(prior)
+     */
+    size_t D = dimension_;
+    quadratic_.assign(numClasses_ * D * D, 0);
+    for (unsigned k = 0; k < numClasses_; k++) {
+        const double * mu = &params[k * (D + D*D + 1)];
+        const double * cov = mu + D;
+        double prior = cov[D*D];
+        if (prior <= 0) {
+            LOG(plog::error) << "Discriminator class " << k << " prior must be positive";
+            throw X6_INVALID_ARGUMENT;
+        }
+
+        // Cholesky factor L of the covariance, lower triangular
+        vector<double> L(D*D, 0);
+        for (size_t i = 0; i < D; i++) {
+            for (size_t j = 0; j <= i; j++) {
+                double sum = cov[i*D + j];
+                for (size_t m = 0; m < j; m++) {
+                    sum -= L[i*D + m] * L[j*D + m];
+                }
+                if (i == j) {
+                    if (sum <= 0) {
+                        LOG(plog::error) << "Discriminator class " << k << " covariance is not positive definite";
+                        throw X6_INVALID_ARGUMENT;
+                    }
+                    L[i*D + i] = std::sqrt(sum);
+                } else {
+                    L[i*D + j] = sum / L[j*D + j];
+                }
+            }
+        }
+
+        // inverse covariance, one column at a time from L L' x = e
+        vector<double> inv(D*D, 0);
+        vector<double> y(D);
+        for (size_t col = 0; col < D; col++) {
+            for (size_t i = 0; i < D; i++) {
+                double sum = (i == col) ? 1.0 : 0.0;
+                for (size_t m = 0; m < i; m++) {
+                    sum -= L[i*D + m] * y[m];
+                }
+                y[i] = sum / L[i*D + i];
+            }
+            for (size_t i = D; i-- > 0;) {
+                double sum = y[i];
+                for (size_t m = i + 1; m < D; m++) {
+                    sum -= L[m*D + i] * inv[m*D + col];
+                }
+                inv[i*D + col] = sum / L[i*D + i];
+            }
+        }
+
+        double logDet = 0;
+        for (size_t i = 0; i < D; i++) {
+            logDet += 2 * std::log(L[i*D + i]);
+        }
+        double muInvMu = 0;
+        for (size_t i = 0; i < D; i++) {
+            double invMu = 0;
+            for (size_t j = 0; j < D; j++) {
+                invMu += inv[i*D + j] * mu[j];
+                quadratic_[(k*D + i)*D + j] = -0.5 * inv[i*D + j];
+            }
+            linear_[k*D + i] = invMu;
+            muInvMu += mu[i] * invMu;
+        }
+        offset_[k] = -0.5 * muInvMu - 0.5 * logDet + std::log(prior);
+    }
+}
+
+int Discriminator::get_buffer_index(const uint16_t & sid) const {
+    auto it = bufferSID_.find(sid);
+    return (it == bufferSID_.end()) ? -1 : it->second;
+}
+
+void Discriminator::reset(size_t numSegments, size_t numWaveforms, size_t maxRecords) {
+    numSegments_ = std::max<size_t>(numSegments, 1);
+    numWaveforms_ = std::max<size_t>(numWaveforms, 1);
+    maxRecords_ = maxRecords;
+    for (auto & buffer : buffers_) {
+        buffer.clear();
+    }
+    counts_.assign(numSegments_ * numClasses_, 0);
+    states_.clear();
+    recordsTaken = 0;
+}
+
+size_t Discriminator::classify() {
+    /*
+     * Classifies every point all inputs have delivered. Each class is scored
+     * over the whole batch of points at once so the loops over points vectorize.
+     */
+    size_t numWords = buffers_[0].size();
+    for (auto & buffer : buffers_) {
+        numWords = std::min(numWords, buffer.size());
+    }
+    size_t N = numWords / 2;
+    states_.clear();
+    if (N == 0) {
+        return 0;
+    }
+
+    size_t D = dimension_;
+    for (size_t i = 0; i < buffers_.size(); i++) {
+        vector<double> & re = features_[2*i];
+        vector<double> & im = features_[2*i + 1];
+        re.resize(N);
+        im.resize(N);
+        const int32_t * words = buffers_[i].data();
+        for (size_t n = 0; n < N; n++) {
+            re[n] = words[2*n] * inputScales_[i];
+            im[n] = words[2*n + 1] * inputScales_[i];
+        }
+        buffers_[i].erase(buffers_[i].begin(), buffers_[i].begin() + 2*N);
+    }
+
+    score_.resize(N);
+    bestScore_.assign(N, -std::numeric_limits<double>::infinity());
+    bestClass_.assign(N, 0);
+    for (unsigned k = 0; k < numClasses_; k++) {
+        std::fill(score_.begin(), score_.end(), offset_[k]);
+        for (size_t d = 0; d < D; d++) {
+            const double w = linear_[k*D + d];
+            const double * x = features_[d].data();
+            for (size_t n = 0; n < N; n++) {
+                score_[n] += w * x[n];
+            }
+        }
+        if (!quadratic_.empty()) {
+            for (size_t d = 0; d < D; d++) {
+                for (size_t e = 0; e < D; e++) {
+                    const double q = quadratic_[(k*D + d)*D + e];
+                    const double * xd = features_[d].data();
+                    const double * xe = features_[e].data();
+                    for (size_t n = 0; n < N; n++) {
+                        score_[n] += q * xd[n] * xe[n];
+                    }
+                }
+            }
+        }
+        for (size_t n = 0; n < N; n++) {
+            bool better = score_[n] > bestScore_[n];
+            bestScore_[n] = better ? score_[n] : bestScore_[n];
+            bestClass_[n] = better ? static_cast<int32_t>(k) : bestClass_[n];
+        }
+    }
+
+    states_.resize(2*N);
+    for (size_t n = 0; n < N; n++) {
+        states_[2*n] = bestClass_[n];
+        states_[2*n + 1] = 0;
+        if (recordsTaken < maxRecords_) {
+            size_t segment = (recordsTaken / numWaveforms_) % numSegments_;
+            counts_[segment * numClasses_ + bestClass_[n]]++;
+            recordsTaken++;
+        }
+    }
+    return N;
+}
+
+void Discriminator::snapshot_counts(uint64_t * buf) const {
+    /* Copies the current counts into a *preallocated* buffer */
+    std::copy(counts_.begin(), counts_.end(), buf);
+}
@@ -0,0 +1,88 @@
+// Discriminator.h
+//
+// Host state discriminator: classifies the I/Q points of one or more result
+// streams into one of several states with a nearest-centroid, linear or
+// Gaussian classifier, and counts the states of each segment.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef DISCRIMINATOR_H_
+#define DISCRIMINATOR_H_
+
+#include <vector>
+using std::vector;
+#include <map>
+using std::map;
+#include <cstddef>
+#include <cstdint>
+
+#include "QDSPStream.h"
+#include "X6_enums.h"
+
+class Discriminator {
+public:
+	Discriminator();
+	Discriminator(const vector<QDSPStream> &, X6_DISCRIMINATOR_KIND, unsigned, const vector<double> &);
+
+	static size_t num_parameters(X6_DISCRIMINATOR_KIND, unsigned, size_t);
+
+	// look up a stream's input index once, then add records by index
+	int get_buffer_index(const uint16_t &) const;
+	const vector<QDSPStream> & get_inputs() const { return inputs_; }
+	unsigned get_num_classes() const { return numClasses_; }
+	size_t get_dimension() const { return dimension_; }
+
+	void reset(size_t, size_t, size_t);
+	template <class B>
+	void add_record(const int &, const B &);
+	size_t classify();
+	// states of the last classify(), each as a {state, 0} result pair
+	const vector<int32_t> & get_states() const { return states_; }
+
+	size_t get_counts_size() const { return counts_.size(); }
+	void snapshot_counts(uint64_t *) const;
+
+	size_t recordsTaken;
+
+private:
+	void set_nearest_centroid(const vector<double> &);
+	void set_linear(const vector<double> &);
+	void set_gaussian(const vector<double> &);
+
+	X6_DISCRIMINATOR_KIND kind_;
+	unsigned numClasses_;
+	size_t dimension_;
+	vector<QDSPStream> inputs_;
+	map<uint16_t, int> bufferSID_;
+	vector<double> inputScales_;
+
+	// score_k(x) = offset_k + linear_k . x + x' quadratic_k x, largest wins;
+	// quadratic_ is empty when every class has a linear score
+	vector<double> offset_;
+	vector<double> linear_;
+	vector<double> quadratic_;
+
+	// raw I/Q words waiting for the other inputs of the same record
+	vector<vector<int32_t>> buffers_;
+	// pending points with one array per feature, and their running best score
+	vector<vector<double>> features_;
+	vector<double> score_;
+	vector<double> bestScore_;
+	vector<int32_t> bestClass_;
+	vector<int32_t> states_;
+
+	// state counts per segment, segment-major
+	vector<uint64_t> counts_;
+	size_t numSegments_;
+	size_t numWaveforms_;
+	size_t maxRecords_;
+};
+
+template <class B>
+void Discriminator::add_record(const int & index, const B & buffer) {
+	buffers_[index].insert(buffers_[index].end(), buffer.begin(), buffer.end());
+}
+
+#endif // DISCRIMINATOR_H_
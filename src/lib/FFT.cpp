@@ -0,0 +1,186 @@
+// FFT.cpp
+//
+// Self-contained mixed-radix FFT for the host spectrum accumulators. Lengths
+// are factored into radix 4, 2 and odd factors; real input of even length is
+// packed into a complex transform of half the length.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#include "FFT.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+
+} // namespace
+
+FFT::FFT(size_t nfft) : nfft_{nfft} {
+    twiddles_.resize(nfft_);
+    for (size_t i = 0; i < nfft_; i++) {
+        double phase = -2 * PI * static_cast<double>(i) / nfft_;
+        twiddles_[i] = std::polar(1.0, phase);
+    }
+
+    /*
+     * Factor into 4s first, then 2s, then odd factors. Anything left once the
+     * trial factor passes sqrt(n) is prime and becomes the last radix.
+     */
+    size_t n = nfft_;
+    size_t p = 4;
+    size_t maxRadix = 1;
+    while (n > 1) {
+        while (n % p) {
+            p = (p == 4) ? 2 : (p == 2) ? 3 : p + 2;
+            if (p * p > n) {
+                p = n;
+            }
+        }
+        n /= p;
+        factors_.push_back(p);
+        factors_.push_back(n);
+        maxRadix = std::max(maxRadix, p);
+    }
+    scratch_.resize(maxRadix);
+}
+
+void FFT::transform(const complex<double> * in, complex<double> * out) const {
+    if (nfft_ == 1) {
+        out[0] = in[0];
+    } else if (nfft_ > 1) {
+        work(out, in, 1, factors_.data());
+    }
+}
+
+void FFT::work(complex<double> * out, const complex<double> * in, size_t fstride, const size_t * factors) const {
+    /*
+     * Decimation in time: the p interleaved subsequences of length m land in
+     * consecutive blocks of out, then radix-p butterflies combine them.
+     */
+    const size_t p = factors[0];
+    const size_t m = factors[1];
+    if (m == 1) {
+        for (size_t j = 0; j < p; j++) {
+            out[j] = in[j * fstride];
+        }
+    } else {
+        for (size_t j = 0; j < p; j++) {
+            work(out + j*m, in + j*fstride, fstride * p, factors + 2);
+        }
+    }
+
+    switch (p) {
+        case 2:
+            butterfly2(out, fstride, m);
+            break;
+        case 4:
+            butterfly4(out, fstride, m);
+            break;
+        default:
+            butterfly_generic(out, fstride, m, p);
+            break;
+    }
+}
+
+void FFT::butterfly2(complex<double> * out, size_t fstride, size_t m) const {
+    complex<double> * out2 = out + m;
+    for (size_t k = 0; k < m; k++) {
+        complex<double> t = out2[k] * twiddles_[k * fstride];
+        out2[k] = out[k] - t;
+        out[k] += t;
+    }
+}
+
+void FFT::butterfly4(complex<double> * out, size_t fstride, size_t m) const {
+    for (size_t k = 0; k < m; k++) {
+        complex<double> s0 = out[k + m] * twiddles_[k * fstride];
+        complex<double> s1 = out[k + 2*m] * twiddles_[2 * k * fstride];
+        complex<double> s2 = out[k + 3*m] * twiddles_[3 * k * fstride];
+        complex<double> s5 = out[k] - s1;
+        complex<double> s4 = s0 - s2;
+        complex<double> s3 = s0 + s2;
+        out[k] += s1;
+        out[k + 2*m] = out[k] - s3;
+        out[k] += s3;
+        // multiplying s4 by -i
+        out[k + m] = complex<double>(s5.real() + s4.imag(), s5.imag() - s4.real());
+        out[k + 3*m] = complex<double>(s5.real() - s4.imag(), s5.imag() + s4.real());
+    }
+}
+
+void FFT::butterfly_generic(complex<double> * out, size_t fstride, size_t m, size_t p) const {
+    // direct p-point DFT of each butterfly, O(p^2) but only for odd radices
+    for (size_t u = 0; u < m; u++) {
+        for (size_t q = 0; q < p; q++) {
+            scratch_[q] = out[u + q*m];
+        }
+        for (size_t q1 = 0; q1 < p; q1++) {
+            size_t k = u + q1*m;
+            size_t twidx = 0;
+            complex<double> sum = scratch_[0];
+            for (size_t q = 1; q < p; q++) {
+                twidx += fstride * k;
+                if (twidx >= nfft_) {
+                    twidx -= nfft_;
+                }
+                sum += scratch_[q] * twiddles_[twidx];
+            }
+            out[k] = sum;
+        }
+    }
+}
+
+RealFFT::RealFFT(size_t nfft) : nfft_{nfft} {
+    if (nfft_ % 2) {
+        fft_ = FFT(nfft_);
+        packed_.resize(nfft_);
+        spectrum_.resize(nfft_);
+        return;
+    }
+    size_t ncfft = nfft_ / 2;
+    fft_ = FFT(ncfft);
+    packed_.resize(ncfft);
+    spectrum_.resize(ncfft);
+    for (size_t i = 0; i < ncfft / 2; i++) {
+        double phase = -PI * (static_cast<double>(i + 1) / ncfft + 0.5);
+        superTwiddles_.push_back(std::polar(1.0, phase));
+    }
+}
+
+void RealFFT::transform(const double * in, complex<double> * out) const {
+    if (nfft_ % 2) {
+        for (size_t n = 0; n < nfft_; n++) {
+            packed_[n] = complex<double>(in[n], 0);
+        }
+        fft_.transform(packed_.data(), spectrum_.data());
+        std::copy(spectrum_.begin(), spectrum_.begin() + num_bins(), out);
+        return;
+    }
+
+    /*
+     * z[n] = x[2n] + i x[2n+1] transforms to Z[k] = E[k] + i O[k], where E and
+     * O are the transforms of the even and odd samples. Untangle them from Z[k]
+     * and conj(Z[N/2-k]), then X[k] = E[k] + exp(-2 pi i k / N) O[k].
+     */
+    size_t ncfft = nfft_ / 2;
+    for (size_t n = 0; n < ncfft; n++) {
+        packed_[n] = complex<double>(in[2*n], in[2*n + 1]);
+    }
+    fft_.transform(packed_.data(), spectrum_.data());
+
+    const complex<double> dc = spectrum_[0];
+    out[0] = complex<double>(dc.real() + dc.imag(), 0);
+    out[ncfft] = complex<double>(dc.real() - dc.imag(), 0);
+    for (size_t k = 1; k <= ncfft / 2; k++) {
+        complex<double> fpk = spectrum_[k];
+        complex<double> fpnk = std::conj(spectrum_[ncfft - k]);
+        complex<double> f1k = fpk + fpnk;
+        complex<double> tw = (fpk - fpnk) * superTwiddles_[k - 1];
+        out[k] = 0.5 * (f1k + tw);
+        out[ncfft - k] = 0.5 * std::conj(f1k - tw);
+    }
+}
@@ -0,0 +1,63 @@
+// FFT.h
+//
+// Self-contained mixed-radix FFT for the host spectrum accumulators. Lengths
+// are factored into radix 4, 2 and odd factors; real input of even length is
+// packed into a complex transform of half the length.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef FFT_H_
+#define FFT_H_
+
+#include <complex>
+using std::complex;
+#include <vector>
+using std::vector;
+#include <cstddef>
+
+class FFT {
+public:
+	FFT() {}
+	FFT(size_t);
+
+	size_t size() const { return nfft_; }
+	// forward transform X[k] = sum_n x[n] exp(-2 pi i k n / N); in and out
+	// must not overlap
+	void transform(const complex<double> *, complex<double> *) const;
+
+private:
+	void work(complex<double> *, const complex<double> *, size_t, const size_t *) const;
+	void butterfly2(complex<double> *, size_t, size_t) const;
+	void butterfly4(complex<double> *, size_t, size_t) const;
+	void butterfly_generic(complex<double> *, size_t, size_t, size_t) const;
+
+	size_t nfft_ = 0;
+	// (radix, remaining length) pairs, outermost stage first
+	vector<size_t> factors_;
+	vector<complex<double>> twiddles_;
+	mutable vector<complex<double>> scratch_;
+};
+
+class RealFFT {
+public:
+	RealFFT() {}
+	RealFFT(size_t);
+
+	size_t size() const { return nfft_; }
+	// bins 0 through N/2 of the transform of N real samples
+	size_t num_bins() const { return nfft_ / 2 + 1; }
+	void transform(const double *, complex<double> *) const;
+
+private:
+	size_t nfft_ = 0;
+	// half-length transform of the even/odd samples packed as complex pairs,
+	// or the full-length transform when N is odd
+	FFT fft_;
+	vector<complex<double>> superTwiddles_;
+	mutable vector<complex<double>> packed_;
+	mutable vector<complex<double>> spectrum_;
+};
+
+#endif // FFT_H_
@@ -0,0 +1,426 @@
+// HostDSP.cpp
+//
+// Software digital down-conversion of raw (PHYSICAL) records on the host:
+// NCO mixing, decimating low-pass filtering and kernel integration for any
+// number of channels beyond the firmware's demodulators and integrators.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#include "HostDSP.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#include "X6_errno.h"
+#include "logging.h"
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+
+// Dot product with four independent partial sums so the compiler can keep
+// the loop in vector registers without reassociating floating point math.
+inline float dot(const float * a, const float * b, size_t len) {
+    float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t ct = 0;
+    for (; ct + 4 <= len; ct += 4) {
+        s0 += a[ct] * b[ct];
+        s1 += a[ct+1] * b[ct+1];
+        s2 += a[ct+2] * b[ct+2];
+        s3 += a[ct+3] * b[ct+3];
+    }
+    for (; ct < len; ct++) {
+        s0 += a[ct] * b[ct];
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+inline int32_t to_fixed(float val, float scale) {
+    const float limit = 2147483520.0f; // largest float below 2^31
+    float scaled = std::max(-limit, std::min(limit, val * scale));
+    return static_cast<int32_t>(std::lrint(scaled));
+}
+
+} // namespace
+
+HostDSP::HostDSP() : running_{false}, ticket_{0}, jobRemaining_{0} {
+    for (auto & job : jobs_) {
+        job.plan = nullptr;
+        job.record = nullptr;
+    }
+}
+
+HostDSP::~HostDSP() {
+    stop();
+}
+
+uint16_t HostDSP::channel_key(unsigned a, unsigned b) {
+    return static_cast<uint16_t>((a << 8) | b);
+}
+
+void HostDSP::clear() {
+    stop();
+    channels_.clear();
+    plans_.clear();
+}
+
+bool HostDSP::has_channel(unsigned a, unsigned b) const {
+    return channels_.count(channel_key(a, b)) > 0;
+}
+
+HostDSP::Channel & HostDSP::get_channel(unsigned a, unsigned b) {
+    if (b < HOST_DSP_FIRST_CHANNEL || b > HOST_DSP_LAST_CHANNEL) {
+        LOG(plog::error) << "Channel " << a << "." << b << " is not a host DSP channel";
+        throw X6_INVALID_CHANNEL;
+    }
+    return channels_[channel_key(a, b)];
+}
+
+const HostDSP::Channel & HostDSP::find_channel(unsigned a, unsigned b) const {
+    auto it = channels_.find(channel_key(a, b));
+    if (it == channels_.end()) {
+        LOG(plog::error) << "Host DSP channel " << a << "." << b << " has not been configured";
+        throw X6_INVALID_CHANNEL;
+    }
+    return it->second;
+}
+
+const HostDSP::Kernel & HostDSP::find_kernel(unsigned a, unsigned b, unsigned c) const {
+    const Channel & channel = find_channel(a, b);
+    auto it = channel.kernels.find(c);
+    if (it == channel.kernels.end()) {
+        LOG(plog::error) << "No kernel written for host DSP stream " << a << "." << b << "." << c;
+        throw X6_INVALID_KERNEL_STREAM;
+    }
+    return it->second;
+}
+
+void HostDSP::set_nco_frequency(unsigned a, unsigned b, double freq) {
+    get_channel(a, b).frequency = freq;
+}
+
+double HostDSP::get_nco_frequency(unsigned a, unsigned b) const {
+    return find_channel(a, b).frequency;
+}
+
+void HostDSP::set_decimation(unsigned a, unsigned b, unsigned factor, const vector<double> & taps) {
+    if (factor == 0) {
+        LOG(plog::error) << "Host DSP decimation factor must be at least 1";
+        throw X6_INVALID_ARGUMENT;
+    }
+    Channel & channel = get_channel(a, b);
+    channel.decimation = factor;
+    channel.filter = taps;
+}
+
+unsigned HostDSP::get_decimation(unsigned a, unsigned b) const {
+    return find_channel(a, b).decimation;
+}
+
+void HostDSP::write_kernel(unsigned a, unsigned b, unsigned c, const vector<complex<double>> & kernel) {
+    if (c == 0 || c == KERNEL_BANK_STREAM) {
+        LOG(plog::error) << "Attempt to write kernel to non kernel integration stream";
+        throw X6_INVALID_KERNEL_STREAM;
+    }
+    if (kernel.empty()) {
+        LOG(plog::error) << "Host DSP kernel must not be empty";
+        throw X6_INVALID_KERNEL_LENGTH;
+    }
+    get_channel(a, b).kernels[c].taps = kernel;
+}
+
+complex<double> HostDSP::read_kernel(unsigned a, unsigned b, unsigned c, unsigned addr) const {
+    const Kernel & kernel = find_kernel(a, b, c);
+    if (addr >= kernel.taps.size()) {
+        LOG(plog::error) << "Kernel address " << addr << " is beyond the kernel length " << kernel.taps.size();
+        throw X6_INVALID_ARGUMENT;
+    }
+    return kernel.taps[addr];
+}
+
+void HostDSP::set_kernel_bias(unsigned a, unsigned b, unsigned c, complex<double> bias) {
+    if (c == 0 || c == KERNEL_BANK_STREAM) {
+        LOG(plog::error) << "Attempt to set kernel bias of non kernel integration stream";
+        throw X6_INVALID_KERNEL_STREAM;
+    }
+    get_channel(a, b).kernels[c].bias = bias;
+}
+
+complex<double> HostDSP::get_kernel_bias(unsigned a, unsigned b, unsigned c) const {
+    return find_kernel(a, b, c).bias;
+}
+
+void HostDSP::set_num_threads(unsigned numThreads) {
+    numThreads_ = std::max(numThreads, 1u);
+}
+
+void HostDSP::set_thread_init(ThreadInit init) {
+    threadInit_ = init;
+}
+
+vector<double> HostDSP::design_filter(unsigned decimation) {
+    /*
+     * Hamming windowed sinc low-pass with its cutoff at the output Nyquist
+     * frequency and unity gain at DC.
+     */
+    if (decimation <= 1) {
+        return vector<double>{1.0};
+    }
+    size_t len = 8 * decimation + 1;
+    double cutoff = 0.5 / decimation;
+    double center = (len - 1) / 2.0;
+    vector<double> taps(len);
+    double sum = 0;
+    for (size_t ct = 0; ct < len; ct++) {
+        double t = ct - center;
+        double sinc = (t == 0) ? 2 * cutoff : std::sin(2 * PI * cutoff * t) / (PI * t);
+        double window = 0.54 - 0.46 * std::cos(2 * PI * ct / (len - 1));
+        taps[ct] = sinc * window;
+        sum += taps[ct];
+    }
+    for (auto & tap : taps) {
+        tap /= sum;
+    }
+    return taps;
+}
+
+void HostDSP::prepare(double rawSampleRate, size_t rawRecordLength, const vector<QDSPStream> & hostStreams) {
+    /*
+     * Builds the per-record plans for the coming acquisition. hostStreams are
+     * the enabled virtual streams; their outputs are ordered as given.
+     */
+    stop();
+    plans_.clear();
+
+    // (a,b) -> index of its ChannelPlan within plans_[a]
+    map<uint16_t, size_t> channelIndex;
+    for (auto & stream : hostStreams) {
+        unsigned a = stream.channelID[0];
+        unsigned b = stream.channelID[1];
+        unsigned c = stream.channelID[2];
+        const Channel & channel = find_channel(a, b);
+        if (plans_.size() <= a) {
+            plans_.resize(a + 1);
+        }
+        AdcPlan & plan = plans_[a];
+
+        auto it = channelIndex.find(channel_key(a, b));
+        if (it == channelIndex.end()) {
+            ChannelPlan chPlan;
+            chPlan.decimation = channel.decimation;
+            chPlan.numOut = rawRecordLength / channel.decimation;
+            if (chPlan.numOut == 0) {
+                LOG(plog::error) << "Host DSP decimation " << channel.decimation << " of channel " << a << "." << b
+                                 << " exceeds the raw record length " << rawRecordLength;
+                throw X6_INVALID_ARGUMENT;
+            }
+            vector<double> taps = channel.filter.empty() ? design_filter(channel.decimation) : channel.filter;
+            chPlan.taps.assign(taps.rbegin(), taps.rend());
+            chPlan.loRe.resize(rawRecordLength);
+            chPlan.loIm.resize(rawRecordLength);
+            double step = 2 * PI * channel.frequency / rawSampleRate;
+            for (size_t n = 0; n < rawRecordLength; n++) {
+                chPlan.loRe[n] = static_cast<float>(std::cos(step * n));
+                chPlan.loIm[n] = static_cast<float>(-std::sin(step * n));
+            }
+            chPlan.mixRe.assign(rawRecordLength + chPlan.taps.size() - 1, 0.0f);
+            chPlan.mixIm.assign(rawRecordLength + chPlan.taps.size() - 1, 0.0f);
+            chPlan.outRe.resize(chPlan.numOut);
+            chPlan.outIm.resize(chPlan.numOut);
+            chPlan.demodOutput = false;
+            chPlan.demodIndex = 0;
+            chPlan.demodScale = 1;
+            it = channelIndex.emplace(channel_key(a, b), plan.channels.size()).first;
+            plan.channels.push_back(std::move(chPlan));
+        }
+        ChannelPlan & chPlan = plan.channels[it->second];
+
+        size_t output = plan.outputStreams.size();
+        plan.outputStreams.push_back(stream.streamID);
+        if (c == 0) {
+            chPlan.demodOutput = true;
+            chPlan.demodIndex = output;
+            chPlan.demodScale = static_cast<float>(stream.fixed_to_float());
+            plan.outputData.emplace_back(2 * chPlan.numOut);
+        } else {
+            const Kernel & kernel = find_kernel(a, b, c);
+            KernelPlan kPlan;
+            size_t len = std::min(kernel.taps.size(), chPlan.numOut);
+            for (size_t ct = 0; ct < len; ct++) {
+                kPlan.re.push_back(static_cast<float>(std::real(kernel.taps[ct])));
+                kPlan.im.push_back(static_cast<float>(std::imag(kernel.taps[ct])));
+            }
+            kPlan.biasRe = static_cast<float>(std::real(kernel.bias));
+            kPlan.biasIm = static_cast<float>(std::imag(kernel.bias));
+            kPlan.scale = static_cast<float>(stream.fixed_to_float());
+            kPlan.output = output;
+            chPlan.kernels.push_back(std::move(kPlan));
+            plan.outputData.emplace_back(2);
+        }
+    }
+
+    // views are taken once the output buffers have stopped moving
+    for (auto & plan : plans_) {
+        for (auto & data : plan.outputData) {
+            plan.outputs.emplace_back(data.data(), data.size());
+        }
+    }
+
+    start();
+}
+
+void HostDSP::start() {
+    /* (re)starts the helper threads over the plans of the last prepare() */
+    stop();
+    bool anyOutputs = std::any_of(plans_.begin(), plans_.end(),
+                                  [](const AdcPlan & plan) { return !plan.outputStreams.empty(); });
+    if (!anyOutputs || numThreads_ <= 1) {
+        return;
+    }
+    running_ = true;
+    for (unsigned ct = 1; ct < numThreads_; ct++) {
+        workers_.emplace_back(&HostDSP::worker, this);
+    }
+}
+
+const vector<uint16_t> & HostDSP::get_output_streams(unsigned a) const {
+    if (a >= plans_.size()) {
+        return noStreams_;
+    }
+    return plans_[a].outputStreams;
+}
+
+const vector<RecordView<int32_t>> & HostDSP::process(unsigned a, const RecordView<int16_t> & record) {
+    AdcPlan & plan = plans_[a];
+    size_t numChannels = plan.channels.size();
+    if (workers_.empty() || numChannels < 2) {
+        for (size_t ct = 0; ct < numChannels; ct++) {
+            run_channel(plan, ct, record);
+        }
+        return plan.outputs;
+    }
+
+    // publish the job and work on it alongside the helpers
+    generation_++;
+    Job & job = jobs_[generation_ & 1];
+    job.plan.store(&plan, std::memory_order_relaxed);
+    job.record.store(&record, std::memory_order_relaxed);
+    jobRemaining_.store(numChannels, std::memory_order_relaxed);
+    ticket_.store(static_cast<uint64_t>(generation_) << 32, std::memory_order_release);
+
+    while (run_pending_channel()) {}
+    while (jobRemaining_.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+    }
+    return plan.outputs;
+}
+
+bool HostDSP::run_pending_channel() {
+    /*
+     * Claims and runs the next channel of the current job. A successful claim
+     * implies the job cannot have finished, so the slot read before it still
+     * belongs to the ticket's generation.
+     */
+    uint64_t ticket = ticket_.load(std::memory_order_acquire);
+    for (;;) {
+        const Job & job = jobs_[(ticket >> 32) & 1];
+        AdcPlan * plan = job.plan.load(std::memory_order_relaxed);
+        const RecordView<int16_t> * record = job.record.load(std::memory_order_relaxed);
+        size_t idx = ticket & 0xffffffff;
+        if (!plan || idx >= plan->channels.size()) {
+            return false;
+        }
+        if (ticket_.compare_exchange_weak(ticket, ticket + 1, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            run_channel(*plan, idx, *record);
+            jobRemaining_.fetch_sub(1, std::memory_order_release);
+            return true;
+        }
+    }
+}
+
+void HostDSP::worker() {
+    if (threadInit_) {
+        threadInit_();
+    }
+    unsigned idle = 0;
+    while (running_) {
+        if (run_pending_channel()) {
+            idle = 0;
+        } else if (++idle < 64) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+}
+
+void HostDSP::request_stop() {
+    running_ = false;
+}
+
+void HostDSP::stop() {
+    running_ = false;
+    for (auto & t : workers_) {
+        if (t.joinable()) {
+            t.join();
+        }
+    }
+    workers_.clear();
+    // the plans may be rebuilt before the next job is published
+    for (auto & job : jobs_) {
+        job.plan = nullptr;
+        job.record = nullptr;
+    }
+}
+
+void HostDSP::run_channel(AdcPlan & plan, size_t idx, const RecordView<int16_t> & record) {
+    ChannelPlan & ch = plan.channels[idx];
+    const size_t numTaps = ch.taps.size();
+    const size_t numIn = std::min(record.size(), ch.loRe.size());
+    const float rawScale = 1.0f / (1 << 13);
+
+    // mix down; the filter history in front of the record stays zero
+    float * mixRe = ch.mixRe.data() + numTaps - 1;
+    float * mixIm = ch.mixIm.data() + numTaps - 1;
+    const int16_t * raw = record.data();
+    const float * loRe = ch.loRe.data();
+    const float * loIm = ch.loIm.data();
+    for (size_t n = 0; n < numIn; n++) {
+        float x = raw[n] * rawScale;
+        mixRe[n] = x * loRe[n];
+        mixIm[n] = x * loIm[n];
+    }
+
+    // low-pass, evaluated only at the decimated output samples
+    const size_t D = ch.decimation;
+    const size_t numOut = std::min(ch.numOut, numIn / D);
+    const float * taps = ch.taps.data();
+    for (size_t m = 0; m < numOut; m++) {
+        size_t start = m * D + D - 1;
+        ch.outRe[m] = dot(taps, ch.mixRe.data() + start, numTaps);
+        ch.outIm[m] = dot(taps, ch.mixIm.data() + start, numTaps);
+    }
+    std::fill(ch.outRe.begin() + numOut, ch.outRe.end(), 0.0f);
+    std::fill(ch.outIm.begin() + numOut, ch.outIm.end(), 0.0f);
+
+    if (ch.demodOutput) {
+        int32_t * out = plan.outputData[ch.demodIndex].data();
+        for (size_t m = 0; m < ch.numOut; m++) {
+            out[2*m] = to_fixed(ch.outRe[m], ch.demodScale);
+            out[2*m + 1] = to_fixed(ch.outIm[m], ch.demodScale);
+        }
+    }
+
+    for (auto & kernel : ch.kernels) {
+        size_t len = kernel.re.size();
+        float re = dot(kernel.re.data(), ch.outRe.data(), len) - dot(kernel.im.data(), ch.outIm.data(), len);
+        float im = dot(kernel.re.data(), ch.outIm.data(), len) + dot(kernel.im.data(), ch.outRe.data(), len);
+        int32_t * out = plan.outputData[kernel.output].data();
+        out[0] = to_fixed(re + kernel.biasRe, kernel.scale);
+        out[1] = to_fixed(im + kernel.biasIm, kernel.scale);
+    }
+}
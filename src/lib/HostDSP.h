@@ -0,0 +1,147 @@
+// HostDSP.h
+//
+// Software digital down-conversion of raw (PHYSICAL) records on the host:
+// NCO mixing, decimating low-pass filtering and kernel integration for any
+// number of channels beyond the firmware's demodulators and integrators.
+// The outputs are published as virtual DEMOD and RESULT streams.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef HOSTDSP_H_
+#define HOSTDSP_H_
+
+#include <atomic>
+#include <complex>
+using std::complex;
+#include <functional>
+#include <map>
+using std::map;
+#include <thread>
+#include <vector>
+using std::vector;
+#include <cstdint>
+
+#include "QDSPStream.h"
+#include "RecordView.h"
+#include "constants.h"
+
+class HostDSP {
+public:
+	// run on each helper thread as it starts, e.g. to set its affinity
+	typedef std::function<void()> ThreadInit;
+
+	HostDSP();
+	~HostDSP();
+
+	void clear();
+	bool has_channel(unsigned, unsigned) const;
+
+	void set_nco_frequency(unsigned, unsigned, double);
+	double get_nco_frequency(unsigned, unsigned) const;
+	void set_decimation(unsigned, unsigned, unsigned, const vector<double> &);
+	unsigned get_decimation(unsigned, unsigned) const;
+	void write_kernel(unsigned, unsigned, unsigned, const vector<complex<double>> &);
+	complex<double> read_kernel(unsigned, unsigned, unsigned, unsigned) const;
+	void set_kernel_bias(unsigned, unsigned, unsigned, complex<double>);
+	complex<double> get_kernel_bias(unsigned, unsigned, unsigned) const;
+
+	void set_num_threads(unsigned);
+	void set_thread_init(ThreadInit);
+
+	void prepare(double, size_t, const vector<QDSPStream> &);
+	// restarts the helpers of a prepared acquisition after stop()
+	void start();
+	const vector<uint16_t> & get_output_streams(unsigned) const;
+	const vector<RecordView<int32_t>> & process(unsigned, const RecordView<int16_t> &);
+	// tells the helpers to exit without joining them
+	void request_stop();
+	void stop();
+
+	static vector<double> design_filter(unsigned);
+
+private:
+	HostDSP(const HostDSP&) = delete;
+	HostDSP& operator=(const HostDSP&) = delete;
+
+	struct Kernel {
+		vector<complex<double>> taps;
+		complex<double> bias;
+	};
+
+	// configuration of one channel (a,b)
+	struct Channel {
+		double frequency = 0;
+		unsigned decimation = HOST_DSP_DEFAULT_DECIMATION;
+		vector<double> filter; // empty for the default design
+		map<unsigned, Kernel> kernels;
+	};
+
+	struct KernelPlan {
+		vector<float> re;
+		vector<float> im;
+		float biasRe;
+		float biasIm;
+		float scale;
+		size_t output;
+	};
+
+	// everything one channel needs per record, laid out for vectorized loops
+	struct ChannelPlan {
+		unsigned decimation;
+		size_t numOut;
+		// NCO over one record; the phase restarts with every record
+		vector<float> loRe, loIm;
+		// filter taps in reverse order
+		vector<float> taps;
+		// mixed record, led by taps.size()-1 zeros for the filter history
+		vector<float> mixRe, mixIm;
+		// decimated baseband record
+		vector<float> outRe, outIm;
+		bool demodOutput;
+		size_t demodIndex;
+		float demodScale;
+		vector<KernelPlan> kernels;
+	};
+
+	struct AdcPlan {
+		vector<ChannelPlan> channels;
+		vector<uint16_t> outputStreams;
+		vector<vector<int32_t>> outputData;
+		vector<RecordView<int32_t>> outputs;
+	};
+
+	static uint16_t channel_key(unsigned, unsigned);
+	Channel & get_channel(unsigned, unsigned);
+	const Channel & find_channel(unsigned, unsigned) const;
+	const Kernel & find_kernel(unsigned, unsigned, unsigned) const;
+
+	void run_channel(AdcPlan &, size_t, const RecordView<int16_t> &);
+	void worker();
+	bool run_pending_channel();
+
+	map<uint16_t, Channel> channels_;
+	// indexed by physical channel a
+	vector<AdcPlan> plans_;
+	vector<uint16_t> noStreams_;
+
+	// helper threads splitting the channels of each record with the caller
+	unsigned numThreads_ = 1;
+	ThreadInit threadInit_;
+	vector<std::thread> workers_;
+	std::atomic<bool> running_;
+	// Current job: generation in the upper 32 bits, next unclaimed channel in
+	// the lower. Jobs alternate between two slots by generation, so a helper
+	// holding a stale ticket never sees the slot of the job being published.
+	struct Job {
+		std::atomic<AdcPlan *> plan;
+		std::atomic<const RecordView<int16_t> *> record;
+	};
+	Job jobs_[2];
+	std::atomic<uint64_t> ticket_;
+	std::atomic<size_t> jobRemaining_;
+	uint32_t generation_ = 0;
+};
+
+#endif // HOSTDSP_H_
@@ -0,0 +1,106 @@
+// KernelBank.cpp
+//
+// Applies a bank of complex integration kernels to each record of a demod
+// stream in one pass, so a single acquisition scores all of them.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#include "KernelBank.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "X6_errno.h"
+#include "logging.h"
+
+namespace {
+
+const size_t LANES = 8;
+
+inline int32_t to_fixed(float val, float scale) {
+    const float limit = 2147483520.0f; // largest float below 2^31
+    float scaled = std::max(-limit, std::min(limit, val * scale));
+    return static_cast<int32_t>(std::lrint(scaled));
+}
+
+} // namespace
+
+KernelBank::KernelBank(const vector<vector<complex<double>>> & kernels) : kernels_(kernels) {
+    if (kernels_.empty()) {
+        LOG(plog::error) << "A kernel bank needs at least one kernel";
+        throw X6_INVALID_KERNEL_LENGTH;
+    }
+    for (auto & kernel : kernels_) {
+        if (kernel.empty()) {
+            LOG(plog::error) << "Kernel bank kernels must not be empty";
+            throw X6_INVALID_KERNEL_LENGTH;
+        }
+    }
+}
+
+void KernelBank::prepare(size_t recordLength, double inputScale, double outputScale) {
+    /*
+     * Lays the kernels out for records of recordLength complex samples.
+     * inputScale and outputScale are the fixed point scales of the demod and
+     * kernel bank streams.
+     */
+    recordLength_ = recordLength;
+    inputScale_ = static_cast<float>(1.0 / inputScale);
+    outputScale_ = static_cast<float>(outputScale);
+
+    size_t numKernels = kernels_.size();
+    kernelRe_.assign(numKernels * recordLength_, 0.0f);
+    kernelIm_.assign(numKernels * recordLength_, 0.0f);
+    for (size_t k = 0; k < numKernels; k++) {
+        size_t len = std::min(kernels_[k].size(), recordLength_);
+        for (size_t n = 0; n < len; n++) {
+            kernelRe_[k * recordLength_ + n] = static_cast<float>(std::real(kernels_[k][n]));
+            kernelIm_[k * recordLength_ + n] = static_cast<float>(std::imag(kernels_[k][n]));
+        }
+    }
+    recordRe_.assign(recordLength_, 0.0f);
+    recordIm_.assign(recordLength_, 0.0f);
+    results_.assign(2 * numKernels, 0);
+    output_ = RecordView<int32_t>(results_.data(), results_.size());
+}
+
+void KernelBank::integrate() {
+    /*
+     * Complex matrix-vector product of the bank with the current record. The
+     * lanes are independent partial sums so the inner loop vectorizes without
+     * reassociating the floating point additions.
+     */
+    const float * yr = recordRe_.data();
+    const float * yi = recordIm_.data();
+    const size_t M = recordLength_;
+    const size_t blocked = M - M % LANES;
+
+    for (size_t k = 0; k < kernels_.size(); k++) {
+        const float * kr = kernelRe_.data() + k * M;
+        const float * ki = kernelIm_.data() + k * M;
+        float rr[LANES] = {0}, ii[LANES] = {0}, ri[LANES] = {0}, ir[LANES] = {0};
+        for (size_t n = 0; n < blocked; n += LANES) {
+            for (size_t l = 0; l < LANES; l++) {
+                rr[l] += kr[n+l] * yr[n+l];
+                ii[l] += ki[n+l] * yi[n+l];
+                ri[l] += kr[n+l] * yi[n+l];
+                ir[l] += ki[n+l] * yr[n+l];
+            }
+        }
+        for (size_t n = blocked; n < M; n++) {
+            rr[0] += kr[n] * yr[n];
+            ii[0] += ki[n] * yi[n];
+            ri[0] += kr[n] * yi[n];
+            ir[0] += ki[n] * yr[n];
+        }
+        float re = 0, im = 0;
+        for (size_t l = 0; l < LANES; l++) {
+            re += rr[l] - ii[l];
+            im += ri[l] + ir[l];
+        }
+        results_[2*k] = to_fixed(re, outputScale_);
+        results_[2*k + 1] = to_fixed(im, outputScale_);
+    }
+}
@@ -0,0 +1,71 @@
+// KernelBank.h
+//
+// Applies a bank of complex integration kernels to each record of a demod
+// stream in one pass, so a single acquisition scores all of them. The results
+// of a record form one record of the kernel bank stream (a,b,15).
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef KERNELBANK_H_
+#define KERNELBANK_H_
+
+#include <algorithm>
+#include <complex>
+using std::complex;
+#include <vector>
+using std::vector;
+#include <cstdint>
+
+#include "RecordView.h"
+#include "AlignedAllocator.h"
+
+class KernelBank {
+public:
+	KernelBank() {}
+	KernelBank(const vector<vector<complex<double>>> &);
+
+	size_t size() const { return kernels_.size(); }
+	const vector<complex<double>> & get_kernel(size_t idx) const { return kernels_[idx]; }
+
+	void prepare(size_t, double, double);
+
+	template <class T>
+	const RecordView<int32_t> & apply(const RecordView<T> &);
+
+private:
+	typedef vector<float, AlignedAllocator<float>> FloatArray;
+
+	void integrate();
+
+	vector<vector<complex<double>>> kernels_;
+	// kernels as K x M planar matrices, zero padded or truncated to the record
+	size_t recordLength_ = 0;
+	FloatArray kernelRe_, kernelIm_;
+	// the current record, deinterleaved and scaled to floating point
+	FloatArray recordRe_, recordIm_;
+	float inputScale_ = 1;
+	float outputScale_ = 1;
+	vector<int32_t> results_;
+	RecordView<int32_t> output_;
+};
+
+template <class T>
+const RecordView<int32_t> & KernelBank::apply(const RecordView<T> & record) {
+	// demod records interleave real and imaginary samples
+	size_t len = std::min(record.size() / 2, recordLength_);
+	const T * data = record.data();
+	for (size_t n = 0; n < len; n++) {
+		recordRe_[n] = data[2*n] * inputScale_;
+		recordIm_[n] = data[2*n + 1] * inputScale_;
+	}
+	for (size_t n = len; n < recordLength_; n++) {
+		recordRe_[n] = 0;
+		recordIm_[n] = 0;
+	}
+	integrate();
+	return output_;
+}
+
+#endif // KERNELBANK_H_
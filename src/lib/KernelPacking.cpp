@@ -0,0 +1,51 @@
+// KernelPacking.cpp
+//
+// Conversion between integration kernels and the words of the firmware kernel
+// memory.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#include "KernelPacking.h"
+
+#include <algorithm>
+
+#include "constants.h"
+#include "logging.h"
+#include "X6_errno.h"
+
+void pack_kernel(const complex<double> * kernel, size_t length, uint32_t * words) {
+    // std::complex is laid out as real, imaginary, so the kernel is one run
+    // of 2*length doubles
+    const double * vals = reinterpret_cast<const double *>(kernel);
+    const size_t numVals = 2 * length;
+
+    double lo = 0, hi = 0;
+    for (size_t ct = 0; ct < numVals; ct++) {
+        lo = std::min(lo, vals[ct]);
+        hi = std::max(hi, vals[ct]);
+    }
+    const double oneBitLevel = 1.0 / (1 << KERNEL_FRAC_BITS);
+    if (hi > MAX_KERNEL_VALUE + 1.5 * oneBitLevel || lo < MIN_KERNEL_VALUE - 0.5 * oneBitLevel) {
+        LOG(plog::error) << "kernel value " << ((hi > MAX_KERNEL_VALUE) ? hi : lo) << " is out of range";
+        throw X6_KERNEL_OUT_OF_RANGE;
+    }
+
+    const double scale = 1 << KERNEL_FRAC_BITS;
+    for (size_t ct = 0; ct < length; ct++) {
+        // truncated toward zero like any double to integer conversion
+        int32_t re = static_cast<int32_t>(std::max(std::min(vals[2*ct], MAX_KERNEL_VALUE), MIN_KERNEL_VALUE) * scale);
+        int32_t im = static_cast<int32_t>(std::max(std::min(vals[2*ct + 1], MAX_KERNEL_VALUE), MIN_KERNEL_VALUE) * scale);
+        words[ct] = (static_cast<uint32_t>(im) << 16) | (static_cast<uint32_t>(re) & 0xffff);
+    }
+}
+
+void unpack_kernel(const uint32_t * words, size_t length, complex<double> * kernel) {
+    const double scale = (1 << 15) - 1;
+    for (size_t ct = 0; ct < length; ct++) {
+        int16_t re = static_cast<int16_t>(words[ct] & 0xffff);
+        int16_t im = static_cast<int16_t>(words[ct] >> 16);
+        kernel[ct] = complex<double>(re / scale, im / scale);
+    }
+}
@@ -0,0 +1,25 @@
+// KernelPacking.h
+//
+// Conversion between integration kernels and the words of the firmware kernel
+// memory: each complex point is quantised to two 16-bit fixed point values,
+// the imaginary part in the upper half of the word. A whole kernel converts in
+// one pass so that uploads and readbacks can go out as one register batch.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef KERNELPACKING_H_
+#define KERNELPACKING_H_
+
+#include <complex>
+using std::complex;
+#include <cstddef>
+#include <cstdint>
+
+// throws X6_KERNEL_OUT_OF_RANGE unless every part lies in [-1, 1) up to the
+// rounding of the fixed point format; values just outside are clipped
+void pack_kernel(const complex<double> *, size_t, uint32_t *);
+void unpack_kernel(const uint32_t *, size_t, complex<double> *);
+
+#endif // KERNELPACKING_H_
@@ -0,0 +1,128 @@
+// MPMCQueue.h
+//
+// Bounded lock-free queue that any number of threads may push to and pop
+// from, after Dmitry Vyukov's bounded MPMC queue: every slot carries a
+// sequence number telling producers and consumers whose turn it is.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef MPMCQUEUE_H_
+#define MPMCQUEUE_H_
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "AlignedAllocator.h"
+
+template <class T>
+class MPMCQueue {
+public:
+	explicit MPMCQueue(size_t capacity = 1024);
+
+	bool push(T &&);
+	bool pop(T &);
+	size_t size() const;
+	size_t capacity() const;
+
+private:
+	MPMCQueue(const MPMCQueue&) = delete;
+	MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+	struct Cell {
+		std::atomic<size_t> sequence;
+		T data;
+	};
+
+	std::vector<Cell> buffer_;
+	size_t mask_;
+	char padHead_[CACHE_LINE_SIZE];
+	std::atomic<size_t> head_;
+	char padTail_[CACHE_LINE_SIZE];
+	std::atomic<size_t> tail_;
+};
+
+template <class T>
+MPMCQueue<T>::MPMCQueue(size_t capacity) : head_{0}, tail_{0} {
+	// round up to a power of two (and at least two) so indices wrap with a mask
+	size_t size = 2;
+	while (size < capacity) {
+		size <<= 1;
+	}
+	buffer_ = std::vector<Cell>(size);
+	mask_ = size - 1;
+	for (size_t ct = 0; ct < size; ct++) {
+		buffer_[ct].sequence.store(ct, std::memory_order_relaxed);
+	}
+}
+
+template <class T>
+bool MPMCQueue<T>::push(T && item) {
+	// leaves item untouched if the queue is full
+	size_t pos = tail_.load(std::memory_order_relaxed);
+	Cell * cell;
+	for (;;) {
+		cell = &buffer_[pos & mask_];
+		size_t seq = cell->sequence.load(std::memory_order_acquire);
+		intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+		if (diff == 0) {
+			// slot is free for this position; claim it
+			if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+				break;
+			}
+		} else if (diff < 0) {
+			// slot still holds the item from one lap ago
+			return false;
+		} else {
+			// another producer claimed this position first
+			pos = tail_.load(std::memory_order_relaxed);
+		}
+	}
+	cell->data = std::move(item);
+	cell->sequence.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+template <class T>
+bool MPMCQueue<T>::pop(T & item) {
+	size_t pos = head_.load(std::memory_order_relaxed);
+	Cell * cell;
+	for (;;) {
+		cell = &buffer_[pos & mask_];
+		size_t seq = cell->sequence.load(std::memory_order_acquire);
+		intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+		if (diff == 0) {
+			if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+				break;
+			}
+		} else if (diff < 0) {
+			// nothing published at this position yet
+			return false;
+		} else {
+			pos = head_.load(std::memory_order_relaxed);
+		}
+	}
+	item = std::move(cell->data);
+	cell->data = T();
+	// hand the slot to the producer one lap ahead
+	cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+	return true;
+}
+
+template <class T>
+size_t MPMCQueue<T>::size() const {
+	size_t tail = tail_.load(std::memory_order_acquire);
+	size_t head = head_.load(std::memory_order_acquire);
+	return tail > head ? tail - head : 0;
+}
+
+template <class T>
+size_t MPMCQueue<T>::capacity() const {
+	return buffer_.size();
+}
+
+#endif // MPMCQUEUE_H_
@@ -0,0 +1,245 @@
+// MemoryPolicy.cpp
+//
+// Allocation of the large per-stream buffers (accumulators and record
+// queues) with optional huge page backing and first-touch placement on the
+// NUMA node of the processing thread.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#include "MemoryPolicy.h"
+#include "AlignedAllocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <cstdlib>
+
+#include <plog/Log.h>
+
+#ifdef __linux__
+	#include <sys/mman.h>
+	#include <pthread.h>
+	#include <sched.h>
+	#include <cstring>
+	#include <cerrno>
+#elif defined(_WIN32)
+	#include <malloc.h>
+#endif
+
+namespace {
+
+// buffers smaller than this are not worth a mapping of their own
+const size_t MIN_MAPPED_SIZE = 1 << 20;
+const size_t HUGE_PAGE_SIZE = 2 << 20;
+const size_t SMALL_PAGE_SIZE = 4096;
+
+struct Allocation {
+	size_t bytes;  // bytes requested
+	size_t mapped; // bytes mapped, 0 for heap allocations
+	bool huge;
+};
+
+std::atomic<int> mode_{HUGEPAGE_NONE};
+thread_local uint64_t firstTouchCPUs_ = 0;
+
+std::mutex mutex_;
+std::map<void *, Allocation> allocations_;
+MemoryStats stats_ = {0, 0, 0, 0, 0};
+
+size_t round_up(size_t bytes, size_t multiple) {
+	return (bytes + multiple - 1) / multiple * multiple;
+}
+
+void * heap_allocate(size_t bytes) {
+	void * ptr = nullptr;
+#ifdef _WIN32
+	ptr = _aligned_malloc(bytes, CACHE_LINE_SIZE);
+#else
+	if (posix_memalign(&ptr, CACHE_LINE_SIZE, bytes) != 0) {
+		ptr = nullptr;
+	}
+#endif
+	return ptr;
+}
+
+void heap_free(void * ptr) {
+#ifdef _WIN32
+	_aligned_free(ptr);
+#else
+	free(ptr);
+#endif
+}
+
+#ifdef __linux__
+void * map_explicit(size_t mapped) {
+	void * ptr = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	return (ptr == MAP_FAILED) ? nullptr : ptr;
+}
+
+void * map_aligned(size_t mapped, bool advise) {
+	// over-map so the buffer can start on a huge page boundary, then trim
+	size_t span = mapped + HUGE_PAGE_SIZE;
+	void * raw = mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (raw == MAP_FAILED) {
+		return nullptr;
+	}
+	uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+	uintptr_t aligned = round_up(start, HUGE_PAGE_SIZE);
+	if (aligned > start) {
+		munmap(raw, aligned - start);
+	}
+	size_t tail = span - (aligned - start) - mapped;
+	if (tail > 0) {
+		munmap(reinterpret_cast<void *>(aligned + mapped), tail);
+	}
+	void * ptr = reinterpret_cast<void *>(aligned);
+	if (advise && madvise(ptr, mapped, MADV_HUGEPAGE) != 0) {
+		LOG(plog::debug) << "madvise(MADV_HUGEPAGE) failed: " << std::strerror(errno);
+	}
+	return ptr;
+}
+
+void first_touch(void * ptr, size_t bytes, uint64_t cpuMask) {
+	/*
+	 * Faults every page in from a thread pinned to the given CPUs so the
+	 * kernel places it on their NUMA node. Later writes from other threads,
+	 * e.g. zero filling on the caller, no longer decide placement.
+	 */
+	std::thread toucher([ptr, bytes, cpuMask]() {
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		for (unsigned cpu = 0; cpu < 64; cpu++) {
+			if ((cpuMask >> cpu) & 1) {
+				CPU_SET(cpu, &cpus);
+			}
+		}
+		if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpus) != 0) {
+			LOG(plog::warning) << "Failed to pin first-touch thread; buffer placement is up to the kernel";
+		}
+		volatile char * bytesPtr = static_cast<volatile char *>(ptr);
+		for (size_t offset = 0; offset < bytes; offset += SMALL_PAGE_SIZE) {
+			bytesPtr[offset] = 0;
+		}
+	});
+	toucher.join();
+}
+#endif
+
+} // anonymous namespace
+
+void MemoryPolicy::set_mode(X6_HUGEPAGE_MODE mode) {
+#ifndef __linux__
+	if (mode != HUGEPAGE_NONE) {
+		LOG(plog::warning) << "Huge page buffers are only supported on Linux; using the default allocator.";
+	}
+#endif
+	mode_ = mode;
+}
+
+X6_HUGEPAGE_MODE MemoryPolicy::get_mode() {
+	return static_cast<X6_HUGEPAGE_MODE>(mode_.load());
+}
+
+void MemoryPolicy::set_first_touch_cpus(uint64_t cpuMask) {
+	firstTouchCPUs_ = cpuMask;
+}
+
+MemoryPolicy::ReserveOnly::ReserveOnly() : cpus_{firstTouchCPUs_} {
+	firstTouchCPUs_ = 0;
+}
+
+MemoryPolicy::ReserveOnly::~ReserveOnly() {
+	firstTouchCPUs_ = cpus_;
+}
+
+void * MemoryPolicy::allocate(size_t bytes) {
+	if (bytes == 0) {
+		return nullptr;
+	}
+	Allocation info = {bytes, 0, false};
+	void * ptr = nullptr;
+	bool fellBack = false;
+
+#ifdef __linux__
+	X6_HUGEPAGE_MODE mode = get_mode();
+	bool mapped = bytes >= MIN_MAPPED_SIZE && (mode != HUGEPAGE_NONE || firstTouchCPUs_ != 0);
+	if (mapped) {
+		info.mapped = round_up(bytes, HUGE_PAGE_SIZE);
+		if (mode == HUGEPAGE_EXPLICIT) {
+			ptr = map_explicit(info.mapped);
+			if (ptr) {
+				info.huge = true;
+			} else {
+				LOG(plog::warning) << "No reserved huge pages for a " << (bytes >> 20)
+				                   << " MB buffer; falling back to transparent huge pages";
+				fellBack = true;
+			}
+		}
+		if (!ptr) {
+			ptr = map_aligned(info.mapped, mode != HUGEPAGE_NONE);
+			info.huge = ptr && mode != HUGEPAGE_NONE;
+		}
+		if (ptr && firstTouchCPUs_ != 0) {
+			first_touch(ptr, info.mapped, firstTouchCPUs_);
+		}
+		if (!ptr) {
+			info.mapped = 0;
+		}
+	}
+#endif
+
+	if (!ptr) {
+		ptr = heap_allocate(bytes);
+	}
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	allocations_[ptr] = info;
+	stats_.bytesInUse += bytes;
+	stats_.peakBytes = std::max(stats_.peakBytes, stats_.bytesInUse);
+	stats_.hugePageBytes += info.huge ? bytes : 0;
+	stats_.allocations++;
+	stats_.fallbacks += fellBack ? 1 : 0;
+	if (info.mapped) {
+		LOG(plog::debug) << "Allocated " << (bytes >> 20) << " MB stream buffer"
+		                 << (info.huge ? " on huge pages" : "");
+	}
+	return ptr;
+}
+
+void MemoryPolicy::deallocate(void * ptr) {
+	if (!ptr) {
+		return;
+	}
+	Allocation info;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto it = allocations_.find(ptr);
+		if (it == allocations_.end()) {
+			LOG(plog::error) << "Tried to free a buffer MemoryPolicy did not allocate";
+			return;
+		}
+		info = it->second;
+		allocations_.erase(it);
+		stats_.bytesInUse -= info.bytes;
+		stats_.hugePageBytes -= info.huge ? info.bytes : 0;
+	}
+#ifdef __linux__
+	if (info.mapped) {
+		munmap(ptr, info.mapped);
+		return;
+	}
+#endif
+	heap_free(ptr);
+}
+
+MemoryStats MemoryPolicy::get_stats() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return stats_;
+}
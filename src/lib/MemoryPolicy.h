@@ -0,0 +1,86 @@
+// MemoryPolicy.h
+//
+// Allocation of the large per-stream buffers (accumulators and record
+// queues) with optional huge page backing and first-touch placement on the
+// NUMA node of the processing thread.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef MEMORYPOLICY_H_
+#define MEMORYPOLICY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "X6_enums.h"
+
+class MemoryPolicy {
+public:
+	// library-wide, takes effect for buffers allocated at the next acquire()
+	static void set_mode(X6_HUGEPAGE_MODE);
+	static X6_HUGEPAGE_MODE get_mode();
+	// CPUs to fault new pages in from; applies to allocations made by the
+	// calling thread, 0 touches them from the calling thread itself
+	static void set_first_touch_cpus(uint64_t);
+
+	// Suspends first touch on the calling thread while in scope, for capacity
+	// that is only reserved. Its pages are committed, and placed, by whichever
+	// thread first writes them.
+	class ReserveOnly {
+	public:
+		ReserveOnly();
+		~ReserveOnly();
+	private:
+		ReserveOnly(const ReserveOnly&) = delete;
+		ReserveOnly& operator=(const ReserveOnly&) = delete;
+		uint64_t cpus_;
+	};
+
+	static void * allocate(size_t);
+	static void deallocate(void *);
+	static MemoryStats get_stats();
+};
+
+template <class T>
+class HugePageAllocator {
+public:
+	typedef T value_type;
+	typedef T * pointer;
+	typedef const T * const_pointer;
+	typedef T & reference;
+	typedef const T & const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	template <class U>
+	struct rebind {
+		typedef HugePageAllocator<U> other;
+	};
+
+	HugePageAllocator() {}
+	template <class U>
+	HugePageAllocator(const HugePageAllocator<U> &) {}
+
+	T * allocate(size_t n) {
+		return static_cast<T *>(MemoryPolicy::allocate(n * sizeof(T)));
+	}
+
+	void deallocate(T * ptr, size_t) {
+		MemoryPolicy::deallocate(ptr);
+	}
+};
+
+template <class T, class U>
+bool operator==(const HugePageAllocator<T> &, const HugePageAllocator<U> &) {
+	return true;
+}
+
+template <class T, class U>
+bool operator!=(const HugePageAllocator<T> &, const HugePageAllocator<U> &) {
+	return false;
+}
+
+#endif // MEMORYPOLICY_H_
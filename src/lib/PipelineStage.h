@@ -0,0 +1,201 @@
+// PipelineStage.h
+//
+// One stage of the acquisition pipeline: a worker thread draining a
+// lock-free input queue through a handler, with depth statistics.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef PIPELINESTAGE_H_
+#define PIPELINESTAGE_H_
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+
+#include "SPSCQueue.h"
+#include "X6_enums.h"
+
+template <class T>
+class PipelineStage {
+public:
+	typedef std::function<void(T &)> Handler;
+	// run on the worker thread before it takes its first item
+	typedef std::function<void()> ThreadInit;
+
+	explicit PipelineStage(size_t capacity = 64);
+	~PipelineStage();
+
+	void set_capacity(size_t);
+	void set_thread_init(ThreadInit);
+	void set_drain_on_stop(bool);
+	void start(Handler);
+	void request_stop();
+	void stop();
+	bool push(T &&);
+	bool is_worker_thread() const;
+	PipelineStats get_stats() const;
+
+private:
+	PipelineStage(const PipelineStage&) = delete;
+	PipelineStage& operator=(const PipelineStage&) = delete;
+
+	void run();
+	static void backoff(unsigned &);
+
+	std::unique_ptr<SPSCQueue<T>> queue_;
+	Handler handler_;
+	ThreadInit threadInit_;
+	std::thread thread_;
+	std::atomic<bool> running_;
+	bool drainOnStop_ = false;
+
+	std::atomic<uint64_t> highWater_;
+	std::atomic<uint64_t> processed_;
+	std::atomic<uint64_t> stalls_;
+};
+
+template <class T>
+PipelineStage<T>::PipelineStage(size_t capacity) :
+	queue_{new SPSCQueue<T>(capacity)}, running_{false}, highWater_{0}, processed_{0}, stalls_{0} {}
+
+template <class T>
+PipelineStage<T>::~PipelineStage() {
+	stop();
+	if (thread_.joinable()) {
+		thread_.join();
+	}
+}
+
+template <class T>
+void PipelineStage<T>::set_capacity(size_t capacity) {
+	// only while stopped
+	if (capacity != queue_->capacity()) {
+		queue_.reset(new SPSCQueue<T>(capacity));
+	}
+}
+
+template <class T>
+void PipelineStage<T>::set_thread_init(ThreadInit init) {
+	threadInit_ = init;
+}
+
+template <class T>
+void PipelineStage<T>::set_drain_on_stop(bool drain) {
+	// only while stopped; a draining worker handles what is already queued
+	// before it exits instead of discarding it
+	drainOnStop_ = drain;
+}
+
+template <class T>
+void PipelineStage<T>::start(Handler handler) {
+	stop();
+	// a worker that stopped itself is still joinable
+	if (thread_.joinable()) {
+		thread_.join();
+	}
+	queue_->clear();
+	highWater_ = 0;
+	processed_ = 0;
+	stalls_ = 0;
+	handler_ = handler;
+	running_ = true;
+	thread_ = std::thread(&PipelineStage<T>::run, this);
+}
+
+template <class T>
+void PipelineStage<T>::request_stop() {
+	// flag only, so stages feeding each other can all be told before any join
+	running_ = false;
+}
+
+template <class T>
+void PipelineStage<T>::stop() {
+	/*
+	 * Stops the worker and, unless it drains on stop, discards anything still
+	 * queued. May be called from
+	 * the worker itself, e.g. from a handler that decides the acquisition is
+	 * done, in which case the thread is joined by the next start().
+	 */
+	running_ = false;
+	if (thread_.joinable() && !is_worker_thread()) {
+		thread_.join();
+	}
+}
+
+template <class T>
+bool PipelineStage<T>::push(T && item) {
+	// waits while the queue is full; returns false if the stage stopped
+	if (!running_) {
+		return false;
+	}
+	unsigned spins = 0;
+	bool stalled = false;
+	while (!queue_->push(std::move(item))) {
+		if (!running_) {
+			return false;
+		}
+		if (!stalled) {
+			stalls_++;
+			stalled = true;
+		}
+		backoff(spins);
+	}
+	uint64_t depth = queue_->size();
+	uint64_t highWater = highWater_.load(std::memory_order_relaxed);
+	while (depth > highWater && !highWater_.compare_exchange_weak(highWater, depth)) {}
+	return true;
+}
+
+template <class T>
+bool PipelineStage<T>::is_worker_thread() const {
+	return std::this_thread::get_id() == thread_.get_id();
+}
+
+template <class T>
+PipelineStats PipelineStage<T>::get_stats() const {
+	PipelineStats stats;
+	stats.depth = queue_->size();
+	stats.highWater = highWater_;
+	stats.capacity = queue_->capacity();
+	stats.processed = processed_;
+	stats.stalls = stalls_;
+	return stats;
+}
+
+template <class T>
+void PipelineStage<T>::run() {
+	if (threadInit_) {
+		threadInit_();
+	}
+	T item;
+	unsigned spins = 0;
+	while (running_ || drainOnStop_) {
+		if (queue_->pop(item)) {
+			handler_(item);
+			// drop references held by the item before waiting for the next
+			item = T();
+			processed_++;
+			spins = 0;
+		} else if (!running_) {
+			break;
+		} else {
+			backoff(spins);
+		}
+	}
+}
+
+template <class T>
+void PipelineStage<T>::backoff(unsigned & spins) {
+	// spin briefly to catch back-to-back buffers, then stop burning the core
+	if (++spins < 64) {
+		std::this_thread::yield();
+	} else {
+		std::this_thread::sleep_for(std::chrono::microseconds(50));
+	}
+}
+
+#endif // PIPELINESTAGE_H_
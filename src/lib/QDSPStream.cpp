@@ -14,7 +14,18 @@ QDSPStream::QDSPStream() : channelID{0,0,0}, streamID{0}, type{PHYSICAL} {};
 
 QDSPStream::QDSPStream(unsigned a, unsigned b, unsigned c) : channelID{a,b,c} {
     streamID = (a << 8) + (b << 4) + c;
-    if ((b == 0) && (c == 0)) {
+    if ((a == DISCRIMINATOR_CHANNEL) && (b != 0)) {
+        // classified states of a host discriminator
+        type = STATE;
+    }
+    else if (b >= HOST_DSP_FIRST_CHANNEL) {
+        // host DSP channels only have a demod stream and kernel results
+        type = (c == 0) ? DEMOD : RESULT;
+    }
+    else if ((b != 0) && (c == KERNEL_BANK_STREAM)) {
+        type = RESULT;
+    }
+    else if ((b == 0) && (c == 0)) {
         type = PHYSICAL;
     }
     else if (c != 0) {
@@ -38,7 +49,17 @@ QDSPStream::QDSPStream(unsigned a, unsigned b, unsigned c) : channelID{a,b,c} {
 
 QDSPStream::QDSPStream(unsigned a, unsigned b, unsigned c, unsigned numRawInt) : channelID{a,b,c} {
     streamID = (a << 8) + (b << 4) + c;
-    if ((b == 0) && (c == 0)) {
+    if ((a == DISCRIMINATOR_CHANNEL) && (b != 0)) {
+        // classified states of a host discriminator
+        type = STATE;
+    }
+    else if (b >= HOST_DSP_FIRST_CHANNEL) {
+        type = (c == 0) ? DEMOD : RESULT;
+    }
+    else if ((b != 0) && (c == KERNEL_BANK_STREAM)) {
+        type = RESULT;
+    }
+    else if ((b == 0) && (c == 0)) {
         type = PHYSICAL;
     }
     else if (c != 0) {
@@ -60,6 +81,22 @@ QDSPStream::QDSPStream(unsigned a, unsigned b, unsigned c, unsigned numRawInt) :
     }
 };
 
+bool QDSPStream::is_host() const {
+    return (channelID[0] != DISCRIMINATOR_CHANNEL) && (channelID[1] >= HOST_DSP_FIRST_CHANNEL);
+}
+
+bool QDSPStream::is_kernel_bank() const {
+    return (channelID[0] != DISCRIMINATOR_CHANNEL) && (channelID[1] != 0) && (channelID[2] == KERNEL_BANK_STREAM);
+}
+
+bool QDSPStream::is_discriminator() const {
+    return (channelID[0] == DISCRIMINATOR_CHANNEL) && (channelID[1] != 0);
+}
+
+bool QDSPStream::computed_on_host() const {
+    return is_host() || is_kernel_bank() || is_discriminator();
+}
+
 unsigned QDSPStream::fixed_to_float() const {
     switch (type) {
         case PHYSICAL:
@@ -90,9 +127,15 @@ size_t QDSPStream::calc_record_length(const size_t & recordLength) const {
             return recordLength / RAW_DECIMATION_FACTOR;
             break;
         case DEMOD:
+            if (hostDecimation) {
+                return 2 * (recordLength / RAW_DECIMATION_FACTOR / hostDecimation);
+            }
             return 2 * recordLength / DEMOD_DECIMATION_FACTOR;
             break;
         case RESULT:
+            if (bankSize) {
+                return 2 * bankSize;
+            }
         case STATE:
         case CORRELATED:
             return 2;
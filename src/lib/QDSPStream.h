@@ -25,7 +25,16 @@ public:
 	unsigned channelID[3];
 	uint16_t streamID;
 	STREAM_T type;
+	// decimation of a host DSP demod stream relative to the raw stream
+	unsigned hostDecimation = 0;
+	// number of kernels of a kernel bank result stream
+	unsigned bankSize = 0;
 
+	bool is_host() const;
+	bool is_kernel_bank() const;
+	bool is_discriminator() const;
+	// true for streams the driver computes rather than receives from the card
+	bool computed_on_host() const;
 	unsigned fixed_to_float() const;
 	size_t calc_record_length(const size_t &) const;
 };
@@ -0,0 +1,55 @@
+// RearmSession.h
+//
+// Whether the card setup a fast re-arm leaves alone is still what the last
+// full acquire() left. A re-arm skips the trigger routing and the Velo packet
+// setup, so only register writes that may touch those invalidate the session.
+// DSP configuration (NCO, thresholds, kernels, biases) is applied by the
+// firmware as it is written and never rewritten by acquire(), and the pulse
+// generators are enabled again at every acquire(), so writes to the DSP and
+// pulse generator blocks keep the session.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef REARMSESSION_H_
+#define REARMSESSION_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+#include "constants.h"
+#include "RegisterBus.h"
+
+class RearmSession {
+public:
+	bool is_valid() const { return valid_; }
+	void validate() { valid_ = true; }
+	void invalidate() { valid_ = false; }
+
+	static bool keeps_session(uint32_t base) {
+		return std::find(BASE_DSP.begin(), BASE_DSP.end(), base) != BASE_DSP.end() ||
+		       std::find(BASE_PG.begin(), BASE_PG.end(), base) != BASE_PG.end();
+	}
+
+	void written(uint32_t base) {
+		if (!keeps_session(base)) {
+			valid_ = false;
+		}
+	}
+
+	void written(const RegisterBatch & batch) {
+		for (auto & access : batch.accesses()) {
+			if (!access.result) {
+				written(access.base);
+			}
+		}
+	}
+
+private:
+	// written from sweep threads as well as the client's
+	std::atomic<bool> valid_{false};
+};
+
+#endif // REARMSESSION_H_
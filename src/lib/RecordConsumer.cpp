@@ -0,0 +1,116 @@
+// RecordConsumer.cpp
+//
+// In-process record consumers: C callbacks registered per stream that are
+// handed read-only views of the records straight out of the received
+// buffers, a batch per buffer, without copying them or leaving the process.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#include "RecordConsumer.h"
+
+#include <algorithm>
+
+void RecordConsumers::set(uint16_t streamID, X6_RECORD_CONSUMER consumer, void * context) {
+    if (consumer) {
+        registered_[streamID] = Registration{consumer, context};
+    } else {
+        registered_.erase(streamID);
+    }
+}
+
+void RecordConsumers::clear() {
+    // the slots are left to a consume thread that may still be draining and
+    // are rebuilt by the next bind()
+    registered_.clear();
+}
+
+bool RecordConsumers::empty() const {
+    return registered_.empty();
+}
+
+void RecordConsumers::bind(int deviceID, const vector<QDSPStream> & slotStreams, size_t numRecords,
+                           unsigned waveforms, unsigned numSegments) {
+    /*
+     * Resolves the registrations against the demux slots of the coming
+     * acquisition. slotStreams[slot] is the stream the demux assigned to slot.
+     */
+    deviceID_ = deviceID;
+    numRecords_ = numRecords;
+    waveforms_ = std::max(waveforms, 1u);
+    numSegments_ = std::max(numSegments, 1u);
+    slots_.clear();
+    slots_.resize(slotStreams.size());
+    pending_.clear();
+    pending_.reserve(slotStreams.size());
+
+    for (size_t slot = 0; slot < slotStreams.size(); slot++) {
+        const QDSPStream & stream = slotStreams[slot];
+        auto it = registered_.find(stream.streamID);
+        if (it == registered_.end()) {
+            continue;
+        }
+        SlotState & state = slots_[slot];
+        state.consumer = it->second.consumer;
+        state.context = it->second.context;
+        state.view.streamID = stream.streamID;
+        state.view.numRecords = 0;
+        state.view.recordLength = 0;
+        // physical and demodulated samples are 16-bit, everything else 32-bit
+        state.view.sampleBytes = (stream.type == PHYSICAL || stream.type == DEMOD) ? 2 : 4;
+        state.view.scale = stream.fixed_to_float();
+        state.view.records = nullptr;
+        state.view.metadata = nullptr;
+    }
+}
+
+void RecordConsumers::reset() {
+    for (auto & state : slots_) {
+        state.records.clear();
+        state.metadata.clear();
+        state.recordIndex = 0;
+    }
+    pending_.clear();
+}
+
+void RecordConsumers::add_record(unsigned slot, const uint32_t * data, size_t numWords, const VitaHeader & vh) {
+    if (slot >= slots_.size()) {
+        return;
+    }
+    SlotState & state = slots_[slot];
+    if (!state.consumer || state.recordIndex >= numRecords_) {
+        return;
+    }
+    if (state.records.empty()) {
+        pending_.push_back(slot);
+    }
+    state.view.recordLength = static_cast<uint32_t>(numWords * sizeof(uint32_t) / state.view.sampleBytes);
+    state.records.push_back(data);
+
+    RecordMetadata meta;
+    meta.streamID = state.view.streamID;
+    meta.timestampSeconds = vh.timestampSeconds;
+    meta.timestampFractional = vh.timestampFractional;
+    meta.packetCount = vh.packetCount;
+    meta.recordIndex = state.recordIndex++;
+    meta.segment = (meta.recordIndex / waveforms_) % numSegments_;
+    state.metadata.push_back(meta);
+}
+
+void RecordConsumers::dispatch() {
+    // one call per stream that received records, in the order they first arrived
+    for (unsigned slot : pending_) {
+        SlotState & state = slots_[slot];
+        state.view.numRecords = static_cast<uint32_t>(state.records.size());
+        state.view.records = state.records.data();
+        state.view.metadata = state.metadata.data();
+        state.consumer(deviceID_, &state.view, state.context);
+        // keep the capacity so later batches do not allocate
+        state.records.clear();
+        state.metadata.clear();
+        state.view.records = nullptr;
+        state.view.metadata = nullptr;
+    }
+    pending_.clear();
+}
@@ -0,0 +1,61 @@
+// RecordConsumer.h
+//
+// In-process record consumers: C callbacks registered per stream that are
+// handed read-only views of the records straight out of the received
+// buffers, a batch per buffer, without copying them or leaving the process.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef RECORDCONSUMER_H_
+#define RECORDCONSUMER_H_
+
+#include <map>
+using std::map;
+#include <vector>
+using std::vector;
+#include <cstdint>
+
+#include "X6_enums.h"
+#include "QDSPStream.h"
+#include "VitaHeader.h"
+
+class RecordConsumers {
+public:
+	void set(uint16_t, X6_RECORD_CONSUMER, void *);
+	void clear();
+	bool empty() const;
+
+	void bind(int, const vector<QDSPStream> &, size_t, unsigned, unsigned);
+	// restarts the record count of every bound slot
+	void reset();
+	void add_record(unsigned, const uint32_t *, size_t, const VitaHeader &);
+	void dispatch();
+
+private:
+	struct Registration {
+		X6_RECORD_CONSUMER consumer;
+		void * context;
+	};
+	map<uint16_t, Registration> registered_;
+
+	// per demux slot; only touched by the thread calling the consumers
+	struct SlotState {
+		X6_RECORD_CONSUMER consumer = nullptr;
+		void * context = nullptr;
+		RecordBatchView view;
+		vector<const void *> records;
+		vector<RecordMetadata> metadata;
+		uint64_t recordIndex = 0;
+	};
+	vector<SlotState> slots_;
+	vector<unsigned> pending_;
+
+	int deviceID_ = 0;
+	size_t numRecords_ = 0;
+	unsigned waveforms_ = 1;
+	unsigned numSegments_ = 1;
+};
+
+#endif // RECORDCONSUMER_H_
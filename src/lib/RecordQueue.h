@@ -11,6 +11,7 @@
 #define RECORDQUEUE_H_
 
 #include <queue>
+#include <vector>
 #include <atomic>
 #include <cstring>
 
@@ -26,8 +27,10 @@
 
 #include <BufferDatagrams_Mb.h>
 #include "QDSPStream.h"
-#include <plog/Log.h>
+#include "logging.h"
 #include "X6_errno.h"
+#include "X6_enums.h"
+#include "MemoryPolicy.h"
 
 
 template <class T>
@@ -38,25 +41,38 @@ public:
 	RecordQueue<T>();
 	RecordQueue<T>(const QDSPStream &, size_t, size_t);
 
-	template <class U>
-	void push(const Innovative::AccessDatagram<U> &);
+	void reserve_storage();
+	void reset();
+	template <class B>
+	void push(const B &);
 	void get(double *, size_t);
 	size_t get_buffer_size();
 
+	void push_metadata(const RecordMetadata &);
+	size_t get_metadata(RecordMetadata *, size_t);
+	size_t get_metadata_size();
+
 	std::atomic<size_t> recordsTaken;
 	std::atomic<size_t> availableRecords;
 	size_t expectedRecords = 0;
+	size_t metadataTaken = 0;
 	size_t recordLength;
 	int32_t socket_ = -1;
+	bool sendMetadata_ = false;
 
 private:
-	std::queue<T> queue_;
+	// records are appended to one preallocated buffer and read out in order;
+	// once the reader catches up both positions rewind to the start
+	std::vector<T, HugePageAllocator<T>> storage_;
+	size_t readPos_ = 0;
+	// metadata is queued in record order, parallel to the record storage
+	std::queue<RecordMetadata> metadata_;
 	QDSPStream stream_;
 	unsigned fixed_to_float_;
 
 	std::vector<double> workbuf_;
-	template <class U>
-	std::vector<double>& convert_to_double(const Innovative::AccessDatagram<U> &);
+	template <class B>
+	std::vector<double>& convert_to_double(const B &);
 };
 
 
@@ -75,17 +91,37 @@ RecordQueue<T>::RecordQueue(const QDSPStream & stream,
 
 
 template <class T>
-template <class U>
-void RecordQueue<T>::push(const Innovative::AccessDatagram<U> & buffer) {
+void RecordQueue<T>::reserve_storage() {
+	// enough for every record the acquisition will deliver, so pushes never
+	// reallocate; pages are only committed as records arrive, on the node of
+	// the process thread that writes them, so they are not touched up front
+	MemoryPolicy::ReserveOnly reserveOnly;
+	storage_.reserve(expectedRecords * recordLength);
+}
+
+template <class T>
+void RecordQueue<T>::reset() {
+	// empties the queue for another acquisition, keeping the storage capacity
+	storage_.clear();
+	readPos_ = 0;
+	std::queue<RecordMetadata>().swap(metadata_);
+	recordsTaken = 0;
+	availableRecords = 0;
+	metadataTaken = 0;
+}
+
+template <class T>
+template <class B>
+void RecordQueue<T>::push(const B & buffer) {
 	if (recordsTaken >= expectedRecords) {
-		LOG(plog::debug) << "Already received expected number of records; dropping buffer";
+		X6_LOG(plog::debug) << "Already received expected number of records; dropping buffer";
 		return;
 	}
 	//TODO: worry about performance, cache-friendly etc.
-	LOG(plog::verbose) << "Buffering data...";
-	LOG(plog::verbose) << "recordsTaken = " << recordsTaken;
-	LOG(plog::verbose) << "New buffer size is " << buffer.size();
-	LOG(plog::verbose) << "queue size is " << queue_.size();
+	X6_LOG(plog::verbose) << "Buffering data...";
+	X6_LOG(plog::verbose) << "recordsTaken = " << recordsTaken;
+	X6_LOG(plog::verbose) << "New buffer size is " << buffer.size();
+	X6_LOG(plog::verbose) << "queue size is " << storage_.size() - readPos_;
 
 	// if we have a socket, process the data and send it immediately
 	if (socket_ != -1) {
@@ -118,11 +154,20 @@ void RecordQueue<T>::push(const Innovative::AccessDatagram<U> & buffer) {
 			                   << status << " bytes";
 			throw X6_SOCKET_ERROR;
 		}
+
+		// follow the record with its metadata if the client asked for it
+		if (sendMetadata_ && !metadata_.empty()) {
+			status = send(socket_, reinterpret_cast<char *>(&metadata_.front()), sizeof(RecordMetadata), 0);
+			if (status != static_cast<ssize_t>(sizeof(RecordMetadata))) {
+				LOG(plog::error) << "Error writing stream ID " << stream_.streamID
+				                   << " metadata to socket.";
+				throw X6_SOCKET_ERROR;
+			}
+			metadata_.pop();
+		}
 	} else {
 		// otherwise, store for later retrieval
-		for (auto val : buffer) {
-			queue_.push(val);
-		}
+		storage_.insert(storage_.end(), buffer.begin(), buffer.end());
 		availableRecords++;
 	}
 
@@ -131,17 +176,22 @@ void RecordQueue<T>::push(const Innovative::AccessDatagram<U> & buffer) {
 
 template <class T>
 void RecordQueue<T>::get(double * buf, size_t numPoints) {
-	size_t initialSize = queue_.size();
+	size_t initialSize = storage_.size() - readPos_;
 	availableRecords -= numPoints / recordLength;
-	// for(size_t ct=0; !queue_.empty() && (ct < numPoints); ct++) {
+	if (numPoints > initialSize) {
+		LOG(plog::error) << "Tried to pull " << numPoints << " from a queue of initial size " << initialSize;
+		LOG(plog::error) << "Tried to pull an empty queue.";
+		numPoints = initialSize;
+	}
+	const T * src = storage_.data() + readPos_;
 	for(size_t ct=0; ct < numPoints; ct++) {
-		if (queue_.empty()) {
-			LOG(plog::error) << "Tried to pull " << numPoints << " from a queue of initial size " << initialSize;
-			LOG(plog::error) << "Tried to pull an empty queue.";
-			break;
-		}
-		buf[ct] = static_cast<double>(queue_.front()) / fixed_to_float_;
-		queue_.pop();
+		buf[ct] = static_cast<double>(src[ct]) / fixed_to_float_;
+	}
+	readPos_ += numPoints;
+	if (readPos_ == storage_.size()) {
+		// drained: reuse the buffer from the start, keeping its capacity
+		storage_.clear();
+		readPos_ = 0;
 	}
 }
 
@@ -151,8 +201,32 @@ size_t RecordQueue<T>::get_buffer_size() {
 }
 
 template <class T>
-template <class U>
-std::vector<double>& RecordQueue<T>::convert_to_double(const Innovative::AccessDatagram<U> &buffer) {
+void RecordQueue<T>::push_metadata(const RecordMetadata & meta) {
+	if (metadataTaken >= expectedRecords) {
+		return;
+	}
+	metadata_.push(meta);
+	metadataTaken++;
+}
+
+template <class T>
+size_t RecordQueue<T>::get_metadata(RecordMetadata * buf, size_t numRecords) {
+	size_t ct;
+	for (ct = 0; ct < numRecords && !metadata_.empty(); ct++) {
+		buf[ct] = metadata_.front();
+		metadata_.pop();
+	}
+	return ct;
+}
+
+template <class T>
+size_t RecordQueue<T>::get_metadata_size() {
+	return metadata_.size();
+}
+
+template <class T>
+template <class B>
+std::vector<double>& RecordQueue<T>::convert_to_double(const B &buffer) {
 	workbuf_.resize(buffer.size());
 	for (size_t ct = 0; ct < buffer.size(); ct++) {
 		workbuf_[ct] = static_cast<double>(buffer[ct]) / fixed_to_float_;
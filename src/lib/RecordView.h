@@ -0,0 +1,37 @@
+// RecordView.h
+//
+// Non-owning view of a single record of samples inside a received buffer.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef RECORDVIEW_H_
+#define RECORDVIEW_H_
+
+#include <cstddef>
+#include <cstdint>
+
+template <class T>
+class RecordView {
+public:
+	RecordView() : data_{nullptr}, size_{0} {}
+	RecordView(const T * data, size_t size) : data_{data}, size_{size} {}
+
+	// reinterpret packed 32-bit VITA payload words as samples of type T
+	static RecordView<T> from_words(const uint32_t * words, size_t numWords) {
+		return RecordView<T>(reinterpret_cast<const T *>(words), numWords * sizeof(uint32_t) / sizeof(T));
+	}
+
+	const T * begin() const { return data_; }
+	const T * end() const { return data_ + size_; }
+	const T & operator[](size_t idx) const { return data_[idx]; }
+	size_t size() const { return size_; }
+	const T * data() const { return data_; }
+
+private:
+	const T * data_;
+	size_t size_;
+};
+
+#endif // RECORDVIEW_H_
@@ -0,0 +1,132 @@
+// RegisterBus.h
+//
+// Wishbone register access for the card. The bus keeps one address space per
+// base address rather than building it for every access, and runs batches of
+// writes and reads in one pass under a single lock so that address/data
+// sequences from different threads cannot interleave. The address space type
+// is a template parameter so the bus can be tested against an in-memory
+// register file.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef REGISTERBUS_H_
+#define REGISTERBUS_H_
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+using std::vector;
+#include <cstddef>
+#include <cstdint>
+
+// register accesses queued to run in order
+class RegisterBatch {
+public:
+	struct Access {
+		uint32_t base;
+		uint32_t offset;
+		uint32_t value;
+		// where a read stores the value; null for a write
+		uint32_t * result;
+	};
+
+	void write(uint32_t base, uint32_t offset, uint32_t value) {
+		accesses_.push_back({base, offset, value, nullptr});
+	}
+	// the value is stored in *result when the batch runs
+	void read(uint32_t base, uint32_t offset, uint32_t * result) {
+		accesses_.push_back({base, offset, 0, result});
+	}
+
+	void reserve(size_t n) { accesses_.reserve(n); }
+	void clear() { accesses_.clear(); }
+	size_t size() const { return accesses_.size(); }
+	bool empty() const { return accesses_.empty(); }
+	const vector<Access> & accesses() const { return accesses_; }
+
+private:
+	vector<Access> accesses_;
+};
+
+// Space must be movable and provide write(offset, value) and read(offset)
+template <class Space>
+class RegisterBus {
+public:
+	// builds the address space of a base address the first time it is used
+	typedef std::function<Space(uint32_t)> SpaceFactory;
+
+	RegisterBus(SpaceFactory factory) : factory_(factory) {}
+
+	RegisterBus(const RegisterBus &) = delete;
+	RegisterBus & operator=(const RegisterBus &) = delete;
+
+	void write(uint32_t base, uint32_t offset, uint32_t value) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		space(base).write(offset, value);
+		writes_++;
+	}
+
+	uint32_t read(uint32_t base, uint32_t offset) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		reads_++;
+		return space(base).read(offset);
+	}
+
+	void execute(const RegisterBatch & batch) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		// batches mostly stay on one base address, so skip the lookup while
+		// they do
+		uint32_t base = 0;
+		Space * current = nullptr;
+		for (auto & access : batch.accesses()) {
+			if (!current || access.base != base) {
+				base = access.base;
+				current = &space(base);
+			}
+			if (access.result) {
+				*access.result = current->read(access.offset);
+				reads_++;
+			} else {
+				current->write(access.offset, access.value);
+				writes_++;
+			}
+		}
+		batches_++;
+	}
+
+	// drops the cached address spaces, e.g. when the card is closed
+	void reset() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		spaces_.clear();
+	}
+
+	uint64_t get_writes() const { return writes_; }
+	uint64_t get_reads() const { return reads_; }
+	uint64_t get_batches() const { return batches_; }
+	size_t get_num_spaces() const {
+		std::lock_guard<std::mutex> lock(mutex_);
+		return spaces_.size();
+	}
+
+private:
+	Space & space(uint32_t base) {
+		auto it = spaces_.find(base);
+		if (it == spaces_.end()) {
+			it = spaces_.emplace(base, factory_(base)).first;
+		}
+		return it->second;
+	}
+
+	SpaceFactory factory_;
+	mutable std::mutex mutex_;
+	std::map<uint32_t, Space> spaces_;
+	std::atomic<uint64_t> writes_{0};
+	std::atomic<uint64_t> reads_{0};
+	std::atomic<uint64_t> batches_{0};
+};
+
+#endif // REGISTERBUS_H_
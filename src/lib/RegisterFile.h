@@ -0,0 +1,65 @@
+// RegisterFile.h
+//
+// In-memory stand-in for the card's wishbone registers, for exercising the
+// register bus and the code built on it without a board. Every register reads
+// back the last value written to it, or 0.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef REGISTERFILE_H_
+#define REGISTERFILE_H_
+
+#include <map>
+#include <utility>
+#include <vector>
+using std::vector;
+#include <cstdint>
+
+class RegisterFile {
+public:
+	// one base address of the file, as the bus sees it
+	class Space {
+	public:
+		Space(RegisterFile & file, uint32_t base) : file_(&file), base_(base) {}
+		void write(uint32_t offset, uint32_t value) { file_->write(base_, offset, value); }
+		uint32_t read(uint32_t offset) { return file_->read(base_, offset); }
+	private:
+		RegisterFile * file_;
+		uint32_t base_;
+	};
+
+	struct Access {
+		uint32_t base;
+		uint32_t offset;
+		uint32_t value;
+		bool write;
+	};
+
+	void write(uint32_t base, uint32_t offset, uint32_t value) {
+		registers_[std::make_pair(base, offset)] = value;
+		log_.push_back({base, offset, value, true});
+	}
+
+	uint32_t read(uint32_t base, uint32_t offset) {
+		auto it = registers_.find(std::make_pair(base, offset));
+		uint32_t value = (it != registers_.end()) ? it->second : 0;
+		log_.push_back({base, offset, value, false});
+		return value;
+	}
+
+	// sets a register without logging an access, e.g. a firmware constant
+	void preset(uint32_t base, uint32_t offset, uint32_t value) {
+		registers_[std::make_pair(base, offset)] = value;
+	}
+
+	const vector<Access> & get_log() const { return log_; }
+	void clear_log() { log_.clear(); }
+
+private:
+	std::map<std::pair<uint32_t, uint32_t>, uint32_t> registers_;
+	vector<Access> log_;
+};
+
+#endif // REGISTERFILE_H_
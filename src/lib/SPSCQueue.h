@@ -0,0 +1,99 @@
+// SPSCQueue.h
+//
+// Bounded lock-free queue for handing items from exactly one producer
+// thread to exactly one consumer thread.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef SPSCQUEUE_H_
+#define SPSCQUEUE_H_
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <utility>
+
+#include "AlignedAllocator.h"
+
+template <class T>
+class SPSCQueue {
+public:
+	explicit SPSCQueue(size_t capacity = 64);
+
+	bool push(T &&);
+	bool pop(T &);
+	size_t size() const;
+	size_t capacity() const;
+	void clear();
+
+private:
+	SPSCQueue(const SPSCQueue&) = delete;
+	SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+	std::vector<T> buffer_;
+	size_t mask_;
+	// padding keeps the consumer and producer indices on separate cache
+	// lines without needing over-aligned allocation
+	char padHead_[CACHE_LINE_SIZE];
+	std::atomic<size_t> head_;
+	char padTail_[CACHE_LINE_SIZE];
+	std::atomic<size_t> tail_;
+};
+
+template <class T>
+SPSCQueue<T>::SPSCQueue(size_t capacity) : head_{0}, tail_{0} {
+	// round up to a power of two so indices wrap with a mask
+	size_t size = 1;
+	while (size < capacity) {
+		size <<= 1;
+	}
+	buffer_.resize(size);
+	mask_ = size - 1;
+}
+
+template <class T>
+bool SPSCQueue<T>::push(T && item) {
+	// producer side; leaves item untouched if the queue is full
+	size_t tail = tail_.load(std::memory_order_relaxed);
+	if (tail - head_.load(std::memory_order_acquire) == buffer_.size()) {
+		return false;
+	}
+	buffer_[tail & mask_] = std::move(item);
+	tail_.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+template <class T>
+bool SPSCQueue<T>::pop(T & item) {
+	// consumer side
+	size_t head = head_.load(std::memory_order_relaxed);
+	if (head == tail_.load(std::memory_order_acquire)) {
+		return false;
+	}
+	item = std::move(buffer_[head & mask_]);
+	// release whatever the slot still holds before handing it back
+	buffer_[head & mask_] = T();
+	head_.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+template <class T>
+size_t SPSCQueue<T>::size() const {
+	return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+}
+
+template <class T>
+size_t SPSCQueue<T>::capacity() const {
+	return buffer_.size();
+}
+
+template <class T>
+void SPSCQueue<T>::clear() {
+	// only safe while neither side is active
+	T item;
+	while (pop(item)) {}
+}
+
+#endif // SPSCQUEUE_H_
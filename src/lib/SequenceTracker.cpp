@@ -0,0 +1,95 @@
+// SequenceTracker.cpp
+//
+// Track VITA packet counter continuity per stream to detect lost,
+// duplicated and reordered packets.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#include "SequenceTracker.h"
+
+#include <tuple>
+
+SequenceTracker::SequenceTracker() : lostPackets_{0} {};
+
+void SequenceTracker::reset(const vector<uint16_t> & streamIDs) {
+    // streams are registered up front so that tracking never inserts into the
+    // map while another thread may be reading statistics
+    streams_.clear();
+    for (auto sid : streamIDs) {
+        streams_.emplace(std::piecewise_construct, std::forward_as_tuple(sid), std::forward_as_tuple());
+    }
+    lostPackets_ = 0;
+}
+
+SEQUENCE_EVENT SequenceTracker::track(uint16_t streamID, unsigned packetCount) {
+    auto it = streams_.find(streamID);
+    if (it == streams_.end()) {
+        return SEQUENCE_UNKNOWN_STREAM;
+    }
+    StreamState & state = it->second;
+    state.packets.store(state.packets.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if (state.lastCount < 0) {
+        state.lastCount = packetCount;
+        return SEQUENCE_OK;
+    }
+
+    // The VITA packet count is only 4 bits so steps are taken modulo 16. A
+    // forward step of up to half the counter range is treated as lost packets;
+    // anything further is taken to be a late packet from behind. Losing 16 or
+    // more packets in a row aliases and cannot be detected. A late packet
+    // filling an earlier gap is taken back out of the lost count.
+    unsigned delta = (packetCount - state.lastCount) & 0xf;
+    if (delta == 1) {
+        state.missing &= ~(1u << packetCount);
+        state.lastCount = packetCount;
+        return SEQUENCE_OK;
+    }
+    else if (delta == 0) {
+        state.duplicates.store(state.duplicates.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return SEQUENCE_DUPLICATE;
+    }
+    else if (delta <= 8) {
+        state.gaps.store(state.gaps.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        state.lostPackets.store(state.lostPackets.load(std::memory_order_relaxed) + delta - 1, std::memory_order_relaxed);
+        lostPackets_ += delta - 1;
+        for (unsigned ct = 1; ct < delta; ct++) {
+            state.missing |= 1u << ((state.lastCount + ct) & 0xf);
+        }
+        state.missing &= ~(1u << packetCount);
+        state.lastCount = packetCount;
+        return SEQUENCE_GAP;
+    }
+    else if (state.missing & (1u << packetCount)) {
+        // a packet counted as lost turned up after all
+        state.missing &= ~(1u << packetCount);
+        state.outOfOrder.store(state.outOfOrder.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        state.lostPackets.store(state.lostPackets.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+        lostPackets_--;
+        return SEQUENCE_OUT_OF_ORDER;
+    }
+    else {
+        // an older packet that already arrived once
+        state.duplicates.store(state.duplicates.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return SEQUENCE_DUPLICATE;
+    }
+}
+
+SequenceStats SequenceTracker::get_stats(uint16_t streamID) const {
+    SequenceStats stats = {0, 0, 0, 0, 0};
+    auto it = streams_.find(streamID);
+    if (it != streams_.end()) {
+        stats.packets = it->second.packets;
+        stats.gaps = it->second.gaps;
+        stats.lostPackets = it->second.lostPackets;
+        stats.duplicates = it->second.duplicates;
+        stats.outOfOrder = it->second.outOfOrder;
+    }
+    return stats;
+}
+
+uint64_t SequenceTracker::get_lost_packets() const {
+    return lostPackets_;
+}
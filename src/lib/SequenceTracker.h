@@ -0,0 +1,51 @@
+// SequenceTracker.h
+//
+// Track VITA packet counter continuity per stream to detect lost,
+// duplicated and reordered packets.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef SEQUENCETRACKER_H_
+#define SEQUENCETRACKER_H_
+
+#include <atomic>
+#include <map>
+using std::map;
+#include <vector>
+using std::vector;
+#include <cstdint>
+
+#include "X6_enums.h"
+
+enum SEQUENCE_EVENT { SEQUENCE_OK, SEQUENCE_GAP, SEQUENCE_DUPLICATE, SEQUENCE_OUT_OF_ORDER, SEQUENCE_UNKNOWN_STREAM };
+
+class SequenceTracker {
+public:
+	SequenceTracker();
+
+	void reset(const vector<uint16_t> &);
+	SEQUENCE_EVENT track(uint16_t, unsigned);
+	SequenceStats get_stats(uint16_t) const;
+	uint64_t get_lost_packets() const;
+
+private:
+	// counters have a single writer (the data handling thread) but are read
+	// from client threads while the acquisition runs
+	struct StreamState {
+		int lastCount = -1;
+		// bit n is set while packet count n was skipped over and may still
+		// arrive late
+		uint16_t missing = 0;
+		std::atomic<uint64_t> packets{0};
+		std::atomic<uint64_t> gaps{0};
+		std::atomic<uint64_t> lostPackets{0};
+		std::atomic<uint64_t> duplicates{0};
+		std::atomic<uint64_t> outOfOrder{0};
+	};
+	map<uint16_t, StreamState> streams_;
+	std::atomic<uint64_t> lostPackets_;
+};
+
+#endif // SEQUENCETRACKER_H_
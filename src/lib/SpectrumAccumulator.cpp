@@ -0,0 +1,125 @@
+// SpectrumAccumulator.cpp
+//
+// Accumulator for spectrum mode: windows and transforms each raw or demod
+// record and sums its power spectrum per segment, so only the averaged
+// spectrum leaves the driver.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#include "SpectrumAccumulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+
+} // namespace
+
+SpectrumAccumulator::SpectrumAccumulator() :
+    recordsTaken{0}, complex_{false}, numSamples_{0}, numBins_{0}, wfmCt_{0}, segment_{0},
+    numSegments_{0}, numWaveforms_{0} {};
+
+SpectrumAccumulator::SpectrumAccumulator(const QDSPStream & stream, const size_t & recordLength,
+                                         const size_t & numSegments, const size_t & numWaveforms,
+                                         X6_SPECTRUM_WINDOW window) :
+    recordsTaken{0}, stream_{stream}, complex_{stream.type != PHYSICAL}, wfmCt_{0}, segment_{0},
+    numSegments_{numSegments}, numWaveforms_{numWaveforms} {
+
+    size_t recordWords = stream.calc_record_length(recordLength);
+    if (complex_) {
+        numSamples_ = recordWords / 2;
+        numBins_ = numSamples_;
+        fft_ = FFT(numSamples_);
+        complexIn_.resize(numSamples_);
+    } else {
+        numSamples_ = recordWords;
+        realFFT_ = RealFFT(numSamples_);
+        numBins_ = realFFT_.num_bins();
+        realIn_.resize(numSamples_);
+    }
+    bins_.resize(numBins_);
+
+    vector<double> w = make_window(window, numSamples_);
+    double sumSquares = 0;
+    for (double val : w) {
+        sumSquares += val * val;
+    }
+    double fixedScale = 1.0 / stream.fixed_to_float();
+    window_.resize(numSamples_);
+    for (size_t n = 0; n < numSamples_; n++) {
+        window_[n] = w[n] * fixedScale;
+    }
+
+    /*
+     * Power per bin: |X(f)|^2 / (N sum(w^2)). With this scaling the bins of a
+     * noise record sum to its mean square for any window. The one-sided raw
+     * spectrum folds the negative frequencies onto the positive ones.
+     */
+    double scale = (numSamples_ > 0) ? 1.0 / (numSamples_ * sumSquares) : 0;
+    binScale_.assign(numBins_, scale);
+    if (!complex_) {
+        for (size_t k = 1; k < numBins_; k++) {
+            bool nyquist = (numSamples_ % 2 == 0) && (k == numBins_ - 1);
+            if (!nyquist) {
+                binScale_[k] *= 2;
+            }
+        }
+    }
+
+    data_.assign(numBins_ * numSegments_, 0);
+}
+
+vector<double> SpectrumAccumulator::make_window(X6_SPECTRUM_WINDOW window, size_t len) {
+    // periodic windows, so the transform sees them as one period
+    vector<double> w(len, 1.0);
+    for (size_t n = 0; n < len; n++) {
+        double phase = 2 * PI * n / len;
+        switch (window) {
+            case SPECTRUM_WINDOW_HANN:
+                w[n] = 0.5 - 0.5 * std::cos(phase);
+                break;
+            case SPECTRUM_WINDOW_BLACKMAN_HARRIS:
+                w[n] = 0.35875 - 0.48829 * std::cos(phase) + 0.14128 * std::cos(2 * phase)
+                       - 0.01168 * std::cos(3 * phase);
+                break;
+            default:
+                break;
+        }
+    }
+    return w;
+}
+
+void SpectrumAccumulator::add_power() {
+    double * segment = &data_[segment_ * numBins_];
+    for (size_t k = 0; k < numBins_; k++) {
+        segment[k] += std::norm(bins_[k]);
+    }
+    recordsTaken++;
+
+    // move onto the next segment once its waveforms are in
+    if (++wfmCt_ == numWaveforms_) {
+        wfmCt_ = 0;
+        if (++segment_ == numSegments_) {
+            segment_ = 0;
+        }
+    }
+}
+
+void SpectrumAccumulator::reset() {
+    std::fill(data_.begin(), data_.end(), 0);
+    wfmCt_ = 0;
+    segment_ = 0;
+    recordsTaken = 0;
+}
+
+void SpectrumAccumulator::snapshot(double * buf) {
+    /* Copies the averaged spectrum of each segment into a *preallocated* buffer */
+    double count = std::max<size_t>(recordsTaken / std::max<size_t>(numSegments_, 1), 1);
+    for (size_t ct = 0; ct < data_.size(); ct++) {
+        buf[ct] = data_[ct] * binScale_[ct % numBins_] / count;
+    }
+}
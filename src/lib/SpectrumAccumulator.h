@@ -0,0 +1,87 @@
+// SpectrumAccumulator.h
+//
+// Accumulator for spectrum mode: windows and transforms each raw or demod
+// record and sums its power spectrum per segment, so only the averaged
+// spectrum leaves the driver.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef SPECTRUMACCUMULATOR_H_
+#define SPECTRUMACCUMULATOR_H_
+
+#include <complex>
+using std::complex;
+#include <vector>
+using std::vector;
+#include <cstddef>
+
+#include "QDSPStream.h"
+#include "MemoryPolicy.h"
+#include "FFT.h"
+#include "X6_enums.h"
+
+class SpectrumAccumulator {
+public:
+	SpectrumAccumulator();
+	SpectrumAccumulator(const QDSPStream &, const size_t &, const size_t &, const size_t &, X6_SPECTRUM_WINDOW);
+
+	static vector<double> make_window(X6_SPECTRUM_WINDOW, size_t);
+
+	// accepts any record buffer with operator[], like Accumulator::accumulate
+	template <class B>
+	void accumulate(const B &);
+
+	void reset();
+	void snapshot(double *);
+	size_t get_buffer_size() const { return data_.size(); }
+	size_t get_num_bins() const { return numBins_; }
+	size_t recordsTaken;
+
+private:
+	void add_power();
+
+	QDSPStream stream_;
+	// demod records are complex and keep all bins; raw records keep the
+	// one-sided spectrum
+	bool complex_;
+	size_t numSamples_;
+	size_t numBins_;
+	size_t wfmCt_;
+	size_t segment_;
+	size_t numSegments_;
+	size_t numWaveforms_;
+
+	// window with the fixed point scaling folded in
+	vector<double> window_;
+	// 1 / sum(w^2), doubled in the bins that stand for a negative frequency too
+	vector<double> binScale_;
+	FFT fft_;
+	RealFFT realFFT_;
+	vector<double> realIn_;
+	vector<complex<double>> complexIn_;
+	vector<complex<double>> bins_;
+
+	// sum of |X(f)|^2, segments x bins
+	typedef vector<double, HugePageAllocator<double>> SumBuffer;
+	SumBuffer data_;
+};
+
+template <class B>
+void SpectrumAccumulator::accumulate(const B & buffer) {
+	if (complex_) {
+		for (size_t n = 0; n < numSamples_; n++) {
+			complexIn_[n] = complex<double>(buffer[2*n] * window_[n], buffer[2*n + 1] * window_[n]);
+		}
+		fft_.transform(complexIn_.data(), bins_.data());
+	} else {
+		for (size_t n = 0; n < numSamples_; n++) {
+			realIn_[n] = buffer[n] * window_[n];
+		}
+		realFFT_.transform(realIn_.data(), bins_.data());
+	}
+	add_power();
+}
+
+#endif // SPECTRUMACCUMULATOR_H_
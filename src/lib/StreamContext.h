@@ -0,0 +1,85 @@
+// StreamContext.h
+//
+// Per-stream state resolved once at acquire() so the data path reaches the
+// accumulator, queue and correlators of a record by demux slot index.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef STREAMCONTEXT_H_
+#define STREAMCONTEXT_H_
+
+#include <mutex>
+#include <vector>
+using std::vector;
+#include <utility>
+
+#include "QDSPStream.h"
+#include "Accumulator.h"
+#include "SpectrumAccumulator.h"
+#include "RecordQueue.h"
+#include "Correlator.h"
+#include "KernelBank.h"
+#include "Discriminator.h"
+#include "CrossBoardCorrelator.h"
+#include "AlignedAllocator.h"
+
+struct alignas(CACHE_LINE_SIZE) StreamContext {
+	QDSPStream stream;
+	// owned by the X6_1000 stream maps, whose nodes do not move
+	Accumulator * accumulator = nullptr;
+	// replaces the accumulator of raw and demod streams in spectrum mode
+	SpectrumAccumulator * spectrum = nullptr;
+	RecordQueue<int32_t> * queue = nullptr;
+	std::mutex * mutex = nullptr;
+	// correlators this stream feeds and the input index it occupies in each
+	vector<std::pair<Correlator *, int>> correlators;
+	// contexts of the host DSP streams computed from this raw stream, in the
+	// order HostDSP::process() returns their records
+	vector<size_t> hostOutputs;
+	// kernel bank applied to the records of a demod stream and the context of
+	// its result stream
+	KernelBank * kernelBank = nullptr;
+	size_t kernelBankOutput = 0;
+	// discriminators this stream feeds, the input index it occupies in each
+	// and the context of the discriminator's state stream
+	struct DiscriminatorInput {
+		Discriminator * discriminator;
+		int index;
+		size_t output;
+	};
+	vector<DiscriminatorInput> discriminators;
+	// correlators across boards this stream feeds and its input index in each
+	vector<std::pair<CrossBoardCorrelator *, int>> crossCorrelators;
+	// records handed to this stream by the demux, including dropped extras
+	size_t recordsReceived = 0;
+
+	// with double buffering, the accumulator, queue, correlators and
+	// discriminators of the other bank, the number of acquisitions this stream has filled and
+	// whether it stays on a full bank because the other is still held
+	struct Bank {
+		Accumulator * accumulator = nullptr;
+		SpectrumAccumulator * spectrum = nullptr;
+		RecordQueue<int32_t> * queue = nullptr;
+		std::mutex * mutex = nullptr;
+		vector<std::pair<Correlator *, int>> correlators;
+		vector<DiscriminatorInput> discriminators;
+	};
+	Bank standby;
+	size_t banksFilled = 0;
+	bool bankStalled = false;
+
+	void switch_bank() {
+		std::swap(accumulator, standby.accumulator);
+		std::swap(spectrum, standby.spectrum);
+		std::swap(queue, standby.queue);
+		std::swap(mutex, standby.mutex);
+		correlators.swap(standby.correlators);
+		discriminators.swap(standby.discriminators);
+	}
+};
+
+typedef vector<StreamContext, AlignedAllocator<StreamContext>> StreamContextArray;
+
+#endif // STREAMCONTEXT_H_
@@ -0,0 +1,237 @@
+// SweepRunner.cpp
+//
+// Runs a parameter sweep on one board from a library thread: before each point
+// it makes that point's register or parameter changes, then acquires, waits
+// and transfers the averages of the requested streams into its slice of a
+// result array the caller allocated.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#include "SweepRunner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <set>
+#include <cstdint>
+
+#include "logging.h"
+
+SweepRunner::SweepRunner(X6_1000 * board, const vector<SweepChange> & changes,
+                         const vector<vector<double>> & waveforms, const vector<QDSPStream> & streams,
+                         size_t numPoints, double * results, size_t resultLength, unsigned timeOut) :
+    board_(board), changes_(changes), waveforms_(waveforms), streams_(streams),
+    numPoints_(numPoints), results_(results), resultLength_(resultLength), timeOut_(timeOut) {
+    if (numPoints_ == 0 || streams_.empty() || !results_) {
+        LOG(plog::error) << "A sweep needs at least one point, one stream and a result array";
+        throw X6_INVALID_ARGUMENT;
+    }
+    // same rule as write_pulse_waveform, checked before any point runs
+    for (size_t idx = 0; idx < waveforms_.size(); idx++) {
+        size_t length = waveforms_[idx].size();
+        if (length == 0 || length % 4 != 0 || length > PG_WF_MEMORY_LENGTH) {
+            LOG(plog::error) << "Sweep waveform " << idx << " has invalid length " << length;
+            throw X6_INVALID_WF_LEN;
+        }
+    }
+    for (auto & change : changes_) {
+        if (change.point >= numPoints_) {
+            LOG(plog::error) << "Sweep change for point " << change.point << " of a " << numPoints_ << " point sweep";
+            throw X6_INVALID_ARGUMENT;
+        }
+        switch (change.parameter) {
+        case SWEEP_NCO_FREQUENCY:
+        case SWEEP_THRESHOLD:
+        case SWEEP_KERNEL_BIAS:
+            break;
+        case SWEEP_PULSE_WAVEFORM:
+            if (change.value < 0 || change.value >= waveforms_.size() || change.value != std::floor(change.value)) {
+                LOG(plog::error) << "Sweep waveform index " << change.value << " out of range";
+                throw X6_INVALID_ARGUMENT;
+            }
+            break;
+        case SWEEP_WISHBONE_REGISTER:
+            if (change.value < 0 || change.value > UINT32_MAX || change.value != std::floor(change.value)) {
+                LOG(plog::error) << "Sweep register value " << change.value << " is not a 32-bit word";
+                throw X6_INVALID_ARGUMENT;
+            }
+            break;
+        default:
+            LOG(plog::error) << "Unknown sweep parameter " << change.parameter;
+            throw X6_INVALID_ARGUMENT;
+        }
+    }
+    // each point's changes in the order they were given
+    std::stable_sort(changes_.begin(), changes_.end(), [](const SweepChange & x, const SweepChange & y) {
+        return x.point < y.point;
+    });
+}
+
+SweepRunner::~SweepRunner() {
+    stop();
+}
+
+void SweepRunner::start() {
+    if (running_) {
+        LOG(plog::error) << "Sweep already running";
+        throw X6_MODE_ERROR;
+    }
+    if (board_->get_is_running() || board_->get_double_buffering()) {
+        LOG(plog::error) << "Sweeps need an idle board without double buffering";
+        throw X6_MODE_ERROR;
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    stopRequested_ = false;
+    pointsDone_ = 0;
+    status_ = X6_OK;
+    running_ = true;
+    thread_ = std::thread(&SweepRunner::run, this);
+}
+
+void SweepRunner::stop() {
+    stopRequested_ = true;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void SweepRunner::wait(unsigned timeOut) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!done_.wait_for(lock, std::chrono::seconds(timeOut), [this]() { return !running_; })) {
+        throw X6_TIMEOUT;
+    }
+    if (status_ != X6_OK) {
+        throw status_;
+    }
+}
+
+void SweepRunner::run() {
+    X6_STATUS status = X6_OK;
+    // points after the first re-arm the setup in place; the board is the
+    // sweep's alone, so the client's setting is restored afterwards
+    bool fastRearm = board_->get_fast_rearm();
+    board_->set_fast_rearm(true);
+    try {
+        load_waveforms();
+        auto change = changes_.cbegin();
+        for (size_t point = 0; point < numPoints_ && !stopRequested_; point++) {
+            run_point(point, change);
+            pointsDone_++;
+        }
+    }
+    catch (X6_STATUS s) {
+        status = s;
+    }
+    catch (...) {
+        status = X6_UNKNOWN_ERROR;
+    }
+    unload_waveforms();
+    board_->set_fast_rearm(fastRearm);
+    if (status != X6_OK) {
+        LOG(plog::error) << "Sweep failed at point " << pointsDone_ << " with status " << status;
+    } else {
+        LOG(plog::info) << "Sweep finished " << pointsDone_ << " of " << numPoints_ << " points";
+    }
+    finish(status);
+}
+
+// library name of an entry of the waveform table
+static std::string waveform_name(size_t idx) {
+    return "sweep " + std::to_string(idx);
+}
+
+void SweepRunner::load_waveforms() {
+    std::map<int, std::set<size_t>> used;
+    for (auto & change : changes_) {
+        if (change.parameter == SWEEP_PULSE_WAVEFORM) {
+            used[change.a].insert(static_cast<size_t>(change.value));
+        }
+    }
+    // whatever was added before a failure is removed again by run()
+    for (auto & pg : used) {
+        for (size_t idx : pg.second) {
+            board_->add_pulse_waveform(pg.first, waveform_name(idx), waveforms_[idx]);
+            loaded_.emplace_back(pg.first, idx);
+        }
+    }
+}
+
+void SweepRunner::unload_waveforms() {
+    for (auto & entry : loaded_) {
+        try {
+            board_->remove_pulse_waveform(entry.first, waveform_name(entry.second));
+        }
+        catch (X6_STATUS) {
+            LOG(plog::warning) << "Could not remove sweep waveform " << entry.second << " from PG " << entry.first;
+        }
+    }
+    loaded_.clear();
+}
+
+void SweepRunner::run_point(size_t point, vector<SweepChange>::const_iterator & change) {
+    for (; change != changes_.cend() && change->point == point; ++change) {
+        apply(*change);
+    }
+    board_->acquire();
+    try {
+        board_->wait_for_acquisition(timeOut_);
+    }
+    catch (X6_STATUS) {
+        board_->stop();
+        throw;
+    }
+    board_->stop();
+
+    if (point == 0) {
+        // buffer sizes are only known once the board set up its streams
+        offsets_.assign(streams_.size() + 1, 0);
+        for (size_t ct = 0; ct < streams_.size(); ct++) {
+            vector<QDSPStream> stream(1, streams_[ct]);
+            offsets_[ct + 1] = offsets_[ct] + board_->get_buffer_size(stream);
+        }
+        pointSize_ = offsets_.back();
+        if (numPoints_ * pointSize_ > resultLength_) {
+            LOG(plog::error) << "Sweep results need " << numPoints_ * pointSize_ << " values but the array holds "
+                             << resultLength_;
+            throw X6_INVALID_ARGUMENT;
+        }
+    }
+    double * slice = results_ + point * pointSize_;
+    for (size_t ct = 0; ct < streams_.size(); ct++) {
+        board_->transfer_stream(streams_[ct], slice + offsets_[ct], offsets_[ct + 1] - offsets_[ct]);
+    }
+}
+
+void SweepRunner::apply(const SweepChange & change) {
+    switch (change.parameter) {
+    case SWEEP_NCO_FREQUENCY:
+        board_->set_nco_frequency(change.a, change.b, change.value);
+        break;
+    case SWEEP_THRESHOLD:
+        board_->set_threshold(change.a, change.c, change.value);
+        break;
+    case SWEEP_KERNEL_BIAS:
+        board_->set_kernel_bias(change.a, change.b, change.c, complex<double>(change.value, change.imag));
+        break;
+    case SWEEP_PULSE_WAVEFORM:
+        board_->select_pulse_waveform(change.a, waveform_name(static_cast<size_t>(change.value)));
+        break;
+    case SWEEP_WISHBONE_REGISTER:
+        board_->write_wishbone_register(change.a, change.b, static_cast<uint32_t>(change.value));
+        break;
+    }
+}
+
+void SweepRunner::finish(X6_STATUS status) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        status_ = status;
+        running_ = false;
+    }
+    done_.notify_all();
+}
@@ -0,0 +1,84 @@
+// SweepRunner.h
+//
+// Runs a parameter sweep on one board from a library thread: before each point
+// it makes that point's register or parameter changes, then acquires, waits
+// and transfers the averages of the requested streams into its slice of a
+// result array the caller allocated. The board is the sweep thread's alone
+// until the sweep is over; libx6 refuses other calls on it meanwhile.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef SWEEPRUNNER_H_
+#define SWEEPRUNNER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+using std::vector;
+#include <cstddef>
+
+#include "X6_1000.h"
+
+class SweepRunner {
+public:
+	// the changes may come in any order; the result array must stay valid
+	// until the sweep is over
+	SweepRunner(X6_1000 *, const vector<SweepChange> &, const vector<vector<double>> &,
+	            const vector<QDSPStream> &, size_t, double *, size_t, unsigned);
+	~SweepRunner();
+
+	SweepRunner(const SweepRunner &) = delete;
+	SweepRunner & operator=(const SweepRunner &) = delete;
+
+	void start();
+	// finishes the point in progress and returns once the thread is done
+	void stop();
+	// blocks until the sweep is over; throws X6_TIMEOUT or the status the
+	// sweep ended in
+	void wait(unsigned);
+
+	bool is_running() const { return running_; }
+	size_t get_points_done() const { return pointsDone_; }
+	// doubles each point takes in the result array, once the first point ran
+	size_t get_point_size() const { return pointSize_; }
+
+private:
+	void run();
+	void load_waveforms();
+	void unload_waveforms();
+	void run_point(size_t, vector<SweepChange>::const_iterator &);
+	void apply(const SweepChange &);
+	void finish(X6_STATUS);
+
+	X6_1000 * board_;
+	vector<SweepChange> changes_;
+	vector<vector<double>> waveforms_;
+	// pulse generator and index of the waveforms put into the library for
+	// the points to select, removed again when the sweep ends
+	vector<std::pair<int, size_t>> loaded_;
+	vector<QDSPStream> streams_;
+	size_t numPoints_;
+	double * results_;
+	size_t resultLength_;
+	unsigned timeOut_;
+
+	std::thread thread_;
+	std::atomic<bool> running_{false};
+	std::atomic<bool> stopRequested_{false};
+	std::atomic<size_t> pointsDone_{0};
+	// offsets of each stream within a point, and the point size
+	vector<size_t> offsets_;
+	std::atomic<size_t> pointSize_{0};
+
+	std::mutex mutex_;
+	std::condition_variable done_;
+	X6_STATUS status_ = X6_OK;
+};
+
+#endif // SWEEPRUNNER_H_
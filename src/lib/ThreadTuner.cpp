@@ -0,0 +1,159 @@
+// ThreadTuner.cpp
+//
+// Per-role CPU affinity and real-time priority for the acquisition threads.
+// Settings are stored up front and applied by each thread to itself when it
+// starts working on an acquisition.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#include "ThreadTuner.h"
+#include "X6_errno.h"
+
+#include <plog/Log.h>
+
+#ifdef _WIN32
+	#include <windows.h>
+#elif defined(__linux__)
+	#include <pthread.h>
+	#include <sched.h>
+	#include <cstring>
+#endif
+
+static const char * role_name(X6_THREAD_ROLE role) {
+    switch (role) {
+        case THREAD_RECEIVE: return "receive";
+        case THREAD_PARSE: return "parse";
+        case THREAD_PROCESS: return "process";
+        case THREAD_CONSUMER: return "consumer";
+        default: return "unknown";
+    }
+}
+
+ThreadTuner::ThreadTuner() {
+    for (auto & s : settings_) {
+        s.requestedCPUs = 0;
+        s.requestedPriority = 0;
+    }
+    reset();
+}
+
+size_t ThreadTuner::index(X6_THREAD_ROLE role) {
+    if (role < 0 || static_cast<size_t>(role) >= NUM_THREAD_ROLES) {
+        LOG(plog::error) << "Invalid thread role " << role;
+        throw X6_INVALID_ARGUMENT;
+    }
+    return role;
+}
+
+void ThreadTuner::set_affinity(X6_THREAD_ROLE role, uint64_t cpuMask) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    settings_[index(role)].requestedCPUs = cpuMask;
+}
+
+void ThreadTuner::set_priority(X6_THREAD_ROLE role, int priority) {
+    // SCHED_FIFO priorities run 1-99 on Linux
+    if (priority < 0 || priority > 99) {
+        LOG(plog::error) << "Thread priority must be between 0 (normal) and 99.";
+        throw X6_INVALID_ARGUMENT;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    settings_[index(role)].requestedPriority = priority;
+}
+
+ThreadSettings ThreadTuner::get_settings(X6_THREAD_ROLE role) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return settings_[index(role)];
+}
+
+void ThreadTuner::reset() {
+    /* forget what was applied, e.g. before a new acquisition starts its threads */
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto & s : settings_) {
+        s.effectiveCPUs = 0;
+        s.effectivePriority = 0;
+        s.applied = 0;
+    }
+}
+
+void ThreadTuner::apply(X6_THREAD_ROLE role) {
+    /*
+     * Applies the settings for a role to the calling thread and records what
+     * the OS actually granted. Failures (e.g. no permission for real-time
+     * scheduling) are logged and leave the thread running as before.
+     */
+    std::lock_guard<std::mutex> lock(mutex_);
+    ThreadSettings & s = settings_[index(role)];
+
+#ifdef __linux__
+    pthread_t self = pthread_self();
+    if (s.requestedCPUs != 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (unsigned cpu = 0; cpu < 64; cpu++) {
+            if ((s.requestedCPUs >> cpu) & 1) {
+                CPU_SET(cpu, &cpus);
+            }
+        }
+        int status = pthread_setaffinity_np(self, sizeof(cpu_set_t), &cpus);
+        if (status != 0) {
+            LOG(plog::warning) << "Failed to pin " << role_name(role) << " thread to CPUs 0x"
+                               << std::hex << s.requestedCPUs << std::dec << ": " << std::strerror(status);
+        }
+    }
+    if (s.requestedPriority != 0) {
+        sched_param param;
+        param.sched_priority = s.requestedPriority;
+        int status = pthread_setschedparam(self, SCHED_FIFO, &param);
+        if (status != 0) {
+            LOG(plog::warning) << "Failed to set SCHED_FIFO priority " << s.requestedPriority
+                               << " on " << role_name(role) << " thread: " << std::strerror(status);
+        }
+    }
+
+    // read back what we ended up with
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    s.effectiveCPUs = 0;
+    if (pthread_getaffinity_np(self, sizeof(cpu_set_t), &cpus) == 0) {
+        for (unsigned cpu = 0; cpu < 64; cpu++) {
+            if (CPU_ISSET(cpu, &cpus)) {
+                s.effectiveCPUs |= uint64_t(1) << cpu;
+            }
+        }
+    }
+    int policy;
+    sched_param param;
+    s.effectivePriority = 0;
+    if (pthread_getschedparam(self, &policy, &param) == 0 && (policy == SCHED_FIFO || policy == SCHED_RR)) {
+        s.effectivePriority = param.sched_priority;
+    }
+#elif defined(_WIN32)
+    HANDLE self = GetCurrentThread();
+    s.effectiveCPUs = 0;
+    if (s.requestedCPUs != 0) {
+        DWORD_PTR previous = SetThreadAffinityMask(self, static_cast<DWORD_PTR>(s.requestedCPUs));
+        if (previous == 0) {
+            LOG(plog::warning) << "Failed to pin " << role_name(role) << " thread; error " << GetLastError();
+        } else {
+            s.effectiveCPUs = s.requestedCPUs;
+        }
+    }
+    // Windows has no SCHED_FIFO; any real-time request maps to time critical
+    if (s.requestedPriority != 0 && !SetThreadPriority(self, THREAD_PRIORITY_TIME_CRITICAL)) {
+        LOG(plog::warning) << "Failed to raise " << role_name(role) << " thread priority; error " << GetLastError();
+    }
+    s.effectivePriority = (GetThreadPriority(self) == THREAD_PRIORITY_TIME_CRITICAL) ? s.requestedPriority : 0;
+#else
+    if (s.requestedCPUs != 0 || s.requestedPriority != 0) {
+        LOG(plog::warning) << "Thread affinity and priority are not supported on this platform.";
+    }
+    s.effectiveCPUs = 0;
+    s.effectivePriority = 0;
+#endif
+
+    s.applied = 1;
+    LOG(plog::info) << "Acquisition " << role_name(role) << " thread running on CPUs 0x" << std::hex
+                    << s.effectiveCPUs << std::dec << " with real-time priority " << s.effectivePriority;
+}
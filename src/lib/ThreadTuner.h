@@ -0,0 +1,40 @@
+// ThreadTuner.h
+//
+// Per-role CPU affinity and real-time priority for the acquisition threads.
+// Settings are stored up front and applied by each thread to itself when it
+// starts working on an acquisition.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef THREADTUNER_H_
+#define THREADTUNER_H_
+
+#include <array>
+#include <mutex>
+#include <cstdint>
+
+#include "X6_enums.h"
+
+const size_t NUM_THREAD_ROLES = 4;
+
+class ThreadTuner {
+public:
+	ThreadTuner();
+
+	void set_affinity(X6_THREAD_ROLE, uint64_t);
+	void set_priority(X6_THREAD_ROLE, int);
+	ThreadSettings get_settings(X6_THREAD_ROLE);
+
+	void reset();
+	void apply(X6_THREAD_ROLE);
+
+private:
+	static size_t index(X6_THREAD_ROLE);
+
+	std::mutex mutex_;
+	std::array<ThreadSettings, NUM_THREAD_ROLES> settings_;
+};
+
+#endif // THREADTUNER_H_
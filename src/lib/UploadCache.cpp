@@ -0,0 +1,56 @@
+// UploadCache.cpp
+//
+// Remembers a hash of what each kernel slot or pulse generator memory of the
+// card currently holds.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#include "UploadCache.h"
+
+UploadCache::UploadCache() : stats_{0, 0} {}
+
+uint64_t UploadCache::hash(const uint32_t * words, size_t length) {
+    const uint8_t * bytes = reinterpret_cast<const uint8_t *>(words);
+    uint64_t h = 14695981039346656037ull;
+    for (size_t ct = 0; ct < length * sizeof(uint32_t); ct++) {
+        h ^= bytes[ct];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+bool UploadCache::needs_upload(uint32_t slot, uint64_t h, bool force) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = hashes_.find(slot);
+    if (iter != hashes_.end()) {
+        if (!force && iter->second == h) {
+            stats_.skips++;
+            return false;
+        }
+        hashes_.erase(iter);
+    }
+    return true;
+}
+
+void UploadCache::uploaded(uint32_t slot, uint64_t h) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hashes_[slot] = h;
+    stats_.uploads++;
+}
+
+void UploadCache::forget(uint32_t slot) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hashes_.erase(slot);
+}
+
+void UploadCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hashes_.clear();
+}
+
+UploadStats UploadCache::get_stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
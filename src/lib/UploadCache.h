@@ -0,0 +1,48 @@
+// UploadCache.h
+//
+// Remembers a hash of what each kernel slot or pulse generator memory of the
+// card currently holds, so that uploads of unchanged content can be skipped.
+// Hashes are 64-bit FNV-1a over the words as written to the card.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef UPLOADCACHE_H_
+#define UPLOADCACHE_H_
+
+#include <map>
+#include <mutex>
+#include <cstddef>
+#include <cstdint>
+
+#include "X6_enums.h"
+
+class UploadCache {
+public:
+	UploadCache();
+
+	static uint64_t hash(const uint32_t *, size_t);
+
+	// whether content with this hash has to be written to the slot; counts a
+	// skip if not. A slot about to be written is forgotten until uploaded()
+	// so that a failed upload is not taken for a finished one.
+	bool needs_upload(uint32_t, uint64_t, bool force = false);
+	void uploaded(uint32_t, uint64_t);
+	// the slot was written some other way and its content is unknown
+	void forget(uint32_t);
+	// forget what the slots hold, e.g. after the card was reset
+	void clear();
+
+	UploadStats get_stats();
+
+private:
+	UploadCache(const UploadCache&) = delete;
+	UploadCache& operator=(const UploadCache&) = delete;
+
+	std::mutex mutex_;
+	std::map<uint32_t, uint64_t> hashes_;
+	UploadStats stats_;
+};
+
+#endif // UPLOADCACHE_H_
@@ -0,0 +1,160 @@
+// VitaDemux.cpp
+//
+// Single-pass demultiplexer for the VITA packets streamed from the QDSP
+// module. Walks the packet headers of a received buffer once and dispatches
+// whole records to per-stream consumers without copying.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#include "VitaDemux.h"
+
+#include <algorithm>
+
+VitaDemux::VitaDemux() :
+    packetsParsed{0}, recordsDispatched{0}, malformedPackets{0},
+    slotTable_(SLOT_TABLE_SIZE, -1) {};
+
+void VitaDemux::clear() {
+    std::fill(slotTable_.begin(), slotTable_.end(), -1);
+    slots_.clear();
+    reset();
+}
+
+void VitaDemux::reset() {
+    /* drop any partial packets or records left over from a previous acquisition */
+    for (auto & s : slots_) {
+        s.staging.clear();
+    }
+    carry_.clear();
+    packetsParsed = 0;
+    recordsDispatched = 0;
+    malformedPackets = 0;
+}
+
+unsigned VitaDemux::add_stream(uint16_t streamID, size_t recordWords) {
+    /*
+     * Registers a stream and returns the dense slot index records for it are
+     * dispatched with. recordWords is the length of a single record in 32-bit
+     * payload words.
+     */
+    int slot = get_slot(streamID);
+    if (slot < 0) {
+        slot = slots_.size();
+        slots_.emplace_back();
+        slotTable_[streamID & (SLOT_TABLE_SIZE - 1)] = slot;
+    }
+    StreamSlot & s = slots_[slot];
+    s.streamID = streamID;
+    s.recordWords = std::max<size_t>(recordWords, 1);
+    s.staging.clear();
+    // reserve up front so staging a partial record never allocates
+    s.staging.reserve(s.recordWords);
+    return slot;
+}
+
+int VitaDemux::get_slot(uint16_t streamID) const {
+    if (streamID >= SLOT_TABLE_SIZE) {
+        return -1;
+    }
+    return slotTable_[streamID];
+}
+
+size_t VitaDemux::get_num_streams() const {
+    return slots_.size();
+}
+
+void VitaDemux::set_packet_handler(PacketHandler handler) {
+    packetHandler_ = handler;
+}
+
+void VitaDemux::set_record_handler(RecordHandler handler) {
+    recordHandler_ = handler;
+}
+
+void VitaDemux::parse(const uint32_t * words, size_t numWords) {
+    /*
+     * Walks the VITA packets in a received buffer. A packet cut off at the end
+     * of the buffer is carried over and completed from the start of the next
+     * one.
+     */
+    size_t ct = 0;
+
+    if (!carry_.empty()) {
+        size_t packetSize = carry_[0] & 0xffff;
+        size_t take = std::min(packetSize - carry_.size(), numWords);
+        carry_.insert(carry_.end(), words, words + take);
+        ct = take;
+        if (carry_.size() < packetSize) {
+            return;
+        }
+        parse_packet(carry_.data(), carry_.size());
+        carry_.clear();
+    }
+
+    while (ct < numWords) {
+        size_t packetSize = words[ct] & 0xffff;
+        if (packetSize == 0) {
+            // zero padding to the end of the buffer
+            break;
+        }
+        if (ct + packetSize > numWords) {
+            carry_.assign(words + ct, words + numWords);
+            break;
+        }
+        parse_packet(words + ct, packetSize);
+        ct += packetSize;
+    }
+}
+
+size_t VitaDemux::parse_packet(const uint32_t * packet, size_t packetSize) {
+    VitaHeader header(packet);
+    if (static_cast<size_t>(header.headerSize) + (header.hasTrailer ? 1 : 0) > packetSize) {
+        malformedPackets++;
+        return packetSize;
+    }
+    packetsParsed++;
+    if (packetHandler_) {
+        packetHandler_(header);
+    }
+
+    int slot = get_slot(header.streamID);
+    if (slot >= 0) {
+        dispatch(slots_[slot], slot, packet + header.headerSize, header.payload_size(), header);
+    }
+    return packetSize;
+}
+
+void VitaDemux::dispatch(StreamSlot & s, unsigned slot, const uint32_t * data, size_t numWords, const VitaHeader & header) {
+    // finish a record started in an earlier packet
+    if (!s.staging.empty()) {
+        size_t take = std::min(s.recordWords - s.staging.size(), numWords);
+        s.staging.insert(s.staging.end(), data, data + take);
+        data += take;
+        numWords -= take;
+        if (s.staging.size() < s.recordWords) {
+            return;
+        }
+        if (recordHandler_) {
+            recordHandler_(slot, s.staging.data(), s.recordWords, s.stagingHeader);
+        }
+        recordsDispatched++;
+        s.staging.clear();
+    }
+
+    // whole records are handed out in place
+    while (numWords >= s.recordWords) {
+        if (recordHandler_) {
+            recordHandler_(slot, data, s.recordWords, header);
+        }
+        recordsDispatched++;
+        data += s.recordWords;
+        numWords -= s.recordWords;
+    }
+
+    if (numWords > 0) {
+        s.staging.assign(data, data + numWords);
+        s.stagingHeader = header;
+    }
+}
@@ -0,0 +1,71 @@
+// VitaDemux.h
+//
+// Single-pass demultiplexer for the VITA packets streamed from the QDSP
+// module. Walks the packet headers of a received buffer once and dispatches
+// whole records to per-stream consumers without copying.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef VITADEMUX_H_
+#define VITADEMUX_H_
+
+#include <functional>
+#include <vector>
+using std::vector;
+#include <cstddef>
+#include <cstdint>
+
+#include "VitaHeader.h"
+
+class VitaDemux {
+public:
+	// called for every packet header, whether or not the stream is registered
+	typedef std::function<void(const VitaHeader &)> PacketHandler;
+	// called with the stream slot, record payload, its length in 32-bit words
+	// and the header of the packet that started the record
+	typedef std::function<void(unsigned, const uint32_t *, size_t, const VitaHeader &)> RecordHandler;
+
+	VitaDemux();
+
+	void clear();
+	void reset();
+	unsigned add_stream(uint16_t, size_t);
+	int get_slot(uint16_t) const;
+	size_t get_num_streams() const;
+
+	void set_packet_handler(PacketHandler);
+	void set_record_handler(RecordHandler);
+
+	void parse(const uint32_t *, size_t);
+
+	size_t packetsParsed;
+	size_t recordsDispatched;
+	size_t malformedPackets;
+
+private:
+	// stream IDs are (a << 8) + (b << 4) + c so 12 bits index them directly
+	static const size_t SLOT_TABLE_SIZE = 1 << 12;
+	vector<int16_t> slotTable_;
+
+	struct StreamSlot {
+		uint16_t streamID;
+		size_t recordWords;
+		// partial record waiting for the remainder from a later packet
+		vector<uint32_t> staging;
+		VitaHeader stagingHeader;
+	};
+	vector<StreamSlot> slots_;
+
+	// partial VITA packet at the end of the previous buffer
+	vector<uint32_t> carry_;
+
+	PacketHandler packetHandler_;
+	RecordHandler recordHandler_;
+
+	size_t parse_packet(const uint32_t *, size_t);
+	void dispatch(StreamSlot &, unsigned, const uint32_t *, size_t, const VitaHeader &);
+};
+
+#endif // VITADEMUX_H_
@@ -0,0 +1,65 @@
+// VitaHeader.cpp
+//
+// Decoder for the VITA-49 packet headers streamed from the QDSP module.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#include "VitaHeader.h"
+
+VitaHeader::VitaHeader() :
+    streamID{0}, packetCount{0}, packetSize{0}, headerSize{0}, hasTrailer{false},
+    timestampSeconds{0}, timestampFractional{0} {};
+
+VitaHeader::VitaHeader(const uint32_t * words) : VitaHeader() {
+    /*
+     * Decodes the standard VITA-49 header word and the optional fields it
+     * announces:
+     *   [31:28] packet type [27] class ID present [26] trailer present
+     *   [23:22] integer timestamp [21:20] fractional timestamp
+     *   [19:16] packet count [15:0] packet size
+     * followed by the stream ID, class ID, integer and fractional timestamp.
+     */
+    uint32_t header = words[0];
+    unsigned packetType = header >> 28;
+    bool hasClassID = (header >> 27) & 0x1;
+    hasTrailer = (header >> 26) & 0x1;
+    bool hasTSI = ((header >> 22) & 0x3) != 0;
+    bool hasTSF = ((header >> 20) & 0x3) != 0;
+    packetCount = (header >> 16) & 0xf;
+    packetSize = header & 0xffff;
+
+    // Optional fields are only read while they lie inside packetSize. A
+    // truncated packet still gets the header size its flags announce, which
+    // payload_size() and the demux treat as malformed.
+    size_t ct = 1;
+    // packet types 1, 3, 4 and 5 carry a stream identifier
+    if (packetType == 1 || packetType == 3 || packetType == 4 || packetType == 5) {
+        if (ct < packetSize) {
+            streamID = words[ct] & 0xffff;
+        }
+        ct++;
+    }
+    if (hasClassID) {
+        ct += 2;
+    }
+    if (hasTSI) {
+        if (ct < packetSize) {
+            timestampSeconds = words[ct];
+        }
+        ct++;
+    }
+    if (hasTSF) {
+        if (ct + 1 < packetSize) {
+            timestampFractional = (static_cast<uint64_t>(words[ct]) << 32) | words[ct+1];
+        }
+        ct += 2;
+    }
+    headerSize = ct;
+};
+
+size_t VitaHeader::payload_size() const {
+    size_t overhead = headerSize + (hasTrailer ? 1 : 0);
+    return (packetSize > overhead) ? packetSize - overhead : 0;
+}
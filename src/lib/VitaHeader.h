@@ -0,0 +1,31 @@
+// VitaHeader.h
+//
+// Decoder for the VITA-49 packet headers streamed from the QDSP module.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef VITAHEADER_H_
+#define VITAHEADER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+class VitaHeader {
+public:
+	VitaHeader();
+	explicit VitaHeader(const uint32_t *);
+
+	uint16_t streamID;
+	uint8_t packetCount;    // 4-bit counter, increments per packet per stream ID
+	uint16_t packetSize;    // total packet size in 32-bit words including header and trailer
+	uint16_t headerSize;    // number of header words before the payload
+	bool hasTrailer;
+	uint32_t timestampSeconds;
+	uint64_t timestampFractional;
+
+	size_t payload_size() const;
+};
+
+#endif // VITAHEADER_H_
@@ -0,0 +1,47 @@
+// WaveformLibrary.cpp
+//
+// Named waveforms of one pulse generator, kept on the host.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#include "WaveformLibrary.h"
+
+#include "X6_errno.h"
+#include "logging.h"
+
+void WaveformLibrary::add(const string & name, const vector<uint32_t> & words, uint64_t hash) {
+    if (words.empty()) {
+        LOG(plog::error) << "Pulse waveform " << name << " is empty";
+        throw X6_INVALID_WF_LEN;
+    }
+    entries_[name] = {words, hash};
+}
+
+void WaveformLibrary::remove(const string & name) {
+    find(name);
+    entries_.erase(name);
+    if (selected_ == name) {
+        selected_.clear();
+    }
+}
+
+void WaveformLibrary::clear() {
+    entries_.clear();
+    selected_.clear();
+}
+
+const WaveformLibrary::Entry & WaveformLibrary::find(const string & name) const {
+    auto iter = entries_.find(name);
+    if (iter == entries_.end()) {
+        LOG(plog::error) << "No pulse waveform named " << name;
+        throw X6_INVALID_ARGUMENT;
+    }
+    return iter->second;
+}
+
+void WaveformLibrary::select(const string & name) {
+    find(name);
+    selected_ = name;
+}
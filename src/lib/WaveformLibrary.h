@@ -0,0 +1,52 @@
+// WaveformLibrary.h
+//
+// Named waveforms of one pulse generator, kept on the host packed as its
+// memory holds them, so that a sweep or sequence can switch between them by
+// name. The pulse generator always plays from the start of its memory, so a
+// selected waveform is uploaded there; together with the upload cache this
+// makes re-selecting the waveform already in memory free.
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef WAVEFORMLIBRARY_H_
+#define WAVEFORMLIBRARY_H_
+
+#include <map>
+using std::map;
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+#include <cstddef>
+#include <cstdint>
+
+class WaveformLibrary {
+public:
+	struct Entry {
+		vector<uint32_t> words; // two samples each
+		uint64_t hash;          // of the words, see UploadCache::hash
+	};
+
+	// replaces any waveform of the same name
+	void add(const string &, const vector<uint32_t> &, uint64_t);
+	void remove(const string &);
+	void clear();
+	bool contains(const string & name) const { return entries_.count(name) > 0; }
+	// throws X6_INVALID_ARGUMENT for names not in the library
+	const Entry & find(const string &) const;
+	size_t size() const { return entries_.size(); }
+
+	// the waveform last uploaded from the library; empty if none, if it was
+	// removed since or if memory was written with another waveform since
+	void select(const string &);
+	void deselect() { selected_.clear(); }
+	const string & get_selected() const { return selected_; }
+
+private:
+	map<string, Entry> entries_;
+	string selected_;
+};
+
+#endif // WAVEFORMLIBRARY_H_
@@ -13,8 +13,10 @@
 #include <limits>		 // numeric_limits
 
 #include "X6_1000.h"
+#include "KernelPacking.h"
 #include "X6_errno.h"
 #include "helpers.h"
+#include "logging.h"
 #include "constants.h"
 
 #include <IppMemoryUtils_Mb.h>	// for Init::UsePerformanceMemoryFunctions
@@ -24,6 +26,8 @@ using namespace Innovative;
 
 // constructor
 X6_1000::X6_1000() :
+    bus_{[this](uint32_t base) { return WishboneSpace(module_, base); }},
+    pipeline_{demux_},
     isOpen_{false},
     isRunning_{false},
     needToInit_{true},
@@ -34,11 +38,26 @@ X6_1000::X6_1000() :
 
   timer_.Interval(1000);
 
+  pipeline_.set_thread_init([this](X6_PIPELINE_STAGE stage) {
+    switch (stage) {
+      case PIPELINE_PARSE:
+        threadTuner_.apply(THREAD_PARSE);
+        break;
+      case PIPELINE_CONSUME:
+        threadTuner_.apply(THREAD_CONSUMER);
+        break;
+      default:
+        threadTuner_.apply(THREAD_PROCESS);
+        break;
+    }
+  });
+
   // Use IPP performance memory functions.
   Init::UsePerformanceMemoryFunctions();
 }
 
 X6_1000::~X6_1000() {
+  pipeline_.stop();
   if (isOpen_) close();
 }
 
@@ -102,6 +121,16 @@ void X6_1000::open(int deviceID) {
 
   isOpen_ = true;
 
+  // Shadow the DSP geometry and configuration so later calls need not read it
+  for (unsigned a = 1; a <= dspShadows_.size(); a++) {
+    try {
+      load_dsp_shadow(a);
+    }
+    catch (X6_STATUS) {
+      LOG(plog::warning) << "Could not shadow DSP " << a << " registers; they are read again when first used";
+    }
+  }
+
   log_card_info();
 
   //	Connect Stream
@@ -164,6 +193,16 @@ void X6_1000::close() {
   stream_.Disconnect();
   module_.Close();
   unregister_sockets();
+  unregister_record_consumers();
+  bus_.reset();
+  kernelUploads_.clear();
+  waveformUploads_.clear();
+  for (auto & library : pulseLibraries_) {
+    library.clear();
+  }
+  for (auto & shadow : dspShadows_) {
+    shadow.clear();
+  }
 
   isOpen_ = false;
   LOG(plog::info) << "Closed connection to device " << deviceID_;
@@ -205,6 +244,7 @@ double X6_1000::get_pll_frequency() {
 void X6_1000::set_trigger_source(X6_TRIGGER_SOURCE trgSrc) {
   // cache trigger source
   triggerSource_ = trgSrc;
+  rearmSession_.invalidate();
 }
 
 X6_TRIGGER_SOURCE X6_1000::get_trigger_source() const {
@@ -216,6 +256,7 @@ void X6_1000::set_trigger_delay(float delay) {
   // leaving as a TODO for now
   // Something like this might work:
   // trigger_.DelayedTriggerPeriod(delay);
+  rearmSession_.invalidate();
 }
 
 void X6_1000::set_digitizer_mode(const X6_DIGITIZER_MODE & mode) {
@@ -227,7 +268,18 @@ X6_DIGITIZER_MODE X6_1000::get_digitizer_mode() const {
   return digitizerMode_;
 }
 
+void X6_1000::set_spectrum_window(const X6_SPECTRUM_WINDOW & window) {
+  // takes effect at the next acquire()
+  LOG(plog::info) << "Setting spectrum window to: " << window;
+  spectrumWindow_ = window;
+}
+
+X6_SPECTRUM_WINDOW X6_1000::get_spectrum_window() const {
+  return spectrumWindow_;
+}
+
 void X6_1000::set_decimation(bool enabled, int factor) {
+  rearmSession_.invalidate();
   module_.Input().Decimation((enabled ) ? factor : 0);
 }
 
@@ -278,11 +330,11 @@ void X6_1000::set_record_length(int recordLength) {
 }
 
 int X6_1000::get_number_of_integrators(unsigned a) {
-  return read_dsp_register(a-1, WB_QDSP_NUM_RAW_KI);
+  return dsp_layout(a).numRawKi;
 }
 
 int X6_1000::get_number_of_demodulators(unsigned a) {
-  return read_dsp_register(a-1, WB_QDSP_NUM_DEMOD);
+  return dsp_layout(a).numDemod;
 }
 
 void X6_1000::set_state_vld_bitmask(unsigned a, unsigned mask) {
@@ -295,41 +347,51 @@ int X6_1000::get_state_vld_bitmask(unsigned a) {
 
 void X6_1000::enable_stream(unsigned a, unsigned b, unsigned c) {
   LOG(plog::info) << "Enable stream " << a << "." << b << "." << c;
+  rearmSession_.invalidate();
 
-  // Read the DSP stream counts
-  uint32_t numRawKi = get_number_of_integrators(a);
-  uint32_t numDemod = get_number_of_demodulators(a);
-  LOG(plog::info) << "Detected DSP " << a << " has having " << numRawKi << " raw streams and " << numDemod << " demod streams.";
+  if (QDSPStream(a, b, c).computed_on_host()) {
+    // computed on the host so there is no firmware stream to enable
+    QDSPStream stream = QDSPStream(a, b, c);
+    activeQDSPStreams_[stream.streamID] = stream;
+    return;
+  }
+
+  const DSPLayout & dsp = dsp_layout(a);
 
   // set the appropriate bit in stream_enable register
   int reg = read_dsp_register(a-1, WB_QDSP_STREAM_ENABLE);
-  int bit = (b==0) ? (c > numRawKi ? (c+2*numDemod) : c) : (numRawKi + b + (c == 0 ? 0 : numDemod));
+  int bit = (b==0) ? (c > dsp.numRawKi ? (c+2*dsp.numDemod) : c) : (dsp.numRawKi + b + (c == 0 ? 0 : dsp.numDemod));
   reg |= 1 << bit;
   LOG(plog::verbose) << "Setting stream_enable register bit " << bit << " by writing register value " << hexn<8> << reg;
   write_dsp_register(a-1, WB_QDSP_STREAM_ENABLE, reg);
 
-  QDSPStream stream = QDSPStream(a, b, c, numRawKi);
+  QDSPStream stream = QDSPStream(a, b, c, dsp.numRawKi);
   LOG(plog::verbose) << "Assigned stream " << a << "." << b << "." << c << " to streamID " << hexn<4> << stream.streamID;
   activeQDSPStreams_[stream.streamID] = stream;
 }
 
 void X6_1000::disable_stream(unsigned a, unsigned b, unsigned c) {
   LOG(plog::info) << "Disable stream " << a << "." << b << "." << c;
+  rearmSession_.invalidate();
+
+  if (QDSPStream(a, b, c).computed_on_host()) {
+    if (!activeQDSPStreams_.erase(QDSPStream(a, b, c).streamID)) {
+      LOG(plog::error) << "Tried to disable stream " << a << "." << b << "." << c << " which was not enabled.";
+    }
+    return;
+  }
 
-  // Read the DSP stream counts
-  uint32_t numRawKi = get_number_of_integrators(a);
-  uint32_t numDemod = get_number_of_demodulators(a);
-  LOG(plog::info) << "Detected DSP " << a << " has having " << numRawKi << " raw streams and " << numDemod << " demod streams.";
+  const DSPLayout & dsp = dsp_layout(a);
 
   // clear the appropriate bit in stream_enable register
   int reg = read_dsp_register(a-1, WB_QDSP_STREAM_ENABLE);
-  int bit = (b==0) ? (c > numRawKi ? (c+2*numDemod) : c) : (numRawKi + b + (c == 0 ? 0 : numDemod));
+  int bit = (b==0) ? (c > dsp.numRawKi ? (c+2*dsp.numDemod) : c) : (dsp.numRawKi + b + (c == 0 ? 0 : dsp.numDemod));
   reg &= ~(1 << bit);
   LOG(plog::verbose) << "Clearing stream_enable register bit " << bit << " by writing register value " << hexn<8> << reg;
   write_dsp_register(a-1, WB_QDSP_STREAM_ENABLE, reg);
 
   //Find the channel
-  uint16_t streamID = QDSPStream(a, b, c, numRawKi).streamID;
+  uint16_t streamID = QDSPStream(a, b, c, dsp.numRawKi).streamID;
   if (activeQDSPStreams_.count(streamID)) {
     activeQDSPStreams_.erase(streamID);
     LOG(plog::info) << "Disabling stream " << a << "." << b << "." << c;
@@ -362,99 +424,90 @@ bool X6_1000::get_output_channel_enable(unsigned channel) {
 }
 
 void X6_1000::set_nco_frequency(int a, int b, double freq) {
-  // Read the DSP stream counts
-  uint32_t numRawKi = get_number_of_integrators(a);
-  uint32_t numDemod = get_number_of_demodulators(a);
-  LOG(plog::info) << "Detected DSP " << a << " has having " << numRawKi << " raw streams and " << numDemod << " demod streams.";
+  if (b >= static_cast<int>(HOST_DSP_FIRST_CHANNEL)) {
+    LOG(plog::verbose) << "Setting host channel " << a << "." << b << " NCO frequency to: " << freq/1e6 << " MHz";
+    hostDSP_.set_nco_frequency(a, b, freq);
+    rearmSession_.invalidate();
+    return;
+  }
+  const DSPLayout & dsp = dsp_layout(a);
 
   // NCO runs at quarter rate
   double nfreq = 4 * freq/get_pll_frequency();
   int32_t phase_increment = rint(nfreq * (1 << 24)); //24 bit precision on DDS
   LOG(plog::verbose) << "Setting channel " << a << "." << b << " NCO frequency to: " << freq/1e6 << " MHz (" << phase_increment << ")";
-  write_dsp_register(a-1, WB_QDSP_PHASE_INC(numRawKi,numDemod) + (b-1), phase_increment);
+  write_dsp_register(a-1, dsp.phaseInc + (b-1), phase_increment);
 }
 
 double X6_1000::get_nco_frequency(int a, int b) {
-  // Read the DSP stream counts
-  uint32_t numRawKi = get_number_of_integrators(a);
-  uint32_t numDemod = get_number_of_demodulators(a);
-  LOG(plog::info) << "Detected DSP " << a << " has having " << numRawKi << " raw streams and " << numDemod << " demod streams.";
+  if (b >= static_cast<int>(HOST_DSP_FIRST_CHANNEL)) {
+    return hostDSP_.get_nco_frequency(a, b);
+  }
+  const DSPLayout & dsp = dsp_layout(a);
 
-  uint32_t phaseInc = read_dsp_register(a-1, WB_QDSP_PHASE_INC(numRawKi,numDemod) + (b-1));
+  uint32_t phaseInc = read_dsp_register(a-1, dsp.phaseInc + (b-1));
   //Undo the math in set_nco_frequency
   return static_cast<double>(phaseInc) / (1 << 24) * get_pll_frequency() / 4;
 }
 
 void X6_1000::set_threshold(int a, int c, double threshold) {
-  // Read the DSP stream counts
-  uint32_t numRawKi = get_number_of_integrators(a);
-  uint32_t numDemod = get_number_of_demodulators(a);
-  LOG(plog::info) << "Detected DSP " << a << " has having " << numRawKi << " raw streams and " << numDemod << " demod streams.";
+  const DSPLayout & dsp = dsp_layout(a);
 
   // Results are sfix32_15, so scale threshold by 2^15.
   int32_t scaled_threshold = threshold * (1 << 15);
   LOG(plog::verbose) << "Setting channel " << a << ".0." << c << " threshold to: " << threshold << " (" << scaled_threshold << ")";
-  write_dsp_register(a-1, WB_QDSP_THRESHOLD(numRawKi,numDemod) + (c-1), scaled_threshold);
+  write_dsp_register(a-1, dsp.threshold + (c-1), scaled_threshold);
 }
 
 double X6_1000::get_threshold(int a, int c) {
-  // Read the DSP stream counts
-  uint32_t numRawKi = get_number_of_integrators(a);
-  uint32_t numDemod = get_number_of_demodulators(a);
-  LOG(plog::info) << "Detected DSP " << a << " has having " << numRawKi << " raw streams and " << numDemod << " demod streams.";
-
-
-  int32_t fixedThreshold = read_dsp_register(a-1, WB_QDSP_THRESHOLD(numRawKi,numDemod) + (c-1));
+  const DSPLayout & dsp = dsp_layout(a);
+  int32_t fixedThreshold = read_dsp_register(a-1, dsp.threshold + (c-1));
   //Undo the scaling above
   return static_cast<double>(fixedThreshold) / (1 << 15);
 }
 
 void X6_1000::set_threshold_invert(int a, int c, bool invert){
-  // Read the DSP stream counts
-  uint32_t numRawKi = get_number_of_integrators(a);
-  uint32_t numDemod = get_number_of_demodulators(a);
-  LOG(plog::info) << "Detected DSP " << a << " has having " << numRawKi << " raw streams and " << numDemod << " demod streams.";
+  const DSPLayout & dsp = dsp_layout(a);
 
   //Get the current register for bit bashing
-  std::bitset<32> bits(read_dsp_register(a-1, WB_QDSP_THRESHOLD_INVERT(numRawKi,numDemod)));
+  std::bitset<32> bits(read_dsp_register(a-1, dsp.thresholdInvert));
   bits[c-1] = invert;
-  write_dsp_register(a-1, WB_QDSP_THRESHOLD_INVERT(numRawKi,numDemod), bits.to_ulong());
+  write_dsp_register(a-1, dsp.thresholdInvert, bits.to_ulong());
 }
 
 bool X6_1000::get_threshold_invert(int a, int c) {
-  // Read the DSP stream counts
-  uint32_t numRawKi = get_number_of_integrators(a);
-  uint32_t numDemod = get_number_of_demodulators(a);
-  LOG(plog::info) << "Detected DSP " << a << " has having " << numRawKi << " raw streams and " << numDemod << " demod streams.";
+  const DSPLayout & dsp = dsp_layout(a);
 
-  std::bitset<32> bits(read_dsp_register(a-1, WB_QDSP_THRESHOLD_INVERT(numRawKi,numDemod)));
+  std::bitset<32> bits(read_dsp_register(a-1, dsp.thresholdInvert));
   return bits[c-1];
 }
 
 void X6_1000::set_threshold_input_sel(int a, int thresholder, bool correlated){
-  // Read the DSP stream counts
-  uint32_t numRawKi = get_number_of_integrators(a);
-  uint32_t numDemod = get_number_of_demodulators(a);
-  LOG(plog::info) << "Detected DSP " << a << " has having " << numRawKi << " raw streams and " << numDemod << " demod streams.";
+  const DSPLayout & dsp = dsp_layout(a);
 
   //Get the current register for bit bashing
-  std::bitset<32> bits(read_dsp_register(a-1, WB_QDSP_THRESHOLD_INPUT_SEL(numRawKi,numDemod)));
+  std::bitset<32> bits(read_dsp_register(a-1, dsp.thresholdInputSel));
   bits[thresholder-1] = correlated;
-  write_dsp_register(a-1, WB_QDSP_THRESHOLD_INPUT_SEL(numRawKi,numDemod), bits.to_ulong());
+  write_dsp_register(a-1, dsp.thresholdInputSel, bits.to_ulong());
 }
 
 bool X6_1000::get_threshold_input_sel(int a, int thresholder) {
-  // Read the DSP stream counts
-  uint32_t numRawKi = get_number_of_integrators(a);
-  uint32_t numDemod = get_number_of_demodulators(a);
-  LOG(plog::info) << "Detected DSP " << a << " has having " << numRawKi << " raw streams and " << numDemod << " demod streams.";
+  const DSPLayout & dsp = dsp_layout(a);
 
-  std::bitset<32> bits(read_dsp_register(a-1, WB_QDSP_THRESHOLD_INPUT_SEL(numRawKi,numDemod)));
+  std::bitset<32> bits(read_dsp_register(a-1, dsp.thresholdInputSel));
   return bits[thresholder-1];
 }
 
 void X6_1000::write_kernel(int a, int b, int c, const vector<complex<double>> & kernel) {
 
+  if (b >= static_cast<int>(HOST_DSP_FIRST_CHANNEL)) {
+    // host kernels are applied in floating point so there is no range or length limit
+    LOG(plog::verbose) << "Writing host channel " << a << "." << b << "." << c << " kernel with length " << kernel.size();
+    hostDSP_.write_kernel(a, b, c, kernel);
+    rearmSession_.invalidate();
+    return;
+  }
+
   if ( (b == 0 && c == 0) || (b != 0 && c == 0) ) {
     LOG(plog::error) << "Attempt to write kernel to non kernel integration stream";
     throw X6_INVALID_KERNEL_STREAM;
@@ -467,91 +520,97 @@ void X6_1000::write_kernel(int a, int b, int c, const vector<complex<double>> &
       throw X6_INVALID_KERNEL_LENGTH;
   }
 
-  //Check the kernel is in range
-  auto range_check = [](double val){
-    const double one_bit_level = 1.0/(1 << KERNEL_FRAC_BITS);
-    if ((val > (MAX_KERNEL_VALUE + 1.5*one_bit_level )) || (val < (MIN_KERNEL_VALUE - 0.5*one_bit_level)) ) {
-      LOG(plog::error) << "kernel value " << val << " is out of range";
-      throw X6_KERNEL_OUT_OF_RANGE;
-    }
-  };
+  //Quantise the whole kernel, checking it is in range
+  vector<uint32_t> words(kernel.size());
+  pack_kernel(kernel.data(), kernel.size(), words.data());
 
-  for (auto val : kernel) {
-    range_check(std::real(val));
-    range_check(std::imag(val));
+  //Nothing to do if the slot already holds this kernel
+  uint32_t slot = (a << 16) | (b << 8) | c;
+  uint64_t hash = UploadCache::hash(words.data(), words.size());
+  if (!kernelUploads_.needs_upload(slot, hash, forceUploads_)) {
+    LOG(plog::verbose) << "Channel " << a << "." << b << "." << c << " already holds this kernel";
+    return;
   }
 
-  auto scale_with_clip = [](double val){
-    val = std::min(val, MAX_KERNEL_VALUE);
-    val = std::max(val, MIN_KERNEL_VALUE);
-    return val * (1 << KERNEL_FRAC_BITS);
-  };
-
-  // Read the DSP stream counts
-  uint32_t numRawKi = get_number_of_integrators(a);
-  uint32_t numDemod = get_number_of_demodulators(a);
-  LOG(plog::info) << "Detected DSP " << a << " has having " << numRawKi << " raw streams and " << numDemod << " demod streams.";
+  const DSPLayout & dsp = dsp_layout(a);
 
   LOG(plog::verbose) << "Writing channel " << a << "." << b << "." << c << " kernel with length	" << kernel.size();
 
   //Depending on raw or demod integrator we are enumerated by c or b
   int channel = (b==0) ? c : b;
-  uint32_t wbLengthReg = (b==0) ?	WB_QDSP_RAW_KERNEL_LENGTH : WB_QDSP_DEMOD_KERNEL_LENGTH(numRawKi,numDemod);
-  uint32_t wbAddrDataReg = (b==0) ?	WB_QDSP_RAW_KERNEL_ADDR_DATA(numRawKi,numDemod) : WB_QDSP_DEMOD_KERNEL_ADDR_DATA(numRawKi,numDemod);
-
-  //Write the length register
-  write_dsp_register(a-1, wbLengthReg + (channel-1), kernel.size());
-
-  //Kernel memory as address/data pairs
-  for (size_t ct = 0; ct < kernel.size(); ct++) {
-    int32_t scaled_re = scale_with_clip(std::real(kernel[ct]));
-    int32_t scaled_im = scale_with_clip(std::imag(kernel[ct]));
-    uint32_t packedval = (scaled_im << 16) | (scaled_re & 0xffff);
-    write_dsp_register(a-1, wbAddrDataReg + 2*(channel-1), ct);
-    write_dsp_register(a-1, wbAddrDataReg + 2*(channel-1) + 1, packedval);
+  uint32_t wbLengthReg = (b==0) ?	WB_QDSP_RAW_KERNEL_LENGTH : dsp.demodKernelLength;
+  uint32_t wbAddrDataReg = (b==0) ?	dsp.rawKernelAddrData : dsp.demodKernelAddrData;
+  wbAddrDataReg += 2*(channel-1);
+
+  //The length register, then kernel memory as address/data pairs, in one batch
+  RegisterBatch batch;
+  batch.reserve(1 + 2*words.size());
+  batch.write(BASE_DSP[a-1], wbLengthReg + (channel-1), kernel.size());
+  for (size_t ct = 0; ct < words.size(); ct++) {
+    batch.write(BASE_DSP[a-1], wbAddrDataReg, ct);
+    batch.write(BASE_DSP[a-1], wbAddrDataReg + 1, words[ct]);
   }
+  execute_register_batch(batch);
+  kernelUploads_.uploaded(slot, hash);
 }
 
 complex<double> X6_1000::read_kernel(unsigned a, unsigned b, unsigned c, unsigned addr) {
   //Read kernel memory at the specified address
+  complex<double> val;
+  read_kernels(a, b, c, addr, 1, &val);
+  return val;
+}
+
+void X6_1000::read_kernels(unsigned a, unsigned b, unsigned c, unsigned addr, size_t length, complex<double> * kernel) {
+  //Read length points of kernel memory starting at the specified address
+  if (b >= HOST_DSP_FIRST_CHANNEL) {
+    for (size_t ct = 0; ct < length; ct++) {
+      kernel[ct] = hostDSP_.read_kernel(a, b, c, addr + ct);
+    }
+    return;
+  }
+
+  size_t maxLength = (b == 0) ? MAX_RAW_KERNEL_LENGTH : MAX_DEMOD_KERNEL_LENGTH;
+  if (addr + length > maxLength) {
+    LOG(plog::error) << "Kernel readback of " << length << " points from address " << addr << " is past the end of kernel memory";
+    throw X6_INVALID_KERNEL_LENGTH;
+  }
 
-  // Read the DSP stream counts
-  uint32_t numRawKi = get_number_of_integrators(a);
-  uint32_t numDemod = get_number_of_demodulators(a);
-  LOG(plog::info) << "Detected DSP " << a << " has having " << numRawKi << " raw streams and " << numDemod << " demod streams.";
+  const DSPLayout & dsp = dsp_layout(a);
 
   //Depending on raw or demod integrator we are enumerated by c or b
   int KI = (b==0) ? c : b;
-  uint32_t wbAddrDataReg = (b==0) ?	WB_QDSP_RAW_KERNEL_ADDR_DATA(numRawKi,numDemod) : WB_QDSP_DEMOD_KERNEL_ADDR_DATA(numRawKi,numDemod);
-
-  //Write the address register
-  write_dsp_register(a-1, wbAddrDataReg + 2*(KI-1), addr);
-
-  //Read the data
-  uint32_t packedVal = read_dsp_register(a-1, wbAddrDataReg + 2*(KI-1) + 1);
+  uint32_t wbAddrDataReg = (b==0) ?	dsp.rawKernelAddrData : dsp.demodKernelAddrData;
+  wbAddrDataReg += 2*(KI-1);
+
+  //Write each address and read its data, all in one batch
+  vector<uint32_t> words(length);
+  RegisterBatch batch;
+  batch.reserve(2*length);
+  for (size_t ct = 0; ct < length; ct++) {
+    batch.write(BASE_DSP[a-1], wbAddrDataReg, addr + ct);
+    batch.read(BASE_DSP[a-1], wbAddrDataReg + 1, &words[ct]);
+  }
+  execute_register_batch(batch);
 
   //Scale and convert back to complex
-  //The conversion from unsigned to signed is not guaranteed to keep the bit pattern
-  //However for gcc using two's complement it does
-  //See http://stacko;verflow.com/a/4219558 and http://stackoverflow.com/q/13150449
-  int16_t fixedReal = packedVal & 0xffff;
-  int16_t fixedImag = packedVal >> 16;
-  return complex<double>(static_cast<double>(fixedReal) / ((1 << 15) - 1),
-                        static_cast<double>(fixedImag) / ((1 << 15) - 1) );
+  unpack_kernel(words.data(), length, kernel);
 }
 
 void X6_1000::set_kernel_bias(int a, int b, int c, complex<double> bias) {
-  // Read the DSP stream counts
-  uint32_t numRawKi = get_number_of_integrators(a);
-  uint32_t numDemod = get_number_of_demodulators(a);
-  LOG(plog::info) << "Detected DSP " << a << " has having " << numRawKi << " raw streams and " << numDemod << " demod streams.";
+  if (b >= static_cast<int>(HOST_DSP_FIRST_CHANNEL)) {
+    hostDSP_.set_kernel_bias(a, b, c, bias);
+    rearmSession_.invalidate();
+    return;
+  }
+  const DSPLayout & dsp = dsp_layout(a);
 
   //Use a QDSPStream to get the scaling
-  QDSPStream stream(a,b,c,numRawKi);
+  QDSPStream stream(a,b,c,dsp.numRawKi);
   unsigned scale = stream.fixed_to_float();
 
   //get wishbone address from stream ID
-  uint32_t wb_addr = (b==0) ?	WB_QDSP_RAW_KERNEL_BIAS(numRawKi,numDemod) : WB_QDSP_DEMOD_KERNEL_BIAS(numRawKi,numDemod);
+  uint32_t wb_addr = (b==0) ?	dsp.rawKernelBias : dsp.demodKernelBias;
   //Depending on raw or demod integrator we are enumerated by c or b
   wb_addr += 2*(((b==0) ? c : b) - 1);
 
@@ -563,17 +622,17 @@ void X6_1000::set_kernel_bias(int a, int b, int c, complex<double> bias) {
 }
 
 complex<double> X6_1000::get_kernel_bias(int a, int b, int c) {
-  // Read the DSP stream counts
-  uint32_t numRawKi = get_number_of_integrators(a);
-  uint32_t numDemod = get_number_of_demodulators(a);
-  LOG(plog::info) << "Detected DSP " << a << " has having " << numRawKi << " raw streams and " << numDemod << " demod streams.";
+  if (b >= static_cast<int>(HOST_DSP_FIRST_CHANNEL)) {
+    return hostDSP_.get_kernel_bias(a, b, c);
+  }
+  const DSPLayout & dsp = dsp_layout(a);
 
   //Use a QDSPStream to get the scaling
-  QDSPStream stream(a,b,c,numRawKi);
+  QDSPStream stream(a,b,c,dsp.numRawKi);
   unsigned scale = stream.fixed_to_float();
 
   //get wishbone address from stream ID
-  uint32_t wb_addr = (b==0) ?	WB_QDSP_RAW_KERNEL_BIAS(numRawKi,numDemod) : WB_QDSP_DEMOD_KERNEL_BIAS(numRawKi,numDemod);
+  uint32_t wb_addr = (b==0) ?	dsp.rawKernelBias : dsp.demodKernelBias;
   //Depending on raw or demod integrator we are enumerated by c or b
   wb_addr += 2*(((b==0) ? c : b) - 1);
 
@@ -584,6 +643,116 @@ complex<double> X6_1000::get_kernel_bias(int a, int b, int c) {
   return complex<double>(static_cast<double>(real_reg) / scale, static_cast<double>(imag_reg) / scale);
 }
 
+void X6_1000::set_host_decimation(int a, int b, unsigned factor, const vector<double> & taps) {
+  // an empty filter selects the default low-pass for the decimation factor
+  LOG(plog::verbose) << "Setting host channel " << a << "." << b << " decimation to " << factor
+                     << " with " << (taps.empty() ? "the default" : std::to_string(taps.size()) + " tap") << " filter";
+  hostDSP_.set_decimation(a, b, factor, taps);
+  rearmSession_.invalidate();
+}
+
+void X6_1000::set_host_dsp_threads(unsigned numThreads) {
+  if (isRunning_) {
+    LOG(plog::error) << "Cannot change the host DSP threads during an acquisition";
+    throw X6_MODE_ERROR;
+  }
+  hostDSP_.set_num_threads(numThreads);
+  rearmSession_.invalidate();
+}
+
+void X6_1000::set_kernel_bank(int a, int b, const vector<vector<complex<double>>> & kernels) {
+  // an empty bank removes the channel's kernel bank
+  if (isRunning_) {
+    LOG(plog::error) << "Cannot change a kernel bank during an acquisition";
+    throw X6_MODE_ERROR;
+  }
+  if (b == 0) {
+    LOG(plog::error) << "Kernel banks apply to demod channels only";
+    throw X6_INVALID_CHANNEL;
+  }
+  rearmSession_.invalidate();
+  uint16_t sid = QDSPStream(a, b, 0).streamID;
+  if (kernels.empty()) {
+    kernelBanks_.erase(sid);
+    return;
+  }
+  LOG(plog::verbose) << "Setting channel " << a << "." << b << " kernel bank of " << kernels.size() << " kernels";
+  kernelBanks_[sid] = KernelBank(kernels);
+}
+
+void X6_1000::set_discriminator(unsigned d, const vector<QDSPStream> & inputs, X6_DISCRIMINATOR_KIND kind,
+                                unsigned numClasses, const vector<double> & params) {
+  // zero classes removes discriminator d
+  if (isRunning_) {
+    LOG(plog::error) << "Cannot change a discriminator during an acquisition";
+    throw X6_MODE_ERROR;
+  }
+  if (d < 1 || d > MAX_DISCRIMINATORS) {
+    LOG(plog::error) << "Discriminator " << d << " out of range 1-" << MAX_DISCRIMINATORS;
+    throw X6_INVALID_CHANNEL;
+  }
+  rearmSession_.invalidate();
+  uint16_t sid = QDSPStream(DISCRIMINATOR_CHANNEL, d, 0).streamID;
+  if (numClasses == 0) {
+    discriminators_.erase(sid);
+    return;
+  }
+  for (auto & input : inputs) {
+    if (input.type != RESULT || input.is_kernel_bank()) {
+      LOG(plog::error) << "Discriminator input " << input.channelID[0] << "." << input.channelID[1] << "."
+                       << input.channelID[2] << " is not a result stream";
+      throw X6_INVALID_CHANNEL;
+    }
+  }
+  LOG(plog::verbose) << "Setting discriminator " << d << " with " << inputs.size() << " inputs and "
+                     << numClasses << " states";
+  discriminators_[sid] = Discriminator(inputs, kind, numClasses, params);
+}
+
+void X6_1000::attach_cross_correlator(const QDSPStream & stream, CrossBoardCorrelator * correlator, int index) {
+  if (isRunning_) {
+    LOG(plog::error) << "Cannot change cross-board correlators during an acquisition";
+    throw X6_MODE_ERROR;
+  }
+  if (stream.type != RESULT || stream.is_kernel_bank()) {
+    LOG(plog::error) << "Cross-board correlator input " << stream.channelID[0] << "." << stream.channelID[1] << "."
+                     << stream.channelID[2] << " is not a result stream";
+    throw X6_INVALID_CHANNEL;
+  }
+  crossCorrelatorInputs_.push_back({stream.streamID, correlator, index});
+  rearmSession_.invalidate();
+}
+
+void X6_1000::detach_cross_correlator(CrossBoardCorrelator * correlator) {
+  if (isRunning_) {
+    LOG(plog::error) << "Cannot change cross-board correlators during an acquisition";
+    throw X6_MODE_ERROR;
+  }
+  crossCorrelatorInputs_.erase(std::remove_if(crossCorrelatorInputs_.begin(), crossCorrelatorInputs_.end(),
+    [correlator](const CrossCorrelatorInput & input) { return input.correlator == correlator; }),
+    crossCorrelatorInputs_.end());
+  rearmSession_.invalidate();
+}
+
+size_t X6_1000::get_discriminator_counts_size(unsigned d) {
+  auto it = discriminators_.find(QDSPStream(DISCRIMINATOR_CHANNEL, d, 0).streamID);
+  if (it == discriminators_.end()) {
+    LOG(plog::error) << "Discriminator " << d << " has not been set";
+    throw X6_INVALID_CHANNEL;
+  }
+  return it->second.get_counts_size();
+}
+
+void X6_1000::transfer_discriminator_counts(unsigned d, uint64_t * buffer, size_t length) {
+  // state counts of each segment, segment-major
+  size_t size = get_discriminator_counts_size(d);
+  if (length < size) {
+    LOG(plog::error) << "Not enough memory allocated in buffer to transfer discriminator counts.";
+    throw X6_INVALID_ARGUMENT;
+  }
+  discriminators_[QDSPStream(DISCRIMINATOR_CHANNEL, d, 0).streamID].snapshot_counts(buffer);
+}
+
 void X6_1000::set_active_channels() {
   module_.Output().ChannelDisableAll();
   module_.Input().ChannelDisableAll();
@@ -600,12 +769,7 @@ void X6_1000::set_active_channels() {
 }
 
 uint32_t X6_1000::get_correlator_size(int a) {
-  // Read the DSP stream counts
-  uint32_t numRawKi = get_number_of_integrators(a);
-  uint32_t numDemod = get_number_of_demodulators(a);
-  LOG(plog::info) << "Detected DSP " << a << " has having " << numRawKi << " raw streams and " << numDemod << " demod streams.";
-
-  return read_dsp_register(a-1, WB_QDSP_CORRELATOR_SIZE(numRawKi,numDemod));
+  return dsp_layout(a).correlatorSize;
 }
 
 void X6_1000::write_correlator_matrix(int a, const vector<double> & matrix) {
@@ -628,10 +792,7 @@ void X6_1000::write_correlator_matrix(int a, const vector<double> & matrix) {
     }
   }
 
-  // Read the DSP stream counts
-  uint32_t numRawKi = get_number_of_integrators(a);
-  uint32_t numDemod = get_number_of_demodulators(a);
-  LOG(plog::info) << "Detected DSP " << a << " has having " << numRawKi << " raw streams and " << numDemod << " demod streams.";
+  const DSPLayout & dsp = dsp_layout(a);
 
   auto scale_with_clip = [](double val){
     val = std::min(val, MAX_CORRELATOR_VALUE);
@@ -640,28 +801,29 @@ void X6_1000::write_correlator_matrix(int a, const vector<double> & matrix) {
   };
 
   //Matrix memory as address/data pairs
+  RegisterBatch batch;
+  batch.reserve(2 * matrix.size());
   for (size_t ct = 0; ct < matrix.size(); ct++) {
     int16_t scaled = scale_with_clip(matrix[ct]);
     uint32_t conv = scaled;
     LOG(plog::info) << "Writing " << hexn<4> << conv << " to addr " << ct;
-    write_dsp_register(a-1, WB_QDSP_CORRELATOR_M_ADDR(numRawKi,numDemod), ct);
-    write_dsp_register(a-1, WB_QDSP_CORRELATOR_M_DATA(numRawKi,numDemod), conv);
+    batch.write(BASE_DSP[a-1], dsp.correlatorMAddr, ct);
+    batch.write(BASE_DSP[a-1], dsp.correlatorMData, conv);
   }
+  execute_register_batch(batch);
 }
 
 double X6_1000::read_correlator_matrix(int a, unsigned addr) {
   //Read correlator matrix memory at the specified address
 
-  // Read the DSP stream counts
-  uint32_t numRawKi = get_number_of_integrators(a);
-  uint32_t numDemod = get_number_of_demodulators(a);
-  LOG(plog::info) << "Detected DSP " << a << " has having " << numRawKi << " raw streams and " << numDemod << " demod streams.";
+  const DSPLayout & dsp = dsp_layout(a);
 
-  //Write the address register
-  write_dsp_register(a-1, WB_QDSP_CORRELATOR_M_ADDR(numRawKi,numDemod), addr);
-
-  //Read the data
-  uint32_t val = read_dsp_register(a-1, WB_QDSP_CORRELATOR_M_DATA(numRawKi,numDemod));
+  //Write the address register and read the data in one go
+  uint32_t val;
+  RegisterBatch batch;
+  batch.write(BASE_DSP[a-1], dsp.correlatorMAddr, addr);
+  batch.read(BASE_DSP[a-1], dsp.correlatorMData, &val);
+  execute_register_batch(batch);
 
   //Scale and convert back to complex
   //The conversion from unsigned to signed is not guaranteed to keep the bit pattern
@@ -672,22 +834,16 @@ double X6_1000::read_correlator_matrix(int a, unsigned addr) {
 }
 
 void X6_1000::set_correlator_input(int a, uint32_t input_num, uint32_t sel) {
-  // Read the DSP stream counts
-  uint32_t numRawKi = get_number_of_integrators(a);
-  uint32_t numDemod = get_number_of_demodulators(a);
-  LOG(plog::info) << "Detected DSP " << a << " has having " << numRawKi << " raw streams and " << numDemod << " demod streams.";
+  const DSPLayout & dsp = dsp_layout(a);
 
   LOG(plog::info) << "Setting input " << input_num << " to " << sel;
-  write_dsp_register(a-1, WB_QDSP_CORRELATOR_SEL(numRawKi,numDemod) + input_num, sel);
+  write_dsp_register(a-1, dsp.correlatorSel + input_num, sel);
 }
 
 uint32_t X6_1000::get_correlator_input(int a, uint32_t input_num) {
-  // Read the DSP stream counts
-  uint32_t numRawKi = get_number_of_integrators(a);
-  uint32_t numDemod = get_number_of_demodulators(a);
-  LOG(plog::info) << "Detected DSP " << a << " has having " << numRawKi << " raw streams and " << numDemod << " demod streams.";
+  const DSPLayout & dsp = dsp_layout(a);
 
-  return read_dsp_register(a-1, WB_QDSP_CORRELATOR_SEL(numRawKi,numDemod) + input_num);
+  return read_dsp_register(a-1, dsp.correlatorSel + input_num);
 }
 
 void X6_1000::log_card_info() {
@@ -706,11 +862,131 @@ void X6_1000::log_card_info() {
 }
 
 void X6_1000::acquire() {
+  // an unchanged setup is re-armed in place rather than rebuilt
+  SessionLayout layout = current_layout();
+  bool rearm = fastRearm_ && rearmSession_.is_valid() && !needToInit_ && layout == session_;
+
   //Configure the streams (calibrate DACs) if necessary
   if (needToInit_) {
     init();
   }
 
+  if (rearm) {
+    LOG(plog::debug) << "Re-arming the previous acquisition in place";
+    reset_stream_state();
+  } else {
+    rearmSession_.invalidate();
+    configure_trigger();
+    initialize_stream_state();
+  }
+
+  vector<uint16_t> streamIDs;
+  for (auto kv : activeQDSPStreams_) {
+    // streams computed on the host never arrive in packets
+    if (!kv.second.computed_on_host()) {
+      streamIDs.push_back(kv.first);
+    }
+  }
+  sequenceTracker_.reset(streamIDs);
+  packetLoss_ = false;
+  bankQueue_.reset(streamContexts_.size());
+  banksStalled_ = false;
+
+  recordsTaken_ = 0;
+
+  if (!rearm) {
+    module_.Velo().LoadAll_VeloDataSize(0x4000);
+    module_.Velo().ForceVeloPacketSize(false);
+
+    // is this necessary??
+    stream_.PrefillPacketCount(prefillPacketCount_);
+  }
+
+  trigger_.AtStreamStart();
+
+  LOG(plog::debug) << "AFE reg. 0x5 (adc/dac run): " << hexn<8> << read_wishbone_register(0x0800, 0x5);
+  LOG(plog::debug) << "AFE reg. 0x8 (adc en): " << hexn<8> << read_wishbone_register(0x0800, 0x8);
+  LOG(plog::debug) << "AFE reg. 0x9 (adc trigger): " << hexn<8> << read_wishbone_register(0x0800, 0x9);
+  LOG(plog::debug) << "AFE reg. 0x80 (dac en): " << hexn<8> << read_wishbone_register(0x0800, 0x80);
+  LOG(plog::debug) << "AFE reg. 0x81 (dac trigger): " << hexn<8> << read_wishbone_register(0x0800, 0x81);
+
+  // Enable the pulse generators, on a re-arm too since a register write may
+  // have cleared the bit; stop() leaves them enabled
+  for (size_t pg = 0; pg < 2; pg++) {
+    std::bitset<32> reg(read_wishbone_register(BASE_PG[pg], WB_PG_CONTROL));
+    reg.set(0);
+    write_wishbone_register(BASE_PG[pg], WB_PG_CONTROL, reg.to_ulong());
+  }
+  if (!rearm) {
+    session_ = layout;
+    rearmSession_.validate();
+  }
+
+  // flag must be set before calling stream start
+  isRunning_ = true;
+  notifier_.start();
+  // threads pick up their affinity and priority as they start working
+  threadTuner_.reset();
+  receiveThreadTuned_ = false;
+  pipeline_.start();
+
+  //	Start Streaming
+  LOG(plog::info) << "Arming acquisition";
+  stream_.Start();
+
+  LOG(plog::debug) << "AFE reg. 0x5 (adc/dac run): " << hexn<8> << read_wishbone_register(0x0800, 0x5);
+  LOG(plog::debug) << "AFE reg. 0x8 (adc en): " << hexn<8> << read_wishbone_register(0x0800, 0x8);
+  LOG(plog::debug) << "AFE reg. 0x9 (adc trigger): " << hexn<8> << read_wishbone_register(0x0800, 0x9);
+  LOG(plog::debug) << "AFE reg. 0x80 (dac en): " << hexn<8> << read_wishbone_register(0x0800, 0x80);
+  LOG(plog::debug) << "AFE reg. 0x81 (dac trigger): " << hexn<8> << read_wishbone_register(0x0800, 0x81);
+}
+
+void X6_1000::set_fast_rearm(bool enable) {
+  // the first acquire() after enabling still sets everything up
+  fastRearm_ = enable;
+}
+
+bool X6_1000::get_fast_rearm() const {
+  return fastRearm_;
+}
+
+void X6_1000::set_force_uploads(bool force) {
+  forceUploads_ = force;
+}
+
+bool X6_1000::get_force_uploads() const {
+  return forceUploads_;
+}
+
+UploadStats X6_1000::get_kernel_upload_stats() {
+  return kernelUploads_.get_stats();
+}
+
+UploadStats X6_1000::get_waveform_upload_stats() {
+  return waveformUploads_.get_stats();
+}
+
+bool X6_1000::SessionLayout::operator==(const SessionLayout & other) const {
+  return recordLength == other.recordLength && numSegments == other.numSegments &&
+         waveforms == other.waveforms && numRecords == other.numRecords &&
+         digitizerMode == other.digitizerMode && spectrumWindow == other.spectrumWindow &&
+         triggerSource == other.triggerSource && hugePageMode == other.hugePageMode;
+}
+
+X6_1000::SessionLayout X6_1000::current_layout() const {
+  SessionLayout layout;
+  layout.recordLength = recordLength_;
+  layout.numSegments = numSegments_;
+  layout.waveforms = waveforms_;
+  layout.numRecords = numRecords_;
+  layout.digitizerMode = digitizerMode_;
+  layout.spectrumWindow = spectrumWindow_;
+  layout.triggerSource = triggerSource_;
+  layout.hugePageMode = MemoryPolicy::get_mode();
+  return layout;
+}
+
+void X6_1000::configure_trigger() {
   //Some trigger stuff cribbed from II examples - necessity of all of it is unclear
   trigger_.DelayedTriggerPeriod(0);
   trigger_.ExternalTrigger(triggerSource_ == EXTERNAL_TRIGGER ? true : false);
@@ -727,129 +1003,87 @@ void X6_1000::acquire() {
   //	Route External Trigger source
   module_.Output().Trigger().ExternalSyncSource( IX6IoDevice::essFrontPanel );
   module_.Input().Trigger().ExternalSyncSource( IX6IoDevice::essFrontPanel );
+}
 
-  // Initialize VeloMergeParsers with stream IDs
-  VMPs_.clear();
-  VMPs_.resize(5);
-
-  physChans_.clear();
-  virtChans_.clear();
+void X6_1000::initialize_stream_state() {
+  /*
+   * Builds the accumulators, queues, correlators and demux slots of every
+   * enabled stream for the coming acquisition.
+   */
   resultChans_.clear();
-  stateChans_.clear();
-  correlatedChans_.clear();
-
   for (auto kv : activeQDSPStreams_){
     switch (kv.second.type) {
     case PHYSICAL:
-      physChans_.push_back(kv.first);
       LOG(plog::debug) << "ADC physical stream ID: " << hexn<4> << kv.first;
       break;
     case DEMOD:
-      virtChans_.push_back(kv.first);
       LOG(plog::debug) << "ADC virtual stream ID: " << hexn<4> << kv.first;
       break;
     case RESULT:
-      resultChans_.push_back(kv.first);
+      // kernel bank records hold many results so they are not correlated
+      if (!kv.second.is_kernel_bank()) {
+        resultChans_.push_back(kv.first);
+      }
       LOG(plog::debug) << "ADC result stream ID: " << hexn<4> << kv.first;
       break;
     case STATE:
-      stateChans_.push_back(kv.first);
       LOG(plog::debug) << "Thresholded state stream ID: " << hexn<4> << kv.first;
       break;
     case CORRELATED:
-      correlatedChans_.push_back(kv.first);
       LOG(plog::debug) << "Correlation stream ID: " << hexn<4> << kv.first;
       break;
     }
   }
+  for (auto & input : crossCorrelatorInputs_) {
+    if (!activeQDSPStreams_.count(input.streamID)) {
+      LOG(plog::error) << "Cross-board correlator input " << hexn<4> << input.streamID << " is not enabled";
+      throw X6_INVALID_CHANNEL;
+    }
+  }
+  // fault the fixed-size stream buffers in on the processing thread's NUMA
+  // node; record queue capacity is only reserved and left untouched
+  MemoryPolicy::set_first_touch_cpus(threadTuner_.get_settings(THREAD_PROCESS).requestedCPUs);
+  initialize_host_dsp();
+  initialize_kernel_banks();
+  initialize_discriminators();
+  initialize_spectra();
   initialize_accumulators();
   initialize_queues();
   initialize_correlators();
-
-  VMPs_[0].Init(physChans_);
-  VMPs_[0].OnDataAvailable.SetEvent(this, &X6_1000::HandlePhysicalStream);
-
-  VMPs_[1].Init(virtChans_);
-  VMPs_[1].OnDataAvailable.SetEvent(this, &X6_1000::HandleVirtualStream);
-
-  VMPs_[2].Init(resultChans_);
-  VMPs_[2].OnDataAvailable.SetEvent(this, &X6_1000::HandleResultStream);
-
-  VMPs_[3].Init(stateChans_);
-  VMPs_[3].OnDataAvailable.SetEvent(this, &X6_1000::HandleStateStream);
-
-  VMPs_[4].Init(correlatedChans_);
-  VMPs_[4].OnDataAvailable.SetEvent(this, &X6_1000::HandleCorrelatedStream);
-
-  //Now set the buffers sizes to fire when a full record length is in
-  int samplesPerWord = module_.Input().Info().SamplesPerWord();
-  LOG(plog::debug) << "samplesPerWord = " << samplesPerWord;
-  // calculate packet size for physical and virtual channels
-  int packetSize = recordLength_/samplesPerWord/get_decimation()/RAW_DECIMATION_FACTOR;
-  LOG(plog::debug) << "Physical channel packetSize = " << packetSize;
-  VMPs_[0].Resize(packetSize);
-  VMPs_[0].Clear();
-
-  //Vitual channels are complex so they get a factor of two.
-  packetSize = 2*recordLength_/samplesPerWord/get_decimation()/DEMOD_DECIMATION_FACTOR;
-  LOG(plog::debug) << "Virtual channel packetSize = " << packetSize;
-  VMPs_[1].Resize(packetSize);
-  VMPs_[1].Clear();
-
-  //Result channels are complex 32bit integers
-  packetSize = 2;
-  LOG(plog::debug) << "Result channel packetSize = " << packetSize;
-  VMPs_[2].Resize(packetSize);
-  VMPs_[2].Clear();
-
-  // State channels are technically just binary but they send in the same manner as result streams
-  packetSize = 2;
-  LOG(plog::debug) << "State channel packetSize = " << packetSize;
-  VMPs_[3].Resize(packetSize);
-  VMPs_[3].Clear();
-
-  // Correlated channels have the same width as result streams
-  //Result channels are complex 32bit integers
-  packetSize = 2;
-  LOG(plog::debug) << "Correlated channel packetSize = " << packetSize;
-  VMPs_[4].Resize(packetSize);
-  VMPs_[4].Clear();
-
-  recordsTaken_ = 0;
-
-  module_.Velo().LoadAll_VeloDataSize(0x4000);
-  module_.Velo().ForceVeloPacketSize(false);
-
-  // is this necessary??
-  stream_.PrefillPacketCount(prefillPacketCount_);
-
-  trigger_.AtStreamStart();
-
-  LOG(plog::debug) << "AFE reg. 0x5 (adc/dac run): " << hexn<8> << read_wishbone_register(0x0800, 0x5);
-  LOG(plog::debug) << "AFE reg. 0x8 (adc en): " << hexn<8> << read_wishbone_register(0x0800, 0x8);
-  LOG(plog::debug) << "AFE reg. 0x9 (adc trigger): " << hexn<8> << read_wishbone_register(0x0800, 0x9);
-  LOG(plog::debug) << "AFE reg. 0x80 (dac en): " << hexn<8> << read_wishbone_register(0x0800, 0x80);
-  LOG(plog::debug) << "AFE reg. 0x81 (dac trigger): " << hexn<8> << read_wishbone_register(0x0800, 0x81);
-
-  // Enable the pulse generators
-  for (size_t pg = 0; pg < 2; pg++) {
-    std::bitset<32> reg(read_wishbone_register(BASE_PG[pg], WB_PG_CONTROL));
-    reg.set(0);
-    write_wishbone_register(BASE_PG[pg], WB_PG_CONTROL, reg.to_ulong());
+  initialize_demux();
+  initialize_standby_bank();
+  MemoryPolicy::set_first_touch_cpus(0);
+  MemoryStats memStats = MemoryPolicy::get_stats();
+  LOG(plog::info) << "Stream buffers use " << (memStats.bytesInUse >> 20) << " MB, "
+                  << (memStats.hugePageBytes >> 20) << " MB of it on huge pages";
+}
+
+void X6_1000::reset_stream_state() {
+  /*
+   * Clears the stream state of the last acquisition where it lies for another
+   * one with the same setup. The buffers keep their memory, and the demux
+   * slots, stream contexts and host DSP plans are reused as they are.
+   */
+  clear_bank();
+  if (doubleBuffering_) {
+    // both banks start over with the first one in front
+    swap_banks();
+    clear_bank();
+    if (bankQueue_.front_bank() == 0) {
+      swap_banks();
+    }
   }
-
-  // flag must be set before calling stream start
-  isRunning_ = true;
-
-  //	Start Streaming
-  LOG(plog::info) << "Arming acquisition";
-  stream_.Start();
-
-  LOG(plog::debug) << "AFE reg. 0x5 (adc/dac run): " << hexn<8> << read_wishbone_register(0x0800, 0x5);
-  LOG(plog::debug) << "AFE reg. 0x8 (adc en): " << hexn<8> << read_wishbone_register(0x0800, 0x8);
-  LOG(plog::debug) << "AFE reg. 0x9 (adc trigger): " << hexn<8> << read_wishbone_register(0x0800, 0x9);
-  LOG(plog::debug) << "AFE reg. 0x80 (dac en): " << hexn<8> << read_wishbone_register(0x0800, 0x80);
-  LOG(plog::debug) << "AFE reg. 0x81 (dac trigger): " << hexn<8> << read_wishbone_register(0x0800, 0x81);
+  initialize_discriminators();
+  for (auto & ctx : streamContexts_) {
+    if (ctx.banksFilled % 2) {
+      ctx.switch_bank();
+    }
+    ctx.banksFilled = 0;
+    ctx.bankStalled = false;
+    ctx.recordsReceived = 0;
+  }
+  consumers_.reset();
+  hostDSP_.start();
 }
 
 void X6_1000::wait_for_acquisition(unsigned timeOut){
@@ -857,18 +1091,86 @@ void X6_1000::wait_for_acquisition(unsigned timeOut){
 
   auto start = std::chrono::system_clock::now();
   auto end = start + std::chrono::seconds(timeOut);
-  while (get_is_running()) {
-    if (std::chrono::system_clock::now() > end)
+  if (doubleBuffering_) {
+    // until a bank is full, or the acquisition stopped
+    if (!bankQueue_.wait_until(end)) {
       throw X6_TIMEOUT;
-    std::this_thread::sleep_for( std::chrono::milliseconds(100) );
+    }
+  } else if (!notifier_.wait_until(end)) {
+    throw X6_TIMEOUT;
+  }
+  if (!isRunning_) {
+    // the acquisition stopped itself; join its threads so that a consumer
+    // thread has finished too
+    stop();
+  }
+  if (packetLoss_) {
+    throw X6_PACKET_LOSS;
   }
 }
 
 void X6_1000::stop() {
-  isRunning_ = false;
-  stream_.Stop();
-  timer_.Enabled(false);
-  trigger_.AtStreamStop();
+  /*
+   * Whichever of the client and the process thread gets here first stops the
+   * acquisition. Every pipeline stage is told to stop before the Malibu
+   * stream, so the driver's event thread cannot stay blocked on a full parse
+   * queue while the stream waits for it. Worker threads are only joined from
+   * outside the pipeline; when the process thread stopped the acquisition
+   * they are joined by the next stop(), wait_for_acquisition() or acquire().
+   */
+  bool onWorker = pipeline_.is_worker_thread();
+  std::unique_lock<std::mutex> lock(stopMutex_, std::defer_lock);
+  if (!onWorker) {
+    lock.lock();
+  }
+  bool wasRunning = isRunning_.exchange(false);
+  if (wasRunning) {
+    pipeline_.request_stop();
+    hostDSP_.request_stop();
+    stream_.Stop();
+    timer_.Enabled(false);
+    trigger_.AtStreamStop();
+  }
+  if (!onWorker) {
+    pipeline_.stop();
+    hostDSP_.stop();
+  }
+  if (wasRunning) {
+    bankQueue_.close();
+    notifier_.finish();
+  }
+}
+
+void X6_1000::set_double_buffering(bool enable) {
+  if (isRunning_) {
+    LOG(plog::error) << "Cannot change double buffering during an acquisition";
+    throw X6_MODE_ERROR;
+  }
+  doubleBuffering_ = enable;
+  rearmSession_.invalidate();
+}
+
+bool X6_1000::get_double_buffering() const {
+  return doubleBuffering_;
+}
+
+size_t X6_1000::get_num_ready_banks() {
+  return doubleBuffering_ ? bankQueue_.num_ready() : 0;
+}
+
+void X6_1000::release_bank() {
+  /*
+   * Hands the bank the client has read back to the acquisition. It is
+   * cleared before the streams may fill it again, and transfers move on to
+   * the other bank.
+   */
+  if (!doubleBuffering_ || bankQueue_.num_ready() == 0) {
+    LOG(plog::error) << "No full bank to release";
+    throw X6_MODE_ERROR;
+  }
+  clear_bank();
+  swap_banks();
+  bankQueue_.release();
 }
 
 bool X6_1000::get_is_running() {
@@ -878,11 +1180,14 @@ bool X6_1000::get_is_running() {
 size_t X6_1000::get_num_new_records() {
   // determines if new data has arrived since the last call
   size_t result = 0;
-  if ( digitizerMode_ == AVERAGER) {
+  if ( digitizerMode_ != DIGITIZER) {
     size_t currentRecords = 0;
     for (auto & kv : accumulators_) {
       currentRecords = max(currentRecords, kv.second.recordsTaken);
     }
+    for (auto & kv : spectra_) {
+      currentRecords = max(currentRecords, kv.second.recordsTaken);
+    }
     result = currentRecords > recordsTaken_;
     recordsTaken_ = currentRecords;
   }
@@ -899,8 +1204,8 @@ size_t X6_1000::get_num_new_records() {
 }
 
 bool X6_1000::get_data_available() {
-  if (digitizerMode_ == AVERAGER) {
-    // in averager mode, it is always valid to ask for data
+  if (digitizerMode_ != DIGITIZER) {
+    // in averager or spectrum mode, it is always valid to ask for data
     return true;
   } else {
     // in digitizer mode, we ask if *any* queue has data available
@@ -913,13 +1218,63 @@ bool X6_1000::get_data_available() {
   }
 }
 
+int X6_1000::get_data_fd() {
+  return notifier_.get_fd();
+}
+
+void X6_1000::set_notification_threshold(unsigned numRecords) {
+  notifier_.set_threshold(numRecords);
+}
+
+void X6_1000::register_data_callback(X6_DATA_CALLBACK callback, void * userData) {
+  notifier_.set_callback(deviceID_, callback, userData);
+}
+
 void X6_1000::register_socket(QDSPStream stream, int32_t socket) {
   uint16_t sid = stream.streamID;
   sockets_[sid] = socket;
+  rearmSession_.invalidate();
 }
 
 void X6_1000::unregister_sockets() {
   sockets_.clear();
+  rearmSession_.invalidate();
+}
+
+void X6_1000::set_socket_metadata(bool enable) {
+  socketMetadata_ = enable;
+  rearmSession_.invalidate();
+}
+
+void X6_1000::register_record_consumer(QDSPStream stream, X6_RECORD_CONSUMER consumer, void * context) {
+  // takes effect at the next acquire(); a null consumer removes the stream's
+  if (isRunning_) {
+    LOG(plog::error) << "Cannot register record consumers while running.";
+    throw X6_MODE_ERROR;
+  }
+  consumers_.set(stream.streamID, consumer, context);
+  rearmSession_.invalidate();
+}
+
+void X6_1000::unregister_record_consumers() {
+  if (isRunning_) {
+    LOG(plog::error) << "Cannot unregister record consumers while running.";
+    throw X6_MODE_ERROR;
+  }
+  consumers_.clear();
+  rearmSession_.invalidate();
+}
+
+void X6_1000::set_record_consumer_dispatch(X6_CONSUMER_DISPATCH dispatch) {
+  if (isRunning_) {
+    LOG(plog::error) << "Cannot change record consumer dispatch while running.";
+    throw X6_MODE_ERROR;
+  }
+  if (dispatch != CONSUMER_INLINE && dispatch != CONSUMER_THREAD) {
+    throw X6_INVALID_ARGUMENT;
+  }
+  consumerDispatch_ = dispatch;
+  rearmSession_.invalidate();
 }
 
 void X6_1000::transfer_stream(QDSPStream stream, double * buffer, size_t length) {
@@ -929,7 +1284,15 @@ void X6_1000::transfer_stream(QDSPStream stream, double * buffer, size_t length)
     LOG(plog::error) << "Tried to transfer waveform from disabled stream.";
     throw X6_INVALID_CHANNEL;
   }
-  if (digitizerMode_ == AVERAGER) {
+  auto spectrum = spectra_.find(sid);
+  if (spectrum != spectra_.end()) {
+    if (length < spectrum->second.get_buffer_size()) {
+      LOG(plog::error) << "Not enough memory allocated in buffer to transfer spectrum.";
+      throw X6_INVALID_ARGUMENT;
+    }
+    spectrum->second.snapshot(buffer);
+  }
+  else if (digitizerMode_ != DIGITIZER) {
     //Don't copy more than we have
     if (length < accumulators_[sid].get_buffer_size() ) {
       LOG(plog::error) << "Not enough memory allocated in buffer to transfer waveform.";
@@ -943,6 +1306,79 @@ void X6_1000::transfer_stream(QDSPStream stream, double * buffer, size_t length)
   }
 }
 
+void X6_1000::transfer_stream_metadata(QDSPStream stream, RecordMetadata * buffer, size_t numRecords) {
+  if (digitizerMode_ != DIGITIZER) {
+    throw X6_MODE_ERROR;
+  }
+  //Check we have the stream
+  uint16_t sid = stream.streamID;
+  if (activeQDSPStreams_.find(sid) == activeQDSPStreams_.end()) {
+    LOG(plog::error) << "Tried to transfer metadata from disabled stream.";
+    throw X6_INVALID_CHANNEL;
+  }
+  mutexes_[sid].lock();
+  size_t numCopied = queues_[sid].get_metadata(buffer, numRecords);
+  mutexes_[sid].unlock();
+  if (numCopied < numRecords) {
+    LOG(plog::error) << "Tried to pull metadata for " << numRecords << " records but only " << numCopied << " available.";
+  }
+}
+
+unsigned X6_1000::get_metadata_buffer_size(QDSPStream & stream) {
+  if (digitizerMode_ != DIGITIZER) {
+    throw X6_MODE_ERROR;
+  }
+  uint16_t sid = stream.streamID;
+  std::lock_guard<std::mutex> lock(mutexes_[sid]);
+  return queues_[sid].get_metadata_size();
+}
+
+SequenceStats X6_1000::get_sequence_stats(QDSPStream & stream) {
+  if (activeQDSPStreams_.find(stream.streamID) == activeQDSPStreams_.end()) {
+    LOG(plog::error) << "Tried to get sequence statistics for disabled stream.";
+    throw X6_INVALID_CHANNEL;
+  }
+  return sequenceTracker_.get_stats(stream.streamID);
+}
+
+void X6_1000::set_abort_on_packet_loss(bool abort) {
+  abortOnPacketLoss_ = abort;
+}
+
+void X6_1000::set_pipeline_depth(unsigned depth) {
+  if (isRunning_) {
+    LOG(plog::error) << "Cannot resize the acquisition pipeline while running.";
+    throw X6_MODE_ERROR;
+  }
+  if (depth == 0) {
+    throw X6_INVALID_ARGUMENT;
+  }
+  pipeline_.set_depth(depth);
+}
+
+PipelineStats X6_1000::get_pipeline_stats(X6_PIPELINE_STAGE stage) {
+  return pipeline_.get_stats(stage);
+}
+
+BufferPoolStats X6_1000::get_buffer_pool_stats() {
+  return pipeline_.get_buffer_pool_stats();
+}
+
+void X6_1000::set_thread_affinity(X6_THREAD_ROLE role, uint64_t cpuMask) {
+  // takes effect at the next acquire()
+  threadTuner_.set_affinity(role, cpuMask);
+  // the stream buffers are placed for the process thread's cores
+  rearmSession_.invalidate();
+}
+
+void X6_1000::set_thread_priority(X6_THREAD_ROLE role, int priority) {
+  threadTuner_.set_priority(role, priority);
+}
+
+ThreadSettings X6_1000::get_thread_settings(X6_THREAD_ROLE role) {
+  return threadTuner_.get_settings(role);
+}
+
 void X6_1000::transfer_variance(QDSPStream stream, double * buffer, size_t length) {
   if (digitizerMode_ == DIGITIZER) {
     throw X6_MODE_ERROR;
@@ -953,6 +1389,10 @@ void X6_1000::transfer_variance(QDSPStream stream, double * buffer, size_t lengt
     LOG(plog::error) << "Tried to transfer waveform variance from disabled stream.";
     throw X6_INVALID_CHANNEL;
   }
+  if (spectra_.count(sid)) {
+    LOG(plog::error) << "Spectrum streams have no variance.";
+    throw X6_MODE_ERROR;
+  }
   //Don't copy more than we have
   if (length < accumulators_[sid].get_buffer_size() ) {
     LOG(plog::error) << "Not enough memory allocated in buffer to transfer variance.";
@@ -1003,7 +1443,10 @@ int X6_1000::get_buffer_size(vector<QDSPStream> & streams) {
   for (size_t i = 0; i < streams.size(); i++)
     sids[i] = streams[i].streamID;
   if (streams.size() == 1) {
-    if ( digitizerMode_ == AVERAGER) {
+    if (spectra_.count(sids[0])) {
+      return spectra_[sids[0]].get_buffer_size();
+    }
+    if ( digitizerMode_ != DIGITIZER) {
       return accumulators_[sids[0]].get_buffer_size();
     }
     else {
@@ -1018,6 +1461,11 @@ int X6_1000::get_buffer_size(vector<QDSPStream> & streams) {
 }
 
 unsigned X6_1000::get_record_length(QDSPStream & stream) {
+  // host demod lengths depend on the decimation resolved at acquire()
+  auto it = activeQDSPStreams_.find(stream.streamID);
+  if (it != activeQDSPStreams_.end()) {
+    return it->second.calc_record_length(recordLength_);
+  }
   return stream.calc_record_length(recordLength_);
 }
 
@@ -1029,6 +1477,9 @@ int X6_1000::get_variance_buffer_size(vector<QDSPStream> & streams) {
   for (size_t i = 0; i < streams.size(); i++)
     sids[i] = streams[i].streamID;
   if (streams.size() == 1) {
+    if (spectra_.count(sids[0])) {
+      throw X6_MODE_ERROR;
+    }
     return accumulators_[sids[0]].get_variance_buffer_size();
   } else {
     return correlators_[sids].get_variance_buffer_size();
@@ -1038,10 +1489,27 @@ int X6_1000::get_variance_buffer_size(vector<QDSPStream> & streams) {
 void X6_1000::initialize_accumulators() {
   accumulators_.clear();
   for (auto kv : activeQDSPStreams_) {
+    // spectrum streams are not averaged in the time domain
+    if (spectra_.count(kv.first)) {
+      continue;
+    }
     accumulators_[kv.first] = Accumulator(kv.second, recordLength_, numSegments_, waveforms_);
   }
 }
 
+void X6_1000::initialize_spectra() {
+  spectra_.clear();
+  if (digitizerMode_ != SPECTRUM) {
+    return;
+  }
+  // raw and demod streams are transformed, everything else is averaged
+  for (auto kv : activeQDSPStreams_) {
+    if (kv.second.type == PHYSICAL || kv.second.type == DEMOD) {
+      spectra_[kv.first] = SpectrumAccumulator(kv.second, recordLength_, numSegments_, waveforms_, spectrumWindow_);
+    }
+  }
+}
+
 void X6_1000::initialize_queues() {
   queues_.clear();
   mutexes_.clear();
@@ -1057,6 +1525,9 @@ void X6_1000::initialize_queues() {
     // add the socket to the RecordQueue if we have one
     if (sockets_.find(kv.first) != sockets_.end()) {
       queues_[kv.first].socket_ = sockets_[kv.first];
+      queues_[kv.first].sendMetadata_ = socketMetadata_;
+    } else if (digitizerMode_ == DIGITIZER) {
+      queues_[kv.first].reserve_storage();
     }
   }
 }
@@ -1081,6 +1552,283 @@ void X6_1000::initialize_correlators() {
   }
 }
 
+void X6_1000::initialize_host_dsp() {
+  /*
+   * Resolves the host DSP streams against the raw streams they are computed
+   * from and builds the down-conversion plans for this acquisition.
+   */
+  vector<QDSPStream> hostStreams;
+  for (auto & kv : activeQDSPStreams_) {
+    QDSPStream & stream = kv.second;
+    if (!stream.is_host() || stream.is_kernel_bank()) {
+      continue;
+    }
+    unsigned a = stream.channelID[0];
+    if (!activeQDSPStreams_.count(QDSPStream(a, 0, 0).streamID)) {
+      LOG(plog::error) << "Host DSP stream " << a << "." << stream.channelID[1] << "." << stream.channelID[2]
+                       << " requires raw stream " << a << ".0.0 to be enabled";
+      throw X6_INVALID_CHANNEL;
+    }
+    if (stream.type == DEMOD) {
+      stream.hostDecimation = hostDSP_.get_decimation(a, stream.channelID[1]);
+    }
+    hostStreams.push_back(stream);
+  }
+  hostDSP_.set_thread_init([this]() { threadTuner_.apply(THREAD_PROCESS); });
+  // the raw stream runs at a quarter of the ADC rate
+  hostDSP_.prepare(get_pll_frequency() / RAW_DECIMATION_FACTOR,
+                   QDSPStream(0, 0, 0).calc_record_length(recordLength_), hostStreams);
+}
+
+void X6_1000::initialize_kernel_banks() {
+  // kernel bank records hold one complex result per kernel of the bank
+  for (auto & kv : activeQDSPStreams_) {
+    QDSPStream & stream = kv.second;
+    if (!stream.is_kernel_bank()) {
+      continue;
+    }
+    unsigned a = stream.channelID[0];
+    unsigned b = stream.channelID[1];
+    uint16_t demodID = QDSPStream(a, b, 0).streamID;
+    auto bank = kernelBanks_.find(demodID);
+    auto demod = activeQDSPStreams_.find(demodID);
+    if (bank == kernelBanks_.end() || demod == activeQDSPStreams_.end()) {
+      LOG(plog::error) << "Kernel bank stream " << a << "." << b << "." << KERNEL_BANK_STREAM
+                       << " requires a kernel bank and demod stream " << a << "." << b << ".0";
+      throw X6_INVALID_CHANNEL;
+    }
+    stream.bankSize = bank->second.size();
+    bank->second.prepare(demod->second.calc_record_length(recordLength_) / 2,
+                         demod->second.fixed_to_float(), stream.fixed_to_float());
+  }
+}
+
+void X6_1000::initialize_discriminators() {
+  for (auto & kv : activeQDSPStreams_) {
+    const QDSPStream & stream = kv.second;
+    if (!stream.is_discriminator()) {
+      continue;
+    }
+    auto it = discriminators_.find(stream.streamID);
+    if (it == discriminators_.end()) {
+      LOG(plog::error) << "No discriminator set for state stream " << stream.channelID[0] << "."
+                       << stream.channelID[1] << "." << stream.channelID[2];
+      throw X6_INVALID_CHANNEL;
+    }
+    for (auto & input : it->second.get_inputs()) {
+      if (!activeQDSPStreams_.count(input.streamID)) {
+        LOG(plog::error) << "Discriminator " << stream.channelID[1] << " input " << input.channelID[0] << "."
+                         << input.channelID[1] << "." << input.channelID[2] << " is not enabled";
+        throw X6_INVALID_CHANNEL;
+      }
+    }
+    it->second.reset(numSegments_, waveforms_, numRecords_);
+  }
+}
+
+void X6_1000::add_stream_context(const QDSPStream & stream) {
+  // resolve everything the data path needs for this stream up front
+  streamContexts_.emplace_back();
+  StreamContext & ctx = streamContexts_.back();
+  ctx.stream = stream;
+  bind_bank(ctx);
+  for (auto & input : crossCorrelatorInputs_) {
+    if (input.streamID == stream.streamID) {
+      ctx.crossCorrelators.emplace_back(input.correlator, input.index);
+    }
+  }
+}
+
+void X6_1000::bind_bank(StreamContext & ctx) {
+  // points the context at its stream's accumulator, queue, correlators and
+  // discriminators
+  uint16_t sid = ctx.stream.streamID;
+  auto spectrum = spectra_.find(sid);
+  if (spectrum != spectra_.end()) {
+    ctx.spectrum = &spectrum->second;
+    ctx.accumulator = nullptr;
+  } else {
+    ctx.spectrum = nullptr;
+    ctx.accumulator = &accumulators_.at(sid);
+  }
+  ctx.queue = &queues_.at(sid);
+  ctx.mutex = &mutexes_.at(sid);
+  ctx.correlators.clear();
+  for (auto & corr : correlators_) {
+    int index = corr.second.get_buffer_index(sid);
+    if (index >= 0) {
+      ctx.correlators.emplace_back(&corr.second, index);
+    }
+  }
+  for (auto & input : ctx.discriminators) {
+    input.discriminator = &discriminators_.at(streamContexts_[input.output].stream.streamID);
+  }
+}
+
+void X6_1000::initialize_standby_bank() {
+  /*
+   * Builds the second bank of a double-buffered acquisition like the first
+   * and gives every stream context its place in it.
+   */
+  if (!doubleBuffering_) {
+    standbyBank_ = StreamBank();
+    for (auto & ctx : streamContexts_) {
+      ctx.standby = StreamContext::Bank();
+      ctx.banksFilled = 0;
+      ctx.bankStalled = false;
+    }
+    return;
+  }
+  swap_banks();
+  initialize_spectra();
+  initialize_accumulators();
+  initialize_queues();
+  initialize_correlators();
+  // same discriminators, counting apart
+  discriminators_ = standbyBank_.discriminators;
+  for (auto & ctx : streamContexts_) {
+    ctx.standby.discriminators = ctx.discriminators;
+    ctx.switch_bank();
+    bind_bank(ctx);
+    ctx.switch_bank();
+    ctx.banksFilled = 0;
+    ctx.bankStalled = false;
+  }
+  swap_banks();
+}
+
+void X6_1000::swap_banks() {
+  // the nodes, and so the stream contexts' pointers into them, stay put
+  accumulators_.swap(standbyBank_.accumulators);
+  spectra_.swap(standbyBank_.spectra);
+  correlators_.swap(standbyBank_.correlators);
+  queues_.swap(standbyBank_.queues);
+  mutexes_.swap(standbyBank_.mutexes);
+  discriminators_.swap(standbyBank_.discriminators);
+}
+
+void X6_1000::clear_bank() {
+  // resets the front bank in place
+  for (auto & kv : accumulators_) {
+    kv.second.reset();
+  }
+  for (auto & kv : spectra_) {
+    kv.second.reset();
+  }
+  for (auto & kv : queues_) {
+    std::lock_guard<std::mutex> lock(mutexes_[kv.first]);
+    kv.second.reset();
+  }
+  for (auto & kv : correlators_) {
+    kv.second.reset();
+  }
+  for (auto & kv : discriminators_) {
+    kv.second.reset(numSegments_, waveforms_, numRecords_);
+  }
+}
+
+void X6_1000::initialize_demux() {
+  demux_.clear();
+  streamContexts_.clear();
+  streamContexts_.reserve(activeQDSPStreams_.size());
+
+  int samplesPerWord = module_.Input().Info().SamplesPerWord();
+  LOG(plog::debug) << "samplesPerWord = " << samplesPerWord;
+
+  for (auto kv : activeQDSPStreams_) {
+    // streams computed on the host never arrive in packets
+    if (kv.second.computed_on_host()) {
+      continue;
+    }
+    // record sizes in 32-bit payload words
+    size_t recordWords;
+    switch (kv.second.type) {
+      case PHYSICAL:
+        recordWords = recordLength_/samplesPerWord/get_decimation()/RAW_DECIMATION_FACTOR;
+        break;
+      case DEMOD:
+        //Vitual channels are complex so they get a factor of two.
+        recordWords = 2*recordLength_/samplesPerWord/get_decimation()/DEMOD_DECIMATION_FACTOR;
+        break;
+      default:
+        // result, state and correlated channels are complex 32bit integers
+        recordWords = 2;
+        break;
+    }
+    LOG(plog::debug) << "Stream ID " << hexn<4> << kv.first << " record size = " << std::dec << recordWords << " words";
+    demux_.add_stream(kv.first, recordWords);
+    add_stream_context(kv.second);
+  }
+
+  // host DSP streams follow the demux slots and are fed by their raw stream
+  size_t numSlots = streamContexts_.size();
+  for (size_t slot = 0; slot < numSlots; slot++) {
+    if (streamContexts_[slot].stream.type != PHYSICAL) {
+      continue;
+    }
+    for (uint16_t sid : hostDSP_.get_output_streams(streamContexts_[slot].stream.channelID[0])) {
+      streamContexts_[slot].hostOutputs.push_back(streamContexts_.size());
+      add_stream_context(activeQDSPStreams_.at(sid));
+    }
+  }
+
+  // kernel bank streams are fed by their demod stream
+  size_t numContexts = streamContexts_.size();
+  for (size_t idx = 0; idx < numContexts; idx++) {
+    const QDSPStream & demod = streamContexts_[idx].stream;
+    if (demod.type != DEMOD) {
+      continue;
+    }
+    auto bankStream = activeQDSPStreams_.find(QDSPStream(demod.channelID[0], demod.channelID[1], KERNEL_BANK_STREAM).streamID);
+    if (bankStream == activeQDSPStreams_.end()) {
+      continue;
+    }
+    streamContexts_[idx].kernelBank = &kernelBanks_.at(demod.streamID);
+    streamContexts_[idx].kernelBankOutput = streamContexts_.size();
+    add_stream_context(bankStream->second);
+  }
+
+  // discriminator state streams are fed by their result streams
+  for (auto & kv : activeQDSPStreams_) {
+    if (!kv.second.is_discriminator()) {
+      continue;
+    }
+    Discriminator & disc = discriminators_.at(kv.first);
+    size_t output = streamContexts_.size();
+    add_stream_context(kv.second);
+    for (size_t idx = 0; idx < output; idx++) {
+      int index = disc.get_buffer_index(streamContexts_[idx].stream.streamID);
+      if (index >= 0) {
+        streamContexts_[idx].discriminators.push_back({&disc, index, output});
+      }
+    }
+  }
+
+  // packets are tracked on the parse thread, records handled on the process thread
+  demux_.set_packet_handler([this](const VitaHeader & vh) { HandlePacket(vh); });
+  pipeline_.set_record_handler([this](unsigned slot, const uint32_t * data, size_t recordWords, const VitaHeader & vh) {
+    HandleRecord(slot, data, recordWords, vh);
+  });
+  pipeline_.set_batch_handler([this]() { HandleBatchProcessed(); });
+
+  // record consumers see the records where they sit in the received buffers
+  if (consumers_.empty()) {
+    pipeline_.set_consumer(nullptr, nullptr, false);
+  } else {
+    vector<QDSPStream> slotStreams;
+    for (size_t slot = 0; slot < numSlots; slot++) {
+      slotStreams.push_back(streamContexts_[slot].stream);
+    }
+    consumers_.bind(deviceID_, slotStreams, numRecords_, waveforms_, numSegments_);
+    pipeline_.set_consumer(
+      [this](unsigned slot, const uint32_t * data, size_t recordWords, const VitaHeader & vh) {
+        consumers_.add_record(slot, data, recordWords, vh);
+      },
+      [this]() { consumers_.dispatch(); },
+      consumerDispatch_ == CONSUMER_THREAD);
+  }
+}
+
 /****************************************************************************
  * Event Handlers
  ****************************************************************************/
@@ -1119,38 +1867,39 @@ void X6_1000::HandleAfterStreamStop(OpenWire::NotifyEvent & /*Event*/) {
   // Disable external triggering initially
   module_.Input().SoftwareTrigger(false);
   module_.Input().Trigger().External(false);
-  VMPs_[0].Flush();
-  VMPs_[1].Flush();
-  VMPs_[2].Flush();
-  VMPs_[3].Flush();
-  VMPs_[4].Flush();
+  if (demux_.malformedPackets > 0) {
+    LOG(plog::warning) << "Skipped " << demux_.malformedPackets << " malformed VITA packets";
+  }
 }
 
 void X6_1000::HandleDataAvailable(Innovative::VitaPacketStreamDataEvent & Event) {
   if (!isRunning_) return;
 
-  // create a buffer to receive the data
-  VeloBuffer buffer;
-  Event.Sender->Recv(buffer);
-
-  AlignedVeloPacketExQ::Range InVelo(buffer);
-  size_t ct = 0;
-  unsigned int * pos = InVelo.begin();
-  LOG(plog::verbose) << "[HandleDataAvailable] Velo packet of size " << buffer.SizeInInts() << " contains...";
-  while (ct < buffer.SizeInInts()){
-    VitaHeaderDatagram vh_dg(pos+ct);
-    double timeStamp = vh_dg.TS_Seconds() + 5e-9*vh_dg.TS_FSeconds();
-    LOG(plog::verbose) << "\t stream ID = " << hexn<4> << vh_dg.StreamId() <<
-      " with size " << vh_dg.PacketSize() <<
-      "; packet count = " << std::dec << vh_dg.PacketCount() <<
-      " at timestamp " << timeStamp;
-    ct += vh_dg.PacketSize();
+  // the driver owns this thread so it is tuned on its first buffer
+  if (!receiveThreadTuned_) {
+    threadTuner_.apply(THREAD_RECEIVE);
+    receiveThreadTuned_ = true;
   }
 
-  // broadcast to all VMPs
-  for (auto & vmp : VMPs_) {
-    vmp.Append(buffer);
-    vmp.Parse();
+  // receive stage: take the buffer and hand it to the parse thread so the
+  // driver's event thread is back waiting on DMA as quickly as possible
+  std::shared_ptr<VeloBuffer> buffer = pipeline_.acquire_buffer();
+  Event.Sender->Recv(*buffer);
+
+  AlignedVeloPacketExQ::Range InVelo(*buffer);
+  X6_LOG(plog::verbose) << "[HandleDataAvailable] Velo packet of size " << buffer->SizeInInts();
+  pipeline_.receive(buffer, InVelo.begin(), buffer->SizeInInts());
+}
+
+void X6_1000::HandleBatchProcessed() {
+  // runs on the process thread once every record of a buffer is handled
+  if (!isRunning_) {
+    return;
+  }
+  if (packetLoss_) {
+    LOG(plog::error) << "Aborting acquisition after packet loss. Stopping...";
+    stop();
+    return;
   }
 
   if (check_done()) {
@@ -1159,124 +1908,148 @@ void X6_1000::HandleDataAvailable(Innovative::VitaPacketStreamDataEvent & Event)
   }
 }
 
-void X6_1000::VMPDataAvailable(Innovative::VeloMergeParserDataAvailable & Event, STREAM_T streamType) {
-  if (!isRunning_) {
-    return;
+void X6_1000::HandlePacket(const VitaHeader & vh) {
+  X6_IF_LOG(plog::verbose) {
+    double timeStamp = vh.timestampSeconds + 5e-9*vh.timestampFractional;
+    LOG(plog::verbose) << "\t stream ID = " << hexn<4> << vh.streamID <<
+      " with size " << std::dec << vh.packetSize <<
+      "; packet count = " << static_cast<unsigned>(vh.packetCount) <<
+      " at timestamp " << timeStamp;
   }
-  // StreamID is now encoded in the PeripheralID of the VMP Vita buffer
-  // PeripheralID is just the order of the streamID in the filter
-  PacketBufferHeader header(Event.Data);
-  uint16_t sid;
-
-  LOG(plog::verbose) << "[VMPDataAvailable] called for stream with header peripheralID " << std::dec << header.PeripheralId();
-
-  switch (streamType) {
-    case PHYSICAL:
-      sid = physChans_[header.PeripheralId()];
-      break;
-    case DEMOD:
-      sid = virtChans_[header.PeripheralId()];
-      break;
-    case RESULT:
-      sid = resultChans_[header.PeripheralId()];
-      break;
-    case STATE:
-      sid = stateChans_[header.PeripheralId()];
-      break;
-    case CORRELATED:
-      sid = correlatedChans_[header.PeripheralId()];
-      break;
+  if (sequenceTracker_.track(vh.streamID, vh.packetCount) == SEQUENCE_GAP) {
+    LOG(plog::warning) << "Packet loss detected on stream ID " << hexn<4> << vh.streamID <<
+      "; packet count jumped to " << std::dec << static_cast<unsigned>(vh.packetCount);
+    packetLoss_ = abortOnPacketLoss_;
   }
+}
 
-  LOG(plog::verbose) << "[VMPDataAvailable] SID for stream with header peripheralID " << std::dec << header.PeripheralId() << " determined to be " << hexn<4> << sid;
+void X6_1000::HandleRecord(unsigned slot, const uint32_t * data, size_t recordWords, const VitaHeader & vh) {
+  if (!isRunning_ || packetLoss_) {
+    return;
+  }
+  StreamContext & ctx = streamContexts_[slot];
 
   // interpret the data as 16 or 32-bit integers depending on the channel type
-  ShortDG sbufferDG(Event.Data);
-  IntegerDG ibufferDG(Event.Data);
-
-  switch (streamType) {
-    case PHYSICAL:
-    case DEMOD:
-      LOG(plog::verbose) << "[VMPDataAvailable] buffer SID = " << hexn<4> << sid << "; buffer.size = " << std::dec << sbufferDG.size() << " samples";
-      if ( digitizerMode_ == AVERAGER) {
-        // accumulate the data in the appropriate channel
-        if (accumulators_[sid].recordsTaken < numRecords_) {
-          accumulators_[sid].accumulate(sbufferDG);
-        }
-      }
-      else {
-        mutexes_[sid].lock();
-        if (queues_[sid].recordsTaken < numRecords_) {
-          queues_[sid].push(sbufferDG);
-        }
-        mutexes_[sid].unlock();
+  // without copying it out of the received buffer
+  if (ctx.stream.type == PHYSICAL || ctx.stream.type == DEMOD) {
+    RecordView<int16_t> sbuffer = RecordView<int16_t>::from_words(data, recordWords);
+    deliver_record(ctx, sbuffer, vh);
+    if (!ctx.hostOutputs.empty()) {
+      // host DSP streams computed from this raw record
+      const vector<RecordView<int32_t>> & outputs = hostDSP_.process(ctx.stream.channelID[0], sbuffer);
+      for (size_t ct = 0; ct < ctx.hostOutputs.size(); ct++) {
+        deliver_record(streamContexts_[ctx.hostOutputs[ct]], outputs[ct], vh);
       }
-      break;
-    case RESULT:
-    case CORRELATED:
-    case STATE:
-      LOG(plog::verbose) << "[VMPDataAvailable] buffer SID = " << hexn<4> << sid << "; buffer.size = " << std::dec << ibufferDG.size() << " samples";
-      if ( digitizerMode_ == AVERAGER) {
-        // accumulate the data in the appropriate channel
-        if (accumulators_[sid].recordsTaken < numRecords_) {
-          accumulators_[sid].accumulate(ibufferDG);
-          // correlate with other result channels
-          for (auto & kv : correlators_) {
-            if (std::find(kv.first.begin(), kv.first.end(), sid) != kv.first.end()) {
-              kv.second.accumulate(sid, ibufferDG);
-            }
-          }
-        }
-      }
-      else {
-        mutexes_[sid].lock();
-        if (queues_[sid].recordsTaken < numRecords_) {
-          queues_[sid].push(ibufferDG);
-        }
-        mutexes_[sid].unlock();
-      }
-      break;
+    }
+  } else {
+    deliver_record(ctx, RecordView<int32_t>::from_words(data, recordWords), vh);
   }
 }
 
-bool X6_1000::check_done() {
-  if ( digitizerMode_ == AVERAGER) {
-    for (auto & kv : accumulators_) {
-      LOG(plog::debug) << "Channel " << hexn<4> << kv.first << " has taken " << std::dec << kv.second.recordsTaken << " records.";
+template <class B>
+void X6_1000::deliver_record(StreamContext & ctx, const B & buffer, const VitaHeader & vh) {
+  ctx.recordsReceived++;
+  if (ctx.kernelBank) {
+    deliver_record(streamContexts_[ctx.kernelBankOutput], ctx.kernelBank->apply(buffer), vh);
+  }
+  for (auto & input : ctx.discriminators) {
+    input.discriminator->add_record(input.index, buffer);
+    size_t numStates = input.discriminator->classify();
+    const int32_t * states = input.discriminator->get_states().data();
+    for (size_t ct = 0; ct < numStates; ct++) {
+      deliver_record(streamContexts_[input.output], RecordView<int32_t>(states + 2*ct, 2), vh);
     }
-    for (auto & kv : accumulators_) {
-      if (kv.second.recordsTaken < numRecords_) {
-        return false;
-      }
+  }
+  for (auto & corr : ctx.crossCorrelators) {
+    corr.first->add_record(corr.second, buffer, ctx.recordsReceived - 1, vh);
+  }
+
+  if (ctx.bankStalled) {
+    return;
+  }
+  if (ctx.spectrum) {
+    if (ctx.spectrum->recordsTaken >= numRecords_) {
+      return;
     }
-    return true;
+    ctx.spectrum->accumulate(buffer);
+    notifier_.records_available(1);
   }
-  else {
-    for (auto & kv : queues_) {
-      LOG(plog::debug) << "Channel " << hexn<4> << kv.first << " has taken " << std::dec << kv.second.recordsTaken << " records.";
+  else if (digitizerMode_ != DIGITIZER) {
+    if (ctx.accumulator->recordsTaken >= numRecords_) {
+      return;
     }
-    for (auto & kv : queues_) {
-      if (kv.second.recordsTaken < numRecords_) {
-        return false;
-      }
+    ctx.accumulator->accumulate(buffer);
+    // correlate with other result channels
+    for (auto & corr : ctx.correlators) {
+      corr.first->accumulate_buffer(corr.second, buffer);
     }
-    return true;
+    notifier_.records_available(1);
+  }
+  else {
+    std::unique_lock<std::mutex> lock(*ctx.mutex);
+    RecordQueue<int32_t> & queue = *ctx.queue;
+    if (queue.recordsTaken >= numRecords_) {
+      return;
+    }
+    // metadata goes first so a socket client receives it right behind the record
+    RecordMetadata meta;
+    meta.streamID = ctx.stream.streamID;
+    meta.timestampSeconds = vh.timestampSeconds;
+    meta.timestampFractional = vh.timestampFractional;
+    meta.packetCount = vh.packetCount;
+    meta.recordIndex = queue.metadataTaken;
+    meta.segment = (meta.recordIndex / waveforms_) % numSegments_;
+    queue.push_metadata(meta);
+    queue.push(buffer);
+    lock.unlock();
+    // notify outside the lock so callbacks may transfer data
+    notifier_.records_available(1);
   }
-}
 
-void X6_1000::write_pulse_waveform(unsigned pg, vector<double>& wf){
+  if (doubleBuffering_ && records_taken(ctx) == numRecords_) {
+    finish_bank(ctx);
+  }
+}
 
-  //Check and write the length
-  //Waveform length should be multiple of four and less than 16384
-  LOG(plog::debug) << "Writing waveform of length " << wf.size() << " to PG " << pg;
-  if (((wf.size() % 4) != 0) || (wf.size() > 16384)){
-    LOG(plog::error) << "invalid waveform length " << wf.size();
-    throw X6_INVALID_WF_LEN;
+void X6_1000::finish_bank(StreamContext & ctx) {
+  /*
+   * The stream has filled its part of a bank and moves on to the other one.
+   * If the client still holds that bank, no stream moves on any more and the
+   * acquisition stops once the bank they are on is full.
+   */
+  bankQueue_.stream_filled(ctx.banksFilled);
+  if (!banksStalled_ && !bankQueue_.may_start(ctx.banksFilled + 1)) {
+    LOG(plog::warning) << "Next bank is still held by the client; stopping at the end of this one";
+    banksStalled_ = true;
+  }
+  if (banksStalled_) {
+    ctx.bankStalled = true;
+    return;
   }
-  write_wishbone_register(BASE_PG[pg], WB_PG_WF_LENGTH, wf.size()/2);
+  ctx.banksFilled++;
+  ctx.switch_bank();
+}
 
+size_t X6_1000::records_taken(const StreamContext & ctx) const {
+  return ctx.spectrum ? ctx.spectrum->recordsTaken :
+         (digitizerMode_ != DIGITIZER) ? ctx.accumulator->recordsTaken : ctx.queue->recordsTaken.load();
+}
+
+bool X6_1000::check_done() {
+  bool done = true;
+  for (auto & ctx : streamContexts_) {
+    size_t taken = records_taken(ctx);
+    X6_LOG(plog::debug) << "Channel " << hexn<4> << ctx.stream.streamID << " has taken " << std::dec << taken << " records.";
+    // with double buffering, streams only stop on a bank the client still holds
+    if (doubleBuffering_ ? !ctx.bankStalled : taken < numRecords_) {
+      done = false;
+    }
+  }
+  return done;
+}
 
-  //Check and write the data
+vector<uint32_t> X6_1000::pack_pulse_waveform(const vector<double> & wf) {
+  //Check and convert the data
   auto range_check = [](double val){
     const double one_bit_level = 1.0/(1 << WF_FRAC_BITS);
     if ((val > (MAX_WF_VALUE + 1.5*one_bit_level)) || (val < (MIN_WF_VALUE - 0.5*one_bit_level)) ) {
@@ -1292,23 +2065,97 @@ void X6_1000::write_pulse_waveform(unsigned pg, vector<double>& wf){
   };
 
   //Loop through pairs, convert to 16bit integer, stack into a uint32_t
+  vector<uint32_t> words(wf.size()/2);
   for (size_t ct = 0; ct < wf.size(); ct+=2) {
     range_check(wf[ct]);
     int32_t fixedValA = scale_with_clip(wf[ct]);
     range_check(wf[ct+1]);
     int32_t fixedValB = scale_with_clip(wf[ct+1]);
-    uint32_t stackedVal = (fixedValB << 16) | (fixedValA & 0x0000ffff); // signed to unsigned is defined modulo 2^n in the standard
-    LOG(plog::debug) << "Writing waveform values " << wf[ct] << "(" << hexn<4> << fixedValA << ") and " <<
-                wf[ct+1] << "(" << hexn<4> << fixedValB << ") as " << hexn<8> << stackedVal;
-    write_wishbone_register(BASE_PG[pg], WB_PG_WF_ADDR, ct/2); // address
-    write_wishbone_register(BASE_PG[pg], WB_PG_WF_DATA, stackedVal); //data
+    words[ct/2] = (fixedValB << 16) | (fixedValA & 0x0000ffff); // signed to unsigned is defined modulo 2^n in the standard
+  }
+  return words;
+}
+
+void X6_1000::write_pulse_waveform(unsigned pg, vector<double>& wf){
+
+  //Check the length
+  //Waveform length should be multiple of four and less than 16384
+  LOG(plog::debug) << "Writing waveform of length " << wf.size() << " to PG " << pg;
+  if (((wf.size() % 4) != 0) || (wf.size() > PG_WF_MEMORY_LENGTH)){
+    LOG(plog::error) << "invalid waveform length " << wf.size();
+    throw X6_INVALID_WF_LEN;
+  }
+  vector<uint32_t> words = pack_pulse_waveform(wf);
+  WaveformLibrary & library = pulse_library(pg);
+  upload_pulse_waveform(pg, words, UploadCache::hash(words.data(), words.size()));
+  //Memory no longer holds the library waveform last selected
+  library.deselect();
+}
+
+void X6_1000::upload_pulse_waveform(unsigned pg, const vector<uint32_t> & words, uint64_t hash) {
+  //Nothing to do if the PG already holds this waveform
+  if (!waveformUploads_.needs_upload(pg, hash, forceUploads_)) {
+    LOG(plog::verbose) << "PG " << pg << " already holds this waveform";
+    return;
+  }
+
+  //The length register, then waveform memory as address/data pairs, in one batch
+  RegisterBatch batch;
+  batch.reserve(1 + 2*words.size());
+  batch.write(BASE_PG[pg], WB_PG_WF_LENGTH, words.size());
+  for (size_t ct = 0; ct < words.size(); ct++) {
+    batch.write(BASE_PG[pg], WB_PG_WF_ADDR, ct); // address
+    batch.write(BASE_PG[pg], WB_PG_WF_DATA, words[ct]); //data
+  }
+  //Memory is unknown until the batch went through
+  waveformUploads_.forget(pg);
+  execute_register_batch(batch);
+  waveformUploads_.uploaded(pg, hash);
+}
+
+void X6_1000::add_pulse_waveform(unsigned pg, const string & name, const vector<double> & wf) {
+  if ((wf.size() == 0) || ((wf.size() % 4) != 0) || (wf.size() > PG_WF_MEMORY_LENGTH)){
+    LOG(plog::error) << "invalid waveform length " << wf.size();
+    throw X6_INVALID_WF_LEN;
   }
+  vector<uint32_t> words = pack_pulse_waveform(wf);
+  WaveformLibrary & library = pulse_library(pg);
+  LOG(plog::debug) << "Adding waveform " << name << " of length " << wf.size() << " to PG " << pg << " library";
+  library.add(name, words, UploadCache::hash(words.data(), words.size()));
+  //The PG plays the new content of the waveform it was pointed at
+  if (library.get_selected() == name) {
+    select_pulse_waveform(pg, name);
+  }
+}
+
+void X6_1000::select_pulse_waveform(unsigned pg, const string & name) {
+  WaveformLibrary & library = pulse_library(pg);
+  const WaveformLibrary::Entry & entry = library.find(name);
+  LOG(plog::debug) << "Selecting waveform " << name << " on PG " << pg;
+  upload_pulse_waveform(pg, entry.words, entry.hash);
+  library.select(name);
+}
+
+void X6_1000::remove_pulse_waveform(unsigned pg, const string & name) {
+  //If the PG is playing it, it keeps doing so until memory is written again
+  pulse_library(pg).remove(name);
+}
+
+WaveformLibrary & X6_1000::pulse_library(unsigned pg) {
+  if (pg >= pulseLibraries_.size()) {
+    LOG(plog::error) << "No pulse generator " << pg;
+    throw X6_INVALID_ARGUMENT;
+  }
+  return pulseLibraries_[pg];
 }
 
 double X6_1000::read_pulse_waveform(unsigned pg, uint16_t addr){
   LOG(plog::debug) << "Reading PG " << pg << " waveform at address " << addr;
-  write_wishbone_register(BASE_PG[pg], 9, addr/2); // address is in 32bit words
-  uint32_t stackedVal = read_wishbone_register(BASE_PG[pg], 10);
+  uint32_t stackedVal;
+  RegisterBatch batch;
+  batch.write(BASE_PG[pg], WB_PG_WF_ADDR, addr/2); // address is in 32bit words
+  batch.read(BASE_PG[pg], WB_PG_WF_DATA, &stackedVal);
+  execute_register_batch(batch);
 
   //If the address is even or odd take the upper/lower 16bits
   //The conversion from unsigned to signed is not guaranteed to keep the bit pattern
@@ -1325,27 +2172,82 @@ void X6_1000::HandleTimer(OpenWire::NotifyEvent & /*Event*/) {
   trigger_.AtTimerTick();
 }
 
-void X6_1000::write_wishbone_register(uint32_t baseAddr, uint32_t offset, uint32_t data) {
-   // Initialize WishboneAddress Space for APS specific firmware
-  Innovative::AddressingSpace & logicMemory = Innovative::LogicMemorySpace(const_cast<X6_1000M&>(module_));
-  Innovative::WishboneBusSpace WB_X6 = Innovative::WishboneBusSpace(logicMemory, baseAddr);
+X6_1000::WishboneSpace::WishboneSpace(Innovative::X6_1000M & module, uint32_t baseAddr) :
+  space_(Innovative::LogicMemorySpace(module), baseAddr) {}
+
+void X6_1000::WishboneSpace::write(uint32_t offset, uint32_t data) {
   //Register.Value is defined as an ii32 in HardwareRegister_Mb.cpp and ii32 is typedefed as unsigend in DataTypes_Mb.h
-  Innovative::Register reg = Register(WB_X6, offset);
+  Innovative::Register reg = Register(space_, offset);
   reg.Value(data);
 }
 
-uint32_t X6_1000::read_wishbone_register(uint32_t baseAddr, uint32_t offset) const {
-  Innovative::AddressingSpace & logicMemory = Innovative::LogicMemorySpace(const_cast<X6_1000M&>(module_));
-  Innovative::WishboneBusSpace WB_X6 = Innovative::WishboneBusSpace(logicMemory, baseAddr);
-  //Register.Value is defined as an ii32 in HardwareRegister_Mb.cpp and ii32 is typedefed as unsigend in DataTypes_Mb.h
-  Innovative::Register reg = Register(WB_X6, offset);
+uint32_t X6_1000::WishboneSpace::read(uint32_t offset) {
+  Innovative::Register reg = Register(space_, offset);
   return reg.Value();
 }
 
+void X6_1000::write_wishbone_register(uint32_t baseAddr, uint32_t offset, uint32_t data) {
+  bus_.write(baseAddr, offset, data);
+  rearmSession_.written(baseAddr);
+  for (unsigned inst = 0; inst < dspShadows_.size(); inst++) {
+    if (baseAddr == BASE_DSP[inst]) {
+      dspShadows_[inst].write(offset, data);
+    }
+  }
+}
+
+uint32_t X6_1000::read_wishbone_register(uint32_t baseAddr, uint32_t offset) const {
+  return bus_.read(baseAddr, offset);
+}
+
+void X6_1000::execute_register_batch(const RegisterBatch & batch) const {
+  bus_.execute(batch);
+  rearmSession_.written(batch);
+  for (auto & shadow : dspShadows_) {
+    shadow.write(batch);
+  }
+}
+
 void X6_1000::write_dsp_register(unsigned instance, uint32_t offset, uint32_t data) {
   write_wishbone_register(BASE_DSP[instance], offset, data);
 }
 
 uint32_t X6_1000::read_dsp_register(unsigned instance, uint32_t offset) const {
+  //Geometry and configuration registers come from the shadow
+  uint32_t value;
+  if (dspShadows_[instance].read(offset, value)) {
+    return value;
+  }
   return read_wishbone_register(BASE_DSP[instance], offset);
 }
+
+void X6_1000::load_dsp_shadow(unsigned a) {
+  dspShadows_[a-1].load(BASE_DSP[a-1], [this](const RegisterBatch & batch) { bus_.execute(batch); });
+}
+
+const DSPLayout & X6_1000::dsp_layout(unsigned a) {
+  if (a < 1 || a > dspShadows_.size()) {
+    LOG(plog::error) << "No DSP " << a;
+    throw X6_INVALID_CHANNEL;
+  }
+  if (!dspShadows_[a-1].is_loaded()) {
+    load_dsp_shadow(a);
+  }
+  return dspShadows_[a-1].get_layout();
+}
+
+unsigned X6_1000::verify_register_shadow(unsigned a) {
+  dsp_layout(a);
+  auto mismatches = dspShadows_[a-1].verify([this](const RegisterBatch & batch) { bus_.execute(batch); });
+  for (auto & mismatch : mismatches) {
+    LOG(plog::warning) << "DSP " << a << " register " << hexn<2> << mismatch.offset << " holds " << hexn<8> << mismatch.card
+                       << " but the shadow has " << hexn<8> << mismatch.shadow;
+  }
+  return mismatches.size();
+}
+
+void X6_1000::resync_register_shadow() {
+  for (unsigned a = 1; a <= dspShadows_.size(); a++) {
+    load_dsp_shadow(a);
+  }
+}
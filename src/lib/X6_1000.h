@@ -10,6 +10,7 @@
 #define X6_1000_H_
 
 #include <array>
+#include <atomic>
 #include <mutex>
 
 #include "X6_enums.h"
@@ -17,7 +18,27 @@
 #include "QDSPStream.h"
 #include "RecordQueue.h"
 #include "Accumulator.h"
+#include "SpectrumAccumulator.h"
 #include "Correlator.h"
+#include "VitaHeader.h"
+#include "VitaDemux.h"
+#include "RecordView.h"
+#include "StreamContext.h"
+#include "AcquisitionPipeline.h"
+#include "ThreadTuner.h"
+#include "RecordConsumer.h"
+#include "HostDSP.h"
+#include "KernelBank.h"
+#include "Discriminator.h"
+#include "CrossBoardCorrelator.h"
+#include "SequenceTracker.h"
+#include "BankQueue.h"
+#include "RegisterBus.h"
+#include "UploadCache.h"
+#include "WaveformLibrary.h"
+#include "DSPShadow.h"
+#include "RearmSession.h"
+#include "DataNotifier.h"
 
 // II Malibu headers
 #include <X6_1000M_Mb.h>
@@ -52,6 +73,8 @@ public:
 
   void set_digitizer_mode(const X6_DIGITIZER_MODE &);
   X6_DIGITIZER_MODE get_digitizer_mode() const;
+  void set_spectrum_window(const X6_SPECTRUM_WINDOW &);
+  X6_SPECTRUM_WINDOW get_spectrum_window() const;
 
   void set_trigger_delay(float delay = 0.0);
 
@@ -65,6 +88,9 @@ public:
 
   void set_averager_settings(const int & recordLength, const int & numSegments, const int & waveforms,  const int & roundRobins);
   void set_record_length(int recordLength);
+  unsigned get_num_segments() const { return numSegments_; }
+  unsigned get_num_waveforms() const { return waveforms_; }
+  unsigned get_num_records() const { return numRecords_; }
 
   int get_number_of_integrators(unsigned);
   int get_number_of_demodulators(unsigned);
@@ -90,8 +116,25 @@ public:
 
   void write_kernel(int, int, int, const vector<complex<double>> &);
   complex<double> read_kernel(unsigned, unsigned, unsigned, unsigned);
+  // reads a run of kernel points starting at an address in one pass
+  void read_kernels(unsigned, unsigned, unsigned, unsigned, size_t, complex<double> *);
+  // kernel and pulse waveform uploads of content the card already holds are
+  // skipped unless uploads are forced
+  void set_force_uploads(bool);
+  bool get_force_uploads() const;
+  UploadStats get_kernel_upload_stats();
+  UploadStats get_waveform_upload_stats();
   void set_kernel_bias(int, int, int, complex<double>);
   complex<double> get_kernel_bias(int, int, int);
+  void set_host_decimation(int, int, unsigned, const vector<double> &);
+  void set_host_dsp_threads(unsigned);
+  void set_kernel_bank(int, int, const vector<vector<complex<double>>> &);
+  void set_discriminator(unsigned, const vector<QDSPStream> &, X6_DISCRIMINATOR_KIND, unsigned, const vector<double> &);
+  // feed a result stream into input index of a correlator shared with other boards
+  void attach_cross_correlator(const QDSPStream &, CrossBoardCorrelator *, int);
+  void detach_cross_correlator(CrossBoardCorrelator *);
+  size_t get_discriminator_counts_size(unsigned);
+  void transfer_discriminator_counts(unsigned, uint64_t *, size_t);
 
   uint32_t get_correlator_size(int);
   void write_correlator_matrix(int, const vector<double> &);
@@ -109,15 +152,40 @@ public:
   void close();
 
   void acquire();
+  // re-arm acquisitions with an unchanged setup without rebuilding it
+  void set_fast_rearm(bool);
+  bool get_fast_rearm() const;
   void wait_for_acquisition(unsigned);
   void stop();
+  // keep acquiring into a second bank while the client reads the first
+  void set_double_buffering(bool);
+  bool get_double_buffering() const;
+  size_t get_num_ready_banks();
+  void release_bank();
   bool get_is_running();
   size_t get_num_new_records();
   bool get_data_available();
+  int get_data_fd();
+  void set_notification_threshold(unsigned);
+  void register_data_callback(X6_DATA_CALLBACK, void *);
 
   void register_socket(QDSPStream, int32_t);
   void unregister_sockets();
+  void set_socket_metadata(bool);
+  void register_record_consumer(QDSPStream, X6_RECORD_CONSUMER, void *);
+  void unregister_record_consumers();
+  void set_record_consumer_dispatch(X6_CONSUMER_DISPATCH);
   void transfer_stream(QDSPStream, double *, size_t);
+  void transfer_stream_metadata(QDSPStream, RecordMetadata *, size_t);
+  unsigned get_metadata_buffer_size(QDSPStream &);
+  SequenceStats get_sequence_stats(QDSPStream &);
+  void set_abort_on_packet_loss(bool);
+  void set_pipeline_depth(unsigned);
+  PipelineStats get_pipeline_stats(X6_PIPELINE_STAGE);
+  BufferPoolStats get_buffer_pool_stats();
+  void set_thread_affinity(X6_THREAD_ROLE, uint64_t);
+  void set_thread_priority(X6_THREAD_ROLE, int);
+  ThreadSettings get_thread_settings(X6_THREAD_ROLE);
   void transfer_variance(QDSPStream, double *, size_t);
   void transfer_correlation(vector<QDSPStream> &, double *, size_t);
   void transfer_correlation_variance(vector<QDSPStream> &, double *, size_t);
@@ -128,12 +196,23 @@ public:
   /* Pulse generator methods */
   void write_pulse_waveform(unsigned, vector<double>&);
   double read_pulse_waveform(unsigned, uint16_t);
+  // named waveforms kept on the host; selecting one uploads it to the start
+  // of pulse generator memory unless the memory already holds it
+  void add_pulse_waveform(unsigned, const string &, const vector<double> &);
+  void select_pulse_waveform(unsigned, const string &);
+  void remove_pulse_waveform(unsigned, const string &);
 
   void write_wishbone_register(uint32_t, uint32_t, uint32_t);
   uint32_t read_wishbone_register(uint32_t, uint32_t) const;
+  // runs queued register writes and reads in one pass
+  void execute_register_batch(const RegisterBatch &) const;
 
   void write_dsp_register(unsigned, uint32_t, uint32_t);
   uint32_t read_dsp_register(unsigned, uint32_t) const;
+  // DSP geometry and configuration registers are read once and then served
+  // from memory; verify compares that copy with the card, resync reloads it
+  unsigned verify_register_shadow(unsigned);
+  void resync_register_shadow();
 
   /**< Rx & Tx BusMaster size in MB */
   const int RxBusmasterSize = 4;
@@ -150,32 +229,117 @@ private:
   Innovative::TriggerManager      trigger_;   /**< Malibu trigger manager */
   Innovative::VitaPacketStream    stream_;
   Innovative::SoftwareTimer       timer_;
-  Innovative::VeloBuffer       	outputPacket_;
-  vector<Innovative::VeloMergeParser> VMPs_; /**< Utility to convert and filter Velo stream back into VITA packets*/
+
+  // one wishbone address space of the card, kept by the register bus
+  class WishboneSpace {
+  public:
+    WishboneSpace(Innovative::X6_1000M &, uint32_t);
+    void write(uint32_t, uint32_t);
+    uint32_t read(uint32_t);
+  private:
+    Innovative::WishboneBusSpace space_;
+  };
+  mutable RegisterBus<WishboneSpace> bus_;
+  // what the kernel slots (a,b,c) and pulse generators currently hold
+  UploadCache kernelUploads_;
+  UploadCache waveformUploads_;
+  bool forceUploads_ = false;
+  // named waveforms of each pulse generator
+  std::array<WaveformLibrary, 2> pulseLibraries_;
+  // geometry and configuration registers of each DSP module
+  mutable std::array<DSPShadow, 2> dspShadows_;
+  VitaDemux demux_; /**< Splits the received Velo stream into per-stream records */
+  StreamContextArray streamContexts_; /**< per-stream data path state indexed by demux slot */
 
   X6_TRIGGER_SOURCE triggerSource_ = EXTERNAL_TRIGGER; /**< cached trigger source */
   X6_DIGITIZER_MODE digitizerMode_ = AVERAGER;
+  X6_SPECTRUM_WINDOW spectrumWindow_ = SPECTRUM_WINDOW_HANN;
 
   map<uint16_t, QDSPStream> activeQDSPStreams_;
 
-  //vector to go from VMP ordering to SID's
-  vector<int> physChans_;
-  vector<int> virtChans_;
+  // result stream IDs available for correlation
   vector<int> resultChans_;
-  vector<int> stateChans_;
-  vector<int> correlatedChans_;
   //Some auxiliary accumlator data
   map<uint16_t, Accumulator> accumulators_;
+  // power spectra of the raw and demod streams in spectrum mode
+  map<uint16_t, SpectrumAccumulator> spectra_;
   map<vector<uint16_t>, Correlator> correlators_;
   map<uint16_t, RecordQueue<int32_t>> queues_;
   // locks for reading/writing data to queues
   map<uint16_t, std::mutex> mutexes_;
+  // the other bank of a double-buffered acquisition, swapped with the maps
+  // above as the client releases banks so that transfers always read the
+  // oldest bank it holds
+  struct StreamBank {
+    map<uint16_t, Accumulator> accumulators;
+    map<uint16_t, SpectrumAccumulator> spectra;
+    map<vector<uint16_t>, Correlator> correlators;
+    map<uint16_t, RecordQueue<int32_t>> queues;
+    map<uint16_t, std::mutex> mutexes;
+    map<uint16_t, Discriminator> discriminators;
+  };
+  StreamBank standbyBank_;
+  bool doubleBuffering_ = false;
+  BankQueue bankQueue_;
+  // a stream found the next bank still held; only touched by the process thread
+  bool banksStalled_ = false;
   // sockets for pushing data directly to client
   map<uint16_t, int32_t> sockets_;
+  bool socketMetadata_ = false;
+  // in-process callbacks handed each batch of records without a copy
+  RecordConsumers consumers_;
+  X6_CONSUMER_DISPATCH consumerDispatch_ = CONSUMER_INLINE;
+  // software down-conversion feeding the host DSP channels (a, 8-15, c)
+  HostDSP hostDSP_;
+  // banks of kernels scored against a demod stream, keyed by its stream ID
+  map<uint16_t, KernelBank> kernelBanks_;
+  // host state discriminators keyed by the ID of their state stream (0,d,0);
+  // with double buffering each bank counts states in its own copy
+  map<uint16_t, Discriminator> discriminators_;
+  // correlators across boards fed by streams of this one, owned by a BoardGroup
+  struct CrossCorrelatorInput {
+    uint16_t streamID;
+    CrossBoardCorrelator * correlator;
+    int index;
+  };
+  vector<CrossCorrelatorInput> crossCorrelatorInputs_;
+  // VITA packet counter continuity
+  SequenceTracker sequenceTracker_;
+  bool abortOnPacketLoss_ = false;
+  std::atomic<bool> packetLoss_{false};
+  // client notification of new records and acquisition completion
+  DataNotifier notifier_;
+  // CPU affinity and priority applied by each acquisition thread to itself
+  ThreadTuner threadTuner_;
+  std::atomic<bool> receiveThreadTuned_{false};
+  // receive/parse/process threads between the driver and the accumulators;
+  // declared after the state its workers touch so it is torn down first
+  AcquisitionPipeline<Innovative::VeloBuffer> pipeline_;
+
+  // the settings the last full acquire() set up for; while they still match
+  // and nothing else was reconfigured, acquire() resets that state in place
+  struct SessionLayout {
+    unsigned recordLength;
+    unsigned numSegments;
+    unsigned waveforms;
+    unsigned numRecords;
+    X6_DIGITIZER_MODE digitizerMode;
+    X6_SPECTRUM_WINDOW spectrumWindow;
+    X6_TRIGGER_SOURCE triggerSource;
+    X6_HUGEPAGE_MODE hugePageMode;
+    bool operator==(const SessionLayout &) const;
+  };
+  SessionLayout session_;
+  // cleared by anything that may change the setup acquire() skips on a
+  // re-arm, including register writes outside the DSP and pulse generators
+  mutable RearmSession rearmSession_;
+  bool fastRearm_ = false;
 
   // State Variables
   bool isOpen_;				  /**< cached flag indicaing board was openned */
-  bool isRunning_;
+  std::atomic<bool> isRunning_;
+  // serializes stop() between client threads
+  std::mutex stopMutex_;
   bool needToInit_;
   int prefillPacketCount_;
   unsigned recordLength_ = 0;
@@ -192,10 +356,30 @@ private:
   void set_active_channels();
   void log_card_info();
   bool check_done();
-
+  size_t records_taken(const StreamContext &) const;
+
+  SessionLayout current_layout() const;
+  void configure_trigger();
+  void initialize_stream_state();
+  void reset_stream_state();
+  void initialize_standby_bank();
+  void swap_banks();
+  void clear_bank();
   void initialize_accumulators();
+  void initialize_spectra();
   void initialize_queues();
   void initialize_correlators();
+  void initialize_demux();
+  void initialize_host_dsp();
+  void initialize_kernel_banks();
+  void initialize_discriminators();
+  void add_stream_context(const QDSPStream &);
+  void bind_bank(StreamContext &);
+  WaveformLibrary & pulse_library(unsigned);
+  void upload_pulse_waveform(unsigned, const vector<uint32_t> &, uint64_t);
+  void load_dsp_shadow(unsigned);
+  const DSPLayout & dsp_layout(unsigned);
+  static vector<uint32_t> pack_pulse_waveform(const vector<double> &);
 
   // Malibu Event handlers
 
@@ -208,27 +392,12 @@ private:
   void HandleAfterStreamStop(OpenWire::NotifyEvent & Event);
 
   void HandleDataAvailable(Innovative::VitaPacketStreamDataEvent & Event);
-  void VMPDataAvailable(Innovative::VeloMergeParserDataAvailable & Event, STREAM_T);
-
-  void HandlePhysicalStream(Innovative::VeloMergeParserDataAvailable & Event) {
-    VMPDataAvailable(Event, PHYSICAL);
-  };
-
-  void HandleVirtualStream(Innovative::VeloMergeParserDataAvailable & Event) {
-    VMPDataAvailable(Event, DEMOD);
-  };
-
-  void HandleResultStream(Innovative::VeloMergeParserDataAvailable & Event) {
-    VMPDataAvailable(Event, RESULT);
-  };
-
-  void HandleStateStream(Innovative::VeloMergeParserDataAvailable & Event) {
-    VMPDataAvailable(Event, STATE);
-  };
-
-  void HandleCorrelatedStream(Innovative::VeloMergeParserDataAvailable & Event) {
-    VMPDataAvailable(Event, CORRELATED);
-  };
+  void HandlePacket(const VitaHeader &);
+  void HandleRecord(unsigned, const uint32_t *, size_t, const VitaHeader &);
+  template <class B>
+  void deliver_record(StreamContext &, const B &, const VitaHeader &);
+  void finish_bank(StreamContext &);
+  void HandleBatchProcessed();
 
   void HandleTimer(OpenWire::NotifyEvent & Event);
 };
@@ -1,6 +1,8 @@
 #ifndef X6_enums_H_
 #define X6_enums_H_
 
+#include <stdint.h>
+
 enum ClockSource {
     EXTERNAL_CLOCK = 0,   /**< External Input */
     INTERNAL_CLOCK        /**< Internal Generation */
@@ -23,7 +25,64 @@ enum X6_TRIGGER_SOURCE {
 
 enum X6_DIGITIZER_MODE {
     DIGITIZER,
-    AVERAGER
+    AVERAGER,
+    SPECTRUM
+};
+
+enum X6_PIPELINE_STAGE {
+    PIPELINE_RECEIVE = 0,   /**< Takes DMA buffers from the driver */
+    PIPELINE_PARSE,         /**< Splits buffers into per-stream records */
+    PIPELINE_PROCESS,       /**< Accumulates or queues records */
+    PIPELINE_CONSUME        /**< Hands records to record consumers on their own thread */
+};
+
+/** Data notification callback: called with the device ID, the number of
+ *  records received since the last notification, whether the acquisition
+ *  has finished, and the user data pointer given at registration.
+ */
+typedef void (*X6_DATA_CALLBACK)(int, unsigned, int, void *);
+
+enum X6_HUGEPAGE_MODE {
+    HUGEPAGE_NONE = 0,     /**< Default allocator and page size */
+    HUGEPAGE_TRANSPARENT,  /**< Advise the kernel to back buffers with transparent huge pages */
+    HUGEPAGE_EXPLICIT      /**< Reserved huge pages (hugetlbfs), falling back to transparent */
+};
+
+enum X6_THREAD_ROLE {
+    THREAD_RECEIVE = 0,  /**< Driver callback thread taking DMA buffers */
+    THREAD_PARSE,        /**< Pipeline thread splitting buffers into records */
+    THREAD_PROCESS,      /**< Pipeline thread accumulating, queueing and sending records */
+    THREAD_CONSUMER      /**< Pipeline thread calling record consumers, if they have their own thread */
+};
+
+enum X6_CONSUMER_DISPATCH {
+    CONSUMER_INLINE = 0,  /**< Call record consumers on the process thread */
+    CONSUMER_THREAD       /**< Call record consumers on a dedicated consumer thread */
+};
+
+enum X6_DISCRIMINATOR_KIND {
+    DISCRIMINATOR_NEAREST_CENTROID = 0, /**< Closest of one centroid per class */
+    DISCRIMINATOR_LINEAR,               /**< Largest of one affine score per class */
+    DISCRIMINATOR_GAUSSIAN              /**< Most likely of one Gaussian per class */
+};
+
+enum X6_SPECTRUM_WINDOW {
+    SPECTRUM_WINDOW_RECTANGULAR = 0, /**< No window */
+    SPECTRUM_WINDOW_HANN,            /**< Periodic Hann window */
+    SPECTRUM_WINDOW_BLACKMAN_HARRIS  /**< Periodic 4-term Blackman-Harris window */
+};
+
+enum X6_SHOT_ALIGNMENT {
+    ALIGN_RECORD_INDEX = 0, /**< Shots are the records with the same index on every board */
+    ALIGN_TIMESTAMP         /**< Shots are the records with matching VITA timestamps */
+};
+
+enum X6_SWEEP_PARAMETER {
+    SWEEP_NCO_FREQUENCY = 0, /**< NCO frequency of demod channel (a,b) */
+    SWEEP_THRESHOLD,         /**< Decision engine threshold of channel (a,0,c) */
+    SWEEP_KERNEL_BIAS,       /**< Kernel bias of channel (a,b,c), value + i*imag */
+    SWEEP_PULSE_WAVEFORM,    /**< Waveform of pulse generator a, by index into the sweep's waveforms */
+    SWEEP_WISHBONE_REGISTER  /**< Wishbone register at base address a, offset b */
 };
 
 struct ChannelTuple {
@@ -32,4 +91,90 @@ struct ChannelTuple {
     int c;
 };
 
+struct RecordMetadata {
+    uint64_t recordIndex;         /**< Index of the record within the acquisition */
+    uint64_t timestampFractional; /**< VITA fractional-seconds timestamp (5 ns ticks) */
+    uint32_t timestampSeconds;    /**< VITA integer-seconds timestamp */
+    uint32_t packetCount;         /**< VITA packet counter (modulo 16) */
+    uint32_t segment;             /**< Segment the record belongs to */
+    uint32_t streamID;            /**< Stream ID of the VITA packet */
+};
+
+struct SequenceStats {
+    uint64_t packets;     /**< VITA packets seen */
+    uint64_t gaps;        /**< Discontinuities where packets were skipped */
+    uint64_t lostPackets; /**< Packets skipped across all gaps that have not arrived late */
+    uint64_t duplicates;  /**< Packets repeating a packet count already seen */
+    uint64_t outOfOrder;  /**< Packets arriving late into an earlier gap */
+};
+
+struct PipelineStats {
+    uint64_t depth;     /**< Items waiting in the stage's input queue */
+    uint64_t highWater; /**< Largest queue depth since the acquisition started */
+    uint64_t capacity;  /**< Input queue capacity */
+    uint64_t processed; /**< Items the stage has handled */
+    uint64_t stalls;    /**< Times the upstream stage waited on a full queue */
+};
+
+struct ThreadSettings {
+    uint64_t requestedCPUs;  /**< Bitmask of cores asked for; 0 leaves affinity alone */
+    uint64_t effectiveCPUs;  /**< Bitmask of cores the thread is allowed on; 0 if unknown */
+    int32_t requestedPriority; /**< Real-time priority asked for; 0 for normal scheduling */
+    int32_t effectivePriority; /**< Real-time priority in effect; 0 if normal scheduling */
+    int32_t applied;         /**< Nonzero once the settings were applied to a running thread */
+};
+
+struct MemoryStats {
+    uint64_t bytesInUse;     /**< Bytes of large stream buffers currently allocated */
+    uint64_t peakBytes;      /**< Most bytes allocated at once */
+    uint64_t hugePageBytes;  /**< Bytes in explicit huge pages or advised for transparent ones */
+    uint64_t allocations;    /**< Large buffers allocated */
+    uint64_t fallbacks;      /**< Explicit huge page requests that fell back to regular pages */
+};
+
+/** Read-only view of the records one received buffer carried for a stream.
+ *  Samples are raw fixed-point values; divide by scale to get the values
+ *  transfer_stream returns. Physical and demodulated streams carry 16-bit
+ *  samples, result, state and correlated streams 32-bit ones; complex data is
+ *  interleaved real, imaginary. The view and everything it points to is only
+ *  valid until the consumer returns.
+ */
+struct RecordBatchView {
+    uint32_t streamID;       /**< Stream ID of the records */
+    uint32_t numRecords;     /**< Records in this batch */
+    uint32_t recordLength;   /**< Samples in each record */
+    uint32_t sampleBytes;    /**< 2 for int16_t samples, 4 for int32_t */
+    double scale;            /**< Fixed-point scaling of the samples */
+    const void * const * records;    /**< Pointer to the first sample of each record */
+    const struct RecordMetadata * metadata; /**< Metadata for each record */
+};
+
+/** Record consumer: called with the device ID, a batch of records for the
+ *  stream it was registered on, and the context pointer given at registration.
+ */
+typedef void (*X6_RECORD_CONSUMER)(int, const struct RecordBatchView *, void *);
+
+struct SweepChange {
+    uint32_t point;     /**< Sweep point the change is made before */
+    int32_t parameter;  /**< X6_SWEEP_PARAMETER to change */
+    int32_t a;
+    int32_t b;
+    int32_t c;
+    double value;       /**< New value, waveform index or register contents */
+    double imag;        /**< Imaginary part of a kernel bias */
+};
+
+struct BufferPoolStats {
+    uint64_t capacity;     /**< Buffers owned by the pool */
+    uint64_t inUse;        /**< Buffers currently held downstream */
+    uint64_t highWater;    /**< Most buffers held at once since the acquisition started */
+    uint64_t allocations;  /**< Buffers allocated since the acquisition started */
+    uint64_t acquisitions; /**< Buffers handed out since the acquisition started */
+};
+
+struct UploadStats {
+    uint64_t uploads; /**< Kernel or waveform uploads written to the card */
+    uint64_t skips;   /**< Uploads skipped because the card already held the content */
+};
+
 #endif
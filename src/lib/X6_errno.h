@@ -18,7 +18,10 @@ enum X6_STATUS {
   X6_INVALID_KERNEL_LENGTH = -13,
   X6_KERNEL_OUT_OF_RANGE = -14,
   X6_MODE_ERROR = -15,
-  X6_SOCKET_ERROR = -16
+  X6_SOCKET_ERROR = -16,
+  X6_PACKET_LOSS = -17,
+  X6_NOT_SUPPORTED = -18,
+  X6_INVALID_ARGUMENT = -19
 };
 
 #ifdef __cplusplus
@@ -41,7 +44,10 @@ static std::map<X6_STATUS, std::string> errorsMsgs = {
 {X6_INVALID_KERNEL_STREAM, "Attempted to write kernel to non kernel (raw or demod.) stream."},
 {X6_KERNEL_OUT_OF_RANGE, "Kernel values must be between -1.0 and (1-1/2^15)."},
 {X6_MODE_ERROR, "Feature requested incompatible with digitizer mode."},
-{X6_SOCKET_ERROR, "Error occured writing data to socket."}
+{X6_SOCKET_ERROR, "Error occured writing data to socket."},
+{X6_PACKET_LOSS, "Acquisition aborted after VITA packets were lost."},
+{X6_NOT_SUPPORTED, "Feature is not supported on this platform."},
+{X6_INVALID_ARGUMENT, "API call made with an argument outside its allowed values."}
 };
 
 #endif
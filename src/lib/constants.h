@@ -68,12 +68,27 @@ const int WB_PG_MODULE_FIRMWARE_VERSION = 0x02;
 const int WB_PG_WF_LENGTH = 0x08;
 const int WB_PG_WF_ADDR   = 0x09;
 const int WB_PG_WF_DATA   = 0x0A;
+// samples of waveform memory in each pulse generator
+const unsigned PG_WF_MEMORY_LENGTH = 16384;
 
 //Readout filter parameters
 const int VIRTUAL_CH_RATIO = 4; // Number of virtual channels per physical channel
 const int RAW_DECIMATION_FACTOR = 4;
 const int DEMOD_DECIMATION_FACTOR = 32;
 
+// Host DSP channels (a,b,c) use demodulator numbers b past the firmware's
+const unsigned HOST_DSP_FIRST_CHANNEL = 8;
+const unsigned HOST_DSP_LAST_CHANNEL = 15;
+// by default host demod streams come out at the firmware demod rate
+const unsigned HOST_DSP_DEFAULT_DECIMATION = DEMOD_DECIMATION_FACTOR / RAW_DECIMATION_FACTOR;
+
+// Stream (a,b,15) of a demod channel b carries the kernel bank results
+const unsigned KERNEL_BANK_STREAM = 15;
+
+// Stream (0,d,0) carries the states classified by host discriminator d
+const unsigned DISCRIMINATOR_CHANNEL = 0;
+const unsigned MAX_DISCRIMINATORS = 15;
+
 // Correlations
 const int MAX_N_BODY_CORRELATIONS = 3;
 
@@ -7,6 +7,7 @@
 // Copyright 2013-2015 Raytheon BBN Technologies
 
 #include <memory> //unique_ptr
+#include <algorithm> //std::max
 #include <string>
 using std::string;
 #include <cstring>
@@ -14,6 +15,9 @@ using std::string;
 
 #include "libx6.h"
 #include "X6_1000.h"
+#include "BoardGroup.h"
+#include "SweepRunner.h"
+#include "AsyncFileAppender.h"
 #include "version.hpp"
 
 #define FILE_PLOG 1
@@ -22,6 +26,10 @@ using std::string;
 // globals
 map<unsigned, std::unique_ptr<X6_1000>> X6s_;
 unsigned numDevices_ = 0;
+map<unsigned, std::unique_ptr<BoardGroup>> groups_;
+unsigned nextGroupID_ = 0;
+// the last sweep started on each board
+map<unsigned, std::unique_ptr<SweepRunner>> sweeps_;
 
 // stub class to open loggers
 class InitAndCleanUp {
@@ -29,14 +37,25 @@ public:
   InitAndCleanUp();
 };
 
+// The default logger only needs to let through what one of its appenders
+// will keep; anything less severe is then skipped before it is formatted.
+static void update_default_logging_level() {
+  plog::Severity fileSeverity = plog::get<FILE_PLOG>()->getMaxSeverity();
+  plog::Severity consoleSeverity = plog::get<CONSOLE_PLOG>()->getMaxSeverity();
+  plog::get()->setMaxSeverity(std::max(fileSeverity, consoleSeverity));
+}
+
 InitAndCleanUp::InitAndCleanUp() {
   if (!plog::get()) {
-    static plog::RollingFileAppender<plog::TxtFormatter> fileAppender("libx6.log", 1000000, 3);
+    // the file is written from a background thread so logging never stalls
+    // the acquisition threads on disk I/O
+    static AsyncFileAppender<plog::TxtFormatter> fileAppender("libx6.log", 1000000, 3);
     plog::init<FILE_PLOG>(plog::info, &fileAppender);
     static plog::ColorConsoleAppender<plog::TxtFormatter> consoleAppender;
     plog::init<CONSOLE_PLOG>(plog::warning, &consoleAppender);
 
     plog::init(plog::verbose).addAppender(plog::get<FILE_PLOG>()).addAppender(plog::get<CONSOLE_PLOG>());
+    update_default_logging_level();
   }
   LOG(plog::info) << "libx6 driver version: " << get_driver_version();
 }
@@ -52,10 +71,32 @@ const char* get_error_msg(X6_STATUS err) {
   }
 }
 
+//A board belongs to the thread of its sweep until the sweep is over
+static bool in_sweep(const unsigned deviceID) {
+  auto sweep = sweeps_.find(deviceID);
+  if (sweep != sweeps_.end() && sweep->second->is_running()) {
+    LOG(plog::error) << "Board " << deviceID << " is running a sweep";
+    return true;
+  }
+  return false;
+}
+
+static bool group_in_sweep(const BoardGroup & group) {
+  for (auto & sweep : sweeps_) {
+    if (group.contains(sweep.first) && in_sweep(sweep.first)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 //Define a couple of templated wrapper functions to make library calls and catch thrown errors
 //First one for void calls
 template<typename F, typename... Args>
 X6_STATUS x6_call(const unsigned deviceID, F func, Args... args){
+  if (in_sweep(deviceID)) {
+    return X6_MODE_ERROR;
+  }
   try{
     (X6s_.at(deviceID).get()->*func)(args...); // for some reason the compiler can't infer the correct dereference operator without the get function
     //Nothing thrown then assume OK
@@ -79,6 +120,9 @@ X6_STATUS x6_call(const unsigned deviceID, F func, Args... args){
 //and one for to store getter values in pointer passed to library
 template<typename R, typename F, typename... Args>
 X6_STATUS x6_getter(const unsigned deviceID, F func, R* resPtr, Args... args){
+  if (in_sweep(deviceID)) {
+    return X6_MODE_ERROR;
+  }
   try {
     *resPtr = (X6s_.at(deviceID).get()->*func)(args...);
     //Nothing thrown then assume OK
@@ -99,6 +143,49 @@ X6_STATUS x6_getter(const unsigned deviceID, F func, R* resPtr, Args... args){
   }
 }
 
+//and the same pair for board group calls
+template<typename F, typename... Args>
+X6_STATUS group_call(const unsigned groupID, F func, Args... args){
+  try {
+    auto it = groups_.find(groupID);
+    if (it == groups_.end()) {
+      return X6_INVALID_ARGUMENT;
+    }
+    if (group_in_sweep(*it->second)) {
+      return X6_MODE_ERROR;
+    }
+    (it->second.get()->*func)(args...);
+    return X6_OK;
+  }
+  catch (X6_STATUS status) {
+    return status;
+  }
+  catch (...) {
+    return X6_UNKNOWN_ERROR;
+  }
+}
+
+template<typename R, typename F, typename... Args>
+X6_STATUS group_getter(const unsigned groupID, F func, R* resPtr, Args... args){
+  try {
+    auto it = groups_.find(groupID);
+    if (it == groups_.end()) {
+      return X6_INVALID_ARGUMENT;
+    }
+    if (group_in_sweep(*it->second)) {
+      return X6_MODE_ERROR;
+    }
+    *resPtr = (it->second.get()->*func)(args...);
+    return X6_OK;
+  }
+  catch (X6_STATUS status) {
+    return status;
+  }
+  catch (...) {
+    return X6_UNKNOWN_ERROR;
+  }
+}
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -130,9 +217,24 @@ X6_STATUS connect_x6(int deviceID) {
 }
 
 X6_STATUS disconnect_x6(int deviceID) {
+  // a sweep still running on the board finishes its point first
+  auto sweep = sweeps_.find(deviceID);
+  if (sweep != sweeps_.end()) {
+    sweep->second->stop();
+  }
   X6_STATUS status = x6_call(deviceID, &X6_1000::close);
 
   if (status == X6_OK){
+    // groups must not outlive their boards
+    for (auto it = groups_.begin(); it != groups_.end();) {
+      if (it->second->contains(deviceID)) {
+        LOG(plog::warning) << "Removing board group " << it->first << " along with board " << deviceID;
+        it = groups_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    sweeps_.erase(deviceID);
     X6s_.erase(deviceID);
   }
   return status;
@@ -228,6 +330,14 @@ X6_STATUS get_digitizer_mode(int deviceID, X6_DIGITIZER_MODE* mode) {
   return x6_getter(deviceID, &X6_1000::get_digitizer_mode, mode);
 }
 
+X6_STATUS set_spectrum_window(int deviceID, X6_SPECTRUM_WINDOW window) {
+  return x6_call(deviceID, &X6_1000::set_spectrum_window, window);
+}
+
+X6_STATUS get_spectrum_window(int deviceID, X6_SPECTRUM_WINDOW* window) {
+  return x6_getter(deviceID, &X6_1000::get_spectrum_window, window);
+}
+
 X6_STATUS set_input_channel_enable(int deviceID, unsigned chan, bool enable) {
   return x6_call(deviceID, &X6_1000::set_input_channel_enable, chan, enable);
 }
@@ -315,6 +425,71 @@ X6_STATUS read_kernel(int deviceID, unsigned a, unsigned b, unsigned c, unsigned
   return x6_getter(deviceID, &X6_1000::read_kernel, tmpVal, a, b, c, addr);
 }
 
+X6_STATUS set_host_decimation(int deviceID, unsigned a, unsigned b, unsigned factor, double* taps, unsigned numTaps) {
+  vector<double> vec;
+  if (taps) {
+    vec.assign(taps, taps + numTaps);
+  }
+  return x6_call(deviceID, &X6_1000::set_host_decimation, a, b, factor, vec);
+}
+
+X6_STATUS set_host_dsp_threads(int deviceID, unsigned numThreads) {
+  return x6_call(deviceID, &X6_1000::set_host_dsp_threads, numThreads);
+}
+
+X6_STATUS set_discriminator(int deviceID, unsigned d, ChannelTuple* inputs, unsigned numInputs,
+                            X6_DISCRIMINATOR_KIND kind, unsigned numClasses, double* params, unsigned numParams) {
+  vector<QDSPStream> streams(numInputs);
+  for (unsigned i = 0; i < numInputs; i++) {
+    streams[i] = QDSPStream(inputs[i].a, inputs[i].b, inputs[i].c);
+  }
+  vector<double> vec;
+  if (params) {
+    vec.assign(params, params + numParams);
+  }
+  return x6_call(deviceID, &X6_1000::set_discriminator, d, streams, kind, numClasses, vec);
+}
+
+X6_STATUS get_discriminator_counts_size(int deviceID, unsigned d, unsigned* size) {
+  return x6_getter(deviceID, &X6_1000::get_discriminator_counts_size, size, d);
+}
+
+X6_STATUS transfer_discriminator_counts(int deviceID, unsigned d, uint64_t* counts, unsigned length) {
+  return x6_call(deviceID, &X6_1000::transfer_discriminator_counts, d, counts, length);
+}
+
+X6_STATUS set_kernel_bank(int deviceID, unsigned a, unsigned b, double* kernels, unsigned numKernels, unsigned kernelLength) {
+  // numKernels kernels of kernelLength complex points, one after the other
+  complex<double>* kernels_cmplx = reinterpret_cast<std::complex<double>*>(kernels);
+  vector<vector<complex<double>>> bank;
+  for (unsigned k = 0; k < numKernels; k++) {
+    bank.emplace_back(kernels_cmplx + k*kernelLength, kernels_cmplx + (k+1)*kernelLength);
+  }
+  return x6_call(deviceID, &X6_1000::set_kernel_bank, a, b, bank);
+}
+
+X6_STATUS read_kernels(int deviceID, unsigned a, unsigned b, unsigned c, double* kernel, unsigned length) {
+  // the first length points of the kernel
+  complex<double>* kernel_cmplx = reinterpret_cast<std::complex<double>*>(kernel);
+  return x6_call(deviceID, &X6_1000::read_kernels, a, b, c, 0u, static_cast<size_t>(length), kernel_cmplx);
+}
+
+X6_STATUS set_force_uploads(int deviceID, bool force) {
+  return x6_call(deviceID, &X6_1000::set_force_uploads, force);
+}
+
+X6_STATUS get_force_uploads(int deviceID, bool* force) {
+  return x6_getter(deviceID, &X6_1000::get_force_uploads, force);
+}
+
+X6_STATUS get_kernel_upload_stats(int deviceID, UploadStats* stats) {
+  return x6_getter(deviceID, &X6_1000::get_kernel_upload_stats, stats);
+}
+
+X6_STATUS get_waveform_upload_stats(int deviceID, UploadStats* stats) {
+  return x6_getter(deviceID, &X6_1000::get_waveform_upload_stats, stats);
+}
+
 X6_STATUS set_kernel_bias(int deviceID, unsigned a, unsigned b, unsigned c, double* val) {
   std::complex<double>* tmp_val = reinterpret_cast<std::complex<double>*>(val);
   return x6_call(deviceID, &X6_1000::set_kernel_bias, a, b, c, *tmp_val);
@@ -350,10 +525,208 @@ X6_STATUS acquire(int deviceID) {
   return x6_call(deviceID, &X6_1000::acquire);
 }
 
+X6_STATUS set_fast_rearm(int deviceID, bool enable) {
+  return x6_call(deviceID, &X6_1000::set_fast_rearm, enable);
+}
+
+X6_STATUS get_fast_rearm(int deviceID, bool* enable) {
+  return x6_getter(deviceID, &X6_1000::get_fast_rearm, enable);
+}
+
+X6_STATUS set_double_buffering(int deviceID, bool enable) {
+  return x6_call(deviceID, &X6_1000::set_double_buffering, enable);
+}
+
+X6_STATUS get_double_buffering(int deviceID, bool* enable) {
+  return x6_getter(deviceID, &X6_1000::get_double_buffering, enable);
+}
+
+X6_STATUS get_num_ready_banks(int deviceID, unsigned* numBanks) {
+  return x6_getter(deviceID, &X6_1000::get_num_ready_banks, numBanks);
+}
+
+X6_STATUS release_bank(int deviceID) {
+  return x6_call(deviceID, &X6_1000::release_bank);
+}
+
 X6_STATUS wait_for_acquisition(int deviceID, unsigned timeOut) {
   return x6_call(deviceID, &X6_1000::wait_for_acquisition, timeOut);
 }
 
+X6_STATUS create_board_group(int* deviceIDs, unsigned numDevices, int* groupID) {
+  vector<int> ids(deviceIDs, deviceIDs + numDevices);
+  vector<X6_1000*> boards;
+  for (int id : ids) {
+    if (X6s_.find(id) == X6s_.end()) {
+      return X6_UNCONNECTED;
+    }
+    if (std::count(ids.begin(), ids.end(), id) > 1) {
+      return X6_INVALID_ARGUMENT;
+    }
+    boards.push_back(X6s_[id].get());
+  }
+  try {
+    std::unique_ptr<BoardGroup> group(new BoardGroup(ids, boards));
+    groups_[nextGroupID_] = std::move(group);
+  }
+  catch (X6_STATUS status) {
+    return status;
+  }
+  *groupID = nextGroupID_++;
+  return X6_OK;
+}
+
+X6_STATUS destroy_board_group(int groupID) {
+  return groups_.erase(groupID) ? X6_OK : X6_INVALID_ARGUMENT;
+}
+
+X6_STATUS group_acquire(int groupID) {
+  return group_call(groupID, &BoardGroup::acquire);
+}
+
+X6_STATUS group_wait_for_acquisition(int groupID, unsigned timeOut) {
+  return group_call(groupID, &BoardGroup::wait_for_acquisition, timeOut);
+}
+
+X6_STATUS group_stop(int groupID) {
+  return group_call(groupID, &BoardGroup::stop);
+}
+
+X6_STATUS get_group_size(int groupID, unsigned* numBoards) {
+  auto it = groups_.find(groupID);
+  if (it == groups_.end()) {
+    return X6_INVALID_ARGUMENT;
+  }
+  *numBoards = it->second->get_device_ids().size();
+  return X6_OK;
+}
+
+X6_STATUS group_get_buffer_sizes(int groupID, ChannelTuple *channelTuples, unsigned numChannels, unsigned* bufferSizes) {
+  // fills one size per board of the group
+  vector<QDSPStream> streams(numChannels);
+  for (unsigned i = 0; i < numChannels; i++) {
+    streams[i] = QDSPStream(channelTuples[i].a, channelTuples[i].b, channelTuples[i].c);
+  }
+  vector<size_t> sizes;
+  X6_STATUS status = group_getter(groupID, &BoardGroup::get_buffer_sizes, &sizes, streams);
+  std::copy(sizes.begin(), sizes.end(), bufferSizes);
+  return status;
+}
+
+X6_STATUS group_transfer_stream(int groupID, ChannelTuple *channelTuples, unsigned numChannels, double* buffer, unsigned* bufferSizes) {
+  // buffer holds each board's data in turn, bufferSizes[i] points for board i
+  vector<QDSPStream> streams(numChannels);
+  for (unsigned i = 0; i < numChannels; i++) {
+    streams[i] = QDSPStream(channelTuples[i].a, channelTuples[i].b, channelTuples[i].c);
+  }
+  auto it = groups_.find(groupID);
+  if (it == groups_.end()) {
+    return X6_INVALID_ARGUMENT;
+  }
+  vector<size_t> sizes(bufferSizes, bufferSizes + it->second->get_device_ids().size());
+  return group_call(groupID, &BoardGroup::transfer_stream, streams, buffer, sizes);
+}
+
+X6_STATUS group_add_correlator(int groupID, int* deviceIDs, ChannelTuple *channelTuples, unsigned numInputs,
+                               X6_SHOT_ALIGNMENT alignment, uint64_t tolerance, unsigned* correlatorID) {
+  vector<int> ids(deviceIDs, deviceIDs + numInputs);
+  vector<QDSPStream> streams(numInputs);
+  for (unsigned i = 0; i < numInputs; i++) {
+    streams[i] = QDSPStream(channelTuples[i].a, channelTuples[i].b, channelTuples[i].c);
+  }
+  return group_getter(groupID, &BoardGroup::add_correlator, correlatorID, ids, streams, alignment, tolerance);
+}
+
+X6_STATUS group_get_correlator_size(int groupID, unsigned correlatorID, unsigned* bufferSize) {
+  return group_getter(groupID, &BoardGroup::get_correlator_size, bufferSize, correlatorID);
+}
+
+X6_STATUS group_transfer_correlation(int groupID, unsigned correlatorID, double* buffer, unsigned bufferLength) {
+  return group_call(groupID, &BoardGroup::transfer_correlation, correlatorID, buffer, bufferLength);
+}
+
+X6_STATUS group_transfer_correlation_variance(int groupID, unsigned correlatorID, double* buffer, unsigned bufferLength) {
+  return group_call(groupID, &BoardGroup::transfer_correlation_variance, correlatorID, buffer, bufferLength);
+}
+
+X6_STATUS start_sweep(int deviceID, SweepChange* changes, unsigned numChanges,
+                      double* waveformData, unsigned* waveformLengths, unsigned numWaveforms,
+                      ChannelTuple* channelTuples, unsigned numChannels,
+                      unsigned numPoints, double* results, unsigned resultLength, unsigned timeOut) {
+  // waveformData holds the waveforms one after the other
+  auto board = X6s_.find(deviceID);
+  if (board == X6s_.end()) {
+    return X6_UNCONNECTED;
+  }
+  auto sweep = sweeps_.find(deviceID);
+  if (sweep != sweeps_.end() && sweep->second->is_running()) {
+    return X6_MODE_ERROR;
+  }
+  vector<SweepChange> changeVec(changes, changes + numChanges);
+  vector<vector<double>> waveforms(numWaveforms);
+  for (unsigned i = 0; i < numWaveforms; i++) {
+    waveforms[i].assign(waveformData, waveformData + waveformLengths[i]);
+    waveformData += waveformLengths[i];
+  }
+  vector<QDSPStream> streams(numChannels);
+  for (unsigned i = 0; i < numChannels; i++) {
+    streams[i] = QDSPStream(channelTuples[i].a, channelTuples[i].b, channelTuples[i].c);
+  }
+  try {
+    std::unique_ptr<SweepRunner> runner(new SweepRunner(board->second.get(), changeVec, waveforms, streams,
+                                                        numPoints, results, resultLength, timeOut));
+    runner->start();
+    sweeps_[deviceID] = std::move(runner);
+  }
+  catch (X6_STATUS status) {
+    return status;
+  }
+  catch (...) {
+    return X6_UNKNOWN_ERROR;
+  }
+  return X6_OK;
+}
+
+X6_STATUS wait_for_sweep(int deviceID, unsigned timeOut) {
+  auto sweep = sweeps_.find(deviceID);
+  if (sweep == sweeps_.end()) {
+    return X6_MODE_ERROR;
+  }
+  try {
+    sweep->second->wait(timeOut);
+  }
+  catch (X6_STATUS status) {
+    return status;
+  }
+  return X6_OK;
+}
+
+X6_STATUS stop_sweep(int deviceID) {
+  auto sweep = sweeps_.find(deviceID);
+  if (sweep != sweeps_.end()) {
+    sweep->second->stop();
+  }
+  return X6_OK;
+}
+
+X6_STATUS get_sweep_progress(int deviceID, unsigned* pointsDone) {
+  auto sweep = sweeps_.find(deviceID);
+  if (sweep == sweeps_.end()) {
+    return X6_MODE_ERROR;
+  }
+  *pointsDone = sweep->second->get_points_done();
+  return X6_OK;
+}
+
+X6_STATUS get_sweep_point_size(int deviceID, unsigned* pointSize) {
+  auto sweep = sweeps_.find(deviceID);
+  if (sweep == sweeps_.end()) {
+    return X6_MODE_ERROR;
+  }
+  *pointSize = sweep->second->get_point_size();
+  return X6_OK;
+}
+
 X6_STATUS get_is_running(int deviceID, int* isRunning) {
   return x6_getter(deviceID, &X6_1000::get_is_running, isRunning);
 }
@@ -366,6 +739,18 @@ X6_STATUS get_data_available(int deviceID, bool* dataAvailable) {
   return x6_getter(deviceID, &X6_1000::get_data_available, dataAvailable);
 }
 
+X6_STATUS get_data_fd(int deviceID, int32_t* fd) {
+  return x6_getter(deviceID, &X6_1000::get_data_fd, fd);
+}
+
+X6_STATUS set_notification_threshold(int deviceID, unsigned numRecords) {
+  return x6_call(deviceID, &X6_1000::set_notification_threshold, numRecords);
+}
+
+X6_STATUS register_data_callback(int deviceID, X6_DATA_CALLBACK callback, void* userData) {
+  return x6_call(deviceID, &X6_1000::register_data_callback, callback, userData);
+}
+
 X6_STATUS stop(int deviceID) {
   return x6_call(deviceID, &X6_1000::stop);
 }
@@ -375,6 +760,80 @@ X6_STATUS register_socket(int deviceID, ChannelTuple *channel, int32_t socket) {
   return x6_call(deviceID, &X6_1000::register_socket, stream, socket);
 }
 
+X6_STATUS set_socket_metadata(int deviceID, bool enable) {
+  return x6_call(deviceID, &X6_1000::set_socket_metadata, enable);
+}
+
+X6_STATUS register_record_consumer(int deviceID, ChannelTuple *channel, X6_RECORD_CONSUMER consumer, void* context) {
+  QDSPStream stream(channel->a, channel->b, channel->c);
+  return x6_call(deviceID, &X6_1000::register_record_consumer, stream, consumer, context);
+}
+
+X6_STATUS unregister_record_consumers(int deviceID) {
+  return x6_call(deviceID, &X6_1000::unregister_record_consumers);
+}
+
+X6_STATUS set_record_consumer_dispatch(int deviceID, X6_CONSUMER_DISPATCH dispatch) {
+  return x6_call(deviceID, &X6_1000::set_record_consumer_dispatch, dispatch);
+}
+
+X6_STATUS transfer_stream_metadata(int deviceID, ChannelTuple *channel, RecordMetadata* buffer, unsigned numRecords) {
+  QDSPStream stream(channel->a, channel->b, channel->c);
+  return x6_call(deviceID, &X6_1000::transfer_stream_metadata, stream, buffer, numRecords);
+}
+
+X6_STATUS get_metadata_buffer_size(int deviceID, ChannelTuple *channel, unsigned* numRecords) {
+  QDSPStream stream(channel->a, channel->b, channel->c);
+  return x6_getter(deviceID, &X6_1000::get_metadata_buffer_size, numRecords, stream);
+}
+
+X6_STATUS get_sequence_stats(int deviceID, ChannelTuple *channel, SequenceStats* stats) {
+  QDSPStream stream(channel->a, channel->b, channel->c);
+  return x6_getter(deviceID, &X6_1000::get_sequence_stats, stats, stream);
+}
+
+X6_STATUS set_abort_on_packet_loss(int deviceID, bool abort) {
+  return x6_call(deviceID, &X6_1000::set_abort_on_packet_loss, abort);
+}
+
+X6_STATUS set_pipeline_depth(int deviceID, unsigned depth) {
+  return x6_call(deviceID, &X6_1000::set_pipeline_depth, depth);
+}
+
+X6_STATUS get_pipeline_stats(int deviceID, X6_PIPELINE_STAGE stage, PipelineStats* stats) {
+  return x6_getter(deviceID, &X6_1000::get_pipeline_stats, stats, stage);
+}
+
+X6_STATUS get_buffer_pool_stats(int deviceID, BufferPoolStats* stats) {
+  return x6_getter(deviceID, &X6_1000::get_buffer_pool_stats, stats);
+}
+
+X6_STATUS set_thread_affinity(int deviceID, X6_THREAD_ROLE role, uint64_t cpuMask) {
+  return x6_call(deviceID, &X6_1000::set_thread_affinity, role, cpuMask);
+}
+
+X6_STATUS set_thread_priority(int deviceID, X6_THREAD_ROLE role, int priority) {
+  return x6_call(deviceID, &X6_1000::set_thread_priority, role, priority);
+}
+
+X6_STATUS get_thread_settings(int deviceID, X6_THREAD_ROLE role, ThreadSettings* settings) {
+  return x6_getter(deviceID, &X6_1000::get_thread_settings, settings, role);
+}
+
+X6_STATUS set_huge_page_mode(X6_HUGEPAGE_MODE mode) {
+  // library-wide, as the buffers come from one allocator
+  if (mode < HUGEPAGE_NONE || mode > HUGEPAGE_EXPLICIT) {
+    return X6_INVALID_ARGUMENT;
+  }
+  MemoryPolicy::set_mode(mode);
+  return X6_OK;
+}
+
+X6_STATUS get_memory_stats(MemoryStats* stats) {
+  *stats = MemoryPolicy::get_stats();
+  return X6_OK;
+}
+
 X6_STATUS transfer_stream(int deviceID, ChannelTuple *channelTuples, unsigned numChannels, double* buffer, unsigned bufferLength) {
   // when passed a single ChannelTuple, fills buffer with the corresponding waveform data
   // when passed multple ChannelTuples, fills buffer with the corresponding correlation data
@@ -432,13 +891,28 @@ EXPORT X6_STATUS read_pulse_waveform(int deviceID, unsigned pg, unsigned addr, d
   return x6_getter(deviceID, &X6_1000::read_pulse_waveform, val, pg, addr);
 }
 
+EXPORT X6_STATUS add_pulse_waveform(int deviceID, unsigned pg, const char* name, double* wf, unsigned numPoints) {
+  vector<double> wfVec(wf, wf+numPoints);
+  return x6_call(deviceID, &X6_1000::add_pulse_waveform, pg, string(name), wfVec);
+}
+
+EXPORT X6_STATUS select_pulse_waveform(int deviceID, unsigned pg, const char* name) {
+  return x6_call(deviceID, &X6_1000::select_pulse_waveform, pg, string(name));
+}
+
+EXPORT X6_STATUS remove_pulse_waveform(int deviceID, unsigned pg, const char* name) {
+  return x6_call(deviceID, &X6_1000::remove_pulse_waveform, pg, string(name));
+}
+
 X6_STATUS set_file_logging_level(plog::Severity severity) {
   plog::get<FILE_PLOG>()->setMaxSeverity(severity);
+  update_default_logging_level();
   return X6_OK;
 }
 
 X6_STATUS set_console_logging_level(plog::Severity severity) {
   plog::get<CONSOLE_PLOG>()->setMaxSeverity(severity);
+  update_default_logging_level();
   return X6_OK;
 }
 
@@ -450,6 +924,33 @@ X6_STATUS write_register(int deviceID, uint32_t wbAddr, uint32_t offset, uint32_
   return x6_call(deviceID, &X6_1000::write_wishbone_register, wbAddr, offset, data);
 }
 
+X6_STATUS write_registers(int deviceID, uint32_t wbAddr, uint32_t* offsets, uint32_t* data, unsigned numRegisters) {
+  // all the writes go out in one pass over the bus
+  RegisterBatch batch;
+  batch.reserve(numRegisters);
+  for (unsigned i = 0; i < numRegisters; i++) {
+    batch.write(wbAddr, offsets[i], data[i]);
+  }
+  return x6_call(deviceID, &X6_1000::execute_register_batch, batch);
+}
+
+X6_STATUS read_registers(int deviceID, uint32_t wbAddr, uint32_t* offsets, uint32_t* data, unsigned numRegisters) {
+  RegisterBatch batch;
+  batch.reserve(numRegisters);
+  for (unsigned i = 0; i < numRegisters; i++) {
+    batch.read(wbAddr, offsets[i], data + i);
+  }
+  return x6_call(deviceID, &X6_1000::execute_register_batch, batch);
+}
+
+X6_STATUS verify_register_shadow(int deviceID, int a, unsigned* mismatches) {
+  return x6_getter(deviceID, &X6_1000::verify_register_shadow, mismatches, a);
+}
+
+X6_STATUS resync_register_shadow(int deviceID) {
+  return x6_call(deviceID, &X6_1000::resync_register_shadow);
+}
+
 X6_STATUS get_logic_temperature(int deviceID, float* temp) {
   return x6_getter(deviceID, &X6_1000::get_logic_temperature, temp);
 }
@@ -33,8 +33,25 @@ extern "C" {
 typedef enum X6_STATUS X6_STATUS;
 typedef enum X6_REFERENCE_SOURCE X6_REFERENCE_SOURCE;
 typedef struct ChannelTuple ChannelTuple;
+typedef struct RecordMetadata RecordMetadata;
+typedef struct SequenceStats SequenceStats;
+typedef struct PipelineStats PipelineStats;
+typedef struct BufferPoolStats BufferPoolStats;
+typedef struct ThreadSettings ThreadSettings;
+typedef struct MemoryStats MemoryStats;
+typedef struct RecordBatchView RecordBatchView;
 typedef enum X6_TRIGGER_SOURCE X6_TRIGGER_SOURCE;
 typedef enum X6_DIGITIZER_MODE X6_DIGITIZER_MODE;
+typedef enum X6_PIPELINE_STAGE X6_PIPELINE_STAGE;
+typedef enum X6_THREAD_ROLE X6_THREAD_ROLE;
+typedef enum X6_HUGEPAGE_MODE X6_HUGEPAGE_MODE;
+typedef enum X6_CONSUMER_DISPATCH X6_CONSUMER_DISPATCH;
+typedef enum X6_DISCRIMINATOR_KIND X6_DISCRIMINATOR_KIND;
+typedef enum X6_SPECTRUM_WINDOW X6_SPECTRUM_WINDOW;
+typedef enum X6_SHOT_ALIGNMENT X6_SHOT_ALIGNMENT;
+typedef enum X6_SWEEP_PARAMETER X6_SWEEP_PARAMETER;
+typedef struct SweepChange SweepChange;
+typedef struct UploadStats UploadStats;
 
 EXPORT const char* get_error_msg(X6_STATUS);
 
@@ -48,6 +65,9 @@ EXPORT X6_STATUS get_reference_source(int, X6_REFERENCE_SOURCE*);
 
 EXPORT X6_STATUS set_digitizer_mode(int, X6_DIGITIZER_MODE);
 EXPORT X6_STATUS get_digitizer_mode(int, X6_DIGITIZER_MODE*);
+// window applied to raw and demod records in SPECTRUM mode
+EXPORT X6_STATUS set_spectrum_window(int, X6_SPECTRUM_WINDOW);
+EXPORT X6_STATUS get_spectrum_window(int, X6_SPECTRUM_WINDOW*);
 
 EXPORT X6_STATUS set_input_channel_enable(int, unsigned, bool);
 EXPORT X6_STATUS get_input_channel_enable(int, unsigned, bool*);
@@ -77,8 +97,23 @@ EXPORT X6_STATUS get_threshold_input_sel(int, int, int, bool*);
 // we use double* becuase of poor C99 complex support in Visual C and Matlab
 EXPORT X6_STATUS write_kernel(int, unsigned, unsigned, unsigned, double*, unsigned);
 EXPORT X6_STATUS read_kernel(int, unsigned, unsigned, unsigned, unsigned, double*);
+EXPORT X6_STATUS read_kernels(int, unsigned, unsigned, unsigned, double*, unsigned);
+// kernel and pulse waveform uploads the card already holds are skipped unless forced
+EXPORT X6_STATUS set_force_uploads(int, bool);
+EXPORT X6_STATUS get_force_uploads(int, bool*);
+EXPORT X6_STATUS get_kernel_upload_stats(int, UploadStats*);
+EXPORT X6_STATUS get_waveform_upload_stats(int, UploadStats*);
 EXPORT X6_STATUS set_kernel_bias(int, unsigned, unsigned, unsigned, double*);
 EXPORT X6_STATUS get_kernel_bias(int, unsigned, unsigned, unsigned, double*);
+// host DSP channels (a, 8-15, c); a null filter selects the default low-pass
+EXPORT X6_STATUS set_host_decimation(int, unsigned, unsigned, unsigned, double*, unsigned);
+EXPORT X6_STATUS set_host_dsp_threads(int, unsigned);
+// numKernels complex kernels of equal length scored together on demod stream (a,b,0)
+EXPORT X6_STATUS set_kernel_bank(int, unsigned, unsigned, double*, unsigned, unsigned);
+// host discriminator d classifies result streams into state stream (0,d,0)
+EXPORT X6_STATUS set_discriminator(int, unsigned, ChannelTuple*, unsigned, X6_DISCRIMINATOR_KIND, unsigned, double*, unsigned);
+EXPORT X6_STATUS get_discriminator_counts_size(int, unsigned, unsigned*);
+EXPORT X6_STATUS transfer_discriminator_counts(int, unsigned, uint64_t*, unsigned);
 
 EXPORT X6_STATUS get_correlator_size(int, int, uint32_t*);
 EXPORT X6_STATUS write_correlator_matrix(int, unsigned, double*, unsigned);
@@ -87,13 +122,60 @@ EXPORT X6_STATUS set_correlator_input(int, int, int, int);
 EXPORT X6_STATUS get_correlator_input(int, int, int, uint32_t*);
 
 EXPORT X6_STATUS acquire(int);
+EXPORT X6_STATUS set_fast_rearm(int, bool);
+EXPORT X6_STATUS get_fast_rearm(int, bool*);
+EXPORT X6_STATUS set_double_buffering(int, bool);
+EXPORT X6_STATUS get_double_buffering(int, bool*);
+EXPORT X6_STATUS get_num_ready_banks(int, unsigned*);
+EXPORT X6_STATUS release_bank(int);
 EXPORT X6_STATUS wait_for_acquisition(int, unsigned);
 EXPORT X6_STATUS get_is_running(int, int*);
 EXPORT X6_STATUS get_num_new_records(int, unsigned*);
 EXPORT X6_STATUS get_data_available(int, bool*);
+EXPORT X6_STATUS get_data_fd(int, int32_t*);
+EXPORT X6_STATUS set_notification_threshold(int, unsigned);
+EXPORT X6_STATUS register_data_callback(int, X6_DATA_CALLBACK, void*);
 EXPORT X6_STATUS stop(int);
+
+// several boards armed, waited on and transferred together
+EXPORT X6_STATUS create_board_group(int*, unsigned, int*);
+EXPORT X6_STATUS destroy_board_group(int);
+EXPORT X6_STATUS group_acquire(int);
+EXPORT X6_STATUS group_wait_for_acquisition(int, unsigned);
+EXPORT X6_STATUS group_stop(int);
+EXPORT X6_STATUS get_group_size(int, unsigned*);
+EXPORT X6_STATUS group_get_buffer_sizes(int, ChannelTuple*, unsigned, unsigned*);
+EXPORT X6_STATUS group_transfer_stream(int, ChannelTuple*, unsigned, double*, unsigned*);
+// correlators of result streams on different boards of a group
+EXPORT X6_STATUS group_add_correlator(int, int*, ChannelTuple*, unsigned, X6_SHOT_ALIGNMENT, uint64_t, unsigned*);
+EXPORT X6_STATUS group_get_correlator_size(int, unsigned, unsigned*);
+EXPORT X6_STATUS group_transfer_correlation(int, unsigned, double*, unsigned);
+EXPORT X6_STATUS group_transfer_correlation_variance(int, unsigned, double*, unsigned);
+// parameter sweeps run on a library thread, one per board at a time
+EXPORT X6_STATUS start_sweep(int, SweepChange*, unsigned, double*, unsigned*, unsigned,
+                             ChannelTuple*, unsigned, unsigned, double*, unsigned, unsigned);
+EXPORT X6_STATUS wait_for_sweep(int, unsigned);
+EXPORT X6_STATUS stop_sweep(int);
+EXPORT X6_STATUS get_sweep_progress(int, unsigned*);
+EXPORT X6_STATUS get_sweep_point_size(int, unsigned*);
 EXPORT X6_STATUS register_socket(int, ChannelTuple*, int32_t);
+EXPORT X6_STATUS set_socket_metadata(int, bool);
+EXPORT X6_STATUS register_record_consumer(int, ChannelTuple*, X6_RECORD_CONSUMER, void*);
+EXPORT X6_STATUS unregister_record_consumers(int);
+EXPORT X6_STATUS set_record_consumer_dispatch(int, X6_CONSUMER_DISPATCH);
 EXPORT X6_STATUS transfer_stream(int, ChannelTuple*, unsigned, double*, unsigned);
+EXPORT X6_STATUS transfer_stream_metadata(int, ChannelTuple*, RecordMetadata*, unsigned);
+EXPORT X6_STATUS get_metadata_buffer_size(int, ChannelTuple*, unsigned*);
+EXPORT X6_STATUS get_sequence_stats(int, ChannelTuple*, SequenceStats*);
+EXPORT X6_STATUS set_abort_on_packet_loss(int, bool);
+EXPORT X6_STATUS set_pipeline_depth(int, unsigned);
+EXPORT X6_STATUS get_pipeline_stats(int, X6_PIPELINE_STAGE, PipelineStats*);
+EXPORT X6_STATUS get_buffer_pool_stats(int, BufferPoolStats*);
+EXPORT X6_STATUS set_thread_affinity(int, X6_THREAD_ROLE, uint64_t);
+EXPORT X6_STATUS set_thread_priority(int, X6_THREAD_ROLE, int);
+EXPORT X6_STATUS get_thread_settings(int, X6_THREAD_ROLE, ThreadSettings*);
+EXPORT X6_STATUS set_huge_page_mode(X6_HUGEPAGE_MODE);
+EXPORT X6_STATUS get_memory_stats(MemoryStats*);
 EXPORT X6_STATUS transfer_variance(int, ChannelTuple*, unsigned, double*, unsigned);
 EXPORT X6_STATUS get_buffer_size(int, ChannelTuple*, unsigned, unsigned*);
 EXPORT X6_STATUS get_record_length(int, ChannelTuple*, unsigned*);
@@ -111,10 +193,18 @@ EXPORT X6_STATUS get_sampleRate(int, double*);
 /* Pulse generator methods */
 EXPORT X6_STATUS write_pulse_waveform(int, unsigned, double*, unsigned);
 EXPORT X6_STATUS read_pulse_waveform(int, unsigned, unsigned, double*);
+// named waveforms kept by the driver, uploaded when selected
+EXPORT X6_STATUS add_pulse_waveform(int, unsigned, const char*, double*, unsigned);
+EXPORT X6_STATUS select_pulse_waveform(int, unsigned, const char*);
+EXPORT X6_STATUS remove_pulse_waveform(int, unsigned, const char*);
 
 /* debug methods */
 EXPORT X6_STATUS read_register(int, uint32_t, uint32_t, uint32_t*);
 EXPORT X6_STATUS write_register(int, uint32_t, uint32_t, uint32_t);
+EXPORT X6_STATUS read_registers(int, uint32_t, uint32_t*, uint32_t*, unsigned);
+EXPORT X6_STATUS write_registers(int, uint32_t, uint32_t*, uint32_t*, unsigned);
+EXPORT X6_STATUS verify_register_shadow(int, int, unsigned*);
+EXPORT X6_STATUS resync_register_shadow(int);
 
 // II X6-1000M Test Interface
 EXPORT X6_STATUS get_logic_temperature(int, float*);
@@ -0,0 +1,26 @@
+// logging.h
+//
+// Logging macros for the acquisition hot paths. X6_LOG and X6_IF_LOG behave
+// like plog's LOG and IF_LOG, except that statements less severe than
+// X6_LOG_MAX_SEVERITY are removed at compile time, including the formatting
+// of their arguments. Set the limit with the X6_LOG_MAX_SEVERITY CMake cache
+// variable using plog's numbering: 0 none, 1 fatal, 2 error, 3 warning,
+// 4 info, 5 debug, 6 verbose (the default, keeping everything).
+//
+// Original authors: Colm Ryan and Blake Johnson
+//
+// Copyright 2015, Raytheon BBN Technologies
+
+#ifndef X6_LOGGING_H_
+#define X6_LOGGING_H_
+
+#include <plog/Log.h>
+
+#ifndef X6_LOG_MAX_SEVERITY
+#define X6_LOG_MAX_SEVERITY 6
+#endif
+
+#define X6_IF_LOG(severity) if ((severity) > X6_LOG_MAX_SEVERITY) {;} else IF_LOG(severity)
+#define X6_LOG(severity) X6_IF_LOG(severity) LOG(severity)
+
+#endif // X6_LOGGING_H_
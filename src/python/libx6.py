@@ -28,12 +28,13 @@ import platform
 import warnings
 import numpy as np
 import numpy.ctypeslib as npct
-from ctypes import c_int32, c_uint32, c_float, c_double, c_char_p, c_bool, create_string_buffer, byref, POINTER, Structure, CDLL
+from ctypes import c_int32, c_uint32, c_uint64, c_float, c_double, c_char, c_char_p, c_bool, c_void_p, create_string_buffer, byref, POINTER, Structure, CDLL, CFUNCTYPE
 from ctypes.util import find_library
 from enum import IntEnum
 
 np_double = npct.ndpointer(dtype=np.double, ndim=1, flags='CONTIGUOUS')
 np_complex = npct.ndpointer(dtype=np.complex128, ndim=1, flags='CONTIGUOUS')
+np_uint32 = npct.ndpointer(dtype=np.uint32, ndim=1, flags='CONTIGUOUS')
 
 # load the shared library
 # try with and without "lib" prefix
@@ -54,6 +55,120 @@ class Channel(Structure):
                 ("b", c_int32),
                 ("c", c_int32)]
 
+# matches the layout of RecordMetadata in X6_enums.h
+metadata_dtype = np.dtype([("record_index", np.uint64),
+                           ("timestamp_fractional", np.uint64),
+                           ("timestamp_seconds", np.uint32),
+                           ("packet_count", np.uint32),
+                           ("segment", np.uint32),
+                           ("stream_id", np.uint32)])
+np_metadata = npct.ndpointer(dtype=metadata_dtype, ndim=1, flags='CONTIGUOUS')
+
+class SequenceStats(Structure):
+    _fields_ = [("packets", c_uint64),
+                ("gaps", c_uint64),
+                ("lost_packets", c_uint64),
+                ("duplicates", c_uint64),
+                ("out_of_order", c_uint64)]
+
+class PipelineStats(Structure):
+    _fields_ = [("depth", c_uint64),
+                ("high_water", c_uint64),
+                ("capacity", c_uint64),
+                ("processed", c_uint64),
+                ("stalls", c_uint64)]
+
+# (device_id, num_records, done, user_data)
+DataCallback = CFUNCTYPE(None, c_int32, c_uint32, c_int32, c_void_p)
+
+class RecordBatchView(Structure):
+    _fields_ = [("stream_id", c_uint32),
+                ("num_records", c_uint32),
+                ("record_length", c_uint32),
+                ("sample_bytes", c_uint32),
+                ("scale", c_double),
+                ("records", POINTER(c_void_p)),
+                ("metadata", c_void_p)]
+
+# (device_id, batch, context)
+RecordConsumer = CFUNCTYPE(None, c_int32, POINTER(RecordBatchView), c_void_p)
+
+class BufferPoolStats(Structure):
+    _fields_ = [("capacity", c_uint64),
+                ("in_use", c_uint64),
+                ("high_water", c_uint64),
+                ("allocations", c_uint64),
+                ("acquisitions", c_uint64)]
+
+class SweepChange(Structure):
+    _fields_ = [("point", c_uint32),
+                ("parameter", c_int32),
+                ("a", c_int32),
+                ("b", c_int32),
+                ("c", c_int32),
+                ("value", c_double),
+                ("imag", c_double)]
+
+class UploadStats(Structure):
+    _fields_ = [("uploads", c_uint64),
+                ("skips", c_uint64)]
+
+class ThreadSettings(Structure):
+    _fields_ = [("requested_cpus", c_uint64),
+                ("effective_cpus", c_uint64),
+                ("requested_priority", c_int32),
+                ("effective_priority", c_int32),
+                ("applied", c_int32)]
+
+class MemoryStats(Structure):
+    _fields_ = [("bytes_in_use", c_uint64),
+                ("peak_bytes", c_uint64),
+                ("huge_page_bytes", c_uint64),
+                ("allocations", c_uint64),
+                ("fallbacks", c_uint64)]
+
+class HugePageMode(IntEnum):
+    none = 0
+    transparent = 1
+    explicit = 2
+
+class ThreadRole(IntEnum):
+    receive = 0
+    parse = 1
+    process = 2
+    consumer = 3
+
+class PipelineStage(IntEnum):
+    receive = 0
+    parse = 1
+    process = 2
+    consume = 3
+
+class ConsumerDispatch(IntEnum):
+    inline = 0
+    thread = 1
+
+class DiscriminatorKind(IntEnum):
+    nearest_centroid = 0
+    linear = 1
+    gaussian = 2
+
+class SpectrumWindow(IntEnum):
+    rectangular = 0
+    hann = 1
+    blackman_harris = 2
+
+class ShotAlignment(IntEnum):
+    record_index = 0
+    timestamp = 1
+
+class SweepParameter(IntEnum):
+    nco_frequency = 0
+    threshold = 1
+    kernel_bias = 2
+    pulse_waveform = 3
+    wishbone_register = 4
+
 class PlogSeverity(IntEnum):
     none = 0
     fatal = 1
@@ -77,7 +192,7 @@ EXTERNAL = 0
 INTERNAL = 1
 
 # digitizer mode
-mode_dict = {0: "digitizer", 1: "averager"}
+mode_dict = {0: "digitizer", 1: "averager", 2: "spectrum"}
 mode_dict_inv = {v:k for k,v in mode_dict.items()}
 DIGITIZER = 0
 AVERAGER = 1
@@ -94,12 +209,18 @@ libx6.get_firmware_version.argtypes    = [c_int32] + [POINTER(c_uint32)]*3 + [c_
 
 libx6.read_register.argtypes           = [c_int32, c_uint32, c_uint32, POINTER(c_uint32)]
 libx6.write_register.argtypes          = [c_int32, c_uint32, c_uint32, c_uint32]
+libx6.read_registers.argtypes          = [c_int32, c_uint32, np_uint32, np_uint32, c_uint32]
+libx6.write_registers.argtypes         = [c_int32, c_uint32, np_uint32, np_uint32, c_uint32]
+libx6.verify_register_shadow.argtypes  = [c_int32, c_int32, POINTER(c_uint32)]
+libx6.resync_register_shadow.argtypes  = [c_int32]
 
 # these take an enum argument, which we will pretend is just a c_uint32
 libx6.set_reference_source.argtypes    = [c_int32, c_uint32]
 libx6.get_reference_source.argtypes    = [c_int32, POINTER(c_uint32)]
 libx6.set_digitizer_mode.argtypes      = [c_int32, c_uint32]
 libx6.get_digitizer_mode.argtypes      = [c_int32, POINTER(c_uint32)]
+libx6.set_spectrum_window.argtypes     = [c_int32, c_uint32]
+libx6.get_spectrum_window.argtypes     = [c_int32, POINTER(c_uint32)]
 
 libx6.get_number_of_integrators.argtypes  = [c_int32]*2 + [POINTER(c_int32)]
 libx6.get_number_of_demodulators.argtypes = [c_int32]*2 + [POINTER(c_int32)]
@@ -123,8 +244,21 @@ libx6.get_threshold_input_sel.argtypes = [c_int32]*3 + [POINTER(c_bool)]
 
 libx6.write_kernel.argtypes            = [c_int32] + [c_uint32]*3 + [np_complex, c_uint32]
 libx6.read_kernel.argtypes             = [c_int32] + [c_uint32]*4 + [np_complex]
+libx6.read_kernels.argtypes            = [c_int32] + [c_uint32]*3 + [np_complex, c_uint32]
+libx6.set_force_uploads.argtypes       = [c_int32, c_bool]
+libx6.get_force_uploads.argtypes       = [c_int32, POINTER(c_bool)]
+libx6.get_kernel_upload_stats.argtypes = [c_int32, POINTER(UploadStats)]
+libx6.get_waveform_upload_stats.argtypes = [c_int32, POINTER(UploadStats)]
 libx6.set_kernel_bias.argtypes         = [c_int32] + [c_uint32]*3 + [np_complex]
 libx6.get_kernel_bias.argtypes         = [c_int32] + [c_uint32]*3 + [np_complex]
+libx6.set_host_decimation.argtypes     = [c_int32] + [c_uint32]*3 + [np_double, c_uint32]
+libx6.set_host_dsp_threads.argtypes    = [c_int32, c_uint32]
+libx6.set_kernel_bank.argtypes         = [c_int32] + [c_uint32]*2 + [np_complex] + [c_uint32]*2
+libx6.set_discriminator.argtypes       = [c_int32, c_uint32, POINTER(Channel), c_uint32, c_int32, c_uint32,
+                                          np_double, c_uint32]
+libx6.get_discriminator_counts_size.argtypes = [c_int32, c_uint32, POINTER(c_uint32)]
+libx6.transfer_discriminator_counts.argtypes = [c_int32, c_uint32,
+                                          npct.ndpointer(dtype=np.uint64, ndim=1, flags='CONTIGUOUS'), c_uint32]
 
 libx6.get_correlator_size.argtypes     = [c_int32]*2 + [POINTER(c_uint32)]
 libx6.write_correlator_matrix.argtypes = [c_int32, c_int32] + [np_double, c_uint32]
@@ -133,12 +267,58 @@ libx6.set_correlator_input.argytpes    = [c_int32, c_int32, c_uint32, c_uint32]
 libx6.get_correlator_input.argtypes    = [c_int32]*3 + [POINTER(c_uint32)]
 
 libx6.acquire.argtypes                 = [c_int32]
+libx6.set_fast_rearm.argtypes          = [c_int32, c_bool]
+libx6.get_fast_rearm.argtypes          = [c_int32, POINTER(c_bool)]
+libx6.set_double_buffering.argtypes    = [c_int32, c_bool]
+libx6.get_double_buffering.argtypes    = [c_int32, POINTER(c_bool)]
+libx6.get_num_ready_banks.argtypes     = [c_int32, POINTER(c_uint32)]
+libx6.release_bank.argtypes            = [c_int32]
 libx6.wait_for_acquisition.argtypes    = [c_int32, c_uint32]
 libx6.get_is_running.argtypes          = [c_int32, POINTER(c_bool)]
 libx6.get_num_new_records.argtypes     = [c_int32, POINTER(c_uint32)]
 libx6.get_data_available.argtypes      = [c_int32, POINTER(c_bool)]
+libx6.get_data_fd.argtypes             = [c_int32, POINTER(c_int32)]
+libx6.set_notification_threshold.argtypes = [c_int32, c_uint32]
+libx6.register_data_callback.argtypes  = [c_int32, DataCallback, c_void_p]
 libx6.stop.argtypes                    = [c_int32]
+libx6.create_board_group.argtypes      = [c_int32, c_uint32, POINTER(c_int32)]
+libx6.destroy_board_group.argtypes     = [c_int32]
+libx6.group_acquire.argtypes           = [c_int32]
+libx6.group_wait_for_acquisition.argtypes = [c_int32, c_uint32]
+libx6.group_stop.argtypes              = [c_int32]
+libx6.get_group_size.argtypes          = [c_int32, POINTER(c_uint32)]
+libx6.group_get_buffer_sizes.argtypes  = [c_int32, POINTER(Channel), c_uint32, POINTER(c_uint32)]
+libx6.group_transfer_stream.argtypes   = [c_int32, POINTER(Channel), c_uint32, np_double, POINTER(c_uint32)]
+libx6.group_add_correlator.argtypes    = [c_int32, POINTER(c_int32), POINTER(Channel), c_uint32, c_int32, c_uint64,
+                                          POINTER(c_uint32)]
+libx6.group_get_correlator_size.argtypes = [c_int32, c_uint32, POINTER(c_uint32)]
+libx6.group_transfer_correlation.argtypes = [c_int32, c_uint32, np_double, c_uint32]
+libx6.group_transfer_correlation_variance.argtypes = [c_int32, c_uint32, np_double, c_uint32]
+libx6.start_sweep.argtypes             = [c_int32, POINTER(SweepChange), c_uint32, np_double, POINTER(c_uint32),
+                                          c_uint32, POINTER(Channel), c_uint32, c_uint32, np_double, c_uint32,
+                                          c_uint32]
+libx6.wait_for_sweep.argtypes          = [c_int32, c_uint32]
+libx6.stop_sweep.argtypes              = [c_int32]
+libx6.get_sweep_progress.argtypes      = [c_int32, POINTER(c_uint32)]
+libx6.get_sweep_point_size.argtypes    = [c_int32, POINTER(c_uint32)]
+libx6.add_pulse_waveform.argtypes      = [c_int32, c_uint32, c_char_p, np_double, c_uint32]
+libx6.select_pulse_waveform.argtypes   = [c_int32, c_uint32, c_char_p]
+libx6.remove_pulse_waveform.argtypes   = [c_int32, c_uint32, c_char_p]
 libx6.register_socket.argtypes         = [c_int32, POINTER(Channel), c_int32]
+libx6.set_socket_metadata.argtypes     = [c_int32, c_bool]
+libx6.register_record_consumer.argtypes = [c_int32, POINTER(Channel), RecordConsumer, c_void_p]
+libx6.unregister_record_consumers.argtypes = [c_int32]
+libx6.set_record_consumer_dispatch.argtypes = [c_int32, c_int32]
+libx6.transfer_stream_metadata.argtypes = [c_int32, POINTER(Channel), np_metadata, c_uint32]
+libx6.get_metadata_buffer_size.argtypes = [c_int32, POINTER(Channel), POINTER(c_uint32)]
+libx6.get_sequence_stats.argtypes      = [c_int32, POINTER(Channel), POINTER(SequenceStats)]
+libx6.set_abort_on_packet_loss.argtypes = [c_int32, c_bool]
+libx6.set_pipeline_depth.argtypes      = [c_int32, c_uint32]
+libx6.get_pipeline_stats.argtypes      = [c_int32, c_int32, POINTER(PipelineStats)]
+libx6.get_buffer_pool_stats.argtypes   = [c_int32, POINTER(BufferPoolStats)]
+libx6.set_thread_affinity.argtypes     = [c_int32, c_int32, c_uint64]
+libx6.set_thread_priority.argtypes     = [c_int32, c_int32, c_int32]
+libx6.get_thread_settings.argtypes     = [c_int32, c_int32, POINTER(ThreadSettings)]
 libx6.transfer_stream.argtypes         = [c_int32, POINTER(Channel), c_uint32,
                                           np_double, c_int32]
 libx6.transfer_variance.argtypes       = [c_int32, POINTER(Channel), c_uint32,
@@ -154,6 +334,9 @@ libx6.set_console_logging_level.restype    = c_int32
 
 libx6.get_logic_temperature.argtypes   = [c_int32, POINTER(c_float)]
 
+libx6.set_huge_page_mode.argtypes      = [c_int32]
+libx6.get_memory_stats.argtypes        = [POINTER(MemoryStats)]
+
 # uniform restype = c_int32, so add it all at once
 attributes = [a for a in dir(libx6) if not a.startswith('_')]
 for a in attributes:
@@ -191,6 +374,18 @@ def set_console_logging_level(level):
     assert isinstance(level, PlogSeverity), "Please use a PlogSeverity enum to set log severity."
     check(libx6.set_console_logging_level(level))
 
+def set_huge_page_mode(mode):
+    """
+    Back accumulator and record queue buffers allocated at the next acquire()
+    with huge pages (HugePageMode). Applies to every board.
+    """
+    check(libx6.set_huge_page_mode(int(mode)))
+
+def get_memory_stats():
+    stats = MemoryStats()
+    check(libx6.get_memory_stats(byref(stats)))
+    return {name: getattr(stats, name) for name, _ in stats._fields_}
+
 def enumerate_boards():
     return [f"X6-{n}" for n in range(int(get_num_devices()))]
 
@@ -202,6 +397,9 @@ class X6(object):
         self.nbr_waveforms = 1
         self.nbr_segments = 1
         self.nbr_round_robins = 1
+        self._data_callback = None
+        self._record_consumers = {}
+        self._sweep_results = None
 
     def __del__(self):
         try:
@@ -274,6 +472,18 @@ class X6(object):
 
     acquire_mode = property(get_acquire_mode, set_acquire_mode)
 
+    def set_spectrum_window(self, window):
+        """
+        Window applied to raw and demod records in spectrum mode, from the
+        next acquire.
+        """
+        self.x6_call("set_spectrum_window", SpectrumWindow(window))
+
+    def get_spectrum_window(self):
+        return SpectrumWindow(self.x6_getter("get_spectrum_window"))
+
+    spectrum_window = property(get_spectrum_window, set_spectrum_window)
+
     def get_number_of_integrators(self, a):
         return self.x6_getter("get_number_of_integrators", a)
 
@@ -336,6 +546,39 @@ class X6(object):
         self.x6_call("read_kernel", a, b, c, offset, point)
         return point[0]
 
+    def read_kernels(self, a, b, c, length):
+        """
+        The first length points of the kernel of stream (a, b, c), read back
+        in one call.
+        """
+        kernel = np.zeros(length, dtype=np.complex128)
+        self.x6_call("read_kernels", a, b, c, kernel, length)
+        return kernel
+
+    def set_force_uploads(self, force):
+        """
+        Write every kernel and pulse waveform to the card, even content it
+        already holds.
+        """
+        self.x6_call("set_force_uploads", force)
+
+    def get_force_uploads(self):
+        return self.x6_getter("get_force_uploads")
+
+    force_uploads = property(get_force_uploads, set_force_uploads)
+
+    def get_upload_stats(self):
+        """
+        Kernel and pulse waveform uploads written and skipped as a dict of
+        dicts of uploads and skips.
+        """
+        result = {}
+        for kind in ("kernel", "waveform"):
+            stats = UploadStats()
+            self.x6_call("get_{}_upload_stats".format(kind), byref(stats))
+            result[kind] = {name: getattr(stats, name) for name, _ in stats._fields_}
+        return result
+
     def set_kernel_bias(self, a, b, c, bias):
         point = np.array([bias], dtype=np.complex128)
         self.x6_call("set_kernel_bias", a, b, c, point)
@@ -345,6 +588,31 @@ class X6(object):
         self.x6_call("get_kernel_bias", a, b, c, point)
         return point[0]
 
+    def set_host_decimation(self, a, b, factor, taps=None):
+        """
+        Decimation and low-pass filter of host DSP channel (a, b) with b in
+        8-15. Without taps a windowed-sinc filter matched to the factor is used.
+        """
+        taps = np.zeros(0) if taps is None else np.ascontiguousarray(taps, dtype=np.double)
+        self.x6_call("set_host_decimation", a, b, factor, taps, len(taps))
+
+    def set_host_dsp_threads(self, num_threads):
+        """
+        Threads, including the process thread, sharing the host DSP channels
+        of each raw record. Set before acquire().
+        """
+        self.x6_call("set_host_dsp_threads", num_threads)
+
+    def set_kernel_bank(self, a, b, kernels):
+        """
+        Score every row of the 2D array kernels against each record of demod
+        stream (a, b, 0). Enable stream (a, b, 15) for the results, one complex
+        value per kernel. Pass an empty array to remove the bank.
+        """
+        kernels = np.atleast_2d(np.ascontiguousarray(kernels, dtype=np.complex128))
+        self.x6_call("set_kernel_bank", a, b, kernels.ravel(),
+                     kernels.shape[0] if kernels.size else 0, kernels.shape[1])
+
     def set_averager_settings(self):
         self.x6_call("set_averager_settings",
                 self.record_length,
@@ -371,6 +639,95 @@ class X6(object):
         self.set_averager_settings()
         self.x6_call("acquire")
 
+    def set_fast_rearm(self, enable):
+        """
+        When enabled, an acquire with the same settings, streams and kernels as
+        the last one resets that acquisition's buffers in place instead of
+        rebuilding them and reconfiguring the trigger and pulse generators.
+        """
+        self.x6_call("set_fast_rearm", enable)
+
+    def get_fast_rearm(self):
+        return self.x6_getter("get_fast_rearm")
+
+    fast_rearm = property(get_fast_rearm, set_fast_rearm)
+
+    def set_double_buffering(self, enable):
+        """
+        When enabled, an acquire keeps two sets of buffers and runs
+        acquisitions back to back, filling one set while the other is read.
+        Call release_bank once done reading the filled set.
+        """
+        self.x6_call("set_double_buffering", enable)
+
+    def get_double_buffering(self):
+        return self.x6_getter("get_double_buffering")
+
+    double_buffering = property(get_double_buffering, set_double_buffering)
+
+    def get_num_ready_banks(self):
+        return self.x6_getter("get_num_ready_banks")
+
+    def release_bank(self):
+        self.x6_call("release_bank")
+
+    def start_sweep(self, changes, streams, num_points, results, waveforms=(), timeout=10):
+        """
+        Run num_points acquisitions back to back on a library thread. changes
+        is a list of (point, SweepParameter, (a, b, c), value) made before
+        the given point: an NCO frequency for channel (a, b), a threshold for
+        (a, 0, c), a complex kernel bias for (a, b, c), an index into
+        waveforms for pulse generator a, or a value for wishbone register
+        (a, b). After each point the transfer_stream data of every stream in
+        streams (a list of (a, b, c)) is written to the point's slice of
+        results, a preallocated double array. Do not use the board otherwise
+        until wait_for_sweep returns.
+        """
+        table = (SweepChange * len(changes))()
+        for ct, (point, parameter, (a, b, c), value) in enumerate(changes):
+            value = complex(value)
+            table[ct] = SweepChange(point, SweepParameter(parameter), a, b, c, value.real, value.imag)
+        channels = (Channel * len(streams))(*[Channel(*t) for t in streams])
+        lengths = (c_uint32 * len(waveforms))(*[len(wf) for wf in waveforms])
+        data = np.concatenate([np.asarray(wf, dtype=np.double) for wf in waveforms]) if len(waveforms) else np.zeros(1)
+        # the library writes into results until the sweep is over
+        self._sweep_results = results
+        self.x6_call("start_sweep", table, len(changes), data, lengths, len(waveforms),
+                     channels, len(streams), num_points, results, len(results), int(timeout))
+
+    def wait_for_sweep(self, timeout):
+        """
+        Wait for the sweep to finish and return its results with one row per
+        point.
+        """
+        self.x6_call("wait_for_sweep", int(timeout))
+        point_size = self.x6_getter("get_sweep_point_size")
+        results, self._sweep_results = self._sweep_results, None
+        if point_size == 0:
+            # stopped before the first point was done
+            return results[:0]
+        return results[:self.get_sweep_progress() * point_size].reshape(-1, point_size)
+
+    def stop_sweep(self):
+        self.x6_call("stop_sweep")
+
+    def get_sweep_progress(self):
+        return self.x6_getter("get_sweep_progress")
+
+    def add_pulse_waveform(self, pg, name, waveform):
+        """
+        Keep a waveform for pulse generator pg under a name, replacing any
+        waveform of that name; select_pulse_waveform uploads it.
+        """
+        data = np.ascontiguousarray(waveform, dtype=np.double)
+        self.x6_call("add_pulse_waveform", pg, name.encode(), data, len(data))
+
+    def select_pulse_waveform(self, pg, name):
+        self.x6_call("select_pulse_waveform", pg, name.encode())
+
+    def remove_pulse_waveform(self, pg, name):
+        self.x6_call("remove_pulse_waveform", pg, name.encode())
+
     def wait_for_acquisition(self, timeout):
         self.x6_call("wait_for_acquisition", timeout)
 
@@ -386,10 +743,74 @@ class X6(object):
     def get_is_running(self):
         return self.x6_getter("get_is_running")
 
+    def get_data_fd(self):
+        """
+        File descriptor (Linux eventfd) that becomes readable when new records
+        cross the notification threshold or the acquisition finishes. Use with
+        select/poll and read 8 bytes to clear it.
+        """
+        return self.x6_getter("get_data_fd")
+
+    def set_notification_threshold(self, num_records):
+        self.x6_call("set_notification_threshold", num_records)
+
+    def register_data_callback(self, callback):
+        """
+        Register `callback(num_records, done)` to be called from the library's
+        data thread. Keep the callback short; pass None to unregister.
+        """
+        if callback is None:
+            self._data_callback = None
+            self.x6_call("register_data_callback", DataCallback(), None)
+            return
+        def wrapper(device_id, num_records, done, user_data):
+            callback(num_records, bool(done))
+        # hold a reference so the ctypes thunk outlives the registration
+        self._data_callback = DataCallback(wrapper)
+        self.x6_call("register_data_callback", self._data_callback, None)
+
     def register_socket(self, a, b, c, sock):
         ch = Channel(a, b, c)
         return self.x6_call("register_socket", byref(ch), sock.fileno())
 
+    def register_record_consumer(self, a, b, c, callback):
+        """
+        Register `callback(records, metadata, scale)` to be handed every batch
+        of records of stream (a, b, c) from the next acquire. `records` is a
+        list of raw integer sample arrays and `metadata` a structured array,
+        both viewing library memory that is reused once the callback returns:
+        copy anything you keep. Divide samples by `scale` to get the values
+        transfer_stream returns. Pass None to unregister the stream.
+        """
+        ch = Channel(a, b, c)
+        if callback is None:
+            self._record_consumers.pop((a, b, c), None)
+            self.x6_call("register_record_consumer", byref(ch), RecordConsumer(), None)
+            return
+        def wrapper(device_id, view_ptr, context):
+            view = view_ptr.contents
+            dtype = np.int16 if view.sample_bytes == 2 else np.int32
+            nbytes = view.record_length * view.sample_bytes
+            records = [np.frombuffer((c_char * nbytes).from_address(view.records[ct]), dtype=dtype)
+                       for ct in range(view.num_records)]
+            metadata = np.frombuffer((c_char * (view.num_records * metadata_dtype.itemsize)).from_address(view.metadata),
+                                     dtype=metadata_dtype)
+            callback(records, metadata, view.scale)
+        # hold a reference so the ctypes thunk outlives the registration
+        self._record_consumers[(a, b, c)] = RecordConsumer(wrapper)
+        self.x6_call("register_record_consumer", byref(ch), self._record_consumers[(a, b, c)], None)
+
+    def unregister_record_consumers(self):
+        self.x6_call("unregister_record_consumers")
+        self._record_consumers = {}
+
+    def set_record_consumer_dispatch(self, dispatch):
+        """
+        Call record consumers on the process thread (ConsumerDispatch.inline)
+        or on a consumer thread of their own (ConsumerDispatch.thread).
+        """
+        self.x6_call("set_record_consumer_dispatch", ConsumerDispatch(dispatch))
+
     def transfer_stream(self, a, b, c):
         ch = Channel(a, b, c)
         buffer_size = self.x6_getter("get_buffer_size", byref(ch), 1)
@@ -404,13 +825,132 @@ class X6(object):
         stream = np.zeros(buffer_size, dtype=np.double)
         self.x6_call("transfer_stream", byref(ch), 1, stream, len(stream))
 
-        if b == 0 and c == 0:
-            # physical channels should be returned directly
+        if (b == 0 and c == 0) or (a != 0 and c == 0 and self.get_acquire_mode() == 'spectrum'):
+            # physical channels and power spectra should be returned directly
             return stream
         else:
             # otherwise, the data is complex and interleaved real/imag
             return stream[::2] + 1j*stream[1::2]
 
+    def set_discriminator(self, d, inputs, kind, params):
+        """
+        Classify the points of the result streams in inputs, a list of (a, b, c)
+        tuples, into the state stream (0, d, 0). params has one row per state:
+          nearest_centroid: the centroid
+          linear: the weights, then the bias
+          gaussian: the mean, the row-major covariance, then the prior
+        where the features are the real and imaginary parts of each input in
+        order. Pass params=None to remove discriminator d.
+        """
+        channels = (Channel * max(len(inputs), 1))(*[Channel(*t) for t in inputs])
+        if params is None:
+            self.x6_call("set_discriminator", d, channels, 0, int(DiscriminatorKind(kind)), 0, np.zeros(0), 0)
+            return
+        params = np.atleast_2d(np.ascontiguousarray(params, dtype=np.double))
+        flat = params.ravel()
+        self.x6_call("set_discriminator", d, channels, len(inputs), int(DiscriminatorKind(kind)),
+                     params.shape[0], flat, len(flat))
+
+    def get_discriminator_counts(self, d):
+        """
+        State counts of discriminator d as an array of segments x states.
+        """
+        size = self.x6_getter("get_discriminator_counts_size", d)
+        counts = np.zeros(size, dtype=np.uint64)
+        self.x6_call("transfer_discriminator_counts", d, counts, size)
+        return counts.reshape(self.nbr_segments, -1)
+
+    def set_socket_metadata(self, enable):
+        """
+        When enabled, every record sent over a registered socket is followed
+        by its RecordMetadata (see `metadata_dtype`).
+        """
+        self.x6_call("set_socket_metadata", enable)
+
+    def transfer_stream_metadata(self, a, b, c):
+        """
+        Get the per-record metadata (VITA timestamp, packet count, segment)
+        queued for a stream in digitizer mode. Metadata is returned in the
+        same order as the records from `transfer_stream`.
+        """
+        ch = Channel(a, b, c)
+        num_records = self.x6_getter("get_metadata_buffer_size", byref(ch))
+        metadata = np.zeros(num_records, dtype=metadata_dtype)
+        if num_records > 0:
+            self.x6_call("transfer_stream_metadata", byref(ch), metadata, num_records)
+        return metadata
+
+    def get_sequence_stats(self, a, b, c):
+        """
+        VITA packet counter statistics for a stream in the current acquisition
+        as a dict of packets, gaps, lost_packets, duplicates and out_of_order.
+        """
+        ch = Channel(a, b, c)
+        stats = SequenceStats()
+        self.x6_call("get_sequence_stats", byref(ch), byref(stats))
+        return {name: getattr(stats, name) for name, _ in stats._fields_}
+
+    def set_abort_on_packet_loss(self, abort):
+        self.x6_call("set_abort_on_packet_loss", abort)
+
+    def set_pipeline_depth(self, depth):
+        """
+        Number of DMA buffers the parse and process stages may each fall behind
+        the driver before the receive stage blocks. Set before acquire().
+        """
+        self.x6_call("set_pipeline_depth", depth)
+
+    def get_pipeline_stats(self, stage):
+        """
+        Queue statistics for a PipelineStage as a dict of depth, high_water,
+        capacity, processed and stalls.
+        """
+        stats = PipelineStats()
+        self.x6_call("get_pipeline_stats", int(stage), byref(stats))
+        return {name: getattr(stats, name) for name, _ in stats._fields_}
+
+    def get_buffer_pool_stats(self):
+        """
+        Receive buffer pool usage as a dict of capacity, in_use, high_water,
+        allocations and acquisitions. Allocations beyond the initial capacity
+        mean the pool had to grow during the acquisition.
+        """
+        stats = BufferPoolStats()
+        self.x6_call("get_buffer_pool_stats", byref(stats))
+        return {name: getattr(stats, name) for name, _ in stats._fields_}
+
+    def set_thread_affinity(self, role, cpus):
+        """
+        Pin the acquisition thread with the given ThreadRole to a list of core
+        indices (or an empty list to leave it unpinned) from the next acquire().
+        """
+        mask = 0
+        for cpu in cpus:
+            mask |= 1 << cpu
+        self.x6_call("set_thread_affinity", int(role), mask)
+
+    def set_thread_priority(self, role, priority):
+        """
+        SCHED_FIFO priority (1-99) for the thread with the given ThreadRole, or
+        0 for normal scheduling. Needs CAP_SYS_NICE or a suitable rtprio limit;
+        check get_thread_settings for what was granted.
+        """
+        self.x6_call("set_thread_priority", int(role), priority)
+
+    def get_thread_settings(self, role):
+        """
+        Requested and effective affinity (as lists of cores) and priority of the
+        thread with the given ThreadRole in the current acquisition.
+        """
+        settings = ThreadSettings()
+        self.x6_call("get_thread_settings", int(role), byref(settings))
+        cores = lambda mask: [cpu for cpu in range(64) if (mask >> cpu) & 1]
+        return {"requested_cpus": cores(settings.requested_cpus),
+                "effective_cpus": cores(settings.effective_cpus),
+                "requested_priority": settings.requested_priority,
+                "effective_priority": settings.effective_priority,
+                "applied": bool(settings.applied)}
+
     def transfer_variance(self, a, b, c):
         ch = Channel(a, b, c)
         buffer_size = self.x6_getter("get_variance_buffer_size", byref(ch), 1)
@@ -429,3 +969,108 @@ class X6(object):
 
     def read_register(self, addr, offset):
         return self.x6_getter("read_register", addr, offset)
+
+    def write_registers(self, addr, offsets, data):
+        """
+        Write data[i] to register offsets[i] of base address addr, all in one
+        pass over the bus.
+        """
+        offsets = np.ascontiguousarray(offsets, dtype=np.uint32)
+        data = np.ascontiguousarray(data, dtype=np.uint32)
+        if len(offsets) != len(data):
+            raise ValueError("Need one value per register offset")
+        self.x6_call("write_registers", addr, offsets, data, len(offsets))
+
+    def read_registers(self, addr, offsets):
+        offsets = np.ascontiguousarray(offsets, dtype=np.uint32)
+        data = np.zeros(len(offsets), dtype=np.uint32)
+        self.x6_call("read_registers", addr, offsets, data, len(offsets))
+        return data
+
+    def verify_register_shadow(self, a):
+        """
+        Number of DSP a registers whose value on the card differs from the
+        driver's copy; each one is logged as a warning.
+        """
+        return self.x6_getter("verify_register_shadow", a)
+
+    def resync_register_shadow(self):
+        self.x6_call("resync_register_shadow")
+
+class BoardGroup(object):
+    """
+    Connected X6 boards armed, waited on and transferred together, with one
+    worker thread per board in the driver.
+    """
+    def __init__(self, boards):
+        super(BoardGroup, self).__init__()
+        self.boards = list(boards)
+        ids = (c_int32 * len(self.boards))(*[b.device_id for b in self.boards])
+        group_id = c_int32()
+        check(libx6.create_board_group(ids, len(self.boards), byref(group_id)))
+        self.group_id = group_id.value
+
+    def __del__(self):
+        try:
+            self.destroy()
+        except Exception as e:
+            pass
+
+    def destroy(self):
+        if self.group_id is not None:
+            check(libx6.destroy_board_group(self.group_id))
+        self.group_id = None
+
+    def acquire(self):
+        check(libx6.group_acquire(self.group_id))
+
+    def wait_for_acquisition(self, timeout):
+        check(libx6.group_wait_for_acquisition(self.group_id, int(timeout)))
+
+    def stop(self):
+        check(libx6.group_stop(self.group_id))
+
+    def transfer_stream(self, a, b, c):
+        """
+        Data of stream (a, b, c) from every board, transferred concurrently,
+        as a list in board order.
+        """
+        ch = Channel(a, b, c)
+        sizes = (c_uint32 * len(self.boards))()
+        check(libx6.group_get_buffer_sizes(self.group_id, byref(ch), 1, sizes))
+        total = sum(sizes)
+        if total == 0:
+            return [None] * len(self.boards)
+        stream = np.zeros(total, dtype=np.double)
+        check(libx6.group_transfer_stream(self.group_id, byref(ch), 1, stream, sizes))
+        data = np.split(stream, np.cumsum(list(sizes))[:-1])
+        if b == 0 and c == 0:
+            return data
+        return [d[::2] + 1j*d[1::2] for d in data]
+
+    def add_correlator(self, inputs, alignment=ShotAlignment.record_index, tolerance=0):
+        """
+        Correlate result streams read out on different boards of the group.
+        inputs is a list of (board, (a, b, c)) pairs, with board one of the
+        X6 objects of the group. Shots are aligned by record index or by VITA
+        timestamp, to within tolerance 5 ns ticks. Returns the correlator index.
+        """
+        ids = (c_int32 * len(inputs))(*[board.device_id for board, _ in inputs])
+        channels = (Channel * len(inputs))(*[Channel(*t) for _, t in inputs])
+        idx = c_uint32()
+        check(libx6.group_add_correlator(self.group_id, ids, channels, len(inputs),
+                                         int(ShotAlignment(alignment)), tolerance, byref(idx)))
+        return idx.value
+
+    def transfer_correlation(self, idx):
+        """
+        Mean product of each segment and its variance (real, imaginary and
+        real-imaginary product) for group correlator idx.
+        """
+        size = c_uint32()
+        check(libx6.group_get_correlator_size(self.group_id, idx, byref(size)))
+        mean = np.zeros(size.value, dtype=np.double)
+        check(libx6.group_transfer_correlation(self.group_id, idx, mean, len(mean)))
+        variance = np.zeros(3 * size.value // 2, dtype=np.double)
+        check(libx6.group_transfer_correlation_variance(self.group_id, idx, variance, len(variance)))
+        return mean[::2] + 1j*mean[1::2], (variance[::3], variance[1::3], variance[2::3])
@@ -46,6 +46,23 @@ TEST_CASE( "Accumulator mean and variance", "[accumulator]") {
 		REQUIRE( vec_equal(obufvar, {2, 50, 10, 2, 5000, 100}) );
 	}
 
+	SECTION("reset for another acquisition") {
+		accumlator.reset();
+		REQUIRE( accumlator.recordsTaken == 0 );
+		ibuf[0] = 0 * scale; ibuf[1] = 10 * scale; // segment 1
+		accumlator.accumulate(ibuf);
+		ibuf[0] = 1 * scale; ibuf[1] = 100 * scale; // segment 2
+		accumlator.accumulate(ibuf);
+		ibuf[0] = 2 * scale; ibuf[1] = 20 * scale; // segment 1
+		accumlator.accumulate(ibuf);
+		ibuf[0] = 3 * scale; ibuf[1] = 200 * scale; // segment 2
+		accumlator.accumulate(ibuf);
+		accumlator.snapshot(obuf.data());
+		REQUIRE( vec_equal(obuf, {1, 15, 2, 150}) );
+		accumlator.snapshot_variance(obufvar.data());
+		REQUIRE( vec_equal(obufvar, {2, 50, 10, 2, 5000, 100}) );
+	}
+
 	SECTION("add additional round robin") {
 		ibuf[0] = 4 * scale; ibuf[1] = 30 * scale; // segment 1
 	    accumlator.accumulate(ibuf);
@@ -0,0 +1,355 @@
+#include "catch.hpp"
+
+#include <vector>
+using std::vector;
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "SPSCQueue.h"
+#include "BufferPool.h"
+#include "AcquisitionPipeline.h"
+
+typedef vector<uint32_t> WordBuffer;
+
+// Build a VITA packet carrying a ramp of payload words
+static void append_ramp_packet(WordBuffer & buf, uint16_t sid, unsigned count, uint32_t start, size_t len) {
+	uint32_t size = 7 + len + 1;
+	uint32_t header = (0x1u << 28) | (1u << 27) | (1u << 26) | (0x1u << 22) | (0x1u << 20) | ((count & 0xf) << 16) | size;
+	buf.push_back(header);
+	buf.push_back(sid);
+	buf.push_back(0); buf.push_back(0);
+	buf.push_back(count);
+	buf.push_back(0); buf.push_back(0);
+	for (size_t ct = 0; ct < len; ct++)
+		buf.push_back(start + ct);
+	buf.push_back(0);
+}
+
+// Feed a synthetic packet stream through the pipeline in buffers of a given size
+static void feed(AcquisitionPipeline<WordBuffer> & pipeline, const WordBuffer & stream, size_t bufferWords) {
+	for (size_t ct = 0; ct < stream.size(); ct += bufferWords) {
+		size_t len = std::min(bufferWords, stream.size() - ct);
+		auto buffer = pipeline.acquire_buffer();
+		buffer->assign(stream.begin() + ct, stream.begin() + ct + len);
+		pipeline.receive(buffer, buffer->data(), buffer->size());
+	}
+}
+
+static bool wait_for(std::function<bool()> done) {
+	auto end = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (!done()) {
+		if (std::chrono::steady_clock::now() > end)
+			return false;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return true;
+}
+
+TEST_CASE("single producer single consumer queue", "[pipeline]") {
+	SPSCQueue<int> queue(5);
+	REQUIRE( queue.capacity() == 8 );
+
+	for (int ct = 0; ct < 8; ct++) {
+		int val = ct;
+		REQUIRE( queue.push(std::move(val)) );
+	}
+	int extra = 8;
+	REQUIRE_FALSE( queue.push(std::move(extra)) );
+	REQUIRE( queue.size() == 8 );
+
+	int val;
+	for (int ct = 0; ct < 8; ct++) {
+		REQUIRE( queue.pop(val) );
+		REQUIRE( val == ct );
+	}
+	REQUIRE_FALSE( queue.pop(val) );
+}
+
+TEST_CASE("buffer pool recycling", "[pipeline]") {
+	BufferPool<WordBuffer> pool;
+	pool.reserve(2);
+	BufferPoolStats stats = pool.get_stats();
+	REQUIRE( stats.capacity == 2 );
+	REQUIRE( stats.allocations == 2 );
+
+	WordBuffer * first;
+	{
+		auto a = pool.acquire();
+		a->resize(100);
+		first = a.get();
+		auto copy = a; // a second holder keeps it out of circulation
+		a.reset();
+		auto b = pool.acquire();
+		CHECK( b.get() != first );
+		CHECK( pool.get_stats().inUse == 2 );
+		// every buffer held: the pool grows rather than blocking
+		auto c = pool.acquire();
+		CHECK( pool.get_stats().capacity == 3 );
+		CHECK( pool.get_stats().highWater == 3 );
+	}
+	stats = pool.get_stats();
+	CHECK( stats.inUse == 0 );
+	CHECK( stats.allocations == 3 );
+	CHECK( stats.acquisitions == 3 );
+
+	// released buffers come back with their capacity intact
+	bool reused = false;
+	for (int ct = 0; ct < 3; ct++) {
+		auto buf = pool.acquire();
+		reused |= (buf.get() == first && buf->capacity() >= 100);
+	}
+	CHECK( reused );
+	CHECK( pool.get_stats().allocations == 3 );
+}
+
+TEST_CASE("buffer pool across threads", "[pipeline]") {
+	SECTION("buffers released on another thread come back") {
+		BufferPool<WordBuffer> pool;
+		pool.reserve(8);
+		SPSCQueue<BufferPool<WordBuffer>::Ptr> handoff(4);
+		const int numBuffers = 20000;
+		bool intact = true;
+		std::thread releaser([&]() {
+			BufferPool<WordBuffer>::Ptr buffer;
+			for (int ct = 0; ct < numBuffers; ct++) {
+				while (!handoff.pop(buffer)) {
+					std::this_thread::yield();
+				}
+				intact &= buffer->size() == 1 && (*buffer)[0] == static_cast<uint32_t>(ct);
+				buffer.reset();
+			}
+		});
+		for (int ct = 0; ct < numBuffers; ct++) {
+			auto buffer = pool.acquire();
+			buffer->assign(1, ct);
+			while (!handoff.push(std::move(buffer))) {
+				std::this_thread::yield();
+			}
+		}
+		releaser.join();
+		CHECK( intact );
+		BufferPoolStats stats = pool.get_stats();
+		CHECK( stats.inUse == 0 );
+		CHECK( stats.acquisitions == numBuffers );
+		// the handoff queue plus one buffer on each side
+		CHECK( stats.capacity <= 8 );
+		CHECK( stats.allocations == stats.capacity );
+	}
+
+	SECTION("past its maximum size the pool hands out buffers of its own") {
+		BufferPool<WordBuffer> pool([]() { return new WordBuffer(); }, 2);
+		auto a = pool.acquire();
+		auto b = pool.acquire();
+		auto c = pool.acquire();
+		CHECK( pool.get_stats().capacity == 2 );
+		CHECK( pool.get_stats().inUse == 2 );
+		CHECK( pool.get_stats().allocations == 3 );
+		WordBuffer * pooled = a.get();
+		a.reset();
+		c.reset();
+		auto d = pool.acquire();
+		CHECK( d.get() == pooled );
+		CHECK( pool.get_stats().allocations == 3 );
+	}
+}
+
+TEST_CASE("acquisition pipeline", "[pipeline]") {
+	VitaDemux demux;
+	demux.add_stream(0x0100, 6);
+	demux.add_stream(0x0112, 2);
+	AcquisitionPipeline<WordBuffer> pipeline(demux);
+
+	std::mutex mutex;
+	vector<vector<uint32_t>> phys, result;
+	std::atomic<size_t> batches{0};
+	std::thread::id processThread;
+	pipeline.set_record_handler([&](unsigned slot, const uint32_t * data, size_t numWords, const VitaHeader &) {
+		std::lock_guard<std::mutex> lock(mutex);
+		processThread = std::this_thread::get_id();
+		(slot == 0 ? phys : result).emplace_back(data, data + numWords);
+	});
+	pipeline.set_batch_handler([&]() { batches++; });
+
+	// 40 physical records spread over packets of 4 words, interleaved with results
+	WordBuffer stream;
+	for (unsigned ct = 0; ct < 60; ct++) {
+		append_ramp_packet(stream, 0x0100, ct, 4*ct, 4);
+		append_ramp_packet(stream, 0x0112, ct, 1000 + 2*ct, 2);
+	}
+
+	SECTION("records arrive complete and in order on a worker thread") {
+		pipeline.start();
+		// odd buffer size splits packets across buffers
+		feed(pipeline, stream, 37);
+		REQUIRE( wait_for([&]() { std::lock_guard<std::mutex> lock(mutex); return result.size() == 60; }) );
+		REQUIRE( wait_for([&]() { std::lock_guard<std::mutex> lock(mutex); return phys.size() == 40; }) );
+		pipeline.stop();
+
+		for (size_t ct = 0; ct < 40; ct++) {
+			for (size_t i = 0; i < 6; i++) {
+				REQUIRE( phys[ct][i] == 6*ct + i );
+			}
+		}
+		for (size_t ct = 0; ct < 60; ct++) {
+			REQUIRE( result[ct][0] == 1000 + 2*ct );
+		}
+		CHECK( processThread != std::this_thread::get_id() );
+
+		PipelineStats stats = pipeline.get_stats(PIPELINE_RECEIVE);
+		CHECK( stats.processed == (stream.size() + 36) / 37 );
+		stats = pipeline.get_stats(PIPELINE_PARSE);
+		CHECK( stats.processed == (stream.size() + 36) / 37 );
+		CHECK( stats.highWater <= stats.capacity );
+		CHECK( pipeline.get_stats(PIPELINE_PROCESS).processed == batches );
+
+		// buffers all came back and were recycled rather than allocated
+		BufferPoolStats poolStats = pipeline.get_buffer_pool_stats();
+		CHECK( poolStats.inUse == 0 );
+		CHECK( poolStats.acquisitions == (stream.size() + 36) / 37 );
+		CHECK( poolStats.allocations == poolStats.capacity );
+		CHECK( poolStats.highWater <= poolStats.capacity );
+	}
+
+	SECTION("a slow process stage backs up into the queues") {
+		pipeline.set_depth(2);
+		pipeline.set_record_handler([&](unsigned, const uint32_t *, size_t, const VitaHeader &) {
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+		});
+		pipeline.start();
+		feed(pipeline, stream, 20);
+		REQUIRE( wait_for([&]() { return pipeline.get_stats(PIPELINE_PARSE).depth == 0; }) );
+		PipelineStats stats = pipeline.get_stats(PIPELINE_PARSE);
+		CHECK( stats.capacity == 2 );
+		CHECK( stats.highWater == 2 );
+		CHECK( stats.stalls > 0 );
+		pipeline.stop();
+	}
+
+	SECTION("stopping from the process thread") {
+		std::atomic<bool> stopped{false};
+		pipeline.set_batch_handler([&]() {
+			pipeline.request_stop();
+			stopped = true;
+		});
+		pipeline.start();
+		feed(pipeline, stream, 64);
+		REQUIRE( wait_for([&]() { return stopped.load(); }) );
+		// receive refuses buffers once stopped
+		auto buffer = pipeline.acquire_buffer();
+		CHECK_FALSE( pipeline.receive(buffer, buffer->data(), buffer->size()) );
+		pipeline.stop();
+
+		// and the pipeline can be restarted
+		stopped = false;
+		pipeline.start();
+		feed(pipeline, stream, 64);
+		REQUIRE( wait_for([&]() { return stopped.load(); }) );
+		pipeline.stop();
+	}
+
+	SECTION("a stop request releases a receive blocked on a full queue") {
+		pipeline.set_depth(2);
+		std::atomic<bool> release{false};
+		pipeline.set_record_handler([&](unsigned, const uint32_t *, size_t, const VitaHeader &) {
+			while (!release) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		});
+		pipeline.start();
+		std::atomic<bool> fed{false};
+		std::thread receiver([&]() {
+			feed(pipeline, stream, 20);
+			fed = true;
+		});
+		REQUIRE( wait_for([&]() { return pipeline.get_stats(PIPELINE_PARSE).stalls > 0; }) );
+		CHECK_FALSE( fed );
+		pipeline.request_stop();
+		CHECK( wait_for([&]() { return fed.load(); }) );
+		receiver.join();
+		release = true;
+		pipeline.stop();
+	}
+
+	SECTION("consumers see every record inline") {
+		vector<vector<uint32_t>> consumed;
+		std::atomic<size_t> consumedBatches{0};
+		bool sameThread = true;
+		pipeline.set_consumer([&](unsigned slot, const uint32_t * data, size_t numWords, const VitaHeader &) {
+			if (slot == 0) {
+				std::lock_guard<std::mutex> lock(mutex);
+				sameThread = sameThread && (std::this_thread::get_id() == processThread);
+				consumed.emplace_back(data, data + numWords);
+			}
+		}, [&]() { consumedBatches++; }, false);
+		pipeline.start();
+		feed(pipeline, stream, 37);
+		REQUIRE( wait_for([&]() { std::lock_guard<std::mutex> lock(mutex); return consumed.size() == 40; }) );
+		pipeline.stop();
+		for (size_t ct = 0; ct < 40; ct++) {
+			REQUIRE( consumed[ct] == phys[ct] );
+		}
+		CHECK( sameThread );
+		CHECK( consumedBatches == batches );
+		CHECK( pipeline.get_stats(PIPELINE_CONSUME).processed == 0 );
+		CHECK( pipeline.get_buffer_pool_stats().inUse == 0 );
+	}
+
+	SECTION("consumers on their own thread hold buffers until they are done") {
+		vector<vector<uint32_t>> consumed;
+		std::thread::id consumeThread;
+		pipeline.set_consumer([&](unsigned slot, const uint32_t * data, size_t numWords, const VitaHeader &) {
+			// a slow consumer must not see its buffers recycled underneath it
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+			if (slot == 0) {
+				std::lock_guard<std::mutex> lock(mutex);
+				consumeThread = std::this_thread::get_id();
+				consumed.emplace_back(data, data + numWords);
+			}
+		}, nullptr, true);
+		pipeline.start();
+		feed(pipeline, stream, 37);
+		REQUIRE( wait_for([&]() { std::lock_guard<std::mutex> lock(mutex); return consumed.size() == 40; }) );
+		pipeline.stop();
+		for (size_t ct = 0; ct < 40; ct++) {
+			for (size_t i = 0; i < 6; i++) {
+				REQUIRE( consumed[ct][i] == 6*ct + i );
+			}
+		}
+		CHECK( consumeThread != processThread );
+		CHECK( consumeThread != std::this_thread::get_id() );
+		CHECK( pipeline.get_stats(PIPELINE_CONSUME).processed == batches );
+		CHECK( pipeline.get_buffer_pool_stats().inUse == 0 );
+	}
+
+	SECTION("a consume thread finishes queued batches when stopped") {
+		std::atomic<size_t> consumedRecords{0};
+		std::atomic<size_t> processedRecords{0};
+		pipeline.set_record_handler([&](unsigned, const uint32_t *, size_t, const VitaHeader &) {
+			processedRecords++;
+		});
+		pipeline.set_consumer([&](unsigned, const uint32_t *, size_t, const VitaHeader &) {
+			std::this_thread::sleep_for(std::chrono::microseconds(500));
+			consumedRecords++;
+		}, nullptr, true);
+		std::atomic<bool> stopped{false};
+		std::atomic<unsigned> numBatches{0};
+		pipeline.set_batch_handler([&]() {
+			if (++numBatches == 3) {
+				pipeline.stop();
+				stopped = true;
+			}
+		});
+		pipeline.start();
+		feed(pipeline, stream, 64);
+		REQUIRE( wait_for([&]() { return stopped.load(); }) );
+		// stop() from the process thread returns only once the consumer is done
+		CHECK( consumedRecords == processedRecords );
+	}
+
+	SECTION("invalid stage") {
+		CHECK_THROWS( pipeline.get_stats(static_cast<X6_PIPELINE_STAGE>(7)) );
+	}
+}
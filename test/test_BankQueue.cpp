@@ -0,0 +1,98 @@
+#include "catch.hpp"
+
+#include <array>
+#include <chrono>
+#include <thread>
+#include <vector>
+using std::vector;
+
+#include "BankQueue.h"
+#include "X6_errno.h"
+
+static std::chrono::system_clock::time_point in_ms(int ms) {
+	return std::chrono::system_clock::now() + std::chrono::milliseconds(ms);
+}
+
+TEST_CASE("Bank queue", "[BankQueue]") {
+	BankQueue banks;
+	banks.reset(3);
+
+	SECTION("a bank is ready once every stream filled it") {
+		CHECK( banks.may_start(0) );
+		CHECK( banks.may_start(1) );
+		CHECK_FALSE( banks.may_start(2) );
+		banks.stream_filled(0);
+		banks.stream_filled(0);
+		CHECK( banks.num_ready() == 0 );
+		CHECK_FALSE( banks.wait_until(in_ms(1)) );
+		// a fast stream may already be on the second bank
+		banks.stream_filled(1);
+		banks.stream_filled(0);
+		CHECK( banks.num_ready() == 1 );
+		CHECK( banks.wait_until(in_ms(1)) );
+		CHECK( banks.front_bank() == 0 );
+
+		banks.release();
+		CHECK( banks.num_ready() == 0 );
+		CHECK( banks.front_bank() == 1 );
+		CHECK( banks.may_start(2) );
+		CHECK_FALSE( banks.may_start(3) );
+	}
+
+	SECTION("nothing to release") {
+		CHECK_THROWS_AS( banks.release(), X6_STATUS );
+	}
+
+	SECTION("closing wakes a waiting client") {
+		std::thread closer([&banks]() {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			banks.close();
+		});
+		CHECK( banks.wait_until(in_ms(5000)) );
+		CHECK( banks.num_ready() == 0 );
+		closer.join();
+	}
+
+	SECTION("client reads each bank while the next one fills") {
+		const size_t numStreams = 3, numAcquisitions = 50, recordsPerBank = 100;
+		banks.reset(numStreams);
+		// each stream sums the acquisition number of its records into its bank
+		std::array<vector<size_t>, 2> sums;
+		sums[0].assign(numStreams, 0);
+		sums[1].assign(numStreams, 0);
+
+		std::thread producer([&]() {
+			vector<size_t> filled(numStreams, 0), taken(numStreams, 0);
+			// a release between two streams lets the later ones run a record
+			// ahead, so any stream may be the last to finish
+			size_t finished = 0;
+			while (finished < numStreams) {
+				for (size_t s = 0; s < numStreams; s++) {
+					if (filled[s] == numAcquisitions || !banks.may_start(filled[s])) {
+						continue;
+					}
+					sums[filled[s] % 2][s] += filled[s];
+					if (++taken[s] == recordsPerBank) {
+						banks.stream_filled(filled[s]++);
+						taken[s] = 0;
+						finished += filled[s] == numAcquisitions;
+					}
+				}
+			}
+		});
+
+		bool consistent = true;
+		for (size_t n = 0; n < numAcquisitions; n++) {
+			REQUIRE( banks.wait_until(in_ms(5000)) );
+			REQUIRE( banks.num_ready() > 0 );
+			unsigned bank = banks.front_bank();
+			for (size_t s = 0; s < numStreams; s++) {
+				consistent &= sums[bank][s] == n * recordsPerBank;
+				sums[bank][s] = 0;
+			}
+			banks.release();
+		}
+		producer.join();
+		CHECK( consistent );
+	}
+}
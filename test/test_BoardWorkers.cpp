@@ -0,0 +1,66 @@
+#include "catch.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+using std::vector;
+
+#include "BoardWorkers.h"
+
+TEST_CASE("Board workers", "[BoardWorkers]") {
+	const size_t numBoards = 4;
+	BoardWorkers workers(numBoards);
+	REQUIRE( workers.size() == numBoards );
+
+	SECTION("every board runs at once") {
+		// each board waits for all the others, which only finishes if they
+		// run concurrently
+		std::atomic<size_t> arrived{0};
+		vector<std::thread::id> ids(numBoards);
+		auto statuses = workers.run([&](size_t board) {
+			ids[board] = std::this_thread::get_id();
+			arrived++;
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+			while (arrived < numBoards) {
+				if (std::chrono::steady_clock::now() > deadline) {
+					throw X6_TIMEOUT;
+				}
+				std::this_thread::yield();
+			}
+		});
+		CHECK( statuses == vector<X6_STATUS>(numBoards, X6_OK) );
+		for (size_t board = 0; board < numBoards; board++) {
+			CHECK( ids[board] != std::this_thread::get_id() );
+		}
+	}
+
+	SECTION("statuses are per board") {
+		auto statuses = workers.run([](size_t board) {
+			if (board == 1) {
+				throw X6_TIMEOUT;
+			}
+			if (board == 3) {
+				throw std::runtime_error("not an X6 status");
+			}
+		});
+		vector<X6_STATUS> expected = {X6_OK, X6_TIMEOUT, X6_OK, X6_UNKNOWN_ERROR};
+		CHECK( statuses == expected );
+	}
+
+	SECTION("workers are reused") {
+		// the same threads run job after job
+		vector<std::thread::id> first(numBoards), later(numBoards);
+		workers.run([&](size_t board) { first[board] = std::this_thread::get_id(); });
+		vector<unsigned> counts(numBoards, 0);
+		for (int ct = 0; ct < 1000; ct++) {
+			workers.run([&](size_t board) {
+				counts[board]++;
+				later[board] = std::this_thread::get_id();
+			});
+		}
+		CHECK( counts == vector<unsigned>(numBoards, 1000) );
+		CHECK( first == later );
+	}
+}
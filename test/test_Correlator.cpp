@@ -117,3 +117,22 @@ TEST_CASE("stream correlator mean and variance", "[correlator]") {
 		REQUIRE( vec_equal(obuf, {0*1*2 - 0*20*30 - 10*1*30 - 10*20*2, -10*20*30 + 10*1*2 + 0*20*2 + 0*1*30}) );
 	}
 }
+
+TEST_CASE("correlator input lookup by index", "[correlator]") {
+	QDSPStream stream1(1,1,1), stream2(1,2,1), stream3(2,1,1);
+	Correlator corr({stream1, stream2}, 1, 1);
+
+	REQUIRE( corr.get_buffer_index(stream1.streamID) == 0 );
+	REQUIRE( corr.get_buffer_index(stream2.streamID) == 1 );
+	REQUIRE( corr.get_buffer_index(stream3.streamID) == -1 );
+
+	const unsigned scale = stream1.fixed_to_float();
+	vector<int> a = {1 * static_cast<int>(scale), 2 * static_cast<int>(scale)};
+	vector<int> b = {3 * static_cast<int>(scale), 4 * static_cast<int>(scale)};
+	corr.accumulate_buffer(0, a);
+	corr.accumulate_buffer(1, b);
+
+	vector<double> obuf(2);
+	corr.snapshot(obuf.data());
+	REQUIRE( vec_equal(obuf, {1*3 - 2*4, 1*4 + 2*3}) );
+}
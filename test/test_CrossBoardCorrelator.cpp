@@ -0,0 +1,164 @@
+#include "catch.hpp"
+
+#include <cmath>
+#include <complex>
+using std::complex;
+#include <random>
+#include <thread>
+#include <vector>
+using std::vector;
+#include <cstdint>
+
+#include "CrossBoardCorrelator.h"
+#include "RecordView.h"
+#include "X6_errno.h"
+
+// a simulated board streaming one result record per shot
+struct SimulatedBoard {
+	QDSPStream stream;
+	vector<complex<double>> shots;
+	vector<int32_t> words;
+
+	SimulatedBoard(const QDSPStream & s, size_t numShots, unsigned seed) : stream(s) {
+		std::mt19937 gen(seed);
+		std::uniform_real_distribution<double> dist(-0.5, 0.5);
+		double scale = stream.fixed_to_float();
+		for (size_t n = 0; n < numShots; n++) {
+			int32_t re = static_cast<int32_t>(std::lrint(dist(gen) * scale));
+			int32_t im = static_cast<int32_t>(std::lrint(dist(gen) * scale));
+			words.push_back(re);
+			words.push_back(im);
+			shots.emplace_back(re / scale, im / scale);
+		}
+	}
+
+	RecordView<int32_t> record(size_t n) const {
+		return RecordView<int32_t>(words.data() + 2*n, 2);
+	}
+};
+
+static VitaHeader timestamp(uint32_t seconds, uint64_t fractional) {
+	VitaHeader vh;
+	vh.timestampSeconds = seconds;
+	vh.timestampFractional = fractional;
+	return vh;
+}
+
+TEST_CASE("Cross-board correlator", "[CrossBoardCorrelator]") {
+	// the same result stream read out on two boards
+	QDSPStream stream(1, 0, 1);
+	const size_t numShots = 4000;
+	SimulatedBoard boardA(stream, numShots, 1);
+	SimulatedBoard boardB(stream, numShots, 2);
+
+	SECTION("record index alignment from two threads") {
+		const size_t numSegments = 4;
+		CrossBoardCorrelator corr({stream, stream}, ALIGN_RECORD_INDEX, 0);
+		corr.reset(numSegments, 1, numShots);
+
+		// each board delivers its records from its own process thread
+		auto feed = [&corr](const SimulatedBoard & board, int index) {
+			VitaHeader vh;
+			for (size_t n = 0; n < board.shots.size(); n++) {
+				corr.add_record(index, board.record(n), n, vh);
+			}
+		};
+		std::thread threadA(feed, std::cref(boardA), 0);
+		std::thread threadB(feed, std::cref(boardB), 1);
+		threadA.join();
+		threadB.join();
+		REQUIRE( corr.get_records_taken() == numShots );
+		CHECK( corr.get_unmatched() == 0 );
+
+		vector<complex<double>> sum(numSegments), sum2(numSegments);
+		vector<double> sumRe2(numSegments), sumIm2(numSegments), sumReIm(numSegments);
+		for (size_t n = 0; n < numShots; n++) {
+			complex<double> p = boardA.shots[n] * boardB.shots[n];
+			size_t seg = n % numSegments;
+			sum[seg] += p;
+			sumRe2[seg] += p.real() * p.real();
+			sumIm2[seg] += p.imag() * p.imag();
+			sumReIm[seg] += p.real() * p.imag();
+		}
+		REQUIRE( corr.get_buffer_size() == 2 * numSegments );
+		vector<double> mean(corr.get_buffer_size());
+		corr.snapshot(mean.data());
+		vector<double> variance(corr.get_variance_buffer_size());
+		corr.snapshot_variance(variance.data());
+		double N = numShots / numSegments;
+		for (size_t seg = 0; seg < numSegments; seg++) {
+			CHECK( mean[2*seg] == Approx(sum[seg].real() / N) );
+			CHECK( mean[2*seg + 1] == Approx(sum[seg].imag() / N) );
+			double re = sum[seg].real(), im = sum[seg].imag();
+			CHECK( variance[3*seg] == Approx((sumRe2[seg] - re*re/N) / (N-1)) );
+			CHECK( variance[3*seg + 1] == Approx((sumIm2[seg] - im*im/N) / (N-1)) );
+			CHECK( variance[3*seg + 2] == Approx((sumReIm[seg] - re*im/N) / (N-1)).margin(1e-12) );
+		}
+	}
+
+	SECTION("shots missing on one board are dropped") {
+		CrossBoardCorrelator corr({stream, stream}, ALIGN_RECORD_INDEX, 0);
+		corr.reset(1, 1, numShots);
+		VitaHeader vh;
+		// board B lost every tenth record
+		complex<double> expected = 0;
+		size_t matched = 0;
+		for (size_t n = 0; n < 100; n++) {
+			corr.add_record(0, boardA.record(n), n, vh);
+			if (n % 10 != 3) {
+				corr.add_record(1, boardB.record(n), n, vh);
+				expected += boardA.shots[n] * boardB.shots[n];
+				matched++;
+			}
+		}
+		CHECK( corr.get_records_taken() == matched );
+		// the last missing shot waits until board B moves past it
+		CHECK( corr.get_unmatched() == 10 );
+		vector<double> mean(2);
+		corr.snapshot(mean.data());
+		CHECK( mean[0] == Approx(expected.real() / matched) );
+		CHECK( mean[1] == Approx(expected.imag() / matched) );
+	}
+
+	SECTION("timestamp alignment") {
+		// 5 records per packet share a timestamp; board B's clock reads one
+		// tick late and board B starts a packet later than board A
+		const uint64_t packetTicks = 1000;
+		const size_t perPacket = 5;
+		CrossBoardCorrelator corr({stream, stream}, ALIGN_TIMESTAMP, 2);
+		corr.reset(1, 1, numShots);
+		complex<double> expected = 0;
+		size_t matched = 0;
+		for (size_t n = 0; n < 200; n++) {
+			uint64_t ticks = 199999000 + (n / perPacket) * packetTicks;
+			corr.add_record(0, boardA.record(n), n, timestamp(ticks / 200000000, ticks % 200000000));
+			if (n >= perPacket) {
+				uint64_t late = ticks + 1;
+				corr.add_record(1, boardB.record(n), n - perPacket, timestamp(late / 200000000, late % 200000000));
+				expected += boardA.shots[n] * boardB.shots[n];
+				matched++;
+			}
+		}
+		CHECK( corr.get_records_taken() == matched );
+		CHECK( corr.get_unmatched() == perPacket );
+		vector<double> mean(2);
+		corr.snapshot(mean.data());
+		CHECK( mean[0] == Approx(expected.real() / matched) );
+	}
+
+	SECTION("records beyond the acquisition are ignored") {
+		CrossBoardCorrelator corr({stream, stream}, ALIGN_RECORD_INDEX, 0);
+		corr.reset(1, 1, 10);
+		VitaHeader vh;
+		for (size_t n = 0; n < 20; n++) {
+			corr.add_record(0, boardA.record(n), n, vh);
+			corr.add_record(1, boardB.record(n), n, vh);
+		}
+		CHECK( corr.get_records_taken() == 10 );
+	}
+
+	SECTION("invalid inputs") {
+		CHECK_THROWS_AS( CrossBoardCorrelator({stream}, ALIGN_RECORD_INDEX, 0), X6_STATUS );
+		CHECK_THROWS_AS( CrossBoardCorrelator({stream, QDSPStream(1, 1, 0)}, ALIGN_RECORD_INDEX, 0), X6_STATUS );
+	}
+}
@@ -0,0 +1,122 @@
+#include "catch.hpp"
+
+#include <cstdint>
+
+#include "constants.h"
+#include "DSPShadow.h"
+#include "RegisterBus.h"
+#include "RegisterFile.h"
+#include "X6_errno.h"
+
+TEST_CASE("DSP register shadow", "[DSPShadow]") {
+	const uint32_t base = BASE_DSP[0];
+	const uint32_t numRawKi = 5, numDemod = 2, correlatorSize = 4;
+
+	RegisterFile file;
+	RegisterBus<RegisterFile::Space> bus([&file](uint32_t b) { return RegisterFile::Space(file, b); });
+	auto execute = [&bus](const RegisterBatch & batch) { bus.execute(batch); };
+
+	file.preset(base, WB_QDSP_NUM_RAW_KI, numRawKi);
+	file.preset(base, WB_QDSP_NUM_DEMOD, numDemod);
+	file.preset(base, WB_QDSP_CORRELATOR_SIZE(numRawKi,numDemod), correlatorSize);
+	file.preset(base, WB_QDSP_STREAM_ENABLE, 0x5);
+	file.preset(base, WB_QDSP_THRESHOLD(numRawKi,numDemod) + 2, 1234);
+	file.preset(base, WB_QDSP_CORRELATOR_SEL(numRawKi,numDemod) + 3, 7);
+
+	DSPShadow shadow;
+	shadow.load(base, execute);
+	REQUIRE( shadow.is_loaded() );
+	// the geometry, the correlator size, then all shadowed registers
+	CHECK( bus.get_batches() == 3 );
+
+	SECTION("register offsets come from the geometry") {
+		const DSPLayout & dsp = shadow.get_layout();
+		CHECK( dsp.numRawKi == numRawKi );
+		CHECK( dsp.numDemod == numDemod );
+		CHECK( dsp.correlatorSize == correlatorSize );
+		CHECK( dsp.demodKernelLength == WB_QDSP_DEMOD_KERNEL_LENGTH(numRawKi,numDemod) );
+		CHECK( dsp.rawKernelAddrData == WB_QDSP_RAW_KERNEL_ADDR_DATA(numRawKi,numDemod) );
+		CHECK( dsp.demodKernelAddrData == WB_QDSP_DEMOD_KERNEL_ADDR_DATA(numRawKi,numDemod) );
+		CHECK( dsp.threshold == WB_QDSP_THRESHOLD(numRawKi,numDemod) );
+		CHECK( dsp.phaseInc == WB_QDSP_PHASE_INC(numRawKi,numDemod) );
+		CHECK( dsp.thresholdInvert == WB_QDSP_THRESHOLD_INVERT(numRawKi,numDemod) );
+		CHECK( dsp.thresholdInputSel == WB_QDSP_THRESHOLD_INPUT_SEL(numRawKi,numDemod) );
+		CHECK( dsp.rawKernelBias == WB_QDSP_RAW_KERNEL_BIAS(numRawKi,numDemod) );
+		CHECK( dsp.demodKernelBias == WB_QDSP_DEMOD_KERNEL_BIAS(numRawKi,numDemod) );
+		CHECK( dsp.correlatorSizeReg == WB_QDSP_CORRELATOR_SIZE(numRawKi,numDemod) );
+		CHECK( dsp.correlatorMAddr == WB_QDSP_CORRELATOR_M_ADDR(numRawKi,numDemod) );
+		CHECK( dsp.correlatorMData == WB_QDSP_CORRELATOR_M_DATA(numRawKi,numDemod) );
+		CHECK( dsp.correlatorSel == WB_QDSP_CORRELATOR_SEL(numRawKi,numDemod) );
+	}
+
+	SECTION("shadowed registers are read from memory") {
+		const DSPLayout & dsp = shadow.get_layout();
+		uint64_t reads = bus.get_reads();
+		uint32_t value = 0;
+		CHECK( shadow.read(WB_QDSP_STREAM_ENABLE, value) );
+		CHECK( value == 0x5 );
+		CHECK( shadow.read(dsp.threshold + 2, value) );
+		CHECK( value == 1234 );
+		CHECK( shadow.read(dsp.correlatorSel + 3, value) );
+		CHECK( value == 7 );
+		CHECK( shadow.read(WB_QDSP_NUM_DEMOD, value) );
+		CHECK( value == numDemod );
+		CHECK( bus.get_reads() == reads );
+
+		// memory interfaces are left to the bus
+		CHECK_FALSE( shadow.read(WB_QDSP_TEST, value) );
+		CHECK_FALSE( shadow.read(dsp.rawKernelAddrData, value) );
+		CHECK_FALSE( shadow.read(dsp.correlatorMData, value) );
+		CHECK_FALSE( shadow.read(dsp.correlatorSel + correlatorSize, value) );
+	}
+
+	SECTION("writes keep the shadow current") {
+		const DSPLayout & dsp = shadow.get_layout();
+		uint32_t value = 0;
+		shadow.write(dsp.phaseInc + 1, 42);
+		CHECK( shadow.read(dsp.phaseInc + 1, value) );
+		CHECK( value == 42 );
+		// the firmware ignores writes to its geometry
+		shadow.write(WB_QDSP_NUM_RAW_KI, 9);
+		CHECK( shadow.read(WB_QDSP_NUM_RAW_KI, value) );
+		CHECK( value == numRawKi );
+
+		RegisterBatch batch;
+		batch.write(base, dsp.thresholdInvert, 3);
+		batch.write(BASE_DSP[1], dsp.thresholdInputSel, 3);
+		batch.write(base, dsp.rawKernelAddrData, 3);
+		bus.execute(batch);
+		shadow.write(batch);
+		CHECK( shadow.read(dsp.thresholdInvert, value) );
+		CHECK( value == 3 );
+		// a write to the other DSP is not this one's
+		CHECK( shadow.read(dsp.thresholdInputSel, value) );
+		CHECK( value == 0 );
+	}
+
+	SECTION("verify reports registers changed behind the shadow's back") {
+		const DSPLayout & dsp = shadow.get_layout();
+		CHECK( shadow.verify(execute).empty() );
+
+		file.write(base, dsp.threshold, 99);
+		file.write(base, WB_QDSP_STATE_VLD_MASK, 0x1f);
+		auto mismatches = shadow.verify(execute);
+		REQUIRE( mismatches.size() == 2 );
+		CHECK( mismatches[0].offset == WB_QDSP_STATE_VLD_MASK );
+		CHECK( mismatches[0].shadow == 0 );
+		CHECK( mismatches[0].card == 0x1f );
+		CHECK( mismatches[1].offset == dsp.threshold );
+		CHECK( mismatches[1].card == 99 );
+
+		shadow.load(base, execute);
+		CHECK( shadow.verify(execute).empty() );
+	}
+
+	SECTION("an implausible geometry is refused") {
+		file.preset(base, WB_QDSP_NUM_RAW_KI, 0xffffffff);
+		CHECK_THROWS_AS( shadow.load(base, execute), X6_STATUS );
+		CHECK_FALSE( shadow.is_loaded() );
+		uint32_t value;
+		CHECK_FALSE( shadow.read(WB_QDSP_STREAM_ENABLE, value) );
+	}
+}
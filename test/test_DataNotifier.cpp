@@ -0,0 +1,70 @@
+#include "catch.hpp"
+
+#include <chrono>
+#include <thread>
+#ifdef __linux__
+	#include <unistd.h>
+#endif
+
+#include "DataNotifier.h"
+
+struct CallbackLog {
+	unsigned calls = 0;
+	unsigned records = 0;
+	bool done = false;
+};
+
+void log_callback(int deviceID, unsigned numRecords, int done, void * userData) {
+	CallbackLog * log = static_cast<CallbackLog *>(userData);
+	log->calls++;
+	log->records += numRecords;
+	log->done = done;
+}
+
+TEST_CASE("data notification", "[notifier]") {
+	DataNotifier notifier;
+	CallbackLog log;
+	notifier.set_callback(0, log_callback, &log);
+	notifier.start();
+
+	SECTION("callback fires when crossing the threshold") {
+		notifier.set_threshold(4);
+		for (int ct = 0; ct < 10; ct++)
+			notifier.records_available(1);
+		REQUIRE( log.calls == 2 );
+		REQUIRE( log.records == 8 );
+		REQUIRE( !log.done );
+
+		notifier.finish();
+		REQUIRE( log.calls == 3 );
+		REQUIRE( log.records == 10 );
+		REQUIRE( log.done );
+	}
+
+	SECTION("wait returns once the acquisition finishes") {
+		std::thread finisher([&notifier]() {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			notifier.finish();
+		});
+		auto end = std::chrono::system_clock::now() + std::chrono::seconds(5);
+		REQUIRE( notifier.wait_until(end) );
+		finisher.join();
+	}
+
+	SECTION("wait times out while running") {
+		auto end = std::chrono::system_clock::now() + std::chrono::milliseconds(10);
+		REQUIRE( !notifier.wait_until(end) );
+	}
+
+#ifdef __linux__
+	SECTION("eventfd is signalled") {
+		int fd = notifier.get_fd();
+		REQUIRE( fd >= 0 );
+		notifier.records_available(1);
+		notifier.finish();
+		uint64_t count = 0;
+		REQUIRE( read(fd, &count, sizeof(count)) == sizeof(count) );
+		REQUIRE( count == 2 );
+	}
+#endif
+}
@@ -0,0 +1,159 @@
+#include "catch.hpp"
+
+#include <cmath>
+#include <random>
+#include <vector>
+using std::vector;
+#include <cstdint>
+
+#include "Discriminator.h"
+#include "RecordView.h"
+#include "constants.h"
+#include "X6_errno.h"
+
+// a single result record holding the complex point (re, im)
+static vector<int32_t> point(const QDSPStream & stream, double re, double im) {
+	double scale = stream.fixed_to_float();
+	return {static_cast<int32_t>(std::lrint(re * scale)), static_cast<int32_t>(std::lrint(im * scale))};
+}
+
+static void add_point(Discriminator & disc, int index, const QDSPStream & stream, double re, double im) {
+	vector<int32_t> record = point(stream, re, im);
+	disc.add_record(index, RecordView<int32_t>(record.data(), record.size()));
+}
+
+TEST_CASE("Discriminator streams", "[Discriminator]") {
+	QDSPStream states(DISCRIMINATOR_CHANNEL, 3, 0);
+	CHECK( states.type == STATE );
+	CHECK( states.is_discriminator() );
+	CHECK( states.computed_on_host() );
+	CHECK( states.calc_record_length(4096) == 2 );
+	// discriminators 8-15 are not host DSP channels
+	CHECK_FALSE( QDSPStream(DISCRIMINATOR_CHANNEL, 9, 0).is_host() );
+	CHECK_FALSE( QDSPStream(1, 1, 1).computed_on_host() );
+}
+
+TEST_CASE("Discriminator classifiers", "[Discriminator]") {
+	QDSPStream result(1, 1, 1);
+	QDSPStream rawResult(1, 0, 1);
+
+	SECTION("nearest centroid") {
+		// three states on a line
+		Discriminator disc({result}, DISCRIMINATOR_NEAREST_CENTROID, 3, {-1, 0, 0, 0, 1, 0});
+		disc.reset(1, 1, 100);
+		double points[][2] = {{-0.9, 0.2}, {0.1, -0.3}, {0.8, 0.4}, {0.45, 0}, {-0.6, 0}};
+		for (auto & p : points) {
+			add_point(disc, 0, result, p[0], p[1]);
+		}
+		REQUIRE( disc.classify() == 5 );
+		const vector<int32_t> & states = disc.get_states();
+		vector<int32_t> expected = {0, 0, 1, 0, 2, 0, 1, 0, 0, 0};
+		CHECK( states == expected );
+		// nothing left to classify
+		CHECK( disc.classify() == 0 );
+	}
+
+	SECTION("linear") {
+		// state 1 above the line im = re, state 0 below
+		Discriminator disc({result}, DISCRIMINATOR_LINEAR, 2, {0, 0, 0, -1, 1, 0});
+		disc.reset(1, 1, 100);
+		add_point(disc, 0, result, 0.5, 0.1);
+		add_point(disc, 0, result, -0.2, 0.3);
+		REQUIRE( disc.classify() == 2 );
+		CHECK( disc.get_states()[0] == 0 );
+		CHECK( disc.get_states()[2] == 1 );
+	}
+
+	SECTION("Gaussian over two inputs") {
+		// two inputs make four features; each state's covariance is diagonal
+		// but stretched along a different feature
+		const size_t D = 4;
+		vector<vector<double>> means = {{0, 0, 0, 0}, {0.4, 0, 0.4, 0}};
+		vector<vector<double>> variances = {{0.25, 0.01, 0.01, 0.01}, {0.01, 0.01, 0.25, 0.01}};
+		vector<double> priors = {0.3, 0.7};
+		vector<double> params;
+		for (size_t k = 0; k < 2; k++) {
+			params.insert(params.end(), means[k].begin(), means[k].end());
+			for (size_t i = 0; i < D; i++) {
+				for (size_t j = 0; j < D; j++) {
+					params.push_back(i == j ? variances[k][i] : 0);
+				}
+			}
+			params.push_back(priors[k]);
+		}
+		REQUIRE( params.size() == Discriminator::num_parameters(DISCRIMINATOR_GAUSSIAN, 2, 2) );
+		Discriminator disc({result, rawResult}, DISCRIMINATOR_GAUSSIAN, 2, params);
+		REQUIRE( disc.get_dimension() == D );
+
+		std::mt19937 gen(42);
+		std::uniform_real_distribution<double> dist(-0.6, 0.8);
+		vector<vector<double>> features;
+		for (size_t n = 0; n < 200; n++) {
+			features.push_back({dist(gen), dist(gen) / 4, dist(gen), dist(gen) / 4});
+		}
+		disc.reset(1, 1, 1000);
+		for (auto & x : features) {
+			add_point(disc, 0, result, x[0], x[1]);
+		}
+		// nothing is classified until the second input catches up
+		CHECK( disc.classify() == 0 );
+		for (auto & x : features) {
+			add_point(disc, 1, rawResult, x[2], x[3]);
+		}
+		REQUIRE( disc.classify() == features.size() );
+
+		bool allMatch = true;
+		for (size_t n = 0; n < features.size(); n++) {
+			// features as the discriminator sees them after fixed point
+			vector<int32_t> a = point(result, features[n][0], features[n][1]);
+			vector<int32_t> b = point(rawResult, features[n][2], features[n][3]);
+			double x[D] = {a[0] / double(result.fixed_to_float()), a[1] / double(result.fixed_to_float()),
+			               b[0] / double(rawResult.fixed_to_float()), b[1] / double(rawResult.fixed_to_float())};
+			double best = -INFINITY;
+			int bestClass = 0;
+			for (int k = 0; k < 2; k++) {
+				double score = std::log(priors[k]);
+				for (size_t i = 0; i < D; i++) {
+					double dx = x[i] - means[k][i];
+					score -= 0.5 * (dx * dx / variances[k][i] + std::log(variances[k][i]));
+				}
+				if (score > best) {
+					best = score;
+					bestClass = k;
+				}
+			}
+			allMatch = allMatch && (disc.get_states()[2*n] == bestClass);
+		}
+		CHECK( allMatch );
+	}
+
+	SECTION("counts per segment") {
+		// 2 segments of 2 waveforms, and records beyond the acquisition ignored
+		Discriminator disc({result}, DISCRIMINATOR_NEAREST_CENTROID, 2, {0, 0, 1, 0});
+		disc.reset(2, 2, 8);
+		double re[] = {0, 1, 1, 1, 0, 0, 0, 1, 1, 1};
+		for (double val : re) {
+			add_point(disc, 0, result, val, 0);
+		}
+		REQUIRE( disc.classify() == 10 );
+		CHECK( disc.recordsTaken == 8 );
+		REQUIRE( disc.get_counts_size() == 4 );
+		vector<uint64_t> counts(4);
+		disc.snapshot_counts(counts.data());
+		// segment 0 saw {0, 1, 0, 0} and segment 1 saw {1, 1, 0, 1}
+		vector<uint64_t> expected = {3, 1, 1, 3};
+		CHECK( counts == expected );
+	}
+
+	SECTION("invalid parameters") {
+		CHECK_THROWS_AS( Discriminator({result}, DISCRIMINATOR_LINEAR, 2, {1, 2, 3}), X6_STATUS );
+		CHECK_THROWS_AS( Discriminator({result}, DISCRIMINATOR_NEAREST_CENTROID, 1, {0, 0}), X6_STATUS );
+		CHECK_THROWS_AS( Discriminator({}, DISCRIMINATOR_NEAREST_CENTROID, 2, {}), X6_STATUS );
+		// covariance that is not positive definite
+		CHECK_THROWS_AS( Discriminator({result}, DISCRIMINATOR_GAUSSIAN, 2,
+			{0, 0, 1, 2, 2, 1, 0.5, 1, 1, 1, 0, 0, 1, 0.5}), X6_STATUS );
+		// non-positive prior
+		CHECK_THROWS_AS( Discriminator({result}, DISCRIMINATOR_GAUSSIAN, 2,
+			{0, 0, 1, 0, 0, 1, 0, 1, 1, 1, 0, 0, 1, 0.5}), X6_STATUS );
+	}
+}
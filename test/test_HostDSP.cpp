@@ -0,0 +1,166 @@
+#include "catch.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <numeric>
+#include <vector>
+using std::vector;
+#include <cstdint>
+
+#include "HostDSP.h"
+#include "X6_errno.h"
+
+static const double PI = 3.14159265358979323846;
+
+// raw record of a cosine at the given fraction of the raw sample rate
+static vector<int16_t> tone(size_t len, double freq, double amplitude, double phase = 0) {
+	vector<int16_t> raw(len);
+	for (size_t n = 0; n < len; n++) {
+		raw[n] = static_cast<int16_t>(std::lrint(amplitude * (1 << 13) * std::cos(2 * PI * freq * n + phase)));
+	}
+	return raw;
+}
+
+TEST_CASE("Host DSP streams", "[HostDSP]") {
+
+	SECTION("classification and record length") {
+		QDSPStream demod(1, 8, 0);
+		QDSPStream result(1, 8, 2);
+		CHECK( demod.is_host() );
+		CHECK( demod.type == DEMOD );
+		CHECK( result.type == RESULT );
+		CHECK_FALSE( QDSPStream(1, 1, 0).is_host() );
+		// without a host decimation the demod length matches the firmware's
+		CHECK( demod.calc_record_length(4096) == QDSPStream(1, 1, 0).calc_record_length(4096) );
+		demod.hostDecimation = 4;
+		CHECK( demod.calc_record_length(4096) == 2 * 4096 / RAW_DECIMATION_FACTOR / 4 );
+		CHECK( result.calc_record_length(4096) == 2 );
+	}
+}
+
+TEST_CASE("Host DSP down-conversion", "[HostDSP]") {
+	const size_t rawLength = 1024;
+	const double rawRate = 1.0;
+	HostDSP dsp;
+
+	SECTION("default filter has unity DC gain") {
+		for (unsigned decimation : {1u, 2u, 8u, 16u}) {
+			vector<double> taps = HostDSP::design_filter(decimation);
+			CHECK( std::accumulate(taps.begin(), taps.end(), 0.0) == Approx(1.0) );
+		}
+	}
+
+	SECTION("tone is mixed to DC and decimated") {
+		dsp.set_nco_frequency(1, 8, 0.125);
+		dsp.set_decimation(1, 8, 8, {});
+		dsp.prepare(rawRate, rawLength, {QDSPStream(1, 8, 0)});
+		REQUIRE( dsp.get_output_streams(1).size() == 1 );
+		CHECK( dsp.get_output_streams(1)[0] == QDSPStream(1, 8, 0).streamID );
+		CHECK( dsp.get_output_streams(2).empty() );
+
+		vector<int16_t> raw = tone(rawLength, 0.125, 0.5);
+		const vector<RecordView<int32_t>> & out = dsp.process(1, RecordView<int16_t>(raw.data(), raw.size()));
+		REQUIRE( out.size() == 1 );
+		REQUIRE( out[0].size() == 2 * rawLength / 8 );
+		// a real cosine of amplitude 0.5 leaves half of it at DC after mixing;
+		// skip the filter's start-up transient
+		const double scale = QDSPStream(1, 8, 0).fixed_to_float();
+		for (size_t m = 8; m < rawLength / 8; m++) {
+			CHECK( out[0][2*m] / scale == Approx(0.25).margin(2e-3) );
+			CHECK( out[0][2*m + 1] / scale == Approx(0.0).margin(2e-3) );
+		}
+	}
+
+	SECTION("kernel integration with bias") {
+		const size_t numOut = rawLength / 4;
+		dsp.set_nco_frequency(2, 9, 0.25);
+		dsp.set_decimation(2, 9, 4, {});
+		// a kernel longer than the decimated record is truncated
+		vector<complex<double>> kernel(numOut + 16, complex<double>(1.0 / numOut, 0));
+		dsp.write_kernel(2, 9, 1, kernel);
+		dsp.set_kernel_bias(2, 9, 1, complex<double>(0.1, -0.2));
+		CHECK( dsp.read_kernel(2, 9, 1, 3) == kernel[3] );
+		CHECK( dsp.get_kernel_bias(2, 9, 1) == complex<double>(0.1, -0.2) );
+		dsp.prepare(rawRate, rawLength, {QDSPStream(2, 9, 0), QDSPStream(2, 9, 1)});
+
+		// a sine leaves -i/4 at DC
+		vector<int16_t> raw = tone(rawLength, 0.25, 0.5, -PI / 2);
+		const vector<RecordView<int32_t>> & out = dsp.process(2, RecordView<int16_t>(raw.data(), raw.size()));
+		REQUIRE( out.size() == 2 );
+		REQUIRE( out[1].size() == 2 );
+		const double scale = QDSPStream(2, 9, 1).fixed_to_float();
+		// the filter transient costs the first few samples of the sum
+		CHECK( out[1][0] / scale == Approx(0.1).margin(0.01) );
+		CHECK( out[1][1] / scale == Approx(-0.2 - 0.25).margin(0.01) );
+	}
+
+	SECTION("custom filter taps") {
+		dsp.set_nco_frequency(1, 10, 0);
+		// boxcar average over each decimation window
+		dsp.set_decimation(1, 10, 2, {0.5, 0.5});
+		CHECK( dsp.get_decimation(1, 10) == 2 );
+		dsp.prepare(rawRate, 8, {QDSPStream(1, 10, 0)});
+		vector<int16_t> raw = {0, 2, 4, 6, 8, 10, 12, 14};
+		const vector<RecordView<int32_t>> & out = dsp.process(1, RecordView<int16_t>(raw.data(), raw.size()));
+		REQUIRE( out[0].size() == 8 );
+		const double scale = QDSPStream(1, 10, 0).fixed_to_float() / static_cast<double>(1 << 13);
+		for (size_t m = 0; m < 4; m++) {
+			CHECK( out[0][2*m] / scale == Approx(4.0 * m + 1) );
+			CHECK( out[0][2*m + 1] == 0 );
+		}
+	}
+
+	SECTION("configuration errors") {
+		CHECK_THROWS_AS( dsp.set_nco_frequency(1, 3, 0.1), X6_STATUS );
+		CHECK_THROWS_AS( dsp.set_decimation(1, 8, 0, {}), X6_STATUS );
+		CHECK_THROWS_AS( dsp.write_kernel(1, 8, 0, {complex<double>(1, 0)}), X6_STATUS );
+		// streams of a channel that was never configured
+		CHECK_THROWS_AS( dsp.prepare(rawRate, rawLength, {QDSPStream(1, 11, 0)}), X6_STATUS );
+		// a result stream without a kernel
+		dsp.set_nco_frequency(1, 11, 0.1);
+		CHECK_THROWS_AS( dsp.prepare(rawRate, rawLength, {QDSPStream(1, 11, 2)}), X6_STATUS );
+	}
+}
+
+TEST_CASE("Host DSP helper threads", "[HostDSP]") {
+	const size_t rawLength = 2048;
+	vector<QDSPStream> streams;
+	auto configure = [&streams](HostDSP & dsp) {
+		streams.clear();
+		for (unsigned b = HOST_DSP_FIRST_CHANNEL; b <= HOST_DSP_LAST_CHANNEL; b++) {
+			dsp.set_nco_frequency(1, b, 0.01 * b);
+			dsp.set_decimation(1, b, 2 + b % 3, {});
+			dsp.write_kernel(1, b, 1, vector<complex<double>>(64, complex<double>(0.01 * b, -0.02)));
+			streams.emplace_back(1, b, 0);
+			streams.emplace_back(1, b, 1);
+		}
+		dsp.set_nco_frequency(2, 8, 0.2);
+		dsp.write_kernel(2, 8, 1, vector<complex<double>>(16, complex<double>(0.5, 0.5)));
+		streams.emplace_back(2, 8, 1);
+	};
+
+	HostDSP single, threaded;
+	configure(single);
+	single.prepare(1.0, rawLength, streams);
+	configure(threaded);
+	threaded.set_num_threads(3);
+	std::atomic<unsigned> started{0};
+	threaded.set_thread_init([&started]() { started++; });
+	threaded.prepare(1.0, rawLength, streams);
+
+	bool allEqual = true;
+	for (unsigned record = 0; record < 200; record++) {
+		unsigned a = (record % 3 == 2) ? 2 : 1;
+		vector<int16_t> raw = tone(rawLength, 0.003 * (record + 1), 0.3, 0.1 * record);
+		RecordView<int16_t> view(raw.data(), raw.size());
+		const vector<RecordView<int32_t>> & expected = single.process(a, view);
+		const vector<RecordView<int32_t>> & actual = threaded.process(a, view);
+		REQUIRE( actual.size() == expected.size() );
+		for (size_t out = 0; out < expected.size(); out++) {
+			allEqual = allEqual && std::equal(expected[out].begin(), expected[out].end(), actual[out].begin());
+		}
+	}
+	CHECK( allEqual );
+	threaded.stop();
+	CHECK( started == 2 );
+}
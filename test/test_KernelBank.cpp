@@ -0,0 +1,94 @@
+#include "catch.hpp"
+
+#include <random>
+#include <vector>
+using std::vector;
+#include <cstdint>
+
+#include "KernelBank.h"
+#include "QDSPStream.h"
+#include "constants.h"
+#include "X6_errno.h"
+
+TEST_CASE("Kernel bank", "[KernelBank]") {
+	const double demodScale = QDSPStream(1, 1, 0).fixed_to_float();
+	const double resultScale = QDSPStream(1, 1, KERNEL_BANK_STREAM).fixed_to_float();
+
+	SECTION("stream classification") {
+		QDSPStream bank(1, 1, KERNEL_BANK_STREAM);
+		CHECK( bank.is_kernel_bank() );
+		CHECK( bank.type == RESULT );
+		CHECK_FALSE( QDSPStream(1, 0, KERNEL_BANK_STREAM).is_kernel_bank() );
+		CHECK( QDSPStream(1, 9, KERNEL_BANK_STREAM).is_kernel_bank() );
+		bank.bankSize = 12;
+		CHECK( bank.calc_record_length(4096) == 24 );
+	}
+
+	SECTION("empty banks and kernels are rejected") {
+		CHECK_THROWS_AS( KernelBank(vector<vector<complex<double>>>{}), X6_STATUS );
+		CHECK_THROWS_AS( KernelBank({{complex<double>(1, 0)}, {}}), X6_STATUS );
+	}
+
+	SECTION("constant record") {
+		const size_t M = 20;
+		vector<vector<complex<double>>> kernels = {
+			vector<complex<double>>(M, complex<double>(1, 0)),
+			vector<complex<double>>(M, complex<double>(0, 1)),
+			// shorter kernels are zero padded, longer ones truncated
+			vector<complex<double>>(5, complex<double>(1, 0)),
+			vector<complex<double>>(M + 7, complex<double>(0.5, 0))
+		};
+		KernelBank bank(kernels);
+		REQUIRE( bank.size() == 4 );
+		bank.prepare(M, demodScale, resultScale);
+
+		// 0.5 + 0.25i in every sample
+		vector<int16_t> record;
+		for (size_t n = 0; n < M; n++) {
+			record.push_back(static_cast<int16_t>(0.5 * demodScale));
+			record.push_back(static_cast<int16_t>(0.25 * demodScale));
+		}
+		const RecordView<int32_t> & out = bank.apply(RecordView<int16_t>(record.data(), record.size()));
+		REQUIRE( out.size() == 8 );
+		CHECK( out[0] / resultScale == Approx(0.5 * M) );
+		CHECK( out[1] / resultScale == Approx(0.25 * M) );
+		CHECK( out[2] / resultScale == Approx(-0.25 * M) );
+		CHECK( out[3] / resultScale == Approx(0.5 * M) );
+		CHECK( out[4] / resultScale == Approx(0.5 * 5) );
+		CHECK( out[5] / resultScale == Approx(0.25 * 5) );
+		CHECK( out[6] / resultScale == Approx(0.25 * M) );
+		CHECK( out[7] / resultScale == Approx(0.125 * M) );
+	}
+
+	SECTION("matches a direct complex product") {
+		const size_t M = 61;
+		const size_t K = 7;
+		std::mt19937 gen(1234);
+		std::uniform_real_distribution<double> dist(-0.5, 0.5);
+		vector<vector<complex<double>>> kernels(K);
+		for (auto & kernel : kernels) {
+			for (size_t n = 0; n < M; n++) {
+				kernel.emplace_back(dist(gen), dist(gen));
+			}
+		}
+		KernelBank bank(kernels);
+		// host demod records are 32-bit
+		bank.prepare(M, demodScale, resultScale);
+		vector<int32_t> record;
+		vector<complex<double>> samples;
+		for (size_t n = 0; n < M; n++) {
+			record.push_back(static_cast<int32_t>(dist(gen) * demodScale));
+			record.push_back(static_cast<int32_t>(dist(gen) * demodScale));
+			samples.emplace_back(record[2*n] / demodScale, record[2*n + 1] / demodScale);
+		}
+		const RecordView<int32_t> & out = bank.apply(RecordView<int32_t>(record.data(), record.size()));
+		for (size_t k = 0; k < K; k++) {
+			complex<double> expected = 0;
+			for (size_t n = 0; n < M; n++) {
+				expected += kernels[k][n] * samples[n];
+			}
+			CHECK( out[2*k] / resultScale == Approx(expected.real()).margin(1e-4) );
+			CHECK( out[2*k + 1] / resultScale == Approx(expected.imag()).margin(1e-4) );
+		}
+	}
+}
@@ -0,0 +1,117 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <complex>
+using std::complex;
+#include <map>
+#include <random>
+#include <vector>
+using std::vector;
+#include <cstdint>
+
+#include "constants.h"
+#include "KernelPacking.h"
+#include "RegisterBus.h"
+#include "X6_errno.h"
+
+// the point by point conversion write_kernel used to do
+static uint32_t reference_word(complex<double> val) {
+	auto scale_with_clip = [](double v) {
+		v = std::min(v, MAX_KERNEL_VALUE);
+		v = std::max(v, MIN_KERNEL_VALUE);
+		return v * (1 << KERNEL_FRAC_BITS);
+	};
+	int32_t re = scale_with_clip(std::real(val));
+	int32_t im = scale_with_clip(std::imag(val));
+	return (static_cast<uint32_t>(im) << 16) | (static_cast<uint32_t>(re) & 0xffff);
+}
+
+// kernel memory behind an address/data register pair
+struct KernelMemorySpace {
+	std::map<uint32_t, uint32_t> * memory;
+	uint32_t addr = 0;
+
+	void write(uint32_t offset, uint32_t value) {
+		if (offset == 0) {
+			addr = value;
+		} else {
+			(*memory)[addr] = value;
+		}
+	}
+	uint32_t read(uint32_t offset) {
+		return offset == 0 ? addr : (*memory)[addr];
+	}
+};
+
+TEST_CASE("Kernel packing", "[KernelPacking]") {
+	std::mt19937 gen(7);
+	std::uniform_real_distribution<double> dist(-1.0, MAX_KERNEL_VALUE);
+	vector<complex<double>> kernel(MAX_RAW_KERNEL_LENGTH);
+	for (auto & val : kernel) {
+		val = complex<double>(dist(gen), dist(gen));
+	}
+	// the edges of the range and values that round into it
+	const double lsb = 1.0 / (1 << KERNEL_FRAC_BITS);
+	kernel[0] = complex<double>(-1.0, MAX_KERNEL_VALUE);
+	kernel[1] = complex<double>(MAX_KERNEL_VALUE + lsb, -1.0 - 0.25*lsb);
+	kernel[2] = complex<double>(0, -0.5*lsb);
+
+	SECTION("matches the point by point conversion") {
+		vector<uint32_t> words(kernel.size());
+		pack_kernel(kernel.data(), kernel.size(), words.data());
+		bool same = true;
+		for (size_t ct = 0; ct < kernel.size(); ct++) {
+			same &= words[ct] == reference_word(kernel[ct]);
+		}
+		CHECK( same );
+	}
+
+	SECTION("round trip") {
+		vector<uint32_t> words(kernel.size());
+		pack_kernel(kernel.data(), kernel.size(), words.data());
+		vector<complex<double>> readback(kernel.size());
+		unpack_kernel(words.data(), words.size(), readback.data());
+		double worst = 0;
+		for (size_t ct = 3; ct < kernel.size(); ct++) {
+			worst = std::max(worst, std::abs(readback[ct] - kernel[ct]));
+		}
+		CHECK( worst < 3*lsb );
+	}
+
+	SECTION("out of range") {
+		vector<uint32_t> words(kernel.size());
+		kernel[100] = complex<double>(0, 1.01);
+		CHECK_THROWS_AS( pack_kernel(kernel.data(), kernel.size(), words.data()), X6_STATUS );
+		kernel[100] = complex<double>(-1.01, 0);
+		CHECK_THROWS_AS( pack_kernel(kernel.data(), kernel.size(), words.data()), X6_STATUS );
+	}
+
+	SECTION("upload and readback as one batch each") {
+		std::map<uint32_t, uint32_t> memory;
+		RegisterBus<KernelMemorySpace> bus([&memory](uint32_t) {
+			KernelMemorySpace space;
+			space.memory = &memory;
+			return space;
+		});
+		vector<uint32_t> words(kernel.size());
+		pack_kernel(kernel.data(), kernel.size(), words.data());
+
+		RegisterBatch upload;
+		for (size_t ct = 0; ct < words.size(); ct++) {
+			upload.write(0x2000, 0, ct);
+			upload.write(0x2000, 1, words[ct]);
+		}
+		bus.execute(upload);
+		REQUIRE( memory.size() == kernel.size() );
+
+		vector<uint32_t> readWords(kernel.size());
+		RegisterBatch readback;
+		for (size_t ct = 0; ct < words.size(); ct++) {
+			readback.write(0x2000, 0, ct);
+			readback.read(0x2000, 1, &readWords[ct]);
+		}
+		bus.execute(readback);
+		CHECK( readWords == words );
+		CHECK( bus.get_batches() == 2 );
+	}
+}
@@ -0,0 +1,165 @@
+#include "catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logging.h"
+#include "MPMCQueue.h"
+#include "AsyncFileAppender.h"
+#include <plog/Formatters/TxtFormatter.h>
+
+static std::string read_file(const std::string & name) {
+	std::ifstream in(name);
+	std::stringstream contents;
+	contents << in.rdbuf();
+	return contents.str();
+}
+
+static void write_record(plog::IAppender & appender, const std::string & msg) {
+	plog::Record record(plog::info, __FUNCTION__, __LINE__, __FILE__, 0);
+	record << msg;
+	appender.write(record);
+}
+
+TEST_CASE("MPMC queue", "[logging]") {
+
+	SECTION("fifo order and bounded capacity") {
+		MPMCQueue<int> queue(3);
+		CHECK( queue.capacity() == 4 );
+		for (int ct = 0; ct < 4; ct++) {
+			int val = ct;
+			CHECK( queue.push(std::move(val)) );
+		}
+		int extra = 99;
+		CHECK_FALSE( queue.push(std::move(extra)) );
+		CHECK( queue.size() == 4 );
+		int val;
+		for (int ct = 0; ct < 4; ct++) {
+			REQUIRE( queue.pop(val) );
+			CHECK( val == ct );
+		}
+		CHECK_FALSE( queue.pop(val) );
+	}
+
+	SECTION("concurrent producers lose nothing") {
+		MPMCQueue<int> queue(64);
+		const int numProducers = 4;
+		const int perProducer = 10000;
+		std::vector<std::thread> producers;
+		for (int p = 0; p < numProducers; p++) {
+			producers.emplace_back([&queue, p, perProducer]() {
+				for (int ct = 0; ct < perProducer; ct++) {
+					int val = p * perProducer + ct;
+					while (!queue.push(std::move(val))) {
+						std::this_thread::yield();
+					}
+				}
+			});
+		}
+		std::vector<int> seen(numProducers * perProducer, 0);
+		int received = 0;
+		int val;
+		while (received < numProducers * perProducer) {
+			if (queue.pop(val)) {
+				seen[val]++;
+				received++;
+			}
+		}
+		for (auto & t : producers) {
+			t.join();
+		}
+		bool allOnce = true;
+		for (int count : seen) {
+			allOnce = allOnce && (count == 1);
+		}
+		CHECK( allOnce );
+	}
+}
+
+TEST_CASE("Asynchronous file appender", "[logging]") {
+
+	SECTION("writes every queued line") {
+		std::remove("test_async.log");
+		{
+			AsyncFileAppender<plog::TxtFormatter> appender("test_async.log");
+			write_record(appender, "first line");
+			write_record(appender, "second line");
+			appender.flush();
+			CHECK( appender.get_written() == 2 );
+			CHECK( appender.get_dropped() == 0 );
+			std::string contents = read_file("test_async.log");
+			CHECK( contents.find("first line") != std::string::npos );
+			CHECK( contents.find("second line") > contents.find("first line") );
+		}
+		std::remove("test_async.log");
+	}
+
+	SECTION("drops lines rather than blocking when the ring is full") {
+		std::remove("test_drop.log");
+		const unsigned numLines = 2000;
+		{
+			AsyncFileAppender<plog::TxtFormatter> appender("test_drop.log", 0, 0, 2);
+			for (unsigned ct = 0; ct < numLines; ct++) {
+				write_record(appender, "line " + std::to_string(ct));
+			}
+			appender.flush();
+			CHECK( appender.get_written() + appender.get_dropped() == numLines );
+		}
+		std::remove("test_drop.log");
+	}
+
+	SECTION("rolls over to numbered files") {
+		const char * names[] = {"test_roll.log", "test_roll.1.log", "test_roll.2.log"};
+		for (auto name : names) {
+			std::remove(name);
+		}
+		{
+			AsyncFileAppender<plog::TxtFormatter> appender("test_roll.log", 256, 3);
+			for (unsigned ct = 0; ct < 100; ct++) {
+				write_record(appender, "rolling line " + std::to_string(ct));
+				appender.flush();
+			}
+		}
+		std::string current = read_file("test_roll.log");
+		CHECK( current.size() <= 256 );
+		CHECK( current.find("rolling line 99") != std::string::npos );
+		CHECK_FALSE( read_file("test_roll.1.log").empty() );
+		CHECK_FALSE( read_file("test_roll.2.log").empty() );
+		CHECK( read_file("test_roll.3.log").empty() );
+		for (auto name : names) {
+			std::remove(name);
+		}
+	}
+}
+
+static int evaluations = 0;
+
+static int count_evaluation() {
+	return ++evaluations;
+}
+
+// compile the following statements as if the build capped logging at info
+#undef X6_LOG_MAX_SEVERITY
+#define X6_LOG_MAX_SEVERITY 4
+
+TEST_CASE("Compile-time log severity limit", "[logging]") {
+	evaluations = 0;
+	X6_LOG(plog::debug) << "never formatted " << count_evaluation();
+	X6_LOG(plog::verbose) << "never formatted " << count_evaluation();
+	X6_IF_LOG(plog::verbose) {
+		count_evaluation();
+	}
+	CHECK( evaluations == 0 );
+
+	// statements at or above the limit still go through the runtime check
+	REQUIRE( plog::get() );
+	plog::Severity saved = plog::get()->getMaxSeverity();
+	plog::get()->setMaxSeverity(plog::verbose);
+	X6_LOG(plog::info) << "formatted " << count_evaluation();
+	plog::get()->setMaxSeverity(saved);
+	CHECK( evaluations == 1 );
+}
@@ -0,0 +1,129 @@
+#include "catch.hpp"
+
+#include <vector>
+using std::vector;
+#include <cstdint>
+
+#ifdef __linux__
+	#include <fstream>
+	#include <unistd.h>
+
+// resident set size of the test process
+static size_t resident_bytes() {
+	std::ifstream statm("/proc/self/statm");
+	size_t total = 0, resident = 0;
+	statm >> total >> resident;
+	return resident * sysconf(_SC_PAGESIZE);
+}
+#endif
+
+#include "MemoryPolicy.h"
+#include "Accumulator.h"
+#include "RecordQueue.h"
+#include "RecordView.h"
+
+TEST_CASE("Stream buffer allocation", "[memory]") {
+	MemoryStats before = MemoryPolicy::get_stats();
+
+	SECTION("small buffers come from the heap in every mode") {
+		MemoryPolicy::set_mode(HUGEPAGE_TRANSPARENT);
+		{
+			vector<int64_t, HugePageAllocator<int64_t>> small(128, 1);
+			CHECK( reinterpret_cast<uintptr_t>(small.data()) % 64 == 0 );
+			MemoryStats during = MemoryPolicy::get_stats();
+			CHECK( during.bytesInUse == before.bytesInUse + 128 * sizeof(int64_t) );
+			CHECK( during.hugePageBytes == before.hugePageBytes );
+		}
+		CHECK( MemoryPolicy::get_stats().bytesInUse == before.bytesInUse );
+		MemoryPolicy::set_mode(HUGEPAGE_NONE);
+	}
+
+#ifdef __linux__
+	SECTION("large buffers are huge page aligned and zeroed") {
+		MemoryPolicy::set_mode(HUGEPAGE_TRANSPARENT);
+		const size_t len = (4 << 20) / sizeof(int64_t);
+		{
+			vector<int64_t, HugePageAllocator<int64_t>> big(len);
+			CHECK( reinterpret_cast<uintptr_t>(big.data()) % (2 << 20) == 0 );
+			CHECK( big[0] == 0 );
+			CHECK( big[len-1] == 0 );
+			MemoryStats during = MemoryPolicy::get_stats();
+			CHECK( during.hugePageBytes == before.hugePageBytes + len * sizeof(int64_t) );
+			CHECK( during.peakBytes >= during.bytesInUse );
+		}
+		CHECK( MemoryPolicy::get_stats().hugePageBytes == before.hugePageBytes );
+		MemoryPolicy::set_mode(HUGEPAGE_NONE);
+	}
+
+	SECTION("explicit huge pages fall back when none are reserved") {
+		MemoryPolicy::set_mode(HUGEPAGE_EXPLICIT);
+		{
+			vector<int32_t, HugePageAllocator<int32_t>> big(1 << 20, 7);
+			CHECK( big[12345] == 7 );
+			// reserved hugetlbfs pages or the transparent fallback; both count as huge
+			MemoryStats during = MemoryPolicy::get_stats();
+			CHECK( during.hugePageBytes == before.hugePageBytes + big.size() * sizeof(int32_t) );
+		}
+		MemoryPolicy::set_mode(HUGEPAGE_NONE);
+	}
+
+	SECTION("first touch from pinned CPUs") {
+		MemoryPolicy::set_first_touch_cpus(0x1);
+		{
+			vector<int64_t, HugePageAllocator<int64_t>> big((2 << 20) / sizeof(int64_t), 3);
+			CHECK( big.back() == 3 );
+		}
+		MemoryPolicy::set_first_touch_cpus(0);
+	}
+
+	SECTION("reserved record queue capacity is not touched up front") {
+		// 64 MB of capacity, with first touch on as it is during acquire()
+		QDSPStream stream(1, 0, 0);
+		RecordQueue<int32_t> queue(stream, 1024, 65536);
+		size_t residentBefore = resident_bytes();
+		MemoryPolicy::set_first_touch_cpus(0x1);
+		queue.reserve_storage();
+		MemoryPolicy::set_first_touch_cpus(0);
+		CHECK( MemoryPolicy::get_stats().bytesInUse >= before.bytesInUse + (64 << 20) );
+		CHECK( resident_bytes() < residentBefore + (8 << 20) );
+	}
+#endif
+}
+
+TEST_CASE("Record queue linear storage", "[memory]") {
+	QDSPStream stream(1, 0, 1);
+	RecordQueue<int32_t> queue(stream, 1024, 3);
+	queue.reserve_storage();
+	vector<uint32_t> words = {10, 20};
+	auto record = RecordView<int32_t>::from_words(words.data(), words.size());
+
+	queue.push(record);
+	queue.push(record);
+	REQUIRE( queue.get_buffer_size() == 4 );
+
+	vector<double> out(4);
+	queue.get(out.data(), 2);
+	REQUIRE( queue.get_buffer_size() == 2 );
+	queue.get(out.data() + 2, 2);
+	const double scale = stream.fixed_to_float();
+	CHECK( out[0] * scale == 10 );
+	CHECK( out[3] * scale == 20 );
+
+	// drained queue rewinds and keeps accepting up to the expected count
+	queue.push(record);
+	queue.push(record);
+	CHECK( queue.recordsTaken == 3 );
+	CHECK( queue.get_buffer_size() == 2 );
+
+	// reset for another acquisition keeps the storage it has
+	MemoryStats filled = MemoryPolicy::get_stats();
+	queue.reset();
+	CHECK( queue.recordsTaken == 0 );
+	CHECK( queue.get_buffer_size() == 0 );
+	CHECK( MemoryPolicy::get_stats().bytesInUse == filled.bytesInUse );
+	for (int ct = 0; ct < 4; ct++) {
+		queue.push(record);
+	}
+	CHECK( queue.recordsTaken == 3 );
+	CHECK( queue.get_buffer_size() == 6 );
+}
@@ -0,0 +1,206 @@
+#include "catch.hpp"
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <map>
+using std::map;
+#include <tuple>
+#include <vector>
+using std::vector;
+#include <cstdint>
+
+#include "constants.h"
+#include "DSPShadow.h"
+#include "RearmSession.h"
+#include "RegisterBus.h"
+#include "QDSPStream.h"
+#include "Accumulator.h"
+#include "Correlator.h"
+#include "RecordQueue.h"
+#include "RecordView.h"
+
+// the per-stream state X6_1000::acquire() sets up, built the same way
+struct StreamState {
+	map<uint16_t, QDSPStream> streams;
+	map<uint16_t, Accumulator> accumulators;
+	map<vector<uint16_t>, Correlator> correlators;
+	map<uint16_t, RecordQueue<int32_t>> queues;
+
+	StreamState(unsigned numChannels, unsigned numDemod, unsigned numKernels) {
+		for (unsigned a = 1; a <= numChannels; a++) {
+			add(QDSPStream(a, 0, 0));
+			for (unsigned b = 1; b <= numDemod; b++) {
+				add(QDSPStream(a, b, 0));
+				for (unsigned c = 1; c <= numKernels; c++) {
+					add(QDSPStream(a, b, c));
+				}
+			}
+		}
+	}
+
+	void add(const QDSPStream & stream) {
+		streams[stream.streamID] = stream;
+	}
+
+	void build(size_t recordLength, size_t numSegments, size_t waveforms, size_t numRecords) {
+		accumulators.clear();
+		queues.clear();
+		correlators.clear();
+		vector<uint16_t> resultChans;
+		for (auto & kv : streams) {
+			accumulators[kv.first] = Accumulator(kv.second, recordLength, numSegments, waveforms);
+			queues.emplace(std::piecewise_construct, std::forward_as_tuple(kv.first),
+			               std::forward_as_tuple(kv.second, recordLength, numRecords));
+			if (kv.second.type == RESULT) {
+				resultChans.push_back(kv.first);
+			}
+		}
+		for (int n = 2; n < MAX_N_BODY_CORRELATIONS; n++) {
+			for (auto c : combinations(resultChans.size(), n)) {
+				vector<uint16_t> ids;
+				vector<QDSPStream> inputs;
+				for (int i = 0; i < n; i++) {
+					ids.push_back(resultChans[c[i]]);
+					inputs.push_back(streams[ids.back()]);
+				}
+				correlators[ids] = Correlator(inputs, numSegments, waveforms);
+			}
+		}
+	}
+
+	void reset() {
+		for (auto & kv : accumulators) {
+			kv.second.reset();
+		}
+		for (auto & kv : queues) {
+			kv.second.reset();
+		}
+		for (auto & kv : correlators) {
+			kv.second.reset();
+		}
+	}
+
+	// one shot of every result stream, the value depending on the shot
+	void run_results(size_t numShots) {
+		vector<uint32_t> words(2);
+		for (size_t shot = 0; shot < numShots; shot++) {
+			for (auto & kv : streams) {
+				if (kv.second.type != RESULT) {
+					continue;
+				}
+				words[0] = static_cast<uint32_t>(shot * 1000 + kv.first);
+				words[1] = static_cast<uint32_t>(shot * 7);
+				auto record = RecordView<int32_t>::from_words(words.data(), words.size());
+				accumulators.at(kv.first).accumulate(record);
+				for (auto & corr : correlators) {
+					int index = corr.second.get_buffer_index(kv.first);
+					if (index >= 0) {
+						corr.second.accumulate_buffer(index, record);
+					}
+				}
+			}
+		}
+	}
+};
+
+TEST_CASE("Stream state reset in place matches a rebuild", "[rearm]") {
+	const size_t numSegments = 4, numShots = 40;
+	StreamState reused(1, 2, 2), fresh(1, 2, 2);
+	reused.build(1024, numSegments, 1, numShots);
+	fresh.build(1024, numSegments, 1, numShots);
+
+	// a first acquisition into the state that is then reset
+	reused.run_results(numShots / 2);
+	reused.reset();
+	reused.run_results(numShots);
+	fresh.run_results(numShots);
+
+	for (auto & kv : fresh.accumulators) {
+		Accumulator & acc = reused.accumulators.at(kv.first);
+		REQUIRE( acc.recordsTaken == kv.second.recordsTaken );
+		if (acc.recordsTaken == 0) {
+			// raw and demod streams took no records, so their means are undefined
+			continue;
+		}
+		vector<double> expected(kv.second.get_buffer_size()), actual(acc.get_buffer_size());
+		kv.second.snapshot(expected.data());
+		acc.snapshot(actual.data());
+		CHECK( actual == expected );
+		vector<double> expectedVar(kv.second.get_variance_buffer_size()), actualVar(acc.get_variance_buffer_size());
+		kv.second.snapshot_variance(expectedVar.data());
+		acc.snapshot_variance(actualVar.data());
+		CHECK( actualVar == expectedVar );
+	}
+	for (auto & kv : fresh.correlators) {
+		Correlator & corr = reused.correlators.at(kv.first);
+		REQUIRE( corr.recordsTaken == kv.second.recordsTaken );
+		vector<double> expected(kv.second.get_buffer_size()), actual(corr.get_buffer_size());
+		kv.second.snapshot(expected.data());
+		corr.snapshot(actual.data());
+		CHECK( actual == expected );
+	}
+}
+
+TEST_CASE("Register writes that keep a re-arm", "[rearm]") {
+	const DSPLayout dsp(2, 2);
+	RearmSession session;
+	CHECK_FALSE( session.is_valid() );
+	session.validate();
+
+	// set_threshold and set_nco_frequency between two acquisitions
+	session.written(BASE_DSP[0]);
+	session.written(BASE_DSP[1]);
+	// a kernel upload and a pulse waveform, in batches
+	RegisterBatch batch;
+	batch.write(BASE_DSP[0], dsp.rawKernelAddrData, 0);
+	batch.write(BASE_DSP[0], dsp.rawKernelAddrData + 1, 0x12345678);
+	batch.write(BASE_PG[1], WB_PG_WF_ADDR, 0);
+	batch.write(BASE_PG[1], WB_PG_WF_DATA, 0x7fff7fff);
+	session.written(batch);
+	// pulse generator control is written again at every acquire()
+	session.written(BASE_PG[0]);
+	CHECK( session.is_valid() );
+
+	// reads of any block
+	RegisterBatch reads;
+	uint32_t value;
+	reads.read(0x0800, 0x5, &value);
+	session.written(reads);
+	CHECK( session.is_valid() );
+
+	// a raw write elsewhere may undo trigger or Velo setup
+	session.written(0x0800);
+	CHECK_FALSE( session.is_valid() );
+	session.validate();
+	RegisterBatch mixed;
+	mixed.write(BASE_DSP[0], dsp.threshold, 1);
+	mixed.write(0x0800, 0x9, 0);
+	session.written(mixed);
+	CHECK_FALSE( session.is_valid() );
+}
+
+TEST_CASE("Per-acquisition stream setup time", "[.benchmark]") {
+	// two channels of two demodulators with two kernels each, as in a
+	// parameter sweep of many short averaged acquisitions
+	const size_t recordLength = 4096, numSegments = 64, waveforms = 1, roundRobins = 100;
+	const size_t numRecords = numSegments * waveforms * roundRobins;
+	const int numAcquisitions = 200;
+	StreamState state(2, 2, 2);
+	state.build(recordLength, numSegments, waveforms, numRecords);
+
+	typedef std::chrono::steady_clock Clock;
+	auto time = [&](std::function<void()> setup) {
+		auto start = Clock::now();
+		for (int ct = 0; ct < numAcquisitions; ct++) {
+			setup();
+		}
+		return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / numAcquisitions;
+	};
+	double rebuild = time([&]() { state.build(recordLength, numSegments, waveforms, numRecords); });
+	double reset = time([&]() { state.reset(); });
+
+	std::cout << state.streams.size() << " streams, " << state.correlators.size() << " correlators: "
+	          << rebuild << " us to rebuild, " << reset << " us to reset in place per acquisition" << std::endl;
+	CHECK( reset > 0 );
+}
@@ -0,0 +1,117 @@
+#include "catch.hpp"
+
+#include <vector>
+using std::vector;
+#include <cstdint>
+
+#include "RecordConsumer.h"
+
+struct Captured {
+	int deviceID = -1;
+	unsigned calls = 0;
+	vector<uint16_t> streamIDs;
+	vector<vector<int32_t>> records;
+	vector<RecordMetadata> metadata;
+	uint32_t sampleBytes = 0;
+	double scale = 0;
+};
+
+static void capture(int deviceID, const RecordBatchView * view, void * context) {
+	Captured & c = *static_cast<Captured *>(context);
+	c.deviceID = deviceID;
+	c.calls++;
+	c.sampleBytes = view->sampleBytes;
+	c.scale = view->scale;
+	for (unsigned ct = 0; ct < view->numRecords; ct++) {
+		c.streamIDs.push_back(view->streamID);
+		const int32_t * samples = static_cast<const int32_t *>(view->records[ct]);
+		c.records.emplace_back(samples, samples + view->recordLength);
+		c.metadata.push_back(view->metadata[ct]);
+	}
+}
+
+TEST_CASE("record consumers", "[consumer]") {
+	// one physical stream and two result streams in demux slot order
+	vector<QDSPStream> slotStreams = {QDSPStream(1, 0, 0), QDSPStream(1, 0, 1), QDSPStream(1, 0, 2)};
+	RecordConsumers consumers;
+	Captured results, raw;
+	consumers.set(slotStreams[1].streamID, capture, &results);
+	REQUIRE_FALSE( consumers.empty() );
+
+	// 2 segments of 3 waveforms, 10 records per stream
+	consumers.bind(3, slotStreams, 10, 3, 2);
+
+	vector<uint32_t> data = {1, 2, 3, 4, 5, 6, 7, 8};
+	VitaHeader vh;
+	vh.timestampSeconds = 42;
+	vh.timestampFractional = 7;
+	vh.packetCount = 5;
+
+	SECTION("records are batched per stream and passed without a copy") {
+		consumers.add_record(1, &data[0], 2, vh);
+		consumers.add_record(0, &data[2], 4, vh);
+		consumers.add_record(2, &data[4], 2, vh);
+		consumers.add_record(1, &data[6], 2, vh);
+		CHECK( results.calls == 0 );
+		consumers.dispatch();
+
+		CHECK( results.calls == 1 );
+		CHECK( results.deviceID == 3 );
+		REQUIRE( results.records.size() == 2 );
+		CHECK( results.records[0] == vector<int32_t>({1, 2}) );
+		CHECK( results.records[1] == vector<int32_t>({7, 8}) );
+		CHECK( results.sampleBytes == 4 );
+		CHECK( results.scale == slotStreams[1].fixed_to_float() );
+		CHECK( results.streamIDs[0] == slotStreams[1].streamID );
+		CHECK( results.metadata[1].recordIndex == 1 );
+		CHECK( results.metadata[1].timestampSeconds == 42 );
+		CHECK( results.metadata[1].packetCount == 5 );
+
+		// nothing pending means no call
+		consumers.dispatch();
+		CHECK( results.calls == 1 );
+	}
+
+	SECTION("metadata counts records across batches and stops at the acquisition size") {
+		for (unsigned ct = 0; ct < 12; ct++) {
+			consumers.add_record(1, &data[0], 2, vh);
+			if (ct % 4 == 3) {
+				consumers.dispatch();
+			}
+		}
+		REQUIRE( results.metadata.size() == 10 );
+		for (unsigned ct = 0; ct < 10; ct++) {
+			CHECK( results.metadata[ct].recordIndex == ct );
+			CHECK( results.metadata[ct].segment == (ct / 3) % 2 );
+		}
+	}
+
+	SECTION("reset restarts the record count of the bound slots") {
+		for (unsigned ct = 0; ct < 12; ct++) {
+			consumers.add_record(1, &data[0], 2, vh);
+		}
+		consumers.reset();
+		consumers.add_record(1, &data[0], 2, vh);
+		consumers.dispatch();
+		REQUIRE( results.metadata.size() == 1 );
+		CHECK( results.metadata[0].recordIndex == 0 );
+	}
+
+	SECTION("physical streams carry 16-bit samples") {
+		consumers.set(slotStreams[0].streamID, capture, &raw);
+		consumers.bind(3, slotStreams, 10, 3, 2);
+		consumers.add_record(0, &data[0], 4, vh);
+		consumers.dispatch();
+		CHECK( raw.sampleBytes == 2 );
+		CHECK( raw.calls == 1 );
+	}
+
+	SECTION("registrations apply from the next bind") {
+		consumers.clear();
+		CHECK( consumers.empty() );
+		consumers.bind(3, slotStreams, 10, 3, 2);
+		consumers.add_record(1, &data[0], 2, vh);
+		consumers.dispatch();
+		CHECK( results.calls == 0 );
+	}
+}
@@ -0,0 +1,89 @@
+#include "catch.hpp"
+
+#include <thread>
+#include <vector>
+using std::vector;
+#include <cstdint>
+
+#include "RegisterBus.h"
+#include "RegisterFile.h"
+
+TEST_CASE("Register bus", "[RegisterBus]") {
+	RegisterFile file;
+	unsigned spacesBuilt = 0;
+	RegisterBus<RegisterFile::Space> bus([&](uint32_t base) {
+		spacesBuilt++;
+		return RegisterFile::Space(file, base);
+	});
+
+	SECTION("single accesses reuse the address space of their base") {
+		bus.write(0x2000, 0x10, 42);
+		bus.write(0x2000, 0x11, 43);
+		bus.write(0x2100, 0x10, 44);
+		CHECK( bus.read(0x2000, 0x10) == 42 );
+		CHECK( bus.read(0x2000, 0x11) == 43 );
+		CHECK( bus.read(0x2100, 0x10) == 44 );
+		CHECK( bus.read(0x2100, 0x11) == 0 );
+		CHECK( spacesBuilt == 2 );
+		CHECK( bus.get_num_spaces() == 2 );
+		CHECK( bus.get_writes() == 3 );
+		CHECK( bus.get_reads() == 4 );
+
+		bus.reset();
+		CHECK( bus.read(0x2000, 0x10) == 42 );
+		CHECK( spacesBuilt == 3 );
+	}
+
+	SECTION("a batch runs in order in one pass") {
+		file.preset(0x2200, 0x05, 7);
+		uint32_t before = 0, after = 0, other = 0;
+		RegisterBatch batch;
+		batch.read(0x2000, 0x01, &before);
+		batch.write(0x2000, 0x01, 5);
+		batch.read(0x2000, 0x01, &after);
+		batch.read(0x2200, 0x05, &other);
+		batch.write(0x2000, 0x02, 6);
+		REQUIRE( batch.size() == 5 );
+		bus.execute(batch);
+
+		CHECK( before == 0 );
+		CHECK( after == 5 );
+		CHECK( other == 7 );
+		CHECK( spacesBuilt == 2 );
+		CHECK( bus.get_batches() == 1 );
+		auto & log = file.get_log();
+		REQUIRE( log.size() == batch.size() );
+		for (size_t ct = 0; ct < log.size(); ct++) {
+			CHECK( log[ct].base == batch.accesses()[ct].base );
+			CHECK( log[ct].offset == batch.accesses()[ct].offset );
+			CHECK( log[ct].write == (batch.accesses()[ct].result == nullptr) );
+		}
+	}
+
+	SECTION("address/data sequences from two threads do not interleave") {
+		// each thread writes a memory through an address/data register pair
+		const uint32_t numWords = 2000;
+		auto upload = [&bus, numWords](uint32_t base) {
+			RegisterBatch batch;
+			for (uint32_t addr = 0; addr < numWords; addr++) {
+				batch.write(base, 0x09, addr);
+				batch.write(base, 0x0A, base + addr);
+			}
+			bus.execute(batch);
+		};
+		std::thread threadA(upload, 0x2000);
+		std::thread threadB(upload, 0x2100);
+		threadA.join();
+		threadB.join();
+
+		auto & log = file.get_log();
+		REQUIRE( log.size() == 4 * numWords );
+		bool paired = true;
+		for (size_t ct = 0; ct < log.size(); ct += 2) {
+			paired &= log[ct].offset == 0x09 && log[ct + 1].offset == 0x0A &&
+			          log[ct + 1].base == log[ct].base && log[ct + 1].value == log[ct].base + log[ct].value;
+		}
+		CHECK( paired );
+		CHECK( bus.get_batches() == 2 );
+	}
+}
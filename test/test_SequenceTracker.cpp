@@ -0,0 +1,122 @@
+#include "catch.hpp"
+
+#include <vector>
+using std::vector;
+#include <cstdint>
+
+#include "VitaHeader.h"
+#include "SequenceTracker.h"
+
+// Build a VITA packet with stream ID, class ID, timestamps and trailer
+void append_vita_packet(vector<uint32_t> & buf, uint16_t sid, unsigned count, size_t payloadWords, uint32_t tsi = 0, uint64_t tsf = 0) {
+	uint32_t size = 7 + payloadWords + 1;
+	uint32_t header = (0x1u << 28) | (1u << 27) | (1u << 26) | (0x1u << 22) | (0x1u << 20) | ((count & 0xf) << 16) | size;
+	buf.push_back(header);
+	buf.push_back(sid);
+	buf.push_back(0); buf.push_back(0); // class ID
+	buf.push_back(tsi);
+	buf.push_back(tsf >> 32); buf.push_back(tsf & 0xffffffff);
+	for (size_t ct = 0; ct < payloadWords; ct++)
+		buf.push_back(ct);
+	buf.push_back(0); // trailer
+}
+
+// Walk a buffer of packets the same way the data handler does
+void track_buffer(SequenceTracker & tracker, const vector<uint32_t> & buf) {
+	size_t ct = 0;
+	while (ct < buf.size()) {
+		VitaHeader vh(buf.data() + ct);
+		tracker.track(vh.streamID, vh.packetCount);
+		ct += vh.packetSize;
+	}
+}
+
+TEST_CASE("VITA header decoding", "[vita]") {
+	vector<uint32_t> buf;
+	append_vita_packet(buf, 0x0111, 5, 2, 42, (uint64_t(3) << 32) + 7);
+	VitaHeader vh(buf.data());
+
+	REQUIRE( vh.streamID == 0x0111 );
+	REQUIRE( vh.packetCount == 5 );
+	REQUIRE( vh.packetSize == 10 );
+	REQUIRE( vh.headerSize == 7 );
+	REQUIRE( vh.hasTrailer );
+	REQUIRE( vh.payload_size() == 2 );
+	REQUIRE( vh.timestampSeconds == 42 );
+	REQUIRE( vh.timestampFractional == (uint64_t(3) << 32) + 7 );
+
+	// optional fields past the end of a truncated packet are not read
+	buf.resize(5);
+	buf[0] = (buf[0] & 0xffff0000) | 5;
+	VitaHeader truncated(buf.data());
+	REQUIRE( truncated.timestampSeconds == 42 );
+	REQUIRE( truncated.timestampFractional == 0 );
+	REQUIRE( truncated.headerSize == 7 );
+	REQUIRE( truncated.payload_size() == 0 );
+}
+
+TEST_CASE("VITA packet sequence tracking", "[sequence]") {
+	SequenceTracker tracker;
+	tracker.reset({0x0100, 0x0111});
+	vector<uint32_t> buf;
+
+	SECTION("continuous sequence with wrap around") {
+		for (unsigned ct = 0; ct < 40; ct++) {
+			append_vita_packet(buf, 0x0100, ct, 4);
+			append_vita_packet(buf, 0x0111, ct + 7, 2);
+		}
+		track_buffer(tracker, buf);
+		SequenceStats stats = tracker.get_stats(0x0100);
+		REQUIRE( stats.packets == 40 );
+		REQUIRE( stats.gaps == 0 );
+		REQUIRE( stats.duplicates == 0 );
+		REQUIRE( stats.outOfOrder == 0 );
+		REQUIRE( tracker.get_lost_packets() == 0 );
+	}
+
+	SECTION("gaps are counted per stream") {
+		for (unsigned ct : {0, 1, 2, 5, 6, 14, 15, 0}) {
+			append_vita_packet(buf, 0x0100, ct, 4);
+		}
+		append_vita_packet(buf, 0x0111, 0, 2);
+		append_vita_packet(buf, 0x0111, 1, 2);
+		track_buffer(tracker, buf);
+		SequenceStats stats = tracker.get_stats(0x0100);
+		REQUIRE( stats.packets == 8 );
+		REQUIRE( stats.gaps == 2 );
+		REQUIRE( stats.lostPackets == 2 + 7 );
+		REQUIRE( tracker.get_stats(0x0111).gaps == 0 );
+		REQUIRE( tracker.get_lost_packets() == 9 );
+	}
+
+	SECTION("duplicates and late packets") {
+		REQUIRE( tracker.track(0x0100, 3) == SEQUENCE_OK );
+		REQUIRE( tracker.track(0x0100, 4) == SEQUENCE_OK );
+		REQUIRE( tracker.track(0x0100, 4) == SEQUENCE_DUPLICATE );
+		REQUIRE( tracker.track(0x0100, 6) == SEQUENCE_GAP );
+		REQUIRE( tracker.track(0x0100, 5) == SEQUENCE_OUT_OF_ORDER );
+		REQUIRE( tracker.track(0x0100, 7) == SEQUENCE_OK );
+		// a second copy of the late packet is a duplicate
+		REQUIRE( tracker.track(0x0100, 5) == SEQUENCE_DUPLICATE );
+		SequenceStats stats = tracker.get_stats(0x0100);
+		REQUIRE( stats.gaps == 1 );
+		REQUIRE( stats.duplicates == 2 );
+		REQUIRE( stats.outOfOrder == 1 );
+		REQUIRE( stats.lostPackets == 0 );
+		REQUIRE( tracker.get_lost_packets() == 0 );
+	}
+
+	SECTION("late packets only recover the gap they fall in") {
+		REQUIRE( tracker.track(0x0100, 14) == SEQUENCE_OK );
+		REQUIRE( tracker.track(0x0100, 3) == SEQUENCE_GAP ); // 15, 0, 1, 2 lost
+		REQUIRE( tracker.track(0x0100, 0) == SEQUENCE_OUT_OF_ORDER );
+		REQUIRE( tracker.track(0x0100, 13) == SEQUENCE_DUPLICATE );
+		REQUIRE( tracker.get_stats(0x0100).lostPackets == 3 );
+		REQUIRE( tracker.get_lost_packets() == 3 );
+	}
+
+	SECTION("unregistered streams are ignored") {
+		REQUIRE( tracker.track(0x0222, 0) == SEQUENCE_UNKNOWN_STREAM );
+		REQUIRE( tracker.get_stats(0x0222).packets == 0 );
+	}
+}
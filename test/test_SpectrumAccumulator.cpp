@@ -0,0 +1,150 @@
+#include "catch.hpp"
+
+#include <cmath>
+#include <complex>
+using std::complex;
+#include <random>
+#include <vector>
+using std::vector;
+#include <cstdint>
+
+#include "FFT.h"
+#include "SpectrumAccumulator.h"
+#include "QDSPStream.h"
+
+static const double PI = 3.14159265358979323846;
+
+static vector<complex<double>> naive_dft(const vector<complex<double>> & x) {
+	size_t N = x.size();
+	vector<complex<double>> X(N);
+	for (size_t k = 0; k < N; k++) {
+		for (size_t n = 0; n < N; n++) {
+			X[k] += x[n] * std::polar(1.0, -2 * PI * ((k * n) % N) / N);
+		}
+	}
+	return X;
+}
+
+TEST_CASE("FFT", "[FFT]") {
+	std::mt19937 gen(7);
+	std::uniform_real_distribution<double> dist(-1, 1);
+
+	SECTION("matches a direct DFT") {
+		// radix 4 and 2, odd factors, primes and mixtures of them
+		for (size_t N : {1, 2, 3, 4, 5, 6, 7, 8, 12, 30, 64, 96, 97, 1000, 1024}) {
+			vector<complex<double>> x(N);
+			for (auto & val : x) {
+				val = complex<double>(dist(gen), dist(gen));
+			}
+			vector<complex<double>> X(N);
+			FFT(N).transform(x.data(), X.data());
+			vector<complex<double>> expected = naive_dft(x);
+			double maxErr = 0;
+			for (size_t k = 0; k < N; k++) {
+				maxErr = std::max(maxErr, std::abs(X[k] - expected[k]));
+			}
+			INFO( "N = " << N );
+			CHECK( maxErr < 1e-9 * N );
+		}
+	}
+
+	SECTION("real input") {
+		for (size_t N : {1, 2, 5, 6, 8, 30, 31, 1024}) {
+			vector<double> x(N);
+			vector<complex<double>> xc(N);
+			for (size_t n = 0; n < N; n++) {
+				x[n] = dist(gen);
+				xc[n] = x[n];
+			}
+			RealFFT fft(N);
+			REQUIRE( fft.num_bins() == N / 2 + 1 );
+			vector<complex<double>> X(fft.num_bins());
+			fft.transform(x.data(), X.data());
+			vector<complex<double>> expected = naive_dft(xc);
+			double maxErr = 0;
+			for (size_t k = 0; k < X.size(); k++) {
+				maxErr = std::max(maxErr, std::abs(X[k] - expected[k]));
+			}
+			INFO( "N = " << N );
+			CHECK( maxErr < 1e-9 * N );
+		}
+	}
+}
+
+TEST_CASE("SpectrumAccumulator", "[SpectrumAccumulator]") {
+	const size_t recordLength = 4096;
+
+	SECTION("raw tone") {
+		// raw records are the record length decimated by 4
+		QDSPStream raw(1, 0, 0);
+		const double scale = raw.fixed_to_float();
+		SpectrumAccumulator acc(raw, recordLength, 1, 1, SPECTRUM_WINDOW_RECTANGULAR);
+		const size_t N = raw.calc_record_length(recordLength);
+		REQUIRE( acc.get_num_bins() == N / 2 + 1 );
+		REQUIRE( acc.get_buffer_size() == N / 2 + 1 );
+
+		// a tone on bin 37 with amplitude 0.5 plus an offset of 0.25
+		vector<int16_t> record(N);
+		for (size_t n = 0; n < N; n++) {
+			record[n] = static_cast<int16_t>(std::lrint((0.25 + 0.5 * std::cos(2 * PI * 37 * n / N)) * scale));
+		}
+		acc.accumulate(record);
+		acc.accumulate(record);
+		CHECK( acc.recordsTaken == 2 );
+		vector<double> spectrum(acc.get_buffer_size());
+		acc.snapshot(spectrum.data());
+		// one-sided power of a cosine is A^2 / 2
+		CHECK( spectrum[0] == Approx(0.0625).epsilon(1e-3) );
+		CHECK( spectrum[37] == Approx(0.125).epsilon(1e-3) );
+		CHECK( spectrum[36] < 1e-6 );
+		CHECK( spectrum[38] < 1e-6 );
+	}
+
+	SECTION("demod noise sums to its power") {
+		QDSPStream demod(1, 1, 0);
+		const double scale = demod.fixed_to_float();
+		const size_t numSegments = 2;
+		SpectrumAccumulator acc(demod, recordLength, numSegments, 1, SPECTRUM_WINDOW_HANN);
+		const size_t N = demod.calc_record_length(recordLength) / 2;
+		REQUIRE( acc.get_num_bins() == N );
+
+		// segment 0 is quiet and segment 1 is complex noise of variance 0.02
+		std::mt19937 gen(11);
+		std::normal_distribution<double> noise(0, 0.1);
+		const size_t numRoundRobins = 50;
+		for (size_t rr = 0; rr < numRoundRobins; rr++) {
+			vector<int16_t> quiet(2 * N, 0);
+			acc.accumulate(quiet);
+			vector<int16_t> noisy(2 * N);
+			for (auto & val : noisy) {
+				val = static_cast<int16_t>(std::lrint(noise(gen) * scale));
+			}
+			acc.accumulate(noisy);
+		}
+		REQUIRE( acc.recordsTaken == 2 * numRoundRobins );
+
+		vector<double> spectrum(acc.get_buffer_size());
+		acc.snapshot(spectrum.data());
+		double quietPower = 0, noisePower = 0;
+		for (size_t k = 0; k < N; k++) {
+			quietPower += spectrum[k];
+			noisePower += spectrum[N + k];
+		}
+		CHECK( quietPower == 0 );
+		CHECK( noisePower == Approx(0.02).epsilon(0.05) );
+
+		acc.reset();
+		CHECK( acc.recordsTaken == 0 );
+		acc.snapshot(spectrum.data());
+		CHECK( spectrum[N + 1] == 0 );
+	}
+
+	SECTION("windows") {
+		vector<double> hann = SpectrumAccumulator::make_window(SPECTRUM_WINDOW_HANN, 8);
+		CHECK( hann[0] == Approx(0).margin(1e-12) );
+		CHECK( hann[4] == Approx(1) );
+		vector<double> bh = SpectrumAccumulator::make_window(SPECTRUM_WINDOW_BLACKMAN_HARRIS, 8);
+		CHECK( bh[0] == Approx(6e-5).margin(1e-6) );
+		CHECK( bh[4] == Approx(1) );
+	}
+}
@@ -0,0 +1,54 @@
+#include "catch.hpp"
+
+#include <thread>
+
+#include "ThreadTuner.h"
+#include "X6_errno.h"
+
+TEST_CASE("Thread tuning settings", "[threads]") {
+	ThreadTuner tuner;
+
+	SECTION("nothing applied until a thread picks the settings up") {
+		tuner.set_affinity(THREAD_PARSE, 0x3);
+		tuner.set_priority(THREAD_PARSE, 10);
+		ThreadSettings s = tuner.get_settings(THREAD_PARSE);
+		CHECK( s.requestedCPUs == 0x3 );
+		CHECK( s.requestedPriority == 10 );
+		CHECK( s.applied == 0 );
+	}
+
+	SECTION("invalid requests are rejected") {
+		CHECK_THROWS_AS( tuner.set_priority(THREAD_PROCESS, 100), X6_STATUS );
+		CHECK_THROWS_AS( tuner.set_priority(THREAD_PROCESS, -1), X6_STATUS );
+		CHECK_THROWS_AS( tuner.get_settings(static_cast<X6_THREAD_ROLE>(5)), X6_STATUS );
+	}
+
+#ifdef __linux__
+	SECTION("a thread pins itself to the requested core") {
+		tuner.set_affinity(THREAD_PROCESS, 0x1);
+		std::thread worker([&tuner]() { tuner.apply(THREAD_PROCESS); });
+		worker.join();
+		ThreadSettings s = tuner.get_settings(THREAD_PROCESS);
+		CHECK( s.applied == 1 );
+		CHECK( s.effectiveCPUs == 0x1 );
+		// without a real-time priority request the thread stays on normal scheduling
+		CHECK( s.effectivePriority == 0 );
+
+		tuner.reset();
+		CHECK( tuner.get_settings(THREAD_PROCESS).applied == 0 );
+		CHECK( tuner.get_settings(THREAD_PROCESS).requestedCPUs == 0x1 );
+	}
+
+	SECTION("a denied real-time request reports what was granted") {
+		// may or may not be permitted where the tests run; either way the
+		// effective priority must reflect reality and nothing throws
+		tuner.set_priority(THREAD_RECEIVE, 5);
+		std::thread worker([&tuner]() { tuner.apply(THREAD_RECEIVE); });
+		worker.join();
+		ThreadSettings s = tuner.get_settings(THREAD_RECEIVE);
+		CHECK( s.applied == 1 );
+		CHECK( (s.effectivePriority == 0 || s.effectivePriority == 5) );
+		CHECK( s.effectiveCPUs != 0 );
+	}
+#endif
+}
@@ -0,0 +1,54 @@
+#include "catch.hpp"
+
+#include <vector>
+using std::vector;
+#include <cstdint>
+
+#include "UploadCache.h"
+
+TEST_CASE("Upload cache", "[UploadCache]") {
+	UploadCache cache;
+	vector<uint32_t> words = {0x00010002, 0xfffe7fff, 0x80000001, 0};
+
+	SECTION("FNV-1a hash") {
+		// the offset basis for no data, and the hash of "abcd" on a little-endian host
+		CHECK( UploadCache::hash(nullptr, 0) == 14695981039346656037ull );
+		uint32_t abcd = 'a' | ('b' << 8) | ('c' << 16) | ('d' << 24);
+		CHECK( UploadCache::hash(&abcd, 1) == 0xfc179f83ee0724ddull );
+		// a trailing zero word still changes the hash
+		CHECK( UploadCache::hash(words.data(), 3) != UploadCache::hash(words.data(), 4) );
+	}
+
+	SECTION("unchanged content is skipped") {
+		uint64_t h = UploadCache::hash(words.data(), words.size());
+		REQUIRE( cache.needs_upload(1, h) );
+		cache.uploaded(1, h);
+		CHECK_FALSE( cache.needs_upload(1, h) );
+		// other slots are independent
+		CHECK( cache.needs_upload(2, h) );
+
+		words[2] ^= 1;
+		uint64_t changed = UploadCache::hash(words.data(), words.size());
+		CHECK( cache.needs_upload(1, changed) );
+		cache.uploaded(1, changed);
+		CHECK_FALSE( cache.needs_upload(1, changed) );
+
+		auto stats = cache.get_stats();
+		CHECK( stats.uploads == 2 );
+		CHECK( stats.skips == 2 );
+	}
+
+	SECTION("forced and failed uploads") {
+		uint64_t h = UploadCache::hash(words.data(), words.size());
+		cache.uploaded(1, h);
+		CHECK( cache.needs_upload(1, h, true) );
+		// the forced upload never finished so the slot content is unknown
+		CHECK( cache.needs_upload(1, h) );
+		cache.uploaded(1, h);
+		CHECK_FALSE( cache.needs_upload(1, h) );
+
+		cache.clear();
+		CHECK( cache.needs_upload(1, h) );
+		CHECK( cache.get_stats().skips == 1 );
+	}
+}
@@ -0,0 +1,211 @@
+#include "catch.hpp"
+
+#include <vector>
+using std::vector;
+#include <cstdint>
+#include <chrono>
+#include <iostream>
+
+#include "VitaDemux.h"
+#include "RecordView.h"
+#include "Accumulator.h"
+#include "StreamContext.h"
+
+// Build a VITA packet carrying the given payload words
+static void append_packet(vector<uint32_t> & buf, uint16_t sid, unsigned count, const vector<uint32_t> & payload) {
+	uint32_t size = 7 + payload.size() + 1;
+	uint32_t header = (0x1u << 28) | (1u << 27) | (1u << 26) | (0x1u << 22) | (0x1u << 20) | ((count & 0xf) << 16) | size;
+	buf.push_back(header);
+	buf.push_back(sid);
+	buf.push_back(0); buf.push_back(0); // class ID
+	buf.push_back(count); // integer timestamp
+	buf.push_back(0); buf.push_back(0);
+	buf.insert(buf.end(), payload.begin(), payload.end());
+	buf.push_back(0); // trailer
+}
+
+static vector<uint32_t> ramp(uint32_t start, size_t len) {
+	vector<uint32_t> v(len);
+	for (size_t ct = 0; ct < len; ct++)
+		v[ct] = start + ct;
+	return v;
+}
+
+struct Collected {
+	unsigned slot;
+	vector<uint32_t> data;
+	uint32_t timestampSeconds;
+};
+
+static void collect_into(VitaDemux & demux, vector<Collected> & records) {
+	demux.set_record_handler([&records](unsigned slot, const uint32_t * data, size_t numWords, const VitaHeader & vh) {
+		records.push_back({slot, vector<uint32_t>(data, data + numWords), vh.timestampSeconds});
+	});
+}
+
+TEST_CASE("VITA demultiplexer", "[demux]") {
+	VitaDemux demux;
+	unsigned physSlot = demux.add_stream(0x0100, 4);
+	unsigned resultSlot = demux.add_stream(0x0112, 2);
+	REQUIRE( demux.get_num_streams() == 2 );
+	REQUIRE( demux.get_slot(0x0100) == static_cast<int>(physSlot) );
+	REQUIRE( demux.get_slot(0x0112) == static_cast<int>(resultSlot) );
+	REQUIRE( demux.get_slot(0x0211) == -1 );
+
+	vector<Collected> records;
+	collect_into(demux, records);
+	vector<uint32_t> buf;
+
+	SECTION("interleaved streams are routed to their slots") {
+		append_packet(buf, 0x0100, 0, ramp(0, 4));
+		append_packet(buf, 0x0112, 0, ramp(100, 2));
+		append_packet(buf, 0x0211, 0, ramp(200, 3)); // not registered
+		append_packet(buf, 0x0100, 1, ramp(4, 4));
+		demux.parse(buf.data(), buf.size());
+
+		REQUIRE( demux.packetsParsed == 4 );
+		REQUIRE( records.size() == 3 );
+		CHECK( records[0].slot == physSlot );
+		CHECK( records[0].data == ramp(0, 4) );
+		CHECK( records[1].slot == resultSlot );
+		CHECK( records[1].data == ramp(100, 2) );
+		CHECK( records[2].slot == physSlot );
+		CHECK( records[2].data == ramp(4, 4) );
+	}
+
+	SECTION("packets holding several records are split") {
+		append_packet(buf, 0x0112, 0, ramp(0, 6));
+		demux.parse(buf.data(), buf.size());
+		REQUIRE( records.size() == 3 );
+		CHECK( records[2].data == ramp(4, 2) );
+	}
+
+	SECTION("records spanning packets are reassembled") {
+		append_packet(buf, 0x0100, 3, ramp(0, 3));
+		append_packet(buf, 0x0100, 4, ramp(3, 3));
+		append_packet(buf, 0x0100, 5, ramp(6, 2));
+		demux.parse(buf.data(), buf.size());
+		REQUIRE( records.size() == 2 );
+		CHECK( records[0].data == ramp(0, 4) );
+		CHECK( records[1].data == ramp(4, 4) );
+		// a record reports the header of the packet it started in
+		CHECK( records[0].timestampSeconds == 3 );
+		CHECK( records[1].timestampSeconds == 4 );
+	}
+
+	SECTION("packets split across buffers are carried over") {
+		append_packet(buf, 0x0100, 0, ramp(0, 4));
+		append_packet(buf, 0x0112, 0, ramp(100, 2));
+		for (size_t split = 1; split < buf.size(); split++) {
+			records.clear();
+			demux.reset();
+			demux.parse(buf.data(), split);
+			demux.parse(buf.data() + split, buf.size() - split);
+			INFO( "split at word " << split );
+			REQUIRE( records.size() == 2 );
+			CHECK( records[0].data == ramp(0, 4) );
+			CHECK( records[1].data == ramp(100, 2) );
+		}
+	}
+
+	SECTION("packet handler sees every header") {
+		vector<uint16_t> sids;
+		demux.set_packet_handler([&sids](const VitaHeader & vh) { sids.push_back(vh.streamID); });
+		append_packet(buf, 0x0100, 0, ramp(0, 4));
+		append_packet(buf, 0x0211, 0, ramp(0, 1));
+		buf.push_back(0); // zero padding ends the walk
+		demux.parse(buf.data(), buf.size());
+		CHECK( sids == vector<uint16_t>({0x0100, 0x0211}) );
+	}
+
+	SECTION("packets too short for their header are dropped") {
+		// the flags announce a stream ID, class ID and timestamps but the
+		// packet ends after two words
+		buf.push_back((0x1u << 28) | (1u << 27) | (1u << 26) | (0x1u << 22) | (0x1u << 20) | 2);
+		buf.push_back(0x0100);
+		append_packet(buf, 0x0100, 0, ramp(0, 4));
+		demux.parse(buf.data(), buf.size());
+		CHECK( demux.malformedPackets == 1 );
+		CHECK( demux.packetsParsed == 1 );
+		REQUIRE( records.size() == 1 );
+		CHECK( records[0].data == ramp(0, 4) );
+	}
+}
+
+TEST_CASE("Accumulating record views", "[demux]") {
+	QDSPStream stream(1, 0, 0);
+	Accumulator accumulator(stream, 16, 1, 1);
+	// recordLength 16 gives 4 int16 samples = 2 payload words
+	vector<uint32_t> words = {(2u << 16) | 1u, (4u << 16) | 3u};
+	RecordView<int16_t> view = RecordView<int16_t>::from_words(words.data(), words.size());
+	REQUIRE( view.size() == 4 );
+	CHECK( view[0] == 1 );
+	CHECK( view[3] == 4 );
+	accumulator.accumulate(view);
+	accumulator.accumulate(view);
+	CHECK( accumulator.recordsTaken == 2 );
+}
+
+// Benchmark the single-pass demultiplexer against broadcasting every buffer
+// to one parser per stream type, each of which walks all the headers and
+// copies out the records it owns. Run with: run_tests "[.benchmark]"
+TEST_CASE("VITA demultiplexer throughput", "[.benchmark]") {
+	const vector<uint16_t> sids = {0x0100, 0x0200, 0x0110, 0x0210, 0x0111, 0x0112, 0x0211, 0x0212, 0x0113, 0x0213};
+	const vector<size_t> recordWords = {1024, 1024, 64, 64, 2, 2, 2, 2, 2, 2};
+	vector<uint32_t> buf;
+	for (unsigned count = 0; count < 64; count++) {
+		for (size_t ct = 0; ct < sids.size(); ct++) {
+			append_packet(buf, sids[ct], count, ramp(0, recordWords[ct]));
+		}
+	}
+	const size_t iterations = 2000;
+	const double megabytes = iterations * buf.size() * sizeof(uint32_t) / 1e6;
+
+	VitaDemux demux;
+	for (size_t ct = 0; ct < sids.size(); ct++) {
+		demux.add_stream(sids[ct], recordWords[ct]);
+	}
+	uint64_t checksum = 0;
+	demux.set_record_handler([&checksum](unsigned, const uint32_t * data, size_t numWords, const VitaHeader &) {
+		checksum += data[numWords - 1];
+	});
+	auto start = std::chrono::steady_clock::now();
+	for (size_t iter = 0; iter < iterations; iter++) {
+		demux.parse(buf.data(), buf.size());
+	}
+	double single = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	// five-parser broadcast baseline: physical, demod, result, state, correlated
+	const vector<vector<size_t>> owned = {{0, 1}, {2, 3}, {4, 5}, {6, 7}, {8, 9}};
+	vector<vector<uint32_t>> outputs(sids.size());
+	uint64_t baseChecksum = 0;
+	start = std::chrono::steady_clock::now();
+	for (size_t iter = 0; iter < iterations; iter++) {
+		for (auto & parser : owned) {
+			size_t ct = 0;
+			while (ct < buf.size()) {
+				VitaHeader vh(buf.data() + ct);
+				for (auto idx : parser) {
+					if (vh.streamID == sids[idx]) {
+						const uint32_t * payload = buf.data() + ct + vh.headerSize;
+						outputs[idx].assign(payload, payload + vh.payload_size());
+						baseChecksum += outputs[idx].back();
+					}
+				}
+				ct += vh.packetSize;
+			}
+		}
+	}
+	double broadcast = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "single pass demux: " << megabytes / single << " MB/s" << std::endl;
+	std::cout << "five parser broadcast: " << megabytes / broadcast << " MB/s" << std::endl;
+	CHECK( checksum == baseChecksum );
+}
+
+TEST_CASE("Stream contexts are cache line aligned", "[demux]") {
+	StreamContextArray contexts(5);
+	for (auto & ctx : contexts) {
+		CHECK( reinterpret_cast<uintptr_t>(&ctx) % CACHE_LINE_SIZE == 0 );
+	}
+}
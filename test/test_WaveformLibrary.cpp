@@ -0,0 +1,61 @@
+#include "catch.hpp"
+
+#include <vector>
+using std::vector;
+#include <cstdint>
+
+#include "WaveformLibrary.h"
+#include "X6_errno.h"
+
+TEST_CASE("Waveform library", "[WaveformLibrary]") {
+	WaveformLibrary library;
+	const vector<uint32_t> a(500, 1), b(1000, 2);
+
+	SECTION("waveforms are kept by name") {
+		library.add("a", a, 1);
+		library.add("b", b, 2);
+		CHECK( library.size() == 2 );
+		CHECK( library.contains("a") );
+		CHECK( library.find("b").words == b );
+		CHECK( library.find("b").hash == 2 );
+		CHECK_THROWS_AS( library.find("c"), X6_STATUS );
+		CHECK_THROWS_AS( library.remove("c"), X6_STATUS );
+		CHECK_THROWS_AS( library.add("c", vector<uint32_t>(), 3), X6_STATUS );
+		CHECK_FALSE( library.contains("c") );
+
+		library.remove("a");
+		CHECK_FALSE( library.contains("a") );
+		CHECK( library.size() == 1 );
+		library.clear();
+		CHECK( library.size() == 0 );
+	}
+
+	SECTION("replacing a waveform") {
+		library.add("a", a, 1);
+		library.add("a", b, 2);
+		CHECK( library.size() == 1 );
+		CHECK( library.find("a").words == b );
+		CHECK( library.find("a").hash == 2 );
+	}
+
+	SECTION("selection") {
+		library.add("a", a, 1);
+		library.add("b", b, 2);
+		CHECK_THROWS_AS( library.select("c"), X6_STATUS );
+		CHECK( library.get_selected().empty() );
+		library.select("b");
+		CHECK( library.get_selected() == "b" );
+		// replacing the selected waveform keeps it selected
+		library.add("b", a, 3);
+		CHECK( library.get_selected() == "b" );
+		library.remove("b");
+		CHECK( library.get_selected().empty() );
+		library.select("a");
+		library.deselect();
+		CHECK( library.get_selected().empty() );
+		CHECK( library.contains("a") );
+		library.select("a");
+		library.clear();
+		CHECK( library.get_selected().empty() );
+	}
+}